@@ -26,6 +26,7 @@
 #include "ns3/building-allocator.h"
 #include "ns3/buildings-helper.h"
 #include "ns3/forwarder-helper.h"
+#include "ns3/lora-statistical-phy.h"
 #include <algorithm>
 #include <ctime>
 
@@ -43,6 +44,9 @@ double simulationTime = 100;
 // Channel model
 bool realisticChannelModel = false;
 
+// Evaluate the packets with LoraStatisticalPhy instead of simulating them
+bool statisticalPhy = false;
+
 int appPeriodSeconds = simulationTime;
 int transientPeriods = 0;
 
@@ -52,6 +56,8 @@ main (int argc, char *argv[])
 
   CommandLine cmd;
   cmd.AddValue ("nDevices", "Number of end devices to include in the simulation", nDevices);
+  cmd.AddValue ("statisticalPhy", "Whether to use the statistical PHY instead of the full simulation",
+                statisticalPhy);
   cmd.Parse (argc, argv);
 
   // Set up logging
@@ -144,6 +150,36 @@ main (int argc, char *argv[])
       mobility->SetPosition (position);
     }
 
+  if (statisticalPhy)
+    {
+      // Evaluate the same deployment without simulating the devices: the
+      // gateway of the ALOHA region has a single reception path on 868.1 MHz
+      Ptr<MobilityModel> gwMobility = CreateObject<ConstantPositionMobilityModel> ();
+      gwMobility->SetPosition (Vector (0.0, 0.0, 15.0));
+
+      Ptr<LoraStatisticalPhy> statPhy = CreateObjectWithAttributes<LoraStatisticalPhy> (
+          "Period", TimeValue (appPeriod), "PacketSize", UintegerValue (150));
+      statPhy->AddChannel (868.1);
+      statPhy->AddReceptionPath (868.1);
+      for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+        {
+          double rxPower = loss->CalcRxPower (14, (*j)->GetObject<MobilityModel> (), gwMobility);
+          statPhy->AddTransmitter (7, rxPower);
+        }
+
+      std::vector<int> packetCounts = statPhy->Run (Seconds (simulationTime));
+
+      // Print in the same format as LoraPacketTracker::PrintPhyPacketsPerGw
+      for (int i = 0; i < 6; ++i)
+        {
+          std::cout << packetCounts.at (i) << " ";
+        }
+      std::cout << std::endl;
+
+      Simulator::Destroy ();
+      return 0;
+    }
+
   // Create the LoraNetDevices of the end devices
   uint8_t nwkId = 54;
   uint32_t nwkAddr = 1864;
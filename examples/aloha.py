@@ -11,7 +11,8 @@ campaign = sem.CampaignManager.new(ns_3_dir, script, results_dir,
 
 # Define the parameter space we are interested in exploring
 params = {
-    'nDevices': list(np.logspace(0, 3))
+    'nDevices': list(np.logspace(0, 3)),
+    'statisticalPhy': [0, 1]
 }
 runs = 10
 
@@ -42,10 +43,12 @@ succprobs = np.mean(campaign.get_results_as_numpy_array(params, get_psucc,
                                                         runs),
                     axis=-1).squeeze()
 
-S = np.multiply(succprobs, G)
+# One column for the full simulation, one for the statistical PHY
+S = np.multiply(succprobs, G[:, np.newaxis])
 S_theory = np.multiply(G, np.exp(-2*G))
 
-plt.plot(G, S)
+plt.plot(G, S[:, 0])
+plt.plot(G, S[:, 1], ':')
 plt.plot(G, S_theory, '--')
-plt.legend(["LoRaWAN module", "Theory"])
+plt.legend(["LoRaWAN module", "Statistical PHY", "Theory"])
 plt.show()
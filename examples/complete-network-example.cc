@@ -26,6 +26,8 @@
 #include "ns3/building-allocator.h"
 #include "ns3/buildings-helper.h"
 #include "ns3/forwarder-helper.h"
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/lora-profiler.h"
 #include <algorithm>
 #include <ctime>
 
@@ -45,8 +47,12 @@ bool realisticChannelModel = false;
 
 int appPeriodSeconds = 600;
 
+// Backhaul
+double batchIntervalSeconds = 0;
+
 // Output control
 bool print = true;
+std::string flightRecorderFile = "";
 
 int
 main (int argc, char *argv[])
@@ -60,8 +66,23 @@ main (int argc, char *argv[])
                 "The period in seconds to be used by periodically transmitting applications",
                 appPeriodSeconds);
   cmd.AddValue ("print", "Whether or not to print various informations", print);
+  cmd.AddValue ("batchInterval",
+                "The time the gateways wait to forward uplinks in batches [s], 0 to "
+                "forward them one by one",
+                batchIntervalSeconds);
+  cmd.AddValue ("flightRecorder",
+                "File to dump the flight recorder to at the end of the run, if not empty",
+                flightRecorderFile);
   cmd.Parse (argc, argv);
 
+  // Keep the last events of the PHYs, to be read with
+  // lora-flight-recorder-decoder
+  if (!flightRecorderFile.empty ())
+    {
+      LoraFlightRecorder::Enable ();
+      LoraFlightRecorder::DumpAtExit (flightRecorderFile);
+    }
+
   // Set up logging
   LogComponentEnable ("ComplexLorawanNetworkExample", LOG_LEVEL_ALL);
   // LogComponentEnable("LoraChannel", LOG_LEVEL_INFO);
@@ -144,11 +165,19 @@ main (int argc, char *argv[])
   helper.EnablePacketTracking (); // Output filename
   // helper.EnableSimulationTimePrinting ();
 
+  // Print where the wall time went, in builds configured with
+  // --enable-lorawan-profiling
+  if (LoraProfiler::IsCompiledIn ())
+    {
+      helper.EnableProfilingReport ();
+    }
+
   //Create the NetworkServerHelper
   NetworkServerHelper nsHelper = NetworkServerHelper ();
 
   //Create the ForwarderHelper
   ForwarderHelper forHelper = ForwarderHelper ();
+  forHelper.SetAttribute ("BatchInterval", TimeValue (Seconds (batchIntervalSeconds)));
 
   /************************
    *  Create End Devices  *
@@ -574,6 +574,7 @@ int main (int argc, char *argv[])
     cpsr = tracker.CountMacPacketsGloballyCpsr (Seconds(0), Seconds(simTime));
   }
   std::cout << generatedPacketsAPP << " " << pdr << " " << cpsr << std::endl;
+  helper.DoPrintEnergySummary (endDevices, "energySummary.txt");
   // std::vector<double> timeStatistics = tracker.TxTimeStatisticsPerEd (Seconds(0),
   //                                                                     Seconds(simTime),
   //                                                                     0);
@@ -0,0 +1,30 @@
+/*
+ * This program prints the records of a dump of the LoraFlightRecorder, one
+ * per line, e.g.:
+ *   ./waf --run "complete-network-example --flightRecorder=fr.bin"
+ *   ./waf --run "lora-flight-recorder-decoder --file=fr.bin"
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/abort.h"
+#include "ns3/lora-flight-recorder.h"
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+int
+main (int argc, char *argv[])
+{
+  std::string file = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("file", "The dump to decode", file);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (file.empty (), "Use --file to choose the dump to decode");
+
+  LoraFlightRecorder::Decode (file, std::cout);
+
+  return 0;
+}
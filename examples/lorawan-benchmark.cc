@@ -0,0 +1,694 @@
+/*
+ * This program measures the cost of the hot paths of the lorawan module.
+ *
+ * Microbenchmarks time a single operation in a loop. Macrobenchmarks run the
+ * scenarios of complete-network-example and energy-single-device-example
+ * with an increasing number of devices, and measure the events processed per
+ * second of wall time, the heap allocations per uplink and the peak resident
+ * set size. The install benchmark measures how many end devices
+ * LoraHelper::Install sets up per second. Results are printed to stdout as a
+ * JSON array.
+ *
+ * Comparing runs with and without --flightRecorder gives the overhead of
+ * keeping the LoraFlightRecorder enabled. Macrobenchmarks also report how
+ * many packets the applications created and how many the LoraPacketPool
+ * recycled: since tracked packets are never recycled, compare
+ * --packetPool=0 and --packetPool=1 with --packetTracking=0.
+ *
+ * The peak RSS is the one of the whole process, so that it is only
+ * meaningful when each process runs a single macrobenchmark, e.g.:
+ *   ./waf --run "lorawan-benchmark --benchmark=network --nDevices=10000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/node-container.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-interference-helper.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-packet-tracker.h"
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/lora-packet-pool.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/capacitor-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/basic-energy-harvester-helper.h"
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanBenchmark");
+
+// Inputs
+std::string benchmark = "all";
+uint32_t iterations = 100000;
+std::string nDevicesList = "100,1000,10000";
+double networkSimulationTime = 600;
+double energySimulationTime = 100;
+bool flightRecorder = false;
+bool packetPool = false;
+bool packetTracking = true;
+
+/////////////////////////////
+// Allocations and events  //
+/////////////////////////////
+
+// Every heap allocation of the process goes through this counter
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+// Number of events taken out of the scheduler
+static uint64_t g_events = 0;
+
+/**
+ * The default scheduler, counting the events it hands to the simulator.
+ */
+class CountingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    g_events++;
+    return MapScheduler::RemoveNext ();
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CountingScheduler);
+
+TypeId
+CountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CountingScheduler")
+    .SetParent<MapScheduler> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<CountingScheduler> ();
+  return tid;
+}
+
+///////////////
+// Reporting //
+///////////////
+
+typedef std::chrono::steady_clock Clock;
+
+std::vector<std::string> results;
+
+// Keep the results of the measured operations alive
+volatile uint64_t sink = 0;
+
+double
+SecondsSince (Clock::time_point start)
+{
+  return std::chrono::duration<double> (Clock::now () - start).count ();
+}
+
+long
+GetPeakRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+void
+ReportMicro (std::string name, uint32_t n, double seconds, uint64_t allocations)
+{
+  std::ostringstream record;
+  record << "{\"benchmark\": \"" << name << "\", \"type\": \"micro\""
+         << ", \"iterations\": " << n
+         << ", \"wall_s\": " << seconds
+         << ", \"ns_per_op\": " << seconds * 1e9 / n
+         << ", \"allocations_per_op\": " << double (allocations) / n << "}";
+  results.push_back (record.str ());
+}
+
+void
+ReportMacro (std::string name, uint32_t nDevices, double setupSeconds, double seconds,
+             uint64_t events, uint64_t uplinks, uint64_t allocations)
+{
+  std::ostringstream record;
+  record << "{\"benchmark\": \"" << name << "\", \"type\": \"macro\""
+         << ", \"devices\": " << nDevices
+         << ", \"setup_s\": " << setupSeconds
+         << ", \"wall_s\": " << seconds
+         << ", \"events\": " << events
+         << ", \"events_per_s\": " << events / seconds
+         << ", \"uplinks\": " << uplinks
+         << ", \"allocations_per_uplink\": "
+         << (uplinks > 0 ? double (allocations) / uplinks : 0)
+         << ", \"packets_created\": " << LoraPacketPool::GetCreatedCount ()
+         << ", \"packets_recycled\": " << LoraPacketPool::GetRecycledCount ()
+         << ", \"peak_rss_kb\": " << GetPeakRssKb () << "}";
+  results.push_back (record.str ());
+}
+
+/////////////////////
+// Microbenchmarks //
+/////////////////////
+
+LoraTxParameters
+GetTxParameters (uint8_t sf)
+{
+  // Same parameters as ClassAEndDeviceLorawanMac
+  LoraTxParameters params;
+  params.sf = sf;
+  params.headerDisabled = 1;
+  params.codingRate = 1;
+  params.bandwidthHz = 125000;
+  params.nPreamble = 8;
+  params.crcEnabled = 1;
+  params.lowDataRateOptimizationEnabled = 0;
+  return params;
+}
+
+Ptr<Packet>
+CreateUplink (uint32_t size)
+{
+  Ptr<Packet> packet = Create<Packet> (size);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (54, 1864));
+  packet->AddHeader (frameHdr);
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+  return packet;
+}
+
+void
+BenchmarkInterference (uint32_t n)
+{
+  LoraInterferenceHelper interference;
+  Ptr<LoraInterferenceHelper::Event> event =
+    interference.Add (Seconds (1), -110, 7, 0, 868.1);
+  for (uint8_t i = 0; i < 20; i++)
+    {
+      interference.Add (Seconds (1), -120 - i % 10, 7 + i % 6, 0, 868.1);
+    }
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sink += interference.IsDestroyedByInterference (event);
+    }
+  ReportMicro ("LoraInterferenceHelper::IsDestroyedByInterference", n,
+               SecondsSince (start), g_allocations - allocations);
+
+  interference.ClearAllEvents ();
+}
+
+void
+BenchmarkChannelSend (uint32_t n)
+{
+  // One end device heard by eight gateways
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator", "rho", DoubleValue (1000),
+                                 "X", DoubleValue (0.0), "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  NodeContainer gateways;
+  gateways.Create (8);
+  mobility.Install (gateways);
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  Ptr<LoraPhy> phy = endDevices.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+  Ptr<Packet> packet = CreateUplink (10);
+  LoraTxParameters params = GetTxParameters (7);
+  Time duration = LoraPhy::GetOnAirTime (packet, params);
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      channel->Send (phy, packet, 14, params, duration, 868.1);
+    }
+  ReportMicro ("LoraChannel::Send", n, SecondsSince (start), g_allocations - allocations);
+
+  // Drop the scheduled receptions
+  Simulator::Destroy ();
+}
+
+void
+BenchmarkOnAirTime (uint32_t n)
+{
+  Ptr<Packet> packet = CreateUplink (10);
+  std::vector<LoraTxParameters> params;
+  for (uint8_t sf = 7; sf <= 12; sf++)
+    {
+      params.push_back (GetTxParameters (sf));
+    }
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sink += LoraPhy::GetOnAirTime (packet, params[i % 6]).GetTimeStep ();
+    }
+  ReportMicro ("LoraPhy::GetOnAirTime", n, SecondsSince (start), g_allocations - allocations);
+}
+
+void
+BenchmarkFrameHeader (uint32_t n)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (54, 1864));
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      frameHdr.SetFCnt (i);
+      packet->AddHeader (frameHdr);
+
+      LoraFrameHeader received;
+      received.SetAsUplink ();
+      packet->RemoveHeader (received);
+      sink += received.GetFCnt ();
+    }
+  ReportMicro ("LoraFrameHeader::Serialize+Deserialize", n, SecondsSince (start),
+               g_allocations - allocations);
+}
+
+void
+BenchmarkCapacitorUpdate (uint32_t n)
+{
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  mobility.Install (endDevices);
+  NetDeviceContainer devices = helper.Install (phyHelper, macHelper, endDevices);
+
+  CapacitorEnergySourceHelper capacitorHelper;
+  EnergySourceContainer sources = capacitorHelper.Install (endDevices);
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Install (devices, sources);
+
+  Ptr<CapacitorEnergySource> source = DynamicCast<CapacitorEnergySource> (sources.Get (0));
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      source->UpdateEnergySource ();
+    }
+  ReportMicro ("CapacitorEnergySource::UpdateEnergySource", n, SecondsSince (start),
+               g_allocations - allocations);
+
+  Simulator::Destroy ();
+}
+
+void
+BenchmarkPacketTracker (uint32_t n)
+{
+  LoraPacketTracker tracker;
+
+  // Each packet is tracked by its pointer: create them beforehand
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      packets.push_back (CreateUplink (10));
+    }
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      tracker.TransmissionCallback (packets[i], 0);
+      tracker.PacketReceptionCallback (packets[i], 1);
+    }
+  ReportMicro ("LoraPacketTracker::TransmissionCallback+PacketReceptionCallback", n,
+               SecondsSince (start), g_allocations - allocations);
+}
+
+/////////////////////
+// Macrobenchmarks //
+/////////////////////
+
+uint64_t uplinks = 0;
+
+void
+OnStartSending (Ptr<Packet const> packet, uint32_t systemId)
+{
+  uplinks++;
+}
+
+/**
+ * Set up end devices and a gateway at the center of a disc, together with
+ * the Network Server, in the way of complete-network-example.
+ */
+void
+InstallNetwork (NodeContainer endDevices, NodeContainer gateways, double radius,
+                LoraHelper &helper, Ptr<LoraChannel> channel)
+{
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator", "rho", DoubleValue (radius),
+                                 "X", DoubleValue (0.0), "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (endDevices);
+
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  allocator->Add (Vector (0.0, 0.0, 15.0));
+  mobility.SetPositionAllocator (allocator);
+  mobility.Install (gateways);
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<LoraPhy> phy = (*j)->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+      phy->TraceConnectWithoutContext ("StartSending", MakeCallback (&OnStartSending));
+    }
+
+  NodeContainer networkServer;
+  networkServer.Create (1);
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  nsHelper.Install (networkServer);
+
+  ForwarderHelper forHelper = ForwarderHelper ();
+  forHelper.Install (gateways);
+}
+
+/**
+ * Run the simulation and report the measurements taken while it runs.
+ */
+void
+RunMacro (std::string name, uint32_t nDevices, Time stopTime, Clock::time_point setupStart)
+{
+  double setupSeconds = SecondsSince (setupStart);
+
+  uplinks = 0;
+  LoraPacketPool::ResetCounters ();
+  uint64_t events = g_events;
+  uint64_t allocations = g_allocations;
+
+  Simulator::Stop (stopTime);
+  Clock::time_point start = Clock::now ();
+  Simulator::Run ();
+  double seconds = SecondsSince (start);
+
+  ReportMacro (name, nDevices, setupSeconds, seconds, g_events - events, uplinks,
+               g_allocations - allocations);
+
+  Simulator::Destroy ();
+}
+
+void
+BenchmarkNetwork (uint32_t nDevices)
+{
+  Clock::time_point setupStart = Clock::now ();
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  LoraHelper helper = LoraHelper ();
+  if (packetTracking)
+    {
+      helper.EnablePacketTracking ();
+    }
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  NodeContainer gateways;
+  gateways.Create (1);
+  InstallNetwork (endDevices, gateways, 7500, helper, channel);
+
+  Time appStopTime = Seconds (networkSimulationTime);
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (600));
+  appHelper.SetPacketSize (23);
+  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (appStopTime);
+
+  RunMacro ("complete-network", nDevices, appStopTime + Hours (1), setupStart);
+}
+
+void
+BenchmarkEnergy (uint32_t nDevices)
+{
+  Clock::time_point setupStart = Clock::now ();
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  LoraHelper helper = LoraHelper ();
+  if (packetTracking)
+    {
+      helper.EnablePacketTracking ();
+    }
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  NodeContainer gateways;
+  gateways.Create (1);
+  InstallNetwork (endDevices, gateways, 100, helper, channel);
+
+  PeriodicSenderHelper periodicSenderHelper;
+  periodicSenderHelper.SetPeriod (Seconds (10));
+  periodicSenderHelper.SetPacketSize (10);
+  periodicSenderHelper.Install (endDevices);
+
+  // Same energy setup as energy-single-device-example, with eh = 0.001 W
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (0.006));
+  capacitorHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (0.545454));
+  capacitorHelper.Set ("CapacitorHighVoltageThreshold", DoubleValue (0.9090));
+  capacitorHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (3.3));
+  capacitorHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (MilliSeconds (500)));
+
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Set ("EnterSleepIfDepleted", BooleanValue (false));
+  radioEnergy.Set ("TurnOnDuration", TimeValue (Seconds (0.3)));
+  radioEnergy.Set ("TurnOnCurrentA", DoubleValue (0.015));
+  radioEnergy.Set ("TxCurrentA", DoubleValue (0.028011));
+  radioEnergy.Set ("IdleCurrentA", DoubleValue (0.000007));
+  radioEnergy.Set ("RxCurrentA", DoubleValue (0.011011));
+  radioEnergy.Set ("SleepCurrentA", DoubleValue (0.0000056));
+  radioEnergy.Set ("StandbyCurrentA", DoubleValue (0.0105055));
+  radioEnergy.Set ("OffCurrentA", DoubleValue (0.0000055));
+
+  BasicEnergyHarvesterHelper harvesterHelper;
+  harvesterHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (10)));
+  harvesterHelper.Set ("HarvestablePower",
+                       StringValue ("ns3::ConstantRandomVariable[Constant=0.001]"));
+
+  NetDeviceContainer devices;
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      devices.Add ((*j)->GetDevice (0));
+    }
+  EnergySourceContainer sources = capacitorHelper.Install (endDevices);
+  radioEnergy.Install (devices, sources);
+  harvesterHelper.Install (sources);
+
+  RunMacro ("energy-single-device", nDevices, Seconds (energySimulationTime), setupStart);
+}
+
+/**
+ * Measure how fast LoraHelper::Install sets up end devices, with packet
+ * tracking enabled, before any event runs.
+ */
+void
+BenchmarkInstall (uint32_t nDevices)
+{
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  LoraHelper helper = LoraHelper ();
+  helper.EnablePacketTracking ();
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (endDevices);
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+
+  uint64_t allocations = g_allocations;
+  Clock::time_point start = Clock::now ();
+  helper.Install (phyHelper, macHelper, endDevices);
+  double seconds = SecondsSince (start);
+  allocations = g_allocations - allocations;
+
+  std::ostringstream record;
+  record << "{\"benchmark\": \"install\", \"type\": \"startup\""
+         << ", \"devices\": " << nDevices
+         << ", \"wall_s\": " << seconds
+         << ", \"nodes_per_s\": " << nDevices / seconds
+         << ", \"allocations_per_node\": " << double (allocations) / nDevices
+         << ", \"peak_rss_kb\": " << GetPeakRssKb () << "}";
+  results.push_back (record.str ());
+
+  Simulator::Destroy ();
+}
+
+/***********
+ ** MAIN  **
+ **********/
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("benchmark", "Benchmarks to run [all, micro, install, network, energy]", benchmark);
+  cmd.AddValue ("iterations", "Number of iterations of each microbenchmark", iterations);
+  cmd.AddValue ("nDevices", "Comma separated numbers of devices of the macrobenchmarks",
+                nDevicesList);
+  cmd.AddValue ("networkSimulationTime", "Simulated time of the network benchmark [s]",
+                networkSimulationTime);
+  cmd.AddValue ("energySimulationTime", "Simulated time of the energy benchmark [s]",
+                energySimulationTime);
+  cmd.AddValue ("flightRecorder", "Whether to keep the flight recorder enabled, to measure "
+                "its overhead", flightRecorder);
+  cmd.AddValue ("packetPool", "Whether the applications recycle their packets", packetPool);
+  cmd.AddValue ("packetTracking", "Whether the macrobenchmarks track packets", packetTracking);
+  cmd.Parse (argc, argv);
+
+  if (flightRecorder)
+    {
+      LoraFlightRecorder::Enable ();
+    }
+  if (packetPool)
+    {
+      LoraPacketPool::Enable ();
+    }
+
+  GlobalValue::Bind ("SchedulerType", TypeIdValue (CountingScheduler::GetTypeId ()));
+
+  std::vector<uint32_t> nDevices;
+  std::istringstream list (nDevicesList);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      nDevices.push_back (std::stoul (item));
+    }
+
+  if (benchmark == "all" || benchmark == "micro")
+    {
+      BenchmarkInterference (iterations);
+      BenchmarkChannelSend (iterations);
+      BenchmarkOnAirTime (iterations);
+      BenchmarkFrameHeader (iterations);
+      BenchmarkCapacitorUpdate (iterations);
+      BenchmarkPacketTracker (iterations);
+    }
+
+  for (uint32_t i = 0; i < nDevices.size (); i++)
+    {
+      if (benchmark == "all" || benchmark == "install")
+        {
+          BenchmarkInstall (nDevices[i]);
+        }
+      if (benchmark == "all" || benchmark == "network")
+        {
+          BenchmarkNetwork (nDevices[i]);
+        }
+      if (benchmark == "all" || benchmark == "energy")
+        {
+          BenchmarkEnergy (nDevices[i]);
+        }
+    }
+
+  std::cout << "[" << std::endl;
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      std::cout << "  " << results[i] << (i + 1 < results.size () ? "," : "") << std::endl;
+    }
+  std::cout << "]" << std::endl;
+
+  return 0;
+}
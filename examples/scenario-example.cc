@@ -0,0 +1,154 @@
+/*
+ * This script builds a deployment from a scenario file with the
+ * LoraScenarioHelper, so that large deployments can be simulated without
+ * writing and compiling a program for each of them. A scenario file looks
+ * like:
+ *
+ *   # trace,<id>,<filename>
+ *   trace,0,outputixys.csv
+ *   # gw,<x>,<y>,<z>
+ *   gw,0,0,15
+ *   # ed,<x>,<y>,<z>,<sf>,<period s>,<packet size>,<capacitance F>,<trace id>
+ *   ed,100,200,1.2,7,600,19,0.006,0
+ *   ed,-350,40,1.2,,600,,,
+ *
+ * When no file is given, a single gateway and a single end device are
+ * simulated.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-scenario-helper.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/capacitor-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/variable-energy-harvester-helper.h"
+#include <chrono>
+#include <fstream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("ScenarioExample");
+
+// Inputs
+std::string scenarioFile = "";
+double simulationTime = 3600;
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("scenario", "The scenario file to simulate", scenarioFile);
+  cmd.AddValue ("simulationTime", "The time for which to simulate [s]", simulationTime);
+  cmd.Parse (argc, argv);
+
+  LogComponentEnable ("ScenarioExample", LOG_LEVEL_ALL);
+  LogComponentEnable ("LoraScenarioHelper", LOG_LEVEL_INFO);
+
+  if (scenarioFile.empty ())
+    {
+      scenarioFile = "scenario.csv";
+      std::ofstream file (scenarioFile.c_str ());
+      file << "gw,0,0,15" << std::endl;
+      file << "ed,100,200,1.2,7,600,19,0.006," << std::endl;
+    }
+
+  /****************************
+   *  Load the scenario file  *
+   ****************************/
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+  LoraScenarioHelper scenario;
+  scenario.Load (scenarioFile);
+
+  /************************
+   *  Create the channel  *
+   ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  /**********************
+   *  Create the nodes  *
+   **********************/
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer gateways = scenario.InstallGateways (helper, phyHelper, macHelper);
+  NodeContainer endDevices = scenario.InstallEndDevices (helper, phyHelper, macHelper);
+
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  ApplicationContainer apps = scenario.InstallApplications (endDevices, appHelper);
+  apps.Start (Seconds (0));
+  apps.Stop (Seconds (simulationTime));
+
+  /************************
+   *  Install the energy  *
+   ************************/
+
+  // Same energy setup as energy-single-device-example
+  CapacitorEnergySourceHelper sourceHelper;
+  sourceHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (0.545454));
+  sourceHelper.Set ("CapacitorHighVoltageThreshold", DoubleValue (0.9090));
+  sourceHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (3.3));
+  sourceHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (MilliSeconds (500)));
+
+  LoraRadioEnergyModelHelper radioHelper;
+  radioHelper.Set ("EnterSleepIfDepleted", BooleanValue (false));
+  radioHelper.Set ("TurnOnDuration", TimeValue (Seconds (0.3)));
+  radioHelper.Set ("TurnOnCurrentA", DoubleValue (0.015));
+  radioHelper.Set ("TxCurrentA", DoubleValue (0.028011));
+  radioHelper.Set ("IdleCurrentA", DoubleValue (0.000007));
+  radioHelper.Set ("RxCurrentA", DoubleValue (0.011011));
+  radioHelper.Set ("SleepCurrentA", DoubleValue (0.0000056));
+  radioHelper.Set ("StandbyCurrentA", DoubleValue (0.0105055));
+  radioHelper.Set ("OffCurrentA", DoubleValue (0.0000055));
+
+  VariableEnergyHarvesterHelper harvesterHelper;
+  scenario.InstallEnergy (endDevices, sourceHelper, radioHelper, harvesterHelper);
+
+  /********************
+   *  Network Server  *
+   ********************/
+
+  NodeContainer networkServer;
+  networkServer.Create (1);
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  nsHelper.Install (networkServer);
+
+  ForwarderHelper forHelper = ForwarderHelper ();
+  forHelper.Install (gateways);
+
+  NS_LOG_INFO ("Built " << scenario.GetNGateways () << " gateways and "
+                        << scenario.GetNEndDevices () << " end devices in "
+                        << std::chrono::duration<double> (std::chrono::steady_clock::now ()
+                                                          - start).count ()
+                        << " s");
+
+  /****************
+   *  Simulation  *
+   ****************/
+
+  Simulator::Stop (Seconds (simulationTime));
+  Simulator::Run ();
+
+  helper.DoPrintEnergySummary (endDevices, "scenarioEnergySummary.txt");
+
+  Simulator::Destroy ();
+
+  return 0;
+}
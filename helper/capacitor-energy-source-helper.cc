@@ -21,12 +21,14 @@
 
 #include "capacitor-energy-source-helper.h"
 #include "ns3/energy-source.h"
+#include "ns3/capacitor-energy-source.h"
 
 namespace ns3 {
 
 CapacitorEnergySourceHelper::CapacitorEnergySourceHelper ()
 {
   m_capacitorEnergySource.SetTypeId ("ns3::CapacitorEnergySource");
+  m_fleetManager = 0;
 }
 
 CapacitorEnergySourceHelper::~CapacitorEnergySourceHelper ()
@@ -39,6 +41,12 @@ CapacitorEnergySourceHelper::Set (std::string name, const AttributeValue &v)
   m_capacitorEnergySource.Set (name, v);
 }
 
+void
+CapacitorEnergySourceHelper::SetFleetManager (Ptr<CapacitorFleetEnergyManager> manager)
+{
+  m_fleetManager = manager;
+}
+
 Ptr<EnergySource>
 CapacitorEnergySourceHelper::DoInstall (Ptr<Node> node) const
 {
@@ -46,6 +54,10 @@ CapacitorEnergySourceHelper::DoInstall (Ptr<Node> node) const
   Ptr<EnergySource> source = m_capacitorEnergySource.Create<EnergySource> ();
   NS_ASSERT (source != NULL);
   source->SetNode (node);
+  if (m_fleetManager != 0)
+    {
+      m_fleetManager->AddSource (source->GetObject<CapacitorEnergySource> ());
+    }
   return source;
 }
 
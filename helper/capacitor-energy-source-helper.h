@@ -23,6 +23,7 @@
 #define CAPACITOR_ENERGY_SOURCE_HELPER_H
 
 #include "ns3/energy-model-helper.h"
+#include "ns3/capacitor-fleet-energy-manager.h"
 #include "ns3/node.h"
 
 namespace ns3 {
@@ -40,11 +41,21 @@ public:
 
   void Set (std::string name, const AttributeValue &v);
 
+  /**
+   * Register all the sources installed from now on with a fleet manager,
+   * which will take care of their periodic updates.
+   *
+   * \param manager The fleet manager. Pass 0 to go back to sources that
+   * update themselves.
+   */
+  void SetFleetManager (Ptr<CapacitorFleetEnergyManager> manager);
+
 private:
   virtual Ptr<EnergySource> DoInstall (Ptr<Node> node) const;
 
 private:
   ObjectFactory m_capacitorEnergySource;
+  Ptr<CapacitorFleetEnergyManager> m_fleetManager;
 
 };
 
@@ -20,6 +20,11 @@
 
 #include "ns3/lora-helper.h"
 #include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/energy-source-container.h"
 
 #include <fstream>
 
@@ -38,6 +43,51 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
   {
   }
 
+  /**
+   * The callbacks to connect to the trace sources of all the PHYs, or all
+   * the MACs, created by an Install call.
+   *
+   * Since these objects all come from the same factory, the callbacks are
+   * built once and each trace source is looked up by name only on the first
+   * object, instead of once per object as TraceConnectWithoutContext does.
+   */
+  class TraceConnections
+  {
+  public:
+    void
+    Add (std::string name, const CallbackBase &callback)
+    {
+      m_names.push_back (name);
+      m_callbacks.push_back (callback);
+    }
+
+    void
+    Connect (Ptr<Object> object)
+    {
+      if (m_accessors.size () != m_names.size ())
+        {
+          TypeId tid = object->GetInstanceTypeId ();
+          for (uint32_t i = 0; i < m_names.size (); i++)
+            {
+              Ptr<const TraceSourceAccessor> accessor =
+                tid.LookupTraceSourceByName (m_names[i]);
+              NS_ASSERT_MSG (accessor != 0, "No trace source " << m_names[i]
+                                                               << " in " << tid.GetName ());
+              m_accessors.push_back (accessor);
+            }
+        }
+      for (uint32_t i = 0; i < m_accessors.size (); i++)
+        {
+          m_accessors[i]->ConnectWithoutContext (PeekPointer (object), m_callbacks[i]);
+        }
+    }
+
+  private:
+    std::vector<std::string> m_names;
+    std::vector<CallbackBase> m_callbacks;
+    std::vector<Ptr<const TraceSourceAccessor> > m_accessors;
+  };
+
   NetDeviceContainer
   LoraHelper::Install ( const LoraPhyHelper &phyHelper,
                         const LorawanMacHelper &macHelper,
@@ -47,6 +97,54 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
 
     NetDeviceContainer devices;
 
+    // Resolve the kind of device and the tracker callbacks once for all the
+    // nodes
+    TypeId deviceType = phyHelper.GetDeviceType ();
+    TraceConnections phyTraces;
+    TraceConnections macTraces;
+    if (m_packetTracker)
+      {
+        if (deviceType == SimpleEndDeviceLoraPhy::GetTypeId ())
+          {
+            phyTraces.Add ("StartSending",
+                           MakeCallback (&LoraPacketTracker::TransmissionCallback,
+                                         m_packetTracker));
+            macTraces.Add ("SentNewPacket",
+                           MakeCallback (&LoraPacketTracker::MacTransmissionCallback,
+                                         m_packetTracker));
+            macTraces.Add ("RequiredTransmissions",
+                           MakeCallback (&LoraPacketTracker::RequiredTransmissionsCallback,
+                                         m_packetTracker));
+          }
+        else if (deviceType == SimpleGatewayLoraPhy::GetTypeId ())
+          {
+            phyTraces.Add ("StartSending",
+                           MakeCallback (&LoraPacketTracker::TransmissionCallback,
+                                         m_packetTracker));
+            phyTraces.Add ("ReceivedPacket",
+                           MakeCallback (&LoraPacketTracker::PacketReceptionCallback,
+                                         m_packetTracker));
+            phyTraces.Add ("LostPacketBecauseInterference",
+                           MakeCallback (&LoraPacketTracker::InterferenceCallback,
+                                         m_packetTracker));
+            phyTraces.Add ("LostPacketBecauseNoMoreReceivers",
+                           MakeCallback (&LoraPacketTracker::NoMoreReceiversCallback,
+                                         m_packetTracker));
+            phyTraces.Add ("LostPacketBecauseUnderSensitivity",
+                           MakeCallback (&LoraPacketTracker::UnderSensitivityCallback,
+                                         m_packetTracker));
+            phyTraces.Add ("NoReceptionBecauseTransmitting",
+                           MakeCallback (&LoraPacketTracker::LostBecauseTxCallback,
+                                         m_packetTracker));
+            macTraces.Add ("SentNewPacket",
+                           MakeCallback (&LoraPacketTracker::MacTransmissionCallback,
+                                         m_packetTracker));
+            macTraces.Add ("ReceivedPacket",
+                           MakeCallback (&LoraPacketTracker::MacGwReceptionCallback,
+                                         m_packetTracker));
+          }
+      }
+
     // Go over the various nodes in which to install the NetDevice
     for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
       {
@@ -62,89 +160,23 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
         NS_LOG_DEBUG ("Done creating the PHY");
 
         // Connect Trace Sources if necessary
-        if (m_packetTracker)
-          {
-            if (phyHelper.GetDeviceType () ==
-                TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy"))
-              {
-                phy->TraceConnectWithoutContext ("StartSending",
-                                                 MakeCallback
-                                                 (&LoraPacketTracker::TransmissionCallback,
-                                                  m_packetTracker));
-              }
-            else if (phyHelper.GetDeviceType () ==
-                     TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy"))
-            {
-              phy->TraceConnectWithoutContext ("StartSending",
-                                               MakeCallback
-                                               (&LoraPacketTracker::TransmissionCallback,
-                                                m_packetTracker));
-              phy->TraceConnectWithoutContext ("ReceivedPacket",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::PacketReceptionCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::InterferenceCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::NoMoreReceiversCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::UnderSensitivityCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("NoReceptionBecauseTransmitting",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::LostBecauseTxCallback,
-                                                 m_packetTracker));
-            }
-        }
-
-      // Create the MAC
-      Ptr<LorawanMac> mac = macHelper.Create (node, device);
-      NS_ASSERT (mac != 0);
-      mac->SetPhy (phy);
-      NS_LOG_DEBUG ("Done creating the MAC");
-      device->SetMac (mac);
-
-      if (m_packetTracker)
-        {
-          if (phyHelper.GetDeviceType () ==
-              TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy"))
-            {
-              mac->TraceConnectWithoutContext ("SentNewPacket",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::MacTransmissionCallback,
-                                                 m_packetTracker));
-
-              mac->TraceConnectWithoutContext ("RequiredTransmissions",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::RequiredTransmissionsCallback,
-                                                 m_packetTracker));
-            }
-          else if (phyHelper.GetDeviceType () ==
-                   TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy"))
-            {
-              mac->TraceConnectWithoutContext ("SentNewPacket",
-                                               MakeCallback
-                                               (&LoraPacketTracker::MacTransmissionCallback,
-                                                m_packetTracker));
-
-              mac->TraceConnectWithoutContext ("ReceivedPacket",
-                                               MakeCallback
-                                               (&LoraPacketTracker::MacGwReceptionCallback,
-                                                m_packetTracker));
-            }
-        }
-
-      node->AddDevice (device);
-      devices.Add (device);
-      NS_LOG_DEBUG ("node=" << node << ", mob=" << node->GetObject<MobilityModel> ()->GetPosition ());
-    }
-  return devices;
-}
+        phyTraces.Connect (phy);
+
+        // Create the MAC
+        Ptr<LorawanMac> mac = macHelper.Create (node, device);
+        NS_ASSERT (mac != 0);
+        mac->SetPhy (phy);
+        NS_LOG_DEBUG ("Done creating the MAC");
+        device->SetMac (mac);
+
+        macTraces.Connect (mac);
+
+        node->AddDevice (device);
+        devices.Add (device);
+        NS_LOG_DEBUG ("node=" << node << ", mob=" << node->GetObject<MobilityModel> ()->GetPosition ());
+      }
+    return devices;
+  }
 
 NetDeviceContainer
 LoraHelper::Install ( const LoraPhyHelper &phy,
@@ -334,6 +366,131 @@ LoraHelper::DoPrintGlobalPerformance (std::string filename)
   outputFile.close();
 }
 
+void
+LoraHelper::DoPrintEnergySummary (NodeContainer endDevices, std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  static const char *stateNames[EndDeviceLoraPhy::IDLE + 1] = {
+    "SLEEP", "STANDBY", "TX", "RX", "OFF", "TURNON", "IDLE"};
+
+  Time timeInState[EndDeviceLoraPhy::IDLE + 1];
+  double energyInState[EndDeviceLoraPhy::IDLE + 1] = {};
+  uint32_t nRadios = 0;
+  uint32_t nCapacitors = 0;
+  uint32_t depletions = 0;
+  uint32_t recharges = 0;
+  uint32_t skippedRadios = 0; // whose histogram has different bins
+  uint32_t skippedCapacitors = 0;
+  DurationHistogram offTimes;
+  DurationHistogram chargeTimes;
+
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      Ptr<EnergySourceContainer> sources = (*it)->GetObject<EnergySourceContainer> ();
+      if (sources == 0)
+        {
+          continue;
+        }
+      for (EnergySourceContainer::Iterator src = sources->Begin (); src != sources->End (); ++src)
+        {
+          DeviceEnergyModelContainer models =
+            (*src)->FindDeviceEnergyModels ("ns3::LoraRadioEnergyModel");
+          for (DeviceEnergyModelContainer::Iterator m = models.Begin (); m != models.End (); ++m)
+            {
+              Ptr<LoraRadioEnergyModel> radio = DynamicCast<LoraRadioEnergyModel> (*m);
+              for (int state = 0; state <= EndDeviceLoraPhy::IDLE; state++)
+                {
+                  timeInState[state] +=
+                    radio->GetTimeInState (EndDeviceLoraPhy::State (state));
+                  energyInState[state] +=
+                    radio->GetEnergyInState (EndDeviceLoraPhy::State (state));
+                }
+              // The first radio sets the bins of the fleet histogram
+              if (nRadios == 0)
+                {
+                  const DurationHistogram &h = radio->GetOffTimeHistogram ();
+                  offTimes.SetBins (h.GetBinWidth (), h.GetNBins ());
+                }
+              if (offTimes.HasSameBins (radio->GetOffTimeHistogram ()))
+                {
+                  offTimes.Merge (radio->GetOffTimeHistogram ());
+                }
+              else
+                {
+                  NS_LOG_WARN ("The OFF periods of node " << (*it)->GetId () <<
+                               " use different bins: they are left out of the histogram");
+                  skippedRadios++;
+                }
+              nRadios++;
+            }
+
+          Ptr<CapacitorEnergySource> capacitor = DynamicCast<CapacitorEnergySource> (*src);
+          if (capacitor != 0)
+            {
+              if (nCapacitors == 0)
+                {
+                  const DurationHistogram &h = capacitor->GetChargeTimeHistogram ();
+                  chargeTimes.SetBins (h.GetBinWidth (), h.GetNBins ());
+                }
+              if (chargeTimes.HasSameBins (capacitor->GetChargeTimeHistogram ()))
+                {
+                  chargeTimes.Merge (capacitor->GetChargeTimeHistogram ());
+                }
+              else
+                {
+                  NS_LOG_WARN ("The charge times of node " << (*it)->GetId () <<
+                               " use different bins: they are left out of the histogram");
+                  skippedCapacitors++;
+                }
+              depletions += capacitor->GetDepletionCount ();
+              recharges += capacitor->GetRechargeCount ();
+              nCapacitors++;
+            }
+        }
+    }
+
+  std::ofstream outputFile;
+  outputFile.open (filename.c_str (), std::ofstream::out | std::ofstream::trunc);
+
+  outputFile << "# Energy summary of " << nRadios << " radios at "
+             << Simulator::Now ().GetSeconds () << " s" << std::endl;
+  outputFile << "# state totalTime[s] meanTime[s] totalEnergy[J] meanEnergy[J]" << std::endl;
+  for (int state = 0; state <= EndDeviceLoraPhy::IDLE; state++)
+    {
+      outputFile << stateNames[state] << " " << timeInState[state].GetSeconds () << " "
+                 << (nRadios > 0 ? timeInState[state].GetSeconds () / nRadios : 0) << " "
+                 << energyInState[state] << " "
+                 << (nRadios > 0 ? energyInState[state] / nRadios : 0) << std::endl;
+    }
+  outputFile << "offTimes " << offTimes.GetTotalCount () << " periods, max "
+             << offTimes.GetMax ().GetSeconds () << " s, bins ";
+  offTimes.Print (outputFile);
+  outputFile << std::endl;
+  if (skippedRadios > 0)
+    {
+      outputFile << "# offTimes leave out " << skippedRadios
+                 << " radios with different bins" << std::endl;
+    }
+
+  if (nCapacitors > 0)
+    {
+      outputFile << "depletions " << depletions << " recharges " << recharges
+                 << " over " << nCapacitors << " capacitors" << std::endl;
+      outputFile << "chargeTimes " << chargeTimes.GetTotalCount () << " periods, max "
+                 << chargeTimes.GetMax ().GetSeconds () << " s, bins ";
+      chargeTimes.Print (outputFile);
+      outputFile << std::endl;
+      if (skippedCapacitors > 0)
+        {
+          outputFile << "# chargeTimes leave out " << skippedCapacitors
+                     << " capacitors with different bins" << std::endl;
+        }
+    }
+
+  outputFile.close ();
+}
+
 void
 LoraHelper::DoPrintSimulationTime (Time interval)
 {
@@ -341,8 +498,26 @@ LoraHelper::DoPrintSimulationTime (Time interval)
   std::cout << "Simulated time: " << Simulator::Now ().GetHours () << " hours" << std::endl;
   std::cout << "Real time from last call: " << std::time (0) - m_oldtime << " seconds" << std::endl;
   m_oldtime = std::time (0);
+  if (LoraProfiler::IsCompiledIn ())
+    {
+      LoraProfiler::PrintSnapshot (std::cout);
+    }
   Simulator::Schedule (interval, &LoraHelper::DoPrintSimulationTime, this, interval);
 }
 
+static void
+PrintProfilingReport (void)
+{
+  LoraProfiler::PrintReport (std::cout);
+}
+
+void
+LoraHelper::EnableProfilingReport (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::ScheduleDestroy (&PrintProfilingReport);
+}
+
 }
 }
@@ -82,10 +82,18 @@ public:
   void EnablePacketTracking (void);
 
   /**
-   * Periodically prints the simulation time to the standard output.
+   * Periodically prints the simulation time to the standard output, together
+   * with a snapshot of the LoraProfiler counters in builds configured with
+   * --enable-lorawan-profiling.
    */
   void EnableSimulationTimePrinting (Time interval);
 
+  /**
+   * Print the LoraProfiler report to the standard output when the simulator
+   * is destroyed.
+   */
+  void EnableProfilingReport (void);
+
   /**
    * Periodically prints the status of devices in the network to a file.
    */
@@ -123,6 +131,17 @@ public:
   void DoPrintDeviceStatus (NodeContainer endDevices, NodeContainer gateways,
                             std::string filename);
 
+  /**
+   * Print a summary of the energy statistics of the end devices: the time
+   * spent and the energy consumed by the radios in each state, the
+   * depletions and recharges of the capacitors, and the histograms of the
+   * OFF periods and of the charge times merged over all devices.
+   *
+   * Devices without a LoraRadioEnergyModel are skipped, and the capacitor
+   * statistics are only printed if some device has a CapacitorEnergySource.
+   */
+  void DoPrintEnergySummary (NodeContainer endDevices, std::string filename);
+
 private:
   /**
    * Actually print the simulation time and re-schedule execution of this
@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-profiler.h"
 #include <iostream>
 #include <fstream>
 
@@ -46,6 +47,8 @@ LoraPacketTracker::~LoraPacketTracker ()
 void
 LoraPacketTracker::MacTransmissionCallback (Ptr<Packet const> packet)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("A new packet was sent by the MAC layer");
@@ -66,6 +69,8 @@ LoraPacketTracker::RequiredTransmissionsCallback (uint8_t reqTx, bool success,
                                                   Time firstAttempt,
                                                   Ptr<Packet> packet)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   NS_LOG_INFO ("Finished retransmission attempts for a packet");
   NS_LOG_DEBUG ("Packet: " << packet << "ReqTx " << unsigned(reqTx) <<
                 ", succ: " << success << ", firstAttempt: " <<
@@ -84,6 +89,8 @@ LoraPacketTracker::RequiredTransmissionsCallback (uint8_t reqTx, bool success,
 void
 LoraPacketTracker::MacGwReceptionCallback (Ptr<Packet const> packet)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("A packet was successfully received" <<
@@ -112,6 +119,8 @@ LoraPacketTracker::MacGwReceptionCallback (Ptr<Packet const> packet)
 void
 LoraPacketTracker::TransmissionCallback (Ptr<Packet const> packet, uint32_t edId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -130,6 +139,8 @@ LoraPacketTracker::TransmissionCallback (Ptr<Packet const> packet, uint32_t edId
 void
 LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       // Remove the successfully received packet from the list of sent ones
@@ -146,6 +157,8 @@ LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t g
 void
 LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -161,6 +174,8 @@ LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t gwId
 void
 LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -175,6 +190,8 @@ LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t g
 void
 LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -190,6 +207,8 @@ LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t
 void
 LoraPacketTracker::LostBecauseTxCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORAWAN_PROFILE (PACKET_TRACKER);
+
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
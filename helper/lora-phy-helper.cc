@@ -78,9 +78,10 @@ LoraPhyHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
   Ptr<LoraPhy> phy = m_phy.Create<LoraPhy> ();
   phy->SetChannel (m_channel);
 
-  // Configuration is different based on the kind of device we have to create
-  std::string typeId = m_phy.GetTypeId ().GetName ();
-  if (typeId == "ns3::SimpleGatewayLoraPhy")
+  // Configuration is different based on the kind of device we have to create.
+  // Compare TypeIds rather than their names, since this runs for every node.
+  TypeId typeId = m_phy.GetTypeId ();
+  if (typeId == SimpleGatewayLoraPhy::GetTypeId ())
     {
       // Inform the channel of the presence of this PHY
       m_channel->Add (phy);
@@ -115,7 +116,7 @@ LoraPhyHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
         }
 
     }
-  else if (typeId == "ns3::SimpleEndDeviceLoraPhy")
+  else if (typeId == SimpleEndDeviceLoraPhy::GetTypeId ())
     {
       // The line below can be commented to speed up uplink-only simulations.
       // This implies that the LoraChannel instance will only know about
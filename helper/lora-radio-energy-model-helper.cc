@@ -25,6 +25,10 @@
 #include "ns3/lora-radio-energy-model.h"
 #include "ns3/lora-tx-current-model.h"
 #include "ns3/end-device-lora-phy.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/end-device-energy-admission.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/energy-gate.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -72,6 +76,22 @@ LoraRadioEnergyModelHelper::SetTxCurrentModel (std::string name,
   m_txCurrentModel = factory;
 }
 
+void
+LoraRadioEnergyModelHelper::SetEnergyGate (std::string name,
+                                           std::string n0, const AttributeValue& v0,
+                                           std::string n1, const AttributeValue& v1,
+                                           std::string n2, const AttributeValue& v2,
+                                           std::string n3, const AttributeValue& v3)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (name);
+  factory.Set (n0, v0);
+  factory.Set (n1, v1);
+  factory.Set (n2, v2);
+  factory.Set (n3, v3);
+  m_energyGate = factory;
+}
+
 void
 LoraRadioEnergyModelHelper::SetEnergyDepletionCallback (
     LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback callback)
@@ -160,6 +180,40 @@ LoraRadioEnergyModelHelper::DoInstall (Ptr<NetDevice> device,
       EnergySourceContainerOnNode->Add (source); // append new EnergySource
     }
 
+  // Bind the PHY to the first source of the node, which is the one it checks
+  // before each state change
+  if (EnergySourceContainerOnNode->Get (0) == source && loraPhy->GetEnergyGate () == 0)
+    {
+      Ptr<EnergyGate> gate;
+      if (m_energyGate.GetTypeId ().GetUid ())
+        {
+          gate = m_energyGate.Create<EnergyGate> ();
+          gate->SetEnergySource (source);
+        }
+      else
+        {
+          gate = EnergyGate::CreateFor (source);
+        }
+      loraPhy->SetEnergyGate (gate);
+    }
+
+  // Resolve once the objects needed by the MAC to check the energy before a
+  // new transmission. As before, the check is based on the first source of
+  // the node, if it is a capacitor.
+  Ptr<CapacitorEnergySource> capacitor =
+      EnergySourceContainerOnNode->Get (0)->GetObject<CapacitorEnergySource> ();
+  Ptr<EndDeviceLorawanMac> mac;
+  if (loraDevice->GetMac ())
+    {
+      mac = loraDevice->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+    }
+  if (capacitor == source && mac != 0 && mac->GetEnergyAdmission () == 0)
+    {
+      Ptr<EndDeviceEnergyAdmission> admission = CreateObject<EndDeviceEnergyAdmission> ();
+      admission->Bind (capacitor, model, mac);
+      mac->SetEnergyAdmission (admission);
+    }
+
   return model;
 }
 
@@ -85,6 +85,27 @@ public:
                           std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),
                           std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());
 
+  /**
+   * \param name the name of the gate to set
+   * \param n0 the name of the attribute to set
+   * \param v0 the value of the attribute to set
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   * \param n2 the name of the attribute to set
+   * \param v2 the value of the attribute to set
+   * \param n3 the name of the attribute to set
+   * \param v3 the value of the attribute to set
+   *
+   * Configure the EnergyGate the EndDeviceLoraPhy uses to check the energy
+   * source before each state change. If not set, a CapacitorEnergyGate or a
+   * BasicEnergyGate is used, depending on the type of the source.
+   */
+  void SetEnergyGate (std::string name,
+                      std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),
+                      std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+                      std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+                      std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue ());
+
   /* Set callbacks */
   void SetEnergyDepletionCallback (LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback callback);
   void SetEnergyRechargedCallback (LoraRadioEnergyModel::LoraRadioEnergyRechargedCallback callback);
@@ -104,6 +125,7 @@ private:
 private:
   ObjectFactory m_radioEnergy; ///< radio energy
   ObjectFactory m_txCurrentModel; ///< transmit current model
+  ObjectFactory m_energyGate; ///< energy gate of the PHY
   LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback m_energyDepletionCallback;
   LoraRadioEnergyModel::LoraRadioEnergyRechargedCallback m_energyRechargedCallback;
   LoraRadioEnergyModel::LoraRadioEnergyChangedCallback m_energyChangedCallback;
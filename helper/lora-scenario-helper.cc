@@ -0,0 +1,542 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#include "ns3/lora-scenario-helper.h"
+#include "ns3/periodic-sender.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraScenarioHelper");
+
+namespace {
+
+/**
+ * The records of a part of the file, and the first error found in it.
+ */
+struct ParsedChunk
+{
+  std::vector<LoraScenarioHelper::GatewayRecord> gateways;
+  std::vector<LoraScenarioHelper::EndDeviceRecord> endDevices;
+  std::vector<std::pair<int32_t, std::string> > traces;
+  std::vector<uint32_t> traceLines; //!< The line of each trace, in the chunk
+  std::vector<uint32_t> endDeviceLines; //!< The line of each end device, in the chunk
+  uint32_t nLines;
+  uint32_t errorLine; //!< The line of the error, in the chunk
+  std::string error; //!< The error, or empty
+};
+
+/**
+ * Split a line at commas, trimming the spaces around each field.
+ */
+void
+SplitFields (const char *begin, const char *end, std::vector<std::string> &fields)
+{
+  fields.clear ();
+  const char *start = begin;
+  for (const char *c = begin; c <= end; c++)
+    {
+      if (c == end || *c == ',')
+        {
+          const char *first = start;
+          const char *last = c;
+          while (first < last && std::isspace (static_cast<unsigned char> (*first)))
+            {
+              first++;
+            }
+          while (last > first && std::isspace (static_cast<unsigned char> (*(last - 1))))
+            {
+              last--;
+            }
+          fields.push_back (std::string (first, last));
+          start = c + 1;
+        }
+    }
+}
+
+bool
+ParseDouble (const std::string &field, double &value)
+{
+  char *end;
+  value = std::strtod (field.c_str (), &end);
+  return !field.empty () && *end == '\0' && std::isfinite (value);
+}
+
+bool
+ParseInteger (const std::string &field, long &value)
+{
+  char *end;
+  value = std::strtol (field.c_str (), &end, 10);
+  return !field.empty () && *end == '\0';
+}
+
+/**
+ * Parse a record, returning an error message if it is not valid.
+ */
+std::string
+ParseRecord (const std::vector<std::string> &fields, uint32_t line, ParsedChunk &chunk)
+{
+  const std::string &type = fields[0];
+  if (type == "trace")
+    {
+      long id;
+      if (fields.size () != 3)
+        {
+          return "a trace record has 3 fields";
+        }
+      if (!ParseInteger (fields[1], id) || id < 0 || id > INT32_MAX)
+        {
+          return "invalid trace id '" + fields[1] + "'";
+        }
+      if (fields[2].empty ())
+        {
+          return "empty trace filename";
+        }
+      chunk.traces.push_back (std::make_pair (int32_t (id), fields[2]));
+      chunk.traceLines.push_back (line);
+      return "";
+    }
+
+  Vector position;
+  if (type == "gw" || type == "ed")
+    {
+      if (fields.size () < 4
+          || !ParseDouble (fields[1], position.x)
+          || !ParseDouble (fields[2], position.y)
+          || !ParseDouble (fields[3], position.z))
+        {
+          return "invalid position";
+        }
+    }
+
+  if (type == "gw")
+    {
+      if (fields.size () != 4)
+        {
+          return "a gw record has 4 fields";
+        }
+      LoraScenarioHelper::GatewayRecord record;
+      record.position = position;
+      chunk.gateways.push_back (record);
+      return "";
+    }
+
+  if (type == "ed")
+    {
+      if (fields.size () != 9)
+        {
+          return "an ed record has 9 fields";
+        }
+      LoraScenarioHelper::EndDeviceRecord record;
+      record.position = position;
+      long value;
+      record.sf = 0;
+      if (!fields[4].empty ())
+        {
+          if (!ParseInteger (fields[4], value) || (value != 0 && (value < 7 || value > 12)))
+            {
+              return "invalid SF '" + fields[4] + "'";
+            }
+          record.sf = value;
+        }
+      record.period = 0;
+      if (!fields[5].empty () && (!ParseDouble (fields[5], record.period) || record.period < 0))
+        {
+          return "invalid period '" + fields[5] + "'";
+        }
+      record.packetSize = 0;
+      if (!fields[6].empty ())
+        {
+          if (!ParseInteger (fields[6], value) || value < 0 || value > 255)
+            {
+              return "invalid packet size '" + fields[6] + "'";
+            }
+          record.packetSize = value;
+        }
+      record.capacitance = 0;
+      if (!fields[7].empty ()
+          && (!ParseDouble (fields[7], record.capacitance) || record.capacitance < 0))
+        {
+          return "invalid capacitance '" + fields[7] + "'";
+        }
+      record.traceId = -1;
+      if (!fields[8].empty ())
+        {
+          if (!ParseInteger (fields[8], value) || value < 0 || value > INT32_MAX)
+            {
+              return "invalid trace id '" + fields[8] + "'";
+            }
+          record.traceId = value;
+        }
+      chunk.endDevices.push_back (record);
+      chunk.endDeviceLines.push_back (line);
+      return "";
+    }
+
+  return "unknown record type '" + type + "'";
+}
+
+/**
+ * Parse the lines of a part of the file, stopping at the first error.
+ */
+void
+ParseChunk (const char *begin, const char *end, ParsedChunk *chunk)
+{
+  std::vector<std::string> fields;
+  chunk->nLines = 0;
+  chunk->errorLine = 0;
+  const char *lineStart = begin;
+  while (lineStart < end)
+    {
+      const char *lineEnd = lineStart;
+      while (lineEnd < end && *lineEnd != '\n')
+        {
+          lineEnd++;
+        }
+      const char *last = lineEnd;
+      if (last > lineStart && *(last - 1) == '\r')
+        {
+          last--;
+        }
+      uint32_t line = chunk->nLines++;
+
+      const char *first = lineStart;
+      while (first < last && std::isspace (static_cast<unsigned char> (*first)))
+        {
+          first++;
+        }
+      if (first < last && *first != '#')
+        {
+          SplitFields (first, last, fields);
+          std::string error = ParseRecord (fields, line, *chunk);
+          if (!error.empty ())
+            {
+              chunk->errorLine = line;
+              chunk->error = error;
+              return;
+            }
+        }
+      lineStart = lineEnd + 1;
+    }
+}
+
+} // namespace
+
+LoraScenarioHelper::LoraScenarioHelper () :
+  m_nThreads (std::max (1u, std::thread::hardware_concurrency ()))
+{
+}
+
+LoraScenarioHelper::~LoraScenarioHelper ()
+{
+}
+
+void
+LoraScenarioHelper::SetParsingThreads (uint32_t nThreads)
+{
+  NS_ASSERT (nThreads > 0);
+  m_nThreads = nThreads;
+}
+
+void
+LoraScenarioHelper::Load (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::string error = TryLoad (filename);
+  NS_ABORT_MSG_UNLESS (error.empty (), error);
+}
+
+std::string
+LoraScenarioHelper::TryLoad (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  m_gateways.clear ();
+  m_endDevices.clear ();
+  m_traces.clear ();
+
+  std::ifstream file (filename.c_str (), std::ios::binary);
+  if (!file.is_open ())
+    {
+      return "Cannot open " + filename;
+    }
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  const std::string text = contents.str ();
+
+  // Split the file in chunks of whole lines, one per thread
+  uint32_t nChunks = std::max<uint32_t> (1, std::min<uint64_t> (m_nThreads,
+                                                                text.size () / 65536));
+  std::vector<const char *> bounds (1, text.data ());
+  for (uint32_t i = 1; i < nChunks; i++)
+    {
+      const char *bound = text.data () + text.size () * i / nChunks;
+      while (bound < text.data () + text.size () && *(bound - 1) != '\n')
+        {
+          bound++;
+        }
+      bounds.push_back (std::max (bound, bounds.back ()));
+    }
+  bounds.push_back (text.data () + text.size ());
+
+  std::vector<ParsedChunk> chunks (nChunks);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < nChunks; i++)
+    {
+      threads.push_back (std::thread (&ParseChunk, bounds[i], bounds[i + 1], &chunks[i]));
+    }
+  ParseChunk (bounds[0], bounds[1], &chunks[0]);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i].join ();
+    }
+
+  // Merge the chunks in the order of the file, reporting 1-based lines
+  std::ostringstream error;
+  std::vector<uint32_t> endDeviceLines;
+  uint32_t firstLine = 1;
+  for (uint32_t i = 0; i < nChunks && error.str ().empty (); i++)
+    {
+      const ParsedChunk &chunk = chunks[i];
+      if (!chunk.error.empty ())
+        {
+          error << filename << ":" << firstLine + chunk.errorLine << ": " << chunk.error;
+          break;
+        }
+      m_gateways.insert (m_gateways.end (), chunk.gateways.begin (), chunk.gateways.end ());
+      m_endDevices.insert (m_endDevices.end (), chunk.endDevices.begin (),
+                           chunk.endDevices.end ());
+      for (uint32_t j = 0; j < chunk.traces.size (); j++)
+        {
+          if (!m_traces.insert (chunk.traces[j]).second)
+            {
+              error << filename << ":" << firstLine + chunk.traceLines[j]
+                    << ": duplicate trace id " << chunk.traces[j].first;
+              break;
+            }
+        }
+      for (uint32_t j = 0; j < chunk.endDeviceLines.size (); j++)
+        {
+          endDeviceLines.push_back (firstLine + chunk.endDeviceLines[j]);
+        }
+      firstLine += chunk.nLines;
+    }
+
+  // Trace ids may be used before their definition
+  for (uint32_t i = 0; i < m_endDevices.size () && error.str ().empty (); i++)
+    {
+      int32_t traceId = m_endDevices[i].traceId;
+      if (traceId >= 0 && m_traces.find (traceId) == m_traces.end ())
+        {
+          error << filename << ":" << endDeviceLines[i] << ": undefined trace id " << traceId;
+        }
+      else if (traceId >= 0 && m_endDevices[i].capacitance == 0)
+        {
+          error << filename << ":" << endDeviceLines[i] << ": a harvester needs a capacitance";
+        }
+    }
+
+  if (!error.str ().empty ())
+    {
+      m_gateways.clear ();
+      m_endDevices.clear ();
+      m_traces.clear ();
+      return error.str ();
+    }
+
+  NS_LOG_INFO ("Loaded " << m_gateways.size () << " gateways, " << m_endDevices.size ()
+                         << " end devices and " << m_traces.size () << " traces from "
+                         << filename << " with " << nChunks << " threads");
+  return "";
+}
+
+uint32_t
+LoraScenarioHelper::GetNGateways (void) const
+{
+  return m_gateways.size ();
+}
+
+uint32_t
+LoraScenarioHelper::GetNEndDevices (void) const
+{
+  return m_endDevices.size ();
+}
+
+const LoraScenarioHelper::GatewayRecord &
+LoraScenarioHelper::GetGateway (uint32_t index) const
+{
+  return m_gateways.at (index);
+}
+
+const LoraScenarioHelper::EndDeviceRecord &
+LoraScenarioHelper::GetEndDevice (uint32_t index) const
+{
+  return m_endDevices.at (index);
+}
+
+std::string
+LoraScenarioHelper::GetTraceFilename (int32_t traceId) const
+{
+  std::map<int32_t, std::string>::const_iterator it = m_traces.find (traceId);
+  return it == m_traces.end () ? "" : it->second;
+}
+
+NodeContainer
+LoraScenarioHelper::InstallGateways (LoraHelper &helper, LoraPhyHelper &phyHelper,
+                                     LorawanMacHelper &macHelper) const
+{
+  NS_LOG_FUNCTION (this);
+
+  NodeContainer gateways;
+  gateways.Create (m_gateways.size ());
+
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < m_gateways.size (); i++)
+    {
+      allocator->Add (m_gateways[i].position);
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (allocator);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (gateways);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  return gateways;
+}
+
+NodeContainer
+LoraScenarioHelper::InstallEndDevices (LoraHelper &helper, LoraPhyHelper &phyHelper,
+                                       LorawanMacHelper &macHelper) const
+{
+  NS_LOG_FUNCTION (this);
+
+  NodeContainer endDevices;
+  endDevices.Create (m_endDevices.size ());
+
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < m_endDevices.size (); i++)
+    {
+      allocator->Add (m_endDevices[i].position);
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (allocator);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (endDevices);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  for (uint32_t i = 0; i < m_endDevices.size (); i++)
+    {
+      if (m_endDevices[i].sf != 0)
+        {
+          Ptr<LoraNetDevice> device = endDevices.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+          Ptr<EndDeviceLorawanMac> mac = device->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+          // In the EU868 region, DR0 is SF12 and DR5 is SF7
+          mac->SetDataRate (12 - m_endDevices[i].sf);
+        }
+    }
+
+  return endDevices;
+}
+
+ApplicationContainer
+LoraScenarioHelper::InstallApplications (NodeContainer endDevices,
+                                         PeriodicSenderHelper &appHelper) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (endDevices.GetN () == m_endDevices.size ());
+
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < m_endDevices.size (); i++)
+    {
+      const EndDeviceRecord &record = m_endDevices[i];
+      if (record.period == 0)
+        {
+          continue;
+        }
+      appHelper.SetPeriod (Seconds (record.period));
+      ApplicationContainer app = appHelper.Install (endDevices.Get (i));
+      if (record.packetSize != 0)
+        {
+          app.Get (0)->GetObject<PeriodicSender> ()->SetPacketSize (record.packetSize);
+        }
+      apps.Add (app);
+    }
+  return apps;
+}
+
+EnergySourceContainer
+LoraScenarioHelper::InstallEnergy (NodeContainer endDevices,
+                                   const CapacitorEnergySourceHelper &sourceHelper,
+                                   const LoraRadioEnergyModelHelper &radioHelper,
+                                   const VariableEnergyHarvesterHelper &harvesterHelper) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (endDevices.GetN () == m_endDevices.size ());
+
+  // Leave the helpers of the caller untouched
+  CapacitorEnergySourceHelper deviceSourceHelper = sourceHelper;
+  VariableEnergyHarvesterHelper deviceHarvesterHelper = harvesterHelper;
+  deviceHarvesterHelper.EnableGroups (true);
+
+  EnergySourceContainer sources;
+  for (uint32_t i = 0; i < m_endDevices.size (); i++)
+    {
+      const EndDeviceRecord &record = m_endDevices[i];
+      if (record.capacitance == 0)
+        {
+          continue;
+        }
+      Ptr<Node> node = endDevices.Get (i);
+      deviceSourceHelper.Set ("Capacitance", DoubleValue (record.capacitance));
+      EnergySourceContainer source = deviceSourceHelper.Install (node);
+      radioHelper.Install (node->GetDevice (0), source.Get (0));
+      if (record.traceId >= 0)
+        {
+          deviceHarvesterHelper.Set ("Filename", StringValue (m_traces.at (record.traceId)));
+          deviceHarvesterHelper.Install (source.Get (0));
+        }
+      sources.Add (source);
+    }
+  return sources;
+}
+
+} // namespace lorawan
+} // namespace ns3
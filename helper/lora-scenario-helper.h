@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#ifndef LORA_SCENARIO_HELPER_H
+#define LORA_SCENARIO_HELPER_H
+
+#include "ns3/lora-helper.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/capacitor-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/variable-energy-harvester-helper.h"
+#include "ns3/application-container.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/node-container.h"
+#include "ns3/vector.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Builds a deployment described by a scenario file.
+ *
+ * A scenario file is a CSV file with one record per line. Empty lines and
+ * lines starting with '#' are skipped. The first field gives the type of the
+ * record:
+ *
+ *     trace,<id>,<filename>
+ *     gw,<x>,<y>,<z>
+ *     ed,<x>,<y>,<z>,<sf>,<period>,<packet size>,<capacitance>,<trace id>
+ *
+ * A trace record names the input file of the VariableEnergyHarvester of the
+ * end devices referring to its id. For end devices, the position is in
+ * meters, the period in seconds and the capacitance in Farad. All the fields
+ * following the position may be left empty: an empty SF (or 0) leaves the
+ * data rate set by the MAC helper, an empty period (or 0) installs no
+ * application, an empty packet size keeps the one of the application helper,
+ * an empty capacitance installs no energy source and an empty trace id
+ * installs no harvester.
+ *
+ * Load parses the file in parallel and validates every record, stopping the
+ * program with the file and line of the first invalid one. The Install
+ * methods then create the nodes and their stack in bulk, in the order of the
+ * file, with the attributes set on the helpers they are given.
+ */
+class LoraScenarioHelper
+{
+public:
+  LoraScenarioHelper ();
+
+  ~LoraScenarioHelper ();
+
+  /**
+   * Set the number of threads parsing the scenario file. By default, one per
+   * hardware thread.
+   */
+  void SetParsingThreads (uint32_t nThreads);
+
+  /**
+   * Parse and validate a scenario file, replacing the records loaded before.
+   *
+   * \param filename The scenario file.
+   */
+  void Load (std::string filename);
+
+  /**
+   * Like Load, but return the error instead of stopping the program. No
+   * record is kept if the file is not valid.
+   *
+   * \param filename The scenario file.
+   * \return The file, line and description of the first error, or an empty
+   * string if the file is valid.
+   */
+  std::string TryLoad (std::string filename);
+
+  /**
+   * \return The number of gateways of the scenario.
+   */
+  uint32_t GetNGateways (void) const;
+
+  /**
+   * \return The number of end devices of the scenario.
+   */
+  uint32_t GetNEndDevices (void) const;
+
+  /**
+   * Create the gateways, at their positions, and install their LoraNetDevice.
+   *
+   * \return The gateways, in the order of the file.
+   */
+  NodeContainer InstallGateways (LoraHelper &helper, LoraPhyHelper &phyHelper,
+                                 LorawanMacHelper &macHelper) const;
+
+  /**
+   * Create the end devices, at their positions, install their LoraNetDevice
+   * with a class A MAC, and set the data rate of the ones with an SF.
+   *
+   * \return The end devices, in the order of the file.
+   */
+  NodeContainer InstallEndDevices (LoraHelper &helper, LoraPhyHelper &phyHelper,
+                                   LorawanMacHelper &macHelper) const;
+
+  /**
+   * Install a PeriodicSender with the period and packet size of its record on
+   * each end device with a period.
+   *
+   * \param endDevices The end devices returned by InstallEndDevices.
+   * \param appHelper The helper creating the applications.
+   */
+  ApplicationContainer InstallApplications (NodeContainer endDevices,
+                                            PeriodicSenderHelper &appHelper) const;
+
+  /**
+   * Install a CapacitorEnergySource with the capacitance of its record, and a
+   * LoraRadioEnergyModel, on each end device with a capacitance, and a
+   * VariableEnergyHarvester on the ones with a trace. Harvesters are put in
+   * groups, so that each trace is read and evaluated once.
+   *
+   * The capacitance, the trace and the grouping are set on copies of the
+   * helpers, whose other attributes apply to every device.
+   *
+   * \param endDevices The end devices returned by InstallEndDevices.
+   * \param sourceHelper The helper creating the energy sources.
+   * \param radioHelper The helper creating the radio energy models.
+   * \param harvesterHelper The helper creating the harvesters.
+   * \return The energy sources, in the order of the file.
+   */
+  EnergySourceContainer InstallEnergy (NodeContainer endDevices,
+                                       const CapacitorEnergySourceHelper &sourceHelper,
+                                       const LoraRadioEnergyModelHelper &radioHelper,
+                                       const VariableEnergyHarvesterHelper &harvesterHelper) const;
+
+  /**
+   * A gateway record.
+   */
+  struct GatewayRecord
+  {
+    Vector position;
+  };
+
+  /**
+   * An end device record.
+   */
+  struct EndDeviceRecord
+  {
+    Vector position;
+    uint8_t sf; //!< The SF, or 0 to leave the data rate of the MAC helper
+    double period; //!< The period of the application [s], or 0
+    uint8_t packetSize; //!< The size of the application packets [bytes], or 0
+    double capacitance; //!< The capacitance [F], or 0
+    int32_t traceId; //!< The id of the harvester trace, or -1
+  };
+
+  /**
+   * \return A gateway record, in the order of the file.
+   */
+  const GatewayRecord &GetGateway (uint32_t index) const;
+
+  /**
+   * \return An end device record, in the order of the file.
+   */
+  const EndDeviceRecord &GetEndDevice (uint32_t index) const;
+
+  /**
+   * \return The file of a harvester trace, or an empty string if the id is
+   * not defined.
+   */
+  std::string GetTraceFilename (int32_t traceId) const;
+
+private:
+  uint32_t m_nThreads; //!< The number of parsing threads
+  std::vector<GatewayRecord> m_gateways;
+  std::vector<EndDeviceRecord> m_endDevices;
+  std::map<int32_t, std::string> m_traces; //!< The trace files, by id
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_SCENARIO_HELPER_H */
@@ -22,6 +22,9 @@
 #include "ns3/gateway-lora-phy.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/lora-net-device.h"
+#include "ns3/class-b-end-device-lorawan-mac.h"
+#include "ns3/class-c-end-device-lorawan-mac.h"
+#include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/random-variable-stream.h"
 
@@ -30,6 +33,25 @@ namespace lorawan {
 
 NS_LOG_COMPONENT_DEFINE ("LorawanMacHelper");
 
+// The conversion tables of the EU and ALOHA regions. They never change, so
+// they are built once rather than once for every MAC the helper creates.
+// Channels and sub-bands are still created for each MAC, since they hold the
+// duty cycle and MAC command state of the device.
+static const std::vector<uint8_t> g_euSfForDataRate {12, 11, 10, 9, 8, 7, 7};
+static const std::vector<double> g_euBandwidthForDataRate
+  {125000, 125000, 125000, 125000, 125000, 125000, 250000};
+static const std::vector<uint32_t> g_euMaxAppPayloadForDataRate
+  {59, 59, 59, 123, 230, 230, 230, 230};
+static const std::vector<double> g_euTxDbmForTxPower {16, 14, 12, 10, 8, 6, 4, 2};
+static const LorawanMac::ReplyDataRateMatrix g_euReplyDataRateMatrix = {{{{0, 0, 0, 0, 0, 0}},
+                                                                         {{1, 0, 0, 0, 0, 0}},
+                                                                         {{2, 1, 0, 0, 0, 0}},
+                                                                         {{3, 2, 1, 0, 0, 0}},
+                                                                         {{4, 3, 2, 1, 0, 0}},
+                                                                         {{5, 4, 3, 2, 1, 0}},
+                                                                         {{6, 5, 4, 3, 2, 1}},
+                                                                         {{7, 6, 5, 4, 3, 2}}}};
+
 LorawanMacHelper::LorawanMacHelper () : m_region (LorawanMacHelper::EU)
 {
 }
@@ -52,10 +74,32 @@ LorawanMacHelper::SetDeviceType (enum DeviceType dt)
     case ED_A:
       m_mac.SetTypeId ("ns3::ClassAEndDeviceLorawanMac");
       break;
+    case ED_B:
+      m_mac.SetTypeId ("ns3::ClassBEndDeviceLorawanMac");
+      if (m_beacon == 0)
+        {
+          m_beacon = CreateObject<LorawanBeacon> ();
+        }
+      break;
+    case ED_C:
+      m_mac.SetTypeId ("ns3::ClassCEndDeviceLorawanMac");
+      break;
     }
   m_deviceType = dt;
 }
 
+void
+LorawanMacHelper::SetBeacon (Ptr<LorawanBeacon> beacon)
+{
+  m_beacon = beacon;
+}
+
+Ptr<LorawanBeacon>
+LorawanMacHelper::GetBeacon (void) const
+{
+  return m_beacon;
+}
+
 void
 LorawanMacHelper::SetAddressGenerator (Ptr<LoraDeviceAddressGenerator> addrGen)
 {
@@ -77,14 +121,27 @@ LorawanMacHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
   mac->SetDevice (device);
 
   // If we are operating on an end device, add an address to it
-  if (m_deviceType == ED_A && m_addrGen != 0)
+  if (m_deviceType != GW && m_addrGen != 0)
     {
       mac->GetObject<ClassAEndDeviceLorawanMac> ()->SetDeviceAddress (m_addrGen->NextAddress ());
     }
 
+  // Synchronize Class B devices to the shared beacon, and have Class C
+  // devices listen from the start of the simulation
+  if (m_deviceType == ED_B)
+    {
+      mac->GetObject<ClassBEndDeviceLorawanMac> ()->SetBeacon (m_beacon);
+      m_beacon->Start ();
+    }
+  else if (m_deviceType == ED_C)
+    {
+      Simulator::ScheduleNow (&ClassCEndDeviceLorawanMac::StartContinuousReception,
+                              mac->GetObject<ClassCEndDeviceLorawanMac> ());
+    }
+
   // Add a basic list of channels based on the region where the device is
   // operating
-  if (m_deviceType == ED_A)
+  if (m_deviceType != GW)
     {
       Ptr<ClassAEndDeviceLorawanMac> edMac = mac->GetObject<ClassAEndDeviceLorawanMac> ();
       switch (m_region)
@@ -141,20 +198,12 @@ LorawanMacHelper::ConfigureForAlohaRegion (Ptr<ClassAEndDeviceLorawanMac> edMac)
   /////////////////////////////////////////////////////
   // TxPower -> Transmission power in dBm conversion //
   /////////////////////////////////////////////////////
-  edMac->SetTxDbmForTxPower (std::vector<double>{16, 14, 12, 10, 8, 6, 4, 2});
+  edMac->SetTxDbmForTxPower (g_euTxDbmForTxPower);
 
   ////////////////////////////////////////////////////////////
   // Matrix to know which DataRate the GW will respond with //
   ////////////////////////////////////////////////////////////
-  LorawanMac::ReplyDataRateMatrix matrix = {{{{0, 0, 0, 0, 0, 0}},
-                                             {{1, 0, 0, 0, 0, 0}},
-                                             {{2, 1, 0, 0, 0, 0}},
-                                             {{3, 2, 1, 0, 0, 0}},
-                                             {{4, 3, 2, 1, 0, 0}},
-                                             {{5, 4, 3, 2, 1, 0}},
-                                             {{6, 5, 4, 3, 2, 1}},
-                                             {{7, 6, 5, 4, 3, 2}}}};
-  edMac->SetReplyDataRateMatrix (matrix);
+  edMac->SetReplyDataRateMatrix (g_euReplyDataRateMatrix);
 
   /////////////////////
   // Preamble length //
@@ -230,11 +279,9 @@ LorawanMacHelper::ApplyCommonAlohaConfigurations (Ptr<LorawanMac> lorawanMac) co
   // DataRate -> SF, DataRate -> Bandwidth     //
   // and DataRate -> MaxAppPayload conversions //
   ///////////////////////////////////////////////
-  lorawanMac->SetSfForDataRate (std::vector<uint8_t>{12, 11, 10, 9, 8, 7, 7});
-  lorawanMac->SetBandwidthForDataRate (
-      std::vector<double>{125000, 125000, 125000, 125000, 125000, 125000, 250000});
-  lorawanMac->SetMaxAppPayloadForDataRate (
-      std::vector<uint32_t>{59, 59, 59, 123, 230, 230, 230, 230});
+  lorawanMac->SetSfForDataRate (g_euSfForDataRate);
+  lorawanMac->SetBandwidthForDataRate (g_euBandwidthForDataRate);
+  lorawanMac->SetMaxAppPayloadForDataRate (g_euMaxAppPayloadForDataRate);
 }
 
 void
@@ -247,20 +294,12 @@ LorawanMacHelper::ConfigureForEuRegion (Ptr<ClassAEndDeviceLorawanMac> edMac) co
   /////////////////////////////////////////////////////
   // TxPower -> Transmission power in dBm conversion //
   /////////////////////////////////////////////////////
-  edMac->SetTxDbmForTxPower (std::vector<double>{16, 14, 12, 10, 8, 6, 4, 2});
+  edMac->SetTxDbmForTxPower (g_euTxDbmForTxPower);
 
   ////////////////////////////////////////////////////////////
   // Matrix to know which DataRate the GW will respond with //
   ////////////////////////////////////////////////////////////
-  LorawanMac::ReplyDataRateMatrix matrix = {{{{0, 0, 0, 0, 0, 0}},
-                                             {{1, 0, 0, 0, 0, 0}},
-                                             {{2, 1, 0, 0, 0, 0}},
-                                             {{3, 2, 1, 0, 0, 0}},
-                                             {{4, 3, 2, 1, 0, 0}},
-                                             {{5, 4, 3, 2, 1, 0}},
-                                             {{6, 5, 4, 3, 2, 1}},
-                                             {{7, 6, 5, 4, 3, 2}}}};
-  edMac->SetReplyDataRateMatrix (matrix);
+  edMac->SetReplyDataRateMatrix (g_euReplyDataRateMatrix);
 
   /////////////////////
   // Preamble length //
@@ -344,11 +383,9 @@ LorawanMacHelper::ApplyCommonEuConfigurations (Ptr<LorawanMac> lorawanMac) const
   // DataRate -> SF, DataRate -> Bandwidth     //
   // and DataRate -> MaxAppPayload conversions //
   ///////////////////////////////////////////////
-  lorawanMac->SetSfForDataRate (std::vector<uint8_t>{12, 11, 10, 9, 8, 7, 7});
-  lorawanMac->SetBandwidthForDataRate (
-      std::vector<double>{125000, 125000, 125000, 125000, 125000, 125000, 250000});
-  lorawanMac->SetMaxAppPayloadForDataRate (
-      std::vector<uint32_t>{59, 59, 59, 123, 230, 230, 230, 230});
+  lorawanMac->SetSfForDataRate (g_euSfForDataRate);
+  lorawanMac->SetBandwidthForDataRate (g_euBandwidthForDataRate);
+  lorawanMac->SetMaxAppPayloadForDataRate (g_euMaxAppPayloadForDataRate);
 }
 
 std::vector<int>
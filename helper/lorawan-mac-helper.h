@@ -26,6 +26,7 @@
 #include "ns3/lora-phy.h"
 #include "ns3/lorawan-mac.h"
 #include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/lorawan-beacon.h"
 #include "ns3/lora-device-address-generator.h"
 #include "ns3/gateway-lorawan-mac.h"
 #include "ns3/node-container.h"
@@ -38,9 +39,10 @@ class LorawanMacHelper
 {
 public:
   /**
-   * Define the kind of device. Can be either GW (Gateway) or ED (End Device).
+   * Define the kind of device. Can be either GW (Gateway) or ED (End Device)
+   * of Class A, B or C.
    */
-  enum DeviceType { GW, ED_A };
+  enum DeviceType { GW, ED_A, ED_B, ED_C };
 
   /**
    * Define the operational region.
@@ -78,6 +80,18 @@ public:
    */
   void SetRegion (enum Regions region);
 
+  /**
+   * Set the beacon the Class B devices created by this helper are
+   * synchronized to. If no beacon is set, one is created when the device
+   * type is set to ED_B.
+   */
+  void SetBeacon (Ptr<LorawanBeacon> beacon);
+
+  /**
+   * Get the beacon of the Class B devices created by this helper.
+   */
+  Ptr<LorawanBeacon> GetBeacon (void) const;
+
   /**
    * Create the LorawanMac instance and connect it to a device
    *
@@ -143,6 +157,7 @@ private:
   Ptr<LoraDeviceAddressGenerator> m_addrGen; //!< Pointer to the address generator to use
   enum DeviceType m_deviceType; //!< The kind of device to install
   enum Regions m_region; //!< The region in which the device will operate
+  Ptr<LorawanBeacon> m_beacon; //!< The beacon shared by the Class B devices
 };
 
 } // namespace lorawan
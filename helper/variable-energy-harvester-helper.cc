@@ -22,10 +22,15 @@
 
 #include "variable-energy-harvester-helper.h"
 #include "ns3/energy-harvester.h"
+#include "ns3/variable-energy-harvester.h"
+#include "ns3/string.h"
 
 namespace ns3 {
   
 VariableEnergyHarvesterHelper::VariableEnergyHarvesterHelper ()
+  : m_groupsEnabled (false),
+    m_powerScale (1),
+    m_timeShift (Seconds (0))
 {
   m_variableEnergyHarvester.SetTypeId ("ns3::VariableEnergyHarvester");
 }
@@ -40,6 +45,36 @@ VariableEnergyHarvesterHelper::Set (std::string name, const AttributeValue &v)
   m_variableEnergyHarvester.Set (name, v);
 }
 
+void
+VariableEnergyHarvesterHelper::EnableGroups (bool enable)
+{
+  m_groupsEnabled = enable;
+}
+
+void
+VariableEnergyHarvesterHelper::SetPowerScale (double scale)
+{
+  m_powerScale = scale;
+}
+
+void
+VariableEnergyHarvesterHelper::SetTimeShift (Time shift)
+{
+  m_timeShift = shift;
+}
+
+Ptr<VariableEnergyHarvesterGroup>
+VariableEnergyHarvesterHelper::GetGroup (std::string filename) const
+{
+  std::map<std::string, Ptr<VariableEnergyHarvesterGroup> >::const_iterator it =
+    m_groups.find (filename);
+  if (it == m_groups.end ())
+    {
+      return 0;
+    }
+  return it->second;
+}
+
 Ptr<EnergyHarvester>
 VariableEnergyHarvesterHelper::DoInstall (Ptr<EnergySource> source) const
 {
@@ -54,6 +89,25 @@ VariableEnergyHarvesterHelper::DoInstall (Ptr<EnergySource> source) const
   source->ConnectEnergyHarvester (harvester);
   harvester->SetNode (node);
   harvester->SetEnergySource (source);
+
+  if (m_groupsEnabled)
+    {
+      Ptr<VariableEnergyHarvester> variableHarvester =
+        harvester->GetObject<VariableEnergyHarvester> ();
+      std::string filename = variableHarvester->GetInputFile ();
+
+      Ptr<VariableEnergyHarvesterGroup> group = GetGroup (filename);
+      if (group == 0)
+        {
+          group = CreateObject<VariableEnergyHarvesterGroup> ();
+          group->SetInputFile (filename);
+          // The group updates its members at their own interval
+          group->SetUpdateInterval (variableHarvester->GetHarvestedPowerUpdateInterval ());
+          m_groups[filename] = group;
+        }
+      group->AddHarvester (variableHarvester, m_powerScale, m_timeShift);
+    }
+
   return harvester;
 }
   
@@ -26,6 +26,8 @@
 #include "ns3/energy-harvester-helper.h"
 #include "ns3/energy-source.h"
 #include "ns3/node.h"
+#include "ns3/variable-energy-harvester-group.h"
+#include <map>
 
 namespace ns3 {
   
@@ -41,12 +43,44 @@ public:
 
   void Set (std::string name, const AttributeValue &v);
 
+  /**
+   * Whether to drive the installed harvesters through groups. If enabled,
+   * harvesters using the same input trace are put in the same
+   * VariableEnergyHarvesterGroup, which evaluates the trace once per step
+   * and only notifies the harvesters whose power changed.
+   */
+  void EnableGroups (bool enable);
+
+  /**
+   * Set the factor multiplying the power of the trace for the harvesters
+   * installed from now on (e.g., to scale with the panel area). Only used
+   * when groups are enabled.
+   */
+  void SetPowerScale (double scale);
+
+  /**
+   * Set the time shift applied to the trace for the harvesters installed from
+   * now on. Only used when groups are enabled.
+   */
+  void SetTimeShift (Time shift);
+
+  /**
+   * \returns The group of the harvesters using the given input trace, or 0 if
+   * no such group was created.
+   */
+  Ptr<VariableEnergyHarvesterGroup> GetGroup (std::string filename) const;
+
 private:
   virtual Ptr<EnergyHarvester> DoInstall (Ptr<EnergySource> source) const;
 
 private:
   ObjectFactory m_variableEnergyHarvester;
 
+  bool m_groupsEnabled;
+  double m_powerScale;
+  Time m_timeShift;
+  mutable std::map<std::string, Ptr<VariableEnergyHarvesterGroup> > m_groups;
+
 };
   
 } // namespace ns3
@@ -95,15 +95,8 @@ AdrComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-
   //Execute the ADR algotithm only if the request bit is set
-  if (fHdr.GetAdr ())
+  if (status->GetLastFrameInfo ().GetAdr ())
     {
       if (int(status->GetReceivedPacketList ().size ()) < historyRange)
         {
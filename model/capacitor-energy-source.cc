@@ -20,7 +20,10 @@
  */
 
 #include "ns3/capacitor-energy-source.h"
+#include "ns3/capacitor-fleet-energy-manager.h"
 #include "ns3/lora-radio-energy-model.h"
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/variable-energy-harvester.h"
 #include "ns3/abort.h"
 #include "ns3/device-energy-model.h"
@@ -32,6 +35,7 @@
 #include "ns3/object-base.h"
 #include "ns3/packet.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
@@ -92,6 +96,32 @@ CapacitorEnergySource::GetTypeId (void)
                          "Name of the output file where to save voltage values", StringValue (),
                          MakeStringAccessor (&CapacitorEnergySource::m_filenameVoltageTracking),
                          MakeStringChecker ())
+          .AddAttribute ("ChargeTimeHistogramBinWidth",
+                         "Width of the bins of the histogram of the times from a depletion "
+                         "to the following recharge",
+                         TimeValue (Seconds (60)),
+                         MakeTimeAccessor (&CapacitorEnergySource::SetChargeTimeHistogramBinWidth,
+                                           &CapacitorEnergySource::GetChargeTimeHistogramBinWidth),
+                         MakeTimeChecker (TimeStep (1)))
+          .AddAttribute ("ChargeTimeHistogramBins",
+                         "Number of bins of the histogram of the times from a depletion to the "
+                         "following recharge, the last one counting all the longer times",
+                         UintegerValue (60),
+                         MakeUintegerAccessor (&CapacitorEnergySource::SetChargeTimeHistogramBins,
+                                               &CapacitorEnergySource::GetChargeTimeHistogramBins),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("DepletionCount",
+                         "Number of times the voltage went under the low threshold",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&CapacitorEnergySource::GetDepletionCount),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("RechargeCount",
+                         "Number of times the voltage went back over the high threshold",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&CapacitorEnergySource::GetRechargeCount),
+                         MakeUintegerChecker<uint32_t> ())
           .AddTraceSource ("RemainingEnergy", "Remaining energy at CapacitorEnergySource.",
                            MakeTraceSourceAccessor (&CapacitorEnergySource::m_remainingEnergyJ),
                            "ns3::TracedValueCallback::Double")
@@ -107,6 +137,11 @@ CapacitorEnergySource::CapacitorEnergySource ()
   ObjectBase::ConstructSelf(AttributeConstructionList ());
   m_lastUpdateTime = Seconds (0.0);
   m_depleted = false;
+  m_fleetManager = 0;
+  m_fleetIndex = 0;
+  m_nextThresholdId = 1;
+  m_depletionCount = 0;
+  m_rechargeCount = 0;
   SetInitialVoltage();
 }
 
@@ -252,8 +287,18 @@ void
 CapacitorEnergySource::UpdateEnergySource (void)
 {
   NS_LOG_FUNCTION (this);
+  LORAWAN_PROFILE (CAPACITOR_UPDATE);
   // NS_LOG_DEBUG ("CapacitorEnergySource: Updating remaining voltage. Depleted? " << m_depleted);
 
+    // If a fleet manager advanced this source since our last update, start
+    // from its value
+    if (m_fleetManager != 0 &&
+        m_fleetManager->GetLastUpdateTime (m_fleetIndex) > m_lastUpdateTime)
+      {
+        m_actualVoltageV = m_fleetManager->GetVoltage (m_fleetIndex);
+        m_lastUpdateTime = m_fleetManager->GetLastUpdateTime (m_fleetIndex);
+      }
+
     double oldVoltage = m_actualVoltageV;
     UpdateVoltage ();
 
@@ -266,12 +311,16 @@ CapacitorEnergySource::UpdateEnergySource (void)
         {
           NS_LOG_DEBUG ("Energy depleted");
           m_depleted = true;
+          m_depletionCount++;
+          m_depletionTime = Simulator::Now ();
           HandleEnergyDrainedEvent ();
         }
       else if (m_depleted && m_actualVoltageV > m_highVoltageTh * m_supplyVoltageV)
         {
           NS_LOG_DEBUG ("Energy recharged");
           m_depleted = false;
+          m_rechargeCount++;
+          m_chargeTimes.Add (Simulator::Now () - m_depletionTime);
           HandleEnergyRechargedEvent ();
         }
       else if (m_actualVoltageV != oldVoltage)
@@ -285,13 +334,19 @@ CapacitorEnergySource::UpdateEnergySource (void)
           HandleEnergyConstantEvent ();
         }
 
-    if (m_voltageUpdateEvent.IsExpired ())
+    // Periodic updates are taken care of by the fleet manager, if any
+    if (m_fleetManager == 0 && m_voltageUpdateEvent.IsExpired ())
       {
         m_voltageUpdateEvent = Simulator::Schedule (m_updateInterval,
                                                   &CapacitorEnergySource::UpdateEnergySource,
                                                  this);
     }
 
+    StoreInFleet ();
+
+    // The harvested power may have changed
+    ScheduleThresholdCrossing ();
+
     // Track the value (also if it did not change)
     TrackVoltage();
 
@@ -335,13 +390,27 @@ void
 CapacitorEnergySource::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  // Harvesters are not aggregated to the node, so nobody else disposes them,
+  // and those driven by a group hold a reference cycle with it
+  for (uint32_t i = 0; i < m_harvesters.size (); i++)
+    {
+      m_harvesters[i]->Dispose ();
+    }
   BreakDeviceEnergyModelRefCycle ();  // break reference cycle
+  m_fleetManager = 0;
+  m_thresholdEvent.Cancel ();
+  m_thresholds.clear ();
 }
 
 void
 CapacitorEnergySource::HandleEnergyDrainedEvent (void)
 {
   NS_LOG_FUNCTION (this);
+  if (lorawan::LoraFlightRecorder::IsEnabled ())
+    {
+      lorawan::LoraFlightRecorder::RecordEnergyDepleted (GetNode () ? GetNode ()->GetId () : 0,
+                                                         m_actualVoltageV);
+    }
   NotifyEnergyDrained (); // notify DeviceEnergyModel objects
 }
 
@@ -349,6 +418,11 @@ void
 CapacitorEnergySource::HandleEnergyRechargedEvent (void)
 {
   NS_LOG_FUNCTION (this);
+  if (lorawan::LoraFlightRecorder::IsEnabled ())
+    {
+      lorawan::LoraFlightRecorder::RecordEnergyRecharged (GetNode () ? GetNode ()->GetId () : 0,
+                                                          m_actualVoltageV);
+    }
   NotifyEnergyRecharged (); // notify DeviceEnergyModel objects
 }
 
@@ -409,6 +483,23 @@ double CapacitorEnergySource::ComputeVoltage (double initialVoltage, double Iloa
   return voltage;
   }
 
+double
+CapacitorEnergySource::ComputeRcVoltage (double initialVoltage, double Iload, double hp,
+                                         double supplyVoltage, double capacitance,
+                                         double durationS)
+{
+  // 1/Req = 1/Rload + 1/ri, with Rload = V/Iload and ri = V^2/hp
+  double g = Iload / supplyVoltage + hp / (supplyVoltage * supplyVoltage);
+  if (g <= 0)
+    {
+      // No load and no harvester: the voltage does not change
+      return initialVoltage;
+    }
+  // Asymptotic voltage, V*Req/ri
+  double vInf = hp / (supplyVoltage * g);
+  return vInf + (initialVoltage - vInf) * std::exp (-durationS * g / capacitance);
+}
+
   double
   CapacitorEnergySource::ComputeInitialVoltage (double finalVoltage,
                                                 double Iload, double hp,
@@ -518,6 +609,13 @@ void
 CapacitorEnergySource::SetCheckForEnergyDepletion (void)
 {
   NS_LOG_FUNCTION(this);
+  // Start from the present voltage, also if a fleet manager advanced this
+  // source in the meantime. The PHY already did this before most transitions.
+  if (Simulator::Now () != m_lastUpdateTime)
+    {
+      UpdateEnergySource ();
+    }
+
   double vmin = m_lowVoltageTh *m_supplyVoltageV;
   double Iload = CalculateDevicesCurrent();
   double ph = GetHarvestersPower ();
@@ -565,6 +663,169 @@ CapacitorEnergySource::SetCheckForEnergyDepletion (void)
       m_checkForEnergyDepletion =
           Simulator::Schedule (Seconds (t), &CapacitorEnergySource::UpdateEnergySource, this);
     }
+
+  // The load may have changed: let the fleet manager know
+  StoreInFleet ();
+
+  ScheduleThresholdCrossing ();
+}
+
+uint32_t
+CapacitorEnergySource::SubscribeVoltageThreshold (double voltage, bool rising,
+                                                  ThresholdCallback callback)
+{
+  NS_LOG_FUNCTION (this << voltage << rising);
+
+  ThresholdSubscription subscription;
+  subscription.id = m_nextThresholdId++;
+  subscription.voltage = voltage;
+  subscription.rising = rising;
+  subscription.energy = false;
+  subscription.callback = callback;
+  m_thresholds.push_back (subscription);
+
+  ScheduleThresholdCrossing ();
+  return subscription.id;
+}
+
+uint32_t
+CapacitorEnergySource::SubscribeEnergyThreshold (double energy, bool rising,
+                                                 ThresholdCallback callback)
+{
+  NS_LOG_FUNCTION (this << energy << rising);
+
+  // E = C V^2 / 2
+  uint32_t id = SubscribeVoltageThreshold (std::sqrt (2 * energy / m_capacitance), rising,
+                                           callback);
+  m_thresholds.back ().energy = true;
+  return id;
+}
+
+void
+CapacitorEnergySource::UnsubscribeThreshold (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+
+  std::vector<ThresholdSubscription>::iterator it;
+  for (it = m_thresholds.begin (); it != m_thresholds.end (); ++it)
+    {
+      if (it->id == id)
+        {
+          m_thresholds.erase (it);
+          ScheduleThresholdCrossing ();
+          return;
+        }
+    }
+}
+
+void
+CapacitorEnergySource::ScheduleThresholdCrossing (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_thresholds.empty ())
+    {
+      m_thresholdEvent.Cancel ();
+      return;
+    }
+
+  // Solve from the present voltage, also if a fleet manager advanced this
+  // source in the meantime. The update calls this method again.
+  if (Simulator::Now () != m_lastUpdateTime)
+    {
+      UpdateEnergySource ();
+      return;
+    }
+
+  // Same RC model as ComputeRcVoltage, starting from now:
+  // v(t) = vInf + (v0 - vInf) exp (-t g / C)
+  double Iload = CalculateDevicesCurrent ();
+  double hp = GetHarvestersPower ();
+  double g = Iload / m_supplyVoltageV + hp / (m_supplyVoltageV * m_supplyVoltageV);
+  double v0 = m_actualVoltageV;
+  double eps = 1e-9;
+
+  double earliest = -1; // [s] from now, negative if never
+  std::vector<ThresholdSubscription>::const_iterator it;
+  for (it = m_thresholds.begin (); it != m_thresholds.end (); ++it)
+    {
+      double t = 0;
+      if ((it->rising && v0 < it->voltage - eps) || (!it->rising && v0 > it->voltage + eps))
+        {
+          if (g <= 0)
+            {
+              continue; // The voltage does not change
+            }
+          double vInf = hp / (m_supplyVoltageV * g);
+          double ratio = (it->voltage - vInf) / (v0 - vInf);
+          if (ratio <= 0 || ratio >= 1)
+            {
+              continue; // The voltage tends to a value before the threshold
+            }
+          t = -std::log (ratio) * m_capacitance / g;
+        }
+      if (earliest < 0 || t < earliest)
+        {
+          earliest = t;
+        }
+    }
+
+  if (earliest < 0)
+    {
+      NS_LOG_DEBUG ("No threshold will be crossed with the present load");
+      m_thresholdEvent.Cancel ();
+      return;
+    }
+
+  // Round up, so that the threshold is crossed when the event runs
+  Time crossing = Simulator::Now () + NanoSeconds (std::ceil (earliest * 1e9));
+  if (m_thresholdEvent.IsRunning () && crossing == m_thresholdTime)
+    {
+      return;
+    }
+
+  NS_LOG_DEBUG ("Next threshold crossing at " << crossing.GetSeconds () << " s");
+  m_thresholdEvent.Cancel ();
+  m_thresholdTime = crossing;
+  m_thresholdEvent = Simulator::Schedule (crossing - Simulator::Now (),
+                                          &CapacitorEnergySource::NotifyThresholdCrossings,
+                                          this);
+}
+
+void
+CapacitorEnergySource::NotifyThresholdCrossings (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  double voltage = GetActualVoltage ();
+  m_thresholdEvent.Cancel ();
+
+  // Take the crossed subscriptions out first, since the callbacks may
+  // subscribe again
+  double eps = 1e-9;
+  std::vector<ThresholdSubscription> crossed;
+  std::vector<ThresholdSubscription>::iterator it = m_thresholds.begin ();
+  while (it != m_thresholds.end ())
+    {
+      if ((it->rising && voltage >= it->voltage - eps)
+          || (!it->rising && voltage <= it->voltage + eps))
+        {
+          crossed.push_back (*it);
+          it = m_thresholds.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+  for (it = crossed.begin (); it != crossed.end (); ++it)
+    {
+      NS_LOG_DEBUG ("Threshold " << it->voltage << " V crossed");
+      it->callback (it->energy ? GetEnergyFromVoltage (voltage) : voltage);
+    }
+
+  ScheduleThresholdCrossing ();
 }
 
 double
@@ -604,19 +865,21 @@ CapacitorEnergySource::GetAveragePower (Time time, double samples)
   NS_LOG_FUNCTION (this);
 
   double avgPower = 0.0;
-  // Assume single harvester
-  Ptr<EnergyHarvester> eh = m_harvesters.at(0);
-  NS_LOG_DEBUG ("is not EH " << (eh == 0));
-  if (!(eh == 0))
+  std::vector<Ptr<EnergyHarvester>>::const_iterator harvester;
+  for (harvester = m_harvesters.begin (); harvester != m_harvesters.end (); harvester++)
     {
-      Ptr<VariableEnergyHarvester> variableEH = eh ->GetObject<VariableEnergyHarvester> ();
-      NS_LOG_DEBUG ((variableEH == 0));
-      avgPower = variableEH-> GetAveragePower (time, samples);
+      Ptr<VariableEnergyHarvester> variableEH =
+          (*harvester)->GetObject<VariableEnergyHarvester> ();
+      if (variableEH != 0)
+        {
+          avgPower += variableEH->GetAveragePower (time, samples);
+        }
+      else
+        {
+          // No forecast available: assume the current power
+          avgPower += (*harvester)->GetPower ();
+        }
     }
-  // else
-  //   {
-  //     avgPower = eh-> GetPower();
-  //   }
   return avgPower;
 
 }
@@ -648,4 +911,90 @@ CapacitorEnergySource::GetEnergyHarvesters (void)
   return m_harvesters; 
 }
 
+double
+CapacitorEnergySource::GetCapacitance (void) const
+{
+  return m_capacitance;
+}
+
+double
+CapacitorEnergySource::GetLowVoltageThreshold (void) const
+{
+  return m_lowVoltageTh;
+}
+
+double
+CapacitorEnergySource::GetHighVoltageThreshold (void) const
+{
+  return m_highVoltageTh;
+}
+
+void
+CapacitorEnergySource::SetFleetManager (Ptr<CapacitorFleetEnergyManager> manager,
+                                        uint32_t index)
+{
+  NS_LOG_FUNCTION (this << manager << index);
+  m_fleetManager = manager;
+  m_fleetIndex = index;
+
+  // From now on, the periodic update is done by the manager
+  m_voltageUpdateEvent.Cancel ();
+  StoreInFleet ();
+}
+
+void
+CapacitorEnergySource::StoreInFleet (void)
+{
+  if (m_fleetManager == 0)
+    {
+      return;
+    }
+  m_fleetManager->Store (m_fleetIndex, m_actualVoltageV, m_lastUpdateTime,
+                         CalculateDevicesCurrent (), GetHarvestersPower (), m_depleted);
+}
+
+uint32_t
+CapacitorEnergySource::GetDepletionCount (void) const
+{
+  return m_depletionCount;
+}
+
+uint32_t
+CapacitorEnergySource::GetRechargeCount (void) const
+{
+  return m_rechargeCount;
+}
+
+const lorawan::DurationHistogram &
+CapacitorEnergySource::GetChargeTimeHistogram (void) const
+{
+  return m_chargeTimes;
+}
+
+void
+CapacitorEnergySource::SetChargeTimeHistogramBinWidth (Time binWidth)
+{
+  NS_LOG_FUNCTION (this << binWidth);
+  m_chargeTimes.SetBins (binWidth, m_chargeTimes.GetNBins ());
+}
+
+Time
+CapacitorEnergySource::GetChargeTimeHistogramBinWidth (void) const
+{
+  return m_chargeTimes.GetBinWidth ();
+}
+
+void
+CapacitorEnergySource::SetChargeTimeHistogramBins (uint32_t nBins)
+{
+  NS_LOG_FUNCTION (this << nBins);
+  m_chargeTimes.SetBins (m_chargeTimes.GetBinWidth (), nBins);
+}
+
+uint32_t
+CapacitorEnergySource::GetChargeTimeHistogramBins (void) const
+{
+  return m_chargeTimes.GetNBins ();
+}
+
 } // namespace ns3
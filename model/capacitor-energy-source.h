@@ -26,13 +26,17 @@
 #include "ns3/traced-value.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/callback.h"
 #include "ns3/energy-source.h"
 #include "ns3/end-device-lora-phy.h"
+#include "ns3/duration-histogram.h"
 #include <bits/stdint-intn.h>
 #include <vector>
 
 namespace ns3 {
 
+class CapacitorFleetEnergyManager;
+
 /**
  * \ingroup energy
  * BasicEnergySource decreases/increases remaining energy stored in itself
@@ -130,6 +134,22 @@ public:
    */
   double ComputeVoltage (double initialVoltage, double Iload, double harvestedPower,
                          Time duration);
+  /**
+   * Closed-form voltage of the capacitor after a given duration, starting from
+   * initialVoltage with constant load current and harvested power. Same model
+   * as ComputeVoltage, without any allocation or access to the source state.
+   *
+   * \param initialVoltage The voltage at the beginning of the interval [V]
+   * \param Iload The current drawn by the load [A]
+   * \param hp The power provided by the harvesters [W]
+   * \param supplyVoltage The max supply voltage of the capacitor [V]
+   * \param capacitance The capacitance [F]
+   * \param durationS The duration of the interval [s]
+   * \return The voltage at the end of the interval [V]
+   */
+  static double ComputeRcVoltage (double initialVoltage, double Iload, double hp,
+                                  double supplyVoltage, double capacitance,
+                                  double durationS);
   /**
    * Compute the initial voltage given Iload and time duration when ending in final voltage
    */
@@ -170,7 +190,119 @@ public:
   double GetEnergyFromVoltage (double voltage);
 
   std::vector<Ptr<EnergyHarvester>> GetEnergyHarvesters(void);
+
+  /**
+   * \returns The capacitance of the capacitor [F]
+   */
+  double GetCapacitance (void) const;
+
+  /**
+   * \returns The low voltage threshold, as a fraction of the max supply voltage
+   */
+  double GetLowVoltageThreshold (void) const;
+
+  /**
+   * \returns The high voltage threshold, as a fraction of the max supply voltage
+   */
+  double GetHighVoltageThreshold (void) const;
+
+  /**
+   * Let a CapacitorFleetEnergyManager take care of the periodic updates of
+   * this source. Called by CapacitorFleetEnergyManager::AddSource.
+   *
+   * \param manager The fleet manager
+   * \param index The slot of this source in the manager
+   */
+  void SetFleetManager (Ptr<CapacitorFleetEnergyManager> manager, uint32_t index);
+
+  /**
+   * Callback invoked when a watched threshold is crossed, with the voltage
+   * [V] or the energy [J] of the capacitor at that time.
+   */
+  typedef Callback<void, double> ThresholdCallback;
+
+  /**
+   * Ask to be notified, once, when the voltage of the capacitor crosses the
+   * given value. The crossing time is solved in closed form from the present
+   * load and harvested power, and solved again whenever they change, so that
+   * a single event is pending for all the subscriptions to this source. If
+   * the voltage is already beyond the value, the callback is invoked as soon
+   * as possible.
+   *
+   * \param voltage The voltage to watch [V]
+   * \param rising Whether to wait for the voltage to rise above the value,
+   * rather than to fall below it
+   * \param callback The callback to invoke, with the voltage
+   * \return The identifier of the subscription, for UnsubscribeThreshold
+   */
+  uint32_t SubscribeVoltageThreshold (double voltage, bool rising, ThresholdCallback callback);
+
+  /**
+   * Like SubscribeVoltageThreshold, for the energy stored in the capacitor.
+   *
+   * \param energy The energy to watch [J]
+   * \param rising Whether to wait for the energy to rise above the value,
+   * rather than to fall below it
+   * \param callback The callback to invoke, with the energy
+   * \return The identifier of the subscription, for UnsubscribeThreshold
+   */
+  uint32_t SubscribeEnergyThreshold (double energy, bool rising, ThresholdCallback callback);
+
+  /**
+   * Cancel a subscription that was not notified yet.
+   *
+   * \param id The identifier returned when subscribing
+   */
+  void UnsubscribeThreshold (uint32_t id);
+
+  /**
+   * \returns The number of times the voltage went under the low threshold
+   */
+  uint32_t GetDepletionCount (void) const;
+
+  /**
+   * \returns The number of times the voltage went back over the high
+   * threshold after a depletion
+   */
+  uint32_t GetRechargeCount (void) const;
+
+  /**
+   * \returns The histogram of the times from a depletion to the following
+   * recharge
+   */
+  const lorawan::DurationHistogram &GetChargeTimeHistogram (void) const;
+
+  void SetChargeTimeHistogramBinWidth (Time binWidth);
+  Time GetChargeTimeHistogramBinWidth (void) const;
+
+  void SetChargeTimeHistogramBins (uint32_t nBins);
+  uint32_t GetChargeTimeHistogramBins (void) const;
+
 private:
+  /**
+   * A threshold watched by SubscribeVoltageThreshold or
+   * SubscribeEnergyThreshold.
+   */
+  struct ThresholdSubscription
+  {
+    uint32_t id;
+    double voltage; // the threshold, as a voltage [V]
+    bool rising; // whether the voltage must rise above the threshold
+    bool energy; // whether to pass the energy, rather than the voltage
+    ThresholdCallback callback;
+  };
+
+  /**
+   * Solve for the first time a watched threshold is crossed, and schedule
+   * NotifyThresholdCrossings at that time.
+   */
+  void ScheduleThresholdCrossing (void);
+
+  /**
+   * Notify the subscriptions whose threshold was crossed.
+   */
+  void NotifyThresholdCrossings (void);
+
   /// Defined in ns3::Object
   void DoInitialize (void);
 
@@ -216,6 +348,13 @@ private:
    */
   void TrackVoltage (void);
 
+  /**
+   * Save the present operating point in the slot of the fleet manager, if
+   * this source is managed by one. The source must be up to date, since the
+   * slot is overwritten with its voltage and time of the last update.
+   */
+  void StoreInFleet (void);
+
 private:
   Ptr<RandomVariableStream> m_initialVoltageRV; // random variable for the initial voltage, in Volt
   double m_initialVoltageV; // initial voltage, in Volts
@@ -233,6 +372,19 @@ private:
   Time m_updateInterval; // voltage update interval
 
   std::string m_filenameVoltageTracking; // name of the output file w/ voltage values
+
+  Ptr<CapacitorFleetEnergyManager> m_fleetManager; // fleet manager, if any
+  uint32_t m_fleetIndex; // slot of this source in the fleet manager
+
+  std::vector<ThresholdSubscription> m_thresholds; // the watched thresholds
+  uint32_t m_nextThresholdId; // identifier of the next subscription
+  EventId m_thresholdEvent; // the next threshold crossing
+  Time m_thresholdTime; // the time of the next threshold crossing
+
+  uint32_t m_depletionCount; // depletions so far
+  uint32_t m_rechargeCount; // recharges so far
+  Time m_depletionTime; // the time of the last depletion
+  lorawan::DurationHistogram m_chargeTimes; // times from depletion to recharge
 };
 
 } // namespace ns3
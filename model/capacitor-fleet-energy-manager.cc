@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/capacitor-fleet-energy-manager.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CapacitorFleetEnergyManager");
+
+NS_OBJECT_ENSURE_REGISTERED (CapacitorFleetEnergyManager);
+
+TypeId
+CapacitorFleetEnergyManager::GetTypeId (void)
+{
+  static TypeId tid =
+      TypeId ("ns3::CapacitorFleetEnergyManager")
+          .SetParent<Object> ()
+          .SetGroupName ("Energy")
+          .AddConstructor<CapacitorFleetEnergyManager> ()
+          .AddAttribute ("UpdateInterval",
+                         "Time between two consecutive updates of all the managed sources.",
+                         TimeValue (Seconds (1.0)),
+                         MakeTimeAccessor (&CapacitorFleetEnergyManager::SetUpdateInterval,
+                                           &CapacitorFleetEnergyManager::GetUpdateInterval),
+                         MakeTimeChecker ());
+  return tid;
+}
+
+CapacitorFleetEnergyManager::CapacitorFleetEnergyManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CapacitorFleetEnergyManager::~CapacitorFleetEnergyManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+CapacitorFleetEnergyManager::AddSource (Ptr<CapacitorEnergySource> source)
+{
+  NS_LOG_FUNCTION (this << source);
+  NS_ASSERT (source != 0);
+
+  uint32_t index = m_sources.size ();
+  double supplyVoltage = source->GetSupplyVoltage ();
+
+  m_sources.push_back (source);
+  m_voltage.push_back (source->GetInitialVoltage ());
+  m_capacitance.push_back (source->GetCapacitance ());
+  m_supplyVoltage.push_back (supplyVoltage);
+  m_loadCurrent.push_back (0);
+  m_harvestedPower.push_back (0);
+  m_lowVoltage.push_back (source->GetLowVoltageThreshold () * supplyVoltage);
+  m_highVoltage.push_back (source->GetHighVoltageThreshold () * supplyVoltage);
+  m_lastUpdate.push_back (Simulator::Now ());
+  m_depleted.push_back (0);
+
+  source->SetFleetManager (this, index);
+
+  // Start the periodic update at the first registration
+  if (m_updateEvent.IsExpired ())
+    {
+      m_updateEvent = Simulator::Schedule (m_updateInterval,
+                                           &CapacitorFleetEnergyManager::UpdateFleet, this);
+    }
+
+  NS_LOG_DEBUG ("Added source " << source << " in slot " << index);
+  return index;
+}
+
+uint32_t
+CapacitorFleetEnergyManager::GetNSources (void) const
+{
+  return m_sources.size ();
+}
+
+void
+CapacitorFleetEnergyManager::Store (uint32_t index, double voltage, Time lastUpdate,
+                                    double loadCurrent, double harvestedPower, bool depleted)
+{
+  NS_LOG_FUNCTION (this << index << voltage << lastUpdate << loadCurrent << harvestedPower);
+  NS_ASSERT (index < m_sources.size ());
+
+  m_voltage[index] = voltage;
+  m_lastUpdate[index] = lastUpdate;
+  m_loadCurrent[index] = loadCurrent;
+  m_harvestedPower[index] = harvestedPower;
+  m_depleted[index] = depleted;
+}
+
+double
+CapacitorFleetEnergyManager::GetVoltage (uint32_t index) const
+{
+  NS_ASSERT (index < m_sources.size ());
+  return m_voltage[index];
+}
+
+Time
+CapacitorFleetEnergyManager::GetLastUpdateTime (uint32_t index) const
+{
+  NS_ASSERT (index < m_sources.size ());
+  return m_lastUpdate[index];
+}
+
+void
+CapacitorFleetEnergyManager::SetUpdateInterval (Time interval)
+{
+  NS_LOG_FUNCTION (this << interval);
+  m_updateInterval = interval;
+}
+
+Time
+CapacitorFleetEnergyManager::GetUpdateInterval (void) const
+{
+  return m_updateInterval;
+}
+
+void
+CapacitorFleetEnergyManager::UpdateFleet (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  AdvanceSlots (Simulator::Now ());
+
+  // Only sources that crossed a threshold need to take action: let them run
+  // their own update, which will find the new voltage in the slot and notify
+  // the device energy models.
+  for (std::vector<uint32_t>::const_iterator it = m_crossed.begin ();
+       it != m_crossed.end (); ++it)
+    {
+      NS_LOG_DEBUG ("Source in slot " << *it << " crossed a threshold, V = "
+                    << m_voltage[*it]);
+      m_sources[*it]->UpdateEnergySource ();
+    }
+
+  m_updateEvent = Simulator::Schedule (m_updateInterval,
+                                       &CapacitorFleetEnergyManager::UpdateFleet, this);
+}
+
+void
+CapacitorFleetEnergyManager::AdvanceSlots (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+
+  m_crossed.clear ();
+
+  double eps = 1e-9;
+  uint32_t n = m_sources.size ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double duration = (now - m_lastUpdate[i]).GetSeconds ();
+      double vs = m_supplyVoltage[i];
+      // Equivalent conductance of the load and of the harvester internal
+      // resistance ri = vs^2 / ph, i.e., 1/Req in CapacitorEnergySource
+      double g = m_loadCurrent[i] / vs + m_harvestedPower[i] / (vs * vs);
+      if (g > 0)
+        {
+          // Steady state voltage, vs * Req / ri
+          double vInf = m_harvestedPower[i] / (vs * g);
+          double decay = std::exp (-duration * g / m_capacitance[i]);
+          m_voltage[i] = vInf + (m_voltage[i] - vInf) * decay;
+        }
+      // else: no load and no harvester, the voltage stays the same
+      m_lastUpdate[i] = now;
+
+      bool depletion = !m_depleted[i] && m_voltage[i] <= m_lowVoltage[i] + eps;
+      bool recharge = m_depleted[i] && m_voltage[i] > m_highVoltage[i];
+      if (depletion || recharge)
+        {
+          m_crossed.push_back (i);
+        }
+    }
+}
+
+void
+CapacitorFleetEnergyManager::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_updateEvent.Cancel ();
+  m_sources.clear ();
+  Object::DoDispose ();
+}
+
+} // namespace ns3
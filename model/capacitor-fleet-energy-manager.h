@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef CAPACITOR_FLEET_ENERGY_MANAGER_H
+#define CAPACITOR_FLEET_ENERGY_MANAGER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include <vector>
+
+namespace ns3 {
+
+class CapacitorEnergySource;
+
+/**
+ * \ingroup energy
+ * \brief Advance the state of many CapacitorEnergySource objects at once.
+ *
+ * Without this object, every CapacitorEnergySource schedules its own periodic
+ * UpdateEnergySource event. Sources that are registered with a fleet manager
+ * stop doing so: the manager keeps voltage, capacitance, load current and
+ * harvested power of all sources in contiguous arrays, and a single periodic
+ * event advances all of them with the closed-form RC solution used by
+ * CapacitorEnergySource::ComputeVoltage.
+ *
+ * Sources are only called back when their voltage crosses the low (depletion)
+ * or the high (recharge) threshold, at which point they run their usual
+ * UpdateEnergySource procedure and notify their device energy models. All
+ * other state changes (PHY transitions, harvester updates) are still handled
+ * by the source itself, which pushes its new operating point to the manager
+ * through Store.
+ *
+ * Since sources are not called at every tick, their EnergyChanged
+ * notifications and the FilenameVoltageTracking output are not produced
+ * periodically when managed by the fleet.
+ */
+class CapacitorFleetEnergyManager : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CapacitorFleetEnergyManager ();
+  virtual ~CapacitorFleetEnergyManager ();
+
+  /**
+   * Register a source with this manager.
+   *
+   * The source stops scheduling its own periodic updates, and will be
+   * advanced by this manager from now on.
+   *
+   * \param source The source to manage.
+   * \return The index of the slot assigned to the source.
+   */
+  uint32_t AddSource (Ptr<CapacitorEnergySource> source);
+
+  /**
+   * \return The number of managed sources.
+   */
+  uint32_t GetNSources (void) const;
+
+  /**
+   * Save the operating point of a source, as computed by the source itself.
+   *
+   * \param index The slot of the source.
+   * \param voltage The voltage of the capacitor at time lastUpdate [V].
+   * \param lastUpdate The time the voltage refers to.
+   * \param loadCurrent The current drawn by the devices from now on [A].
+   * \param harvestedPower The power provided by the harvesters from now on [W].
+   * \param depleted Whether the source is currently depleted.
+   */
+  void Store (uint32_t index, double voltage, Time lastUpdate,
+              double loadCurrent, double harvestedPower, bool depleted);
+
+  /**
+   * \param index The slot of the source.
+   * \return The voltage saved in the slot at the time of the last update [V].
+   */
+  double GetVoltage (uint32_t index) const;
+
+  /**
+   * \param index The slot of the source.
+   * \return The time of the last update of the slot.
+   */
+  Time GetLastUpdateTime (uint32_t index) const;
+
+  /**
+   * Set the interval between two consecutive updates of the fleet.
+   */
+  void SetUpdateInterval (Time interval);
+
+  /**
+   * \return The interval between two consecutive updates of the fleet.
+   */
+  Time GetUpdateInterval (void) const;
+
+  /**
+   * Bring all the slots to the current simulation time, and notify the
+   * sources whose voltage crossed a threshold.
+   */
+  void UpdateFleet (void);
+
+private:
+  /// Defined in ns3::Object
+  void DoDispose (void);
+
+  /**
+   * Advance all slots to time now, and save the indexes of the sources that
+   * crossed their threshold in m_crossed.
+   */
+  void AdvanceSlots (Time now);
+
+  std::vector<Ptr<CapacitorEnergySource> > m_sources; // managed sources
+  // Per-source state, in structure of arrays form
+  std::vector<double> m_voltage; // voltage at the last update [V]
+  std::vector<double> m_capacitance; // capacitance [F]
+  std::vector<double> m_supplyVoltage; // max supply voltage [V]
+  std::vector<double> m_loadCurrent; // current drawn by the load [A]
+  std::vector<double> m_harvestedPower; // power provided by the harvesters [W]
+  std::vector<double> m_lowVoltage; // depletion threshold [V]
+  std::vector<double> m_highVoltage; // recharge threshold [V]
+  std::vector<Time> m_lastUpdate; // time of the last update
+  std::vector<uint8_t> m_depleted; // whether the source is depleted
+
+  std::vector<uint32_t> m_crossed; // sources that crossed a threshold
+
+  Time m_updateInterval; // interval between fleet updates
+  EventId m_updateEvent; // next fleet update
+};
+
+} // namespace ns3
+
+#endif /* CAPACITOR_FLEET_ENERGY_MANAGER_H */
@@ -254,6 +254,35 @@ ClassAEndDeviceLorawanMac::Receive (Ptr<Packet const> packet)
   m_phy->GetObject<EndDeviceLoraPhy> ()->SwitchToSleep ();
 }
 
+bool
+ClassAEndDeviceLorawanMac::ReceiveOutsideWindows (Ptr<Packet const> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  Ptr<Packet> packetCopy = packet->Copy ();
+  LorawanMacHeader mHdr;
+  packetCopy->RemoveHeader (mHdr);
+  if (mHdr.IsUplink ())
+    {
+      NS_LOG_DEBUG ("Ignoring an uplink packet.");
+      return false;
+    }
+
+  LoraFrameHeader fHdr;
+  fHdr.SetAsDownlink ();
+  packetCopy->RemoveHeader (fHdr);
+  if (!(m_address == fHdr.GetAddress ()))
+    {
+      NS_LOG_DEBUG ("The message is intended for another recipient.");
+      return false;
+    }
+
+  NS_LOG_INFO ("Received a downlink outside of the receive windows.");
+  ParseCommands (fHdr);
+  m_receivedPacket (packet);
+  return true;
+}
+
 void
 ClassAEndDeviceLorawanMac::FailedReception (Ptr<Packet const> packet, bool lostBecauseInterference)
 {
@@ -516,8 +545,7 @@ ClassAEndDeviceLorawanMac::GetNextClassTransmissionDelay (Time waitingTime)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  if (!m_closeFirstWindow.IsExpired () || !m_closeSecondWindow.IsExpired () ||
-      !m_secondReceiveWindow.IsExpired ())
+  if (HasPendingReceiveWindows ())
     {
       NS_LOG_WARN ("Attempting to send when there are receive windows:"
                    << " Transmission postponed.");
@@ -534,6 +562,13 @@ ClassAEndDeviceLorawanMac::GetNextClassTransmissionDelay (Time waitingTime)
   return waitingTime;
 }
 
+bool
+ClassAEndDeviceLorawanMac::HasPendingReceiveWindows (void) const
+{
+  return !m_closeFirstWindow.IsExpired () || !m_closeSecondWindow.IsExpired () ||
+         !m_secondReceiveWindow.IsExpired ();
+}
+
 uint8_t
 ClassAEndDeviceLorawanMac::GetFirstReceiveWindowDataRate (void)
 {
@@ -100,7 +100,7 @@ public:
   /**
    * Perform operations needed to close the second receive window.
    */
-  void CloseSecondReceiveWindow (void);
+  virtual void CloseSecondReceiveWindow (void);
 
   /////////////////////////
   // Getters and Setters //
@@ -168,6 +168,26 @@ public:
   // TracedCallback<> m_emptyCallback;
   TracedCallback<> m_closeSecondReceiveWindowCallback;
 
+protected:
+  /**
+   * \return Whether one of the receive windows that follow an uplink is
+   * open, or still has to be opened or closed.
+   */
+  bool HasPendingReceiveWindows (void) const;
+
+  /**
+   * Handle a packet received outside of the receive windows that follow an
+   * uplink, as in the ping slots of Class B devices or during the
+   * continuous reception of Class C devices: if it is a downlink for this
+   * device, apply its MAC commands and fire the ReceivedPacket trace. Unlike
+   * Receive, this never triggers a retransmission, and leaves the PHY state
+   * to the caller.
+   *
+   * \param packet The received packet.
+   * \return Whether the packet was a downlink for this device.
+   */
+  bool ReceiveOutsideWindows (Ptr<Packet const> packet);
+
 private:
 
   /**
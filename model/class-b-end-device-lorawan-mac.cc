@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/class-b-end-device-lorawan-mac.h"
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("ClassBEndDeviceLorawanMac");
+
+NS_OBJECT_ENSURE_REGISTERED (ClassBEndDeviceLorawanMac);
+
+TypeId
+ClassBEndDeviceLorawanMac::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClassBEndDeviceLorawanMac")
+    .SetParent<ClassAEndDeviceLorawanMac> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<ClassBEndDeviceLorawanMac> ()
+    .AddAttribute ("PingSlotPeriodicity",
+                   "The device opens 2^(7 - PingSlotPeriodicity) ping slots "
+                   "per beacon period",
+                   UintegerValue (7),
+                   MakeUintegerAccessor (&ClassBEndDeviceLorawanMac::m_pingSlotPeriodicity),
+                   MakeUintegerChecker<uint8_t> (0, 7))
+    .AddAttribute ("PingSlotDataRate",
+                   "The Data Rate used in the ping slots",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&ClassBEndDeviceLorawanMac::m_pingSlotDataRate),
+                   MakeUintegerChecker<uint8_t> (0, 5))
+    .AddAttribute ("PingSlotFrequency",
+                   "The frequency used in the ping slots, in MHz",
+                   DoubleValue (869.525),
+                   MakeDoubleAccessor (&ClassBEndDeviceLorawanMac::m_pingSlotFrequency),
+                   MakeDoubleChecker<double> ());
+  return tid;
+}
+
+ClassBEndDeviceLorawanMac::ClassBEndDeviceLorawanMac () :
+  m_inPingSlot (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ClassBEndDeviceLorawanMac::~ClassBEndDeviceLorawanMac ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+ClassBEndDeviceLorawanMac::SetBeacon (Ptr<LorawanBeacon> beacon)
+{
+  m_beacon = beacon;
+}
+
+Ptr<LorawanBeacon>
+ClassBEndDeviceLorawanMac::GetBeacon (void) const
+{
+  return m_beacon;
+}
+
+uint32_t
+ClassBEndDeviceLorawanMac::GetPingNb (void) const
+{
+  return 1 << (7 - m_pingSlotPeriodicity);
+}
+
+uint8_t
+ClassBEndDeviceLorawanMac::GetPingSlotDataRate (void) const
+{
+  return m_pingSlotDataRate;
+}
+
+double
+ClassBEndDeviceLorawanMac::GetPingSlotFrequency (void) const
+{
+  return m_pingSlotFrequency;
+}
+
+Time
+ClassBEndDeviceLorawanMac::GetNextPingSlot (Time time) const
+{
+  NS_LOG_FUNCTION (this << time);
+  NS_ABORT_MSG_IF (m_beacon == 0, "Class B device without a beacon");
+
+  uint32_t pingNb = GetPingNb ();
+  uint32_t pingPeriod = m_beacon->GetNPingSlots () / pingNb;
+  int64_t step = pingPeriod * m_beacon->GetPingSlotDuration ().GetTimeStep ();
+
+  // The ping slots of a period are at a fixed distance from each other, after
+  // an offset that changes at each beacon: find the first one in the period
+  // of the given time, or else take the first one of the next period.
+  uint32_t beaconIndex = m_beacon->GetBeaconIndex (time);
+  while (true)
+    {
+      uint32_t offset = LorawanBeacon::GetPingOffset (beaconIndex, m_address, pingPeriod);
+      Time firstSlot = m_beacon->GetPingSlotStart (beaconIndex, offset);
+      if (time <= firstSlot)
+        {
+          return firstSlot;
+        }
+
+      int64_t n = ((time - firstSlot).GetTimeStep () + step - 1) / step;
+      if (n < pingNb)
+        {
+          return firstSlot + TimeStep (n * step);
+        }
+      beaconIndex++;
+    }
+}
+
+void
+ClassBEndDeviceLorawanMac::SchedulePingSlot (Time slotStart)
+{
+  NS_LOG_FUNCTION (this << slotStart);
+  NS_ASSERT (slotStart >= Simulator::Now ());
+
+  m_openPingSlot.Cancel ();
+  m_openPingSlot = Simulator::Schedule (slotStart - Simulator::Now (),
+                                        &ClassBEndDeviceLorawanMac::OpenPingSlot, this);
+}
+
+void
+ClassBEndDeviceLorawanMac::OpenPingSlot (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<EndDeviceLoraPhy> phy = m_phy->GetObject<EndDeviceLoraPhy> ();
+
+  // The Class A receive windows and the transmissions take precedence over
+  // the ping slots
+  if (phy->GetState () != EndDeviceLoraPhy::SLEEP || HasPendingReceiveWindows ())
+    {
+      NS_LOG_INFO ("Won't open the ping slot since the PHY is busy.");
+      return;
+    }
+
+  phy->SetFrequency (m_pingSlotFrequency);
+  phy->SetSpreadingFactor (GetSfFromDataRate (m_pingSlotDataRate));
+  if (!phy->SwitchToStandby ())
+    {
+      return;
+    }
+  m_inPingSlot = true;
+
+  // Stay open for the time needed to detect a preamble, like the Class A
+  // receive windows
+  double tSym = pow (2, GetSfFromDataRate (m_pingSlotDataRate)) /
+                GetBandwidthFromDataRate (m_pingSlotDataRate);
+  m_closePingSlot = Simulator::Schedule (Seconds ((4.25 + m_receiveWindowDurationInSymbols) * tSym),
+                                         &ClassBEndDeviceLorawanMac::ClosePingSlot, this);
+}
+
+void
+ClassBEndDeviceLorawanMac::ClosePingSlot (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<EndDeviceLoraPhy> phy = m_phy->GetObject<EndDeviceLoraPhy> ();
+  if (phy->GetState () == EndDeviceLoraPhy::RX)
+    {
+      // PHY is receiving: Receive or FailedReception will close the slot
+      return;
+    }
+
+  m_inPingSlot = false;
+  if (phy->GetState () == EndDeviceLoraPhy::STANDBY)
+    {
+      phy->SwitchToSleep ();
+    }
+}
+
+void
+ClassBEndDeviceLorawanMac::Receive (Ptr<Packet const> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  if (!m_inPingSlot)
+    {
+      ClassAEndDeviceLorawanMac::Receive (packet);
+      return;
+    }
+
+  m_inPingSlot = false;
+  m_closePingSlot.Cancel ();
+  ReceiveOutsideWindows (packet);
+  m_phy->GetObject<EndDeviceLoraPhy> ()->SwitchToSleep ();
+}
+
+void
+ClassBEndDeviceLorawanMac::FailedReception (Ptr<Packet const> packet,
+                                            bool lostBecauseInterference)
+{
+  NS_LOG_FUNCTION (this << packet << lostBecauseInterference);
+
+  if (!m_inPingSlot)
+    {
+      ClassAEndDeviceLorawanMac::FailedReception (packet, lostBecauseInterference);
+      return;
+    }
+
+  // A downlink lost in a ping slot does not cause a retransmission
+  m_inPingSlot = false;
+  m_closePingSlot.Cancel ();
+  m_phy->GetObject<EndDeviceLoraPhy> ()->SwitchToSleep ();
+}
+
+void
+ClassBEndDeviceLorawanMac::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_openPingSlot.Cancel ();
+  m_closePingSlot.Cancel ();
+  m_beacon = 0;
+  ClassAEndDeviceLorawanMac::DoDispose ();
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef CLASS_B_END_DEVICE_LORAWAN_MAC_H
+#define CLASS_B_END_DEVICE_LORAWAN_MAC_H
+
+#include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/lorawan-beacon.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Class representing the MAC layer of a Class B LoRaWAN device.
+ *
+ * On top of the Class A receive windows, a Class B device opens
+ * 2^(7 - PingSlotPeriodicity) ping slots per beacon period, about one every
+ * 2^PingSlotPeriodicity seconds, at times derived from the beacon of the
+ * network (see LorawanBeacon) and from its address.
+ *
+ * Since a ping slot in which no downlink is sent has no effect on the
+ * device, other than on its energy consumption, ping slots are not
+ * scheduled periodically: the Network Server, when it has a downlink for
+ * the device, asks it for its next ping slot with GetNextPingSlot, and
+ * makes the device open only that one with SchedulePingSlot. The cost of a
+ * Class B device is thus independent of the number of its ping slots.
+ */
+class ClassBEndDeviceLorawanMac : public ClassAEndDeviceLorawanMac
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ClassBEndDeviceLorawanMac ();
+  virtual ~ClassBEndDeviceLorawanMac ();
+
+  virtual void Receive (Ptr<Packet const> packet);
+
+  virtual void FailedReception (Ptr<Packet const> packet, bool lostBecauseInterference);
+
+  /**
+   * Set the beacon this device is synchronized to.
+   */
+  void SetBeacon (Ptr<LorawanBeacon> beacon);
+
+  /**
+   * Get the beacon this device is synchronized to.
+   */
+  Ptr<LorawanBeacon> GetBeacon (void) const;
+
+  /**
+   * \return The number of ping slots this device opens in a beacon period.
+   */
+  uint32_t GetPingNb (void) const;
+
+  /**
+   * Compute the start of the first ping slot of this device that does not
+   * start before the given time.
+   */
+  Time GetNextPingSlot (Time time) const;
+
+  /**
+   * Open a ping slot at the given time, which must have been returned by
+   * GetNextPingSlot. Only one ping slot can be pending: a later call
+   * replaces the ping slot planned before.
+   */
+  void SchedulePingSlot (Time slotStart);
+
+  /**
+   * Get the Data Rate that is used in the ping slots.
+   */
+  uint8_t GetPingSlotDataRate (void) const;
+
+  /**
+   * Get the frequency that is used in the ping slots, in MHz.
+   */
+  double GetPingSlotFrequency (void) const;
+
+private:
+  void DoDispose (void);
+
+  /**
+   * Open the ping slot planned with SchedulePingSlot, if the PHY is not busy
+   * with the Class A receive windows or a transmission.
+   */
+  void OpenPingSlot (void);
+
+  /**
+   * Close the ping slot, unless a reception is ongoing.
+   */
+  void ClosePingSlot (void);
+
+  Ptr<LorawanBeacon> m_beacon; //!< The beacon the ping slots are derived from
+  uint8_t m_pingSlotPeriodicity; //!< A ping slot every 2^periodicity seconds
+  uint8_t m_pingSlotDataRate; //!< The Data Rate of the ping slots
+  double m_pingSlotFrequency; //!< The frequency of the ping slots [MHz]
+
+  EventId m_openPingSlot; //!< The opening of the planned ping slot
+  EventId m_closePingSlot; //!< The closing of the open ping slot
+  bool m_inPingSlot; //!< Whether the PHY is listening in a ping slot
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+#endif /* CLASS_B_END_DEVICE_LORAWAN_MAC_H */
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/class-c-end-device-lorawan-mac.h"
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("ClassCEndDeviceLorawanMac");
+
+NS_OBJECT_ENSURE_REGISTERED (ClassCEndDeviceLorawanMac);
+
+TypeId
+ClassCEndDeviceLorawanMac::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClassCEndDeviceLorawanMac")
+    .SetParent<ClassAEndDeviceLorawanMac> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<ClassCEndDeviceLorawanMac> ();
+  return tid;
+}
+
+ClassCEndDeviceLorawanMac::ClassCEndDeviceLorawanMac () :
+  m_continuousReception (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ClassCEndDeviceLorawanMac::~ClassCEndDeviceLorawanMac ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+ClassCEndDeviceLorawanMac::SendToPhy (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  // The Class A procedure takes over until the second receive window closes
+  m_continuousReception = false;
+  ClassAEndDeviceLorawanMac::SendToPhy (packet);
+}
+
+void
+ClassCEndDeviceLorawanMac::Receive (Ptr<Packet const> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  if (m_continuousReception)
+    {
+      // The PHY is back in STANDBY after the reception: keep listening
+      ReceiveOutsideWindows (packet);
+      return;
+    }
+
+  ClassAEndDeviceLorawanMac::Receive (packet);
+  StartContinuousReception ();
+}
+
+void
+ClassCEndDeviceLorawanMac::FailedReception (Ptr<Packet const> packet,
+                                            bool lostBecauseInterference)
+{
+  NS_LOG_FUNCTION (this << packet << lostBecauseInterference);
+
+  if (m_continuousReception)
+    {
+      // A lost downlink does not cause a retransmission
+      return;
+    }
+
+  ClassAEndDeviceLorawanMac::FailedReception (packet, lostBecauseInterference);
+  StartContinuousReception ();
+}
+
+void
+ClassCEndDeviceLorawanMac::CloseSecondReceiveWindow (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow ();
+  StartContinuousReception ();
+}
+
+void
+ClassCEndDeviceLorawanMac::StartContinuousReception (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<EndDeviceLoraPhy> phy = m_phy->GetObject<EndDeviceLoraPhy> ();
+  if (m_continuousReception || HasPendingReceiveWindows ()
+      || phy->GetState () != EndDeviceLoraPhy::SLEEP)
+    {
+      return;
+    }
+
+  phy->SetFrequency (GetSecondReceiveWindowFrequency ());
+  phy->SetSpreadingFactor (GetSfFromDataRate (GetSecondReceiveWindowDataRate ()));
+  m_continuousReception = phy->SwitchToStandby ();
+
+  NS_LOG_DEBUG ("Continuous reception " <<
+                (m_continuousReception ? "started" : "could not start"));
+}
+
+bool
+ClassCEndDeviceLorawanMac::IsInContinuousReception (void) const
+{
+  return m_continuousReception;
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
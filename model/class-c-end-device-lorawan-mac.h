@@ -0,0 +1,73 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef CLASS_C_END_DEVICE_LORAWAN_MAC_H
+#define CLASS_C_END_DEVICE_LORAWAN_MAC_H
+
+#include "ns3/class-a-end-device-lorawan-mac.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Class representing the MAC layer of a Class C LoRaWAN device.
+ *
+ * A Class C device behaves like a Class A one around its uplinks and, when
+ * it is neither transmitting nor in a Class A receive window, keeps the PHY
+ * in STANDBY on the frequency and Data Rate of the second receive window.
+ * Continuous reception needs no event of its own: the PHY locks on the
+ * downlinks that reach it, and goes back to STANDBY after each reception.
+ *
+ * Continuous reception is resumed when the second receive window closes,
+ * not right after the uplink as the LoRaWAN specification prescribes, so
+ * that the first receive window keeps the parameters SendToPhy set for it.
+ */
+class ClassCEndDeviceLorawanMac : public ClassAEndDeviceLorawanMac
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ClassCEndDeviceLorawanMac ();
+  virtual ~ClassCEndDeviceLorawanMac ();
+
+  virtual void SendToPhy (Ptr<Packet> packet);
+
+  virtual void Receive (Ptr<Packet const> packet);
+
+  virtual void FailedReception (Ptr<Packet const> packet, bool lostBecauseInterference);
+
+  virtual void CloseSecondReceiveWindow (void);
+
+  /**
+   * Start listening on the parameters of the second receive window, if the
+   * PHY is sleeping and no Class A receive window is pending.
+   */
+  void StartContinuousReception (void);
+
+  /**
+   * \return Whether the device is in continuous reception.
+   */
+  bool IsInContinuousReception (void) const;
+
+private:
+  bool m_continuousReception; //!< Whether the PHY listens on the RX2 parameters
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+#endif /* CLASS_C_END_DEVICE_LORAWAN_MAC_H */
@@ -18,8 +18,13 @@
 
 #include "ns3/correlated-shadowing-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include <cmath>
+#include <algorithm>
+#include <fstream>
 
 namespace ns3 {
 namespace lorawan {
@@ -41,12 +46,90 @@ CorrelatedShadowingPropagationLossModel::GetTypeId (void)
                    DoubleValue (110.0),
                    MakeDoubleAccessor
                      (&CorrelatedShadowingPropagationLossModel::m_correlationDistance),
-                   MakeDoubleChecker<double> ());
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("UseRaster",
+                   "Whether to use pre-generated shadowing rasters instead of "
+                   "per-square shadowing maps",
+                   BooleanValue (false),
+                   MakeBooleanAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_useRaster),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RasterMin",
+                   "Lower left corner of the area covered by the raster",
+                   VectorValue (Vector (-5000, -5000, 0)),
+                   MakeVectorAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_rasterMin),
+                   MakeVectorChecker ())
+    .AddAttribute ("RasterMax",
+                   "Upper right corner of the area covered by the raster",
+                   VectorValue (Vector (5000, 5000, 0)),
+                   MakeVectorAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_rasterMax),
+                   MakeVectorChecker ())
+    .AddAttribute ("RasterResolution",
+                   "Spacing of the points at which the interpolation "
+                   "coefficients are precomputed, in meters",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_rasterResolution),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("RasterFile",
+                   "Binary file from which the raster is loaded, if it matches "
+                   "the current configuration, and to which it is saved. Leave "
+                   "empty to always generate a new raster",
+                   StringValue (""),
+                   MakeStringAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_rasterFile),
+                   MakeStringChecker ())
+    .AddAttribute ("RasterMaxValues",
+                   "Maximum number of shadowing values kept by the raster. Each "
+                   "transmitter square takes one value per vertex of the raster: "
+                   "transmitter squares found when the raster is full use the "
+                   "per-square shadowing maps",
+                   UintegerValue (1 << 24),
+                   MakeUintegerAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_rasterMaxValues),
+                   MakeUintegerChecker<uint64_t> ());
   return tid;
 }
 
 CorrelatedShadowingPropagationLossModel::CorrelatedShadowingPropagationLossModel ()
+  : m_rasterInitialized (false),
+    m_rasterChanged (false),
+    m_firstSquareX (0),
+    m_firstSquareY (0),
+    m_nSquaresX (0),
+    m_nSquaresY (0),
+    m_kernelPoints (0),
+    m_rasterFull (false)
+{
+  m_rasterValue = CreateObject<NormalRandomVariable> ();
+  m_rasterValue->SetAttribute ("Mean", DoubleValue (0.0));
+  m_rasterValue->SetAttribute ("Variance", DoubleValue (16.0));
+
+  m_shadowingValue = CreateObject<NormalRandomVariable> ();
+  m_shadowingValue->SetAttribute ("Mean", DoubleValue (0.0));
+  m_shadowingValue->SetAttribute ("Variance", DoubleValue (16.0));
+}
+
+void
+CorrelatedShadowingPropagationLossModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_rasterChanged)
+    {
+      SaveRaster ();
+    }
+  m_shadowingGrid.clear ();
+  PropagationLossModel::DoDispose ();
+}
+
+int
+CorrelatedShadowingPropagationLossModel::GetSquareCoordinate (double value) const
 {
+  // (x > 0) - (x < 0) is the sign function
+  return ((value > 0) - (value < 0)) *
+         (int) ((std::fabs (value) + m_correlationDistance / 2) / m_correlationDistance);
 }
 
 double
@@ -78,6 +161,21 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   NS_LOG_DEBUG ("x " << x << ", y " << y);
   NS_LOG_DEBUG ("xcoord " << xcoord << ", ycoord " << ycoord);
 
+  if (m_useRaster)
+    {
+      if (!m_rasterInitialized)
+        {
+          InitializeRaster ();
+        }
+      double loss;
+      if (GetRasterLoss (xcoord, ycoord, b->GetPosition ().x, b->GetPosition ().y, loss))
+        {
+          NS_LOG_INFO ("Shadowing loss from raster: " << loss);
+          return txPowerDbm - loss;
+        }
+      NS_LOG_DEBUG ("Outside of the raster, using the shadowing map");
+    }
+
   // Look for the computed coordinates in the shadowingGrid
   std::map<std::pair<int,int>, Ptr<ShadowingMap> >::const_iterator it;
 
@@ -90,7 +188,7 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                     << coordinates.first << " " << coordinates.second);
 
       Ptr<ShadowingMap> shadowingMap =
-        Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> ();
+        Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> (m_shadowingValue);
 
       m_shadowingGrid[coordinates] = shadowingMap;
     }
@@ -118,7 +216,225 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
 int64_t
 CorrelatedShadowingPropagationLossModel::DoAssignStreams (int64_t stream)
 {
-  return 0;
+  m_rasterValue->SetStream (stream);
+  // Shared by all the shadowing maps
+  m_shadowingValue->SetStream (stream + 1);
+  return 2;
+}
+
+/***************************
+ *  Raster implementation  *
+ ***************************/
+
+void
+CorrelatedShadowingPropagationLossModel::InitializeRaster (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_rasterMin.x < m_rasterMax.x && m_rasterMin.y < m_rasterMax.y);
+
+  double d = m_correlationDistance;
+
+  // Squares covering the bounding box
+  m_firstSquareX = GetSquareCoordinate (m_rasterMin.x);
+  m_firstSquareY = GetSquareCoordinate (m_rasterMin.y);
+  m_nSquaresX = GetSquareCoordinate (m_rasterMax.x) - m_firstSquareX + 1;
+  m_nSquaresY = GetSquareCoordinate (m_rasterMax.y) - m_firstSquareY + 1;
+
+  // Interpolation coefficients on a sub-grid of each square. They are the
+  // same phi coefficients computed by ShadowingMap::GetLoss, which only
+  // depend on the position relative to the vertices of the square.
+  m_kernelPoints = std::max (1, (int) std::ceil (d / m_rasterResolution));
+  int n = m_kernelPoints;
+  m_kernel.assign ((n + 1) * (n + 1) * 4, 0);
+  double c[2][4] = {{0, d, d, 0}, {0, 0, d, d}};
+  for (int b = 0; b <= n; b++)
+    {
+      for (int a = 0; a <= n; a++)
+        {
+          double x = d * a / n;
+          double y = d * b / n;
+          double *phi = &m_kernel[(b * (n + 1) + a) * 4];
+          for (int j = 0; j < 4; j++)
+            {
+              double distance =
+                std::sqrt ((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
+              double k = std::exp (-distance / d);
+              for (int i = 0; i < 4; i++)
+                {
+                  phi[i] += ShadowingMap::m_kInv[i][j] * k;
+                }
+            }
+        }
+    }
+
+  if (!LoadRaster ())
+    {
+      m_rasterOffset.assign (m_nSquaresX * m_nSquaresY, -1);
+      m_raster.clear ();
+    }
+
+  NS_LOG_DEBUG ("Raster of " << m_nSquaresX << "x" << m_nSquaresY << " squares, "
+                             << n << " kernel intervals per side");
+  m_rasterInitialized = true;
+}
+
+bool
+CorrelatedShadowingPropagationLossModel::GetRasterLoss (int txX, int txY,
+                                                        double x, double y,
+                                                        double &loss) const
+{
+  int tx = txX - m_firstSquareX;
+  int ty = txY - m_firstSquareY;
+  int rxX = GetSquareCoordinate (x);
+  int rxY = GetSquareCoordinate (y);
+  int rx = rxX - m_firstSquareX;
+  int ry = rxY - m_firstSquareY;
+  if (tx < 0 || tx >= m_nSquaresX || ty < 0 || ty >= m_nSquaresY
+      || rx < 0 || rx >= m_nSquaresX || ry < 0 || ry >= m_nSquaresY)
+    {
+      return false;
+    }
+
+  // Values at the vertices of the grid, as seen from the transmitter square.
+  // They are drawn the first time a transmitter is found in this square.
+  int verticesX = m_nSquaresX + 1;
+  int64_t &offset = m_rasterOffset[ty * m_nSquaresX + tx];
+  if (offset < 0)
+    {
+      uint32_t nVertices = verticesX * (m_nSquaresY + 1);
+      if (m_raster.size () + nVertices > m_rasterMaxValues)
+        {
+          if (!m_rasterFull)
+            {
+              NS_LOG_WARN ("The raster holds " << m_raster.size () << " values, and cannot "
+                           << "take " << nVertices << " more: new transmitter squares "
+                           << "use the shadowing maps");
+              m_rasterFull = true;
+            }
+          return false;
+        }
+      offset = m_raster.size ();
+      NS_LOG_DEBUG ("Drawing " << nVertices << " values for square " << txX << " " << txY);
+      m_raster.reserve (m_raster.size () + nVertices);
+      for (uint32_t i = 0; i < nVertices; i++)
+        {
+          m_raster.push_back (m_rasterValue->GetValue ());
+        }
+      m_rasterChanged = true;
+    }
+  const double *vertices = &m_raster[offset];
+  double q11 = vertices[ry * verticesX + rx]; // lower left
+  double q21 = vertices[ry * verticesX + rx + 1]; // lower right
+  double q12 = vertices[(ry + 1) * verticesX + rx]; // upper left
+  double q22 = vertices[(ry + 1) * verticesX + rx + 1]; // upper right
+
+  // Position inside the square, in units of the kernel sub-grid
+  double d = m_correlationDistance;
+  int n = m_kernelPoints;
+  double u = std::min (std::max ((x - (rxX * d - d / 2)) / d, 0.0), 1.0) * n;
+  double v = std::min (std::max ((y - (rxY * d - d / 2)) / d, 0.0), 1.0) * n;
+  int a = std::min ((int) u, n - 1);
+  int b = std::min ((int) v, n - 1);
+  double fu = u - a;
+  double fv = v - b;
+
+  // Bilinear interpolation of the coefficients of the 4 closest kernel points
+  const double *k00 = &m_kernel[(b * (n + 1) + a) * 4];
+  const double *k10 = k00 + 4;
+  const double *k01 = k00 + (n + 1) * 4;
+  const double *k11 = k01 + 4;
+  double phi[4];
+  for (int i = 0; i < 4; i++)
+    {
+      phi[i] = (1 - fu) * (1 - fv) * k00[i] + fu * (1 - fv) * k10[i] +
+               (1 - fu) * fv * k01[i] + fu * fv * k11[i];
+    }
+
+  loss = q11 * phi[0] + q21 * phi[1] + q22 * phi[2] + q12 * phi[3];
+  return true;
+}
+
+bool
+CorrelatedShadowingPropagationLossModel::LoadRaster (void) const
+{
+  NS_LOG_FUNCTION (this << m_rasterFile);
+
+  if (m_rasterFile.empty ())
+    {
+      return false;
+    }
+  std::ifstream file (m_rasterFile.c_str (), std::ios::binary);
+  if (!file.is_open ())
+    {
+      NS_LOG_DEBUG ("Raster file not found, generating a new raster");
+      return false;
+    }
+
+  // The header must describe the same raster
+  double header[5];
+  int32_t squares[4];
+  file.read ((char *) header, sizeof (header));
+  file.read ((char *) squares, sizeof (squares));
+  if (!file || header[0] != m_correlationDistance || header[1] != m_rasterMin.x
+      || header[2] != m_rasterMin.y || header[3] != m_rasterMax.x || header[4] != m_rasterMax.y
+      || squares[0] != m_firstSquareX || squares[1] != m_firstSquareY
+      || squares[2] != m_nSquaresX || squares[3] != m_nSquaresY)
+    {
+      NS_LOG_WARN ("Raster file " << m_rasterFile << " does not match the configuration of "
+                                  << "the model, generating a new raster");
+      return false;
+    }
+
+  uint64_t nValues;
+  std::vector<int64_t> offsets (m_nSquaresX * m_nSquaresY);
+  file.read ((char *) &offsets[0], offsets.size () * sizeof (int64_t));
+  file.read ((char *) &nValues, sizeof (nValues));
+  std::vector<double> values (nValues);
+  if (nValues > 0)
+    {
+      file.read ((char *) &values[0], nValues * sizeof (double));
+    }
+  if (!file)
+    {
+      NS_LOG_WARN ("Raster file " << m_rasterFile << " is truncated, generating a new raster");
+      return false;
+    }
+
+  m_rasterOffset.swap (offsets);
+  m_raster.swap (values);
+  NS_LOG_DEBUG ("Loaded " << m_raster.size () << " values from " << m_rasterFile);
+  return true;
+}
+
+void
+CorrelatedShadowingPropagationLossModel::SaveRaster (void) const
+{
+  NS_LOG_FUNCTION (this << m_rasterFile);
+
+  if (m_rasterFile.empty () || !m_rasterInitialized)
+    {
+      return;
+    }
+  std::ofstream file (m_rasterFile.c_str (), std::ios::binary | std::ios::trunc);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open raster file " << m_rasterFile);
+      return;
+    }
+
+  double header[5] = {m_correlationDistance, m_rasterMin.x, m_rasterMin.y,
+                      m_rasterMax.x, m_rasterMax.y};
+  int32_t squares[4] = {m_firstSquareX, m_firstSquareY, m_nSquaresX, m_nSquaresY};
+  uint64_t nValues = m_raster.size ();
+  file.write ((const char *) header, sizeof (header));
+  file.write ((const char *) squares, sizeof (squares));
+  file.write ((const char *) &m_rasterOffset[0], m_rasterOffset.size () * sizeof (int64_t));
+  file.write ((const char *) &nValues, sizeof (nValues));
+  if (nValues > 0)
+    {
+      file.write ((const char *) &m_raster[0], nValues * sizeof (double));
+    }
+  m_rasterChanged = false;
 }
 
 /*********************************
@@ -146,6 +462,14 @@ CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap () :
   m_shadowingValue->SetAttribute ("Variance", DoubleValue (16.0));
 }
 
+CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap
+  (Ptr<NormalRandomVariable> shadowingValue) :
+  m_correlationDistance (110),
+  m_shadowingValue (shadowingValue)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
 CorrelatedShadowingPropagationLossModel::ShadowingMap::~ShadowingMap ()
 {
   NS_LOG_FUNCTION_NOARGS ();
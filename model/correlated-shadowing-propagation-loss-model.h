@@ -23,6 +23,8 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/random-variable-stream.h"
+#include <vector>
+#include <string>
 
 namespace ns3 {
 class MobilityModel;
@@ -70,6 +72,12 @@ public:
      */
     ShadowingMap ();
 
+    /**
+     * \param shadowingValue The variable drawing the values at the vertices,
+     * possibly shared with other maps.
+     */
+    ShadowingMap (Ptr<NormalRandomVariable> shadowingValue);
+
     ~ShadowingMap ();
 
     /**
@@ -80,6 +88,9 @@ public:
     double GetLoss (CorrelatedShadowingPropagationLossModel::Position position);
 
 private:
+    // The raster mode reuses m_kInv
+    friend class CorrelatedShadowingPropagationLossModel;
+
     /**
      * For each Position, this map gives a corresponding loss.
      * The map contains a basic grid that is initialized at construction
@@ -124,6 +135,13 @@ private:
    */
   double GetCorrelationDistance (void);
 
+  /**
+   * Write the shadowing values of the raster generated so far to the file set
+   * with the RasterFile attribute, so that they can be reused by other runs.
+   * This is also done automatically when the model is disposed.
+   */
+  void SaveRaster (void) const;
+
 private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
@@ -131,8 +149,87 @@ private:
 
   virtual int64_t DoAssignStreams (int64_t stream);
 
+  virtual void DoDispose (void);
+
+  /**
+   * Compute the coordinate of the grid square containing a value, i.e.,
+   * round it to the closest multiple of the correlation distance.
+   */
+  int GetSquareCoordinate (double value) const;
+
+  /**
+   * Compute the interpolation kernel of the raster, and load the shadowing
+   * values from the RasterFile if it matches the raster configuration.
+   */
+  void InitializeRaster (void) const;
+
+  /**
+   * Read the shadowing values of the raster from the RasterFile.
+   *
+   * \return Whether the file exists and matches the raster configuration.
+   */
+  bool LoadRaster (void) const;
+
+  /**
+   * Get the shadowing seen at (x, y) by a transmitter in the square at
+   * coordinates (txX, txY), using the raster.
+   *
+   * \return false if either the transmitter square or the receiver position
+   * are outside the raster.
+   */
+  bool GetRasterLoss (int txX, int txY, double x, double y, double &loss) const;
+
   double m_correlationDistance;     //!< The correlation distance for the ShadowingMap
 
+  /**
+   * Raster mode.
+   *
+   * Instead of the std::map based ShadowingMap objects, shadowing values are
+   * kept in flat arrays covering the bounding box [RasterMin, RasterMax].
+   * For each square of the grid in which a transmitter is found, the
+   * independent values at all the vertices of the grid inside the bounding
+   * box are drawn once, and stored contiguously in m_raster. The
+   * interpolation coefficients of the ShadowingMap only depend on the
+   * position of the receiver inside its square, so they are computed once on
+   * a sub-grid of RasterResolution meters (m_kernel), and bilinearly
+   * interpolated at lookup time. A lookup is thus a constant number of reads
+   * from contiguous arrays, and always returns the same value for the same
+   * pair of positions. Transmitters or receivers outside the bounding box
+   * fall back to the ShadowingMap.
+   *
+   * Each transmitter square takes one value per vertex of the whole box, so
+   * the memory grows with the product of the two. It is bounded by
+   * RasterMaxValues: once the raster is full, transmitters in new squares
+   * also fall back to the ShadowingMap. Values are never evicted, so that
+   * the shadowing seen by static nodes never changes.
+   */
+  bool m_useRaster;
+  Vector m_rasterMin;  //!< Lower left corner of the raster
+  Vector m_rasterMax;  //!< Upper right corner of the raster
+  double m_rasterResolution; //!< Resolution of the interpolation kernel [m]
+  std::string m_rasterFile; //!< File to load and save the raster values
+
+  mutable bool m_rasterInitialized; //!< Whether InitializeRaster was called
+  mutable bool m_rasterChanged; //!< Whether values were drawn since loading
+  mutable int m_firstSquareX; //!< Coordinate of the leftmost square
+  mutable int m_firstSquareY; //!< Coordinate of the lowest square
+  mutable int m_nSquaresX; //!< Number of squares along x
+  mutable int m_nSquaresY; //!< Number of squares along y
+  mutable int m_kernelPoints; //!< Sub-grid intervals along each side of a square
+  /// Interpolation coefficients at each sub-grid point, 4 per point
+  mutable std::vector<double> m_kernel;
+  /// Offset in m_raster of the values of each transmitter square, -1 if not drawn
+  mutable std::vector<int64_t> m_rasterOffset;
+  /// Values at the grid vertices, for each transmitter square
+  mutable std::vector<double> m_raster;
+  /// The normal random variable used to draw the raster values
+  Ptr<NormalRandomVariable> m_rasterValue;
+  uint64_t m_rasterMaxValues; //!< Maximum size of m_raster
+  mutable bool m_rasterFull; //!< Whether a square was refused for lack of space
+
+  /// The normal random variable shared by the ShadowingMap objects
+  Ptr<NormalRandomVariable> m_shadowingValue;
+
   /**
    * Map linking a square to a ShadowingMap.
    * Each square of the shadowing grid has a corresponding ShadowingMap, and a
@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/downlink-planner.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("DownlinkPlanner");
+
+NS_OBJECT_ENSURE_REGISTERED (DownlinkPlanner);
+
+TypeId
+DownlinkPlanner::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DownlinkPlanner")
+    .SetParent<Object> ()
+    .AddConstructor<DownlinkPlanner> ()
+    .AddAttribute ("SlotDuration",
+                   "The duration of the slots in which receive window "
+                   "opportunities are batched. The wheel covers 65536 slots, "
+                   "so the minimum keeps both receive windows after the "
+                   "longest receive delay, 15 s, within it.",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&DownlinkPlanner::m_slotDuration),
+                   MakeTimeChecker (MicroSeconds (250)))
+    .SetGroupName ("lorawan");
+  return tid;
+}
+
+DownlinkPlanner::DownlinkPlanner () :
+  m_currentTurn (0),
+  m_currentSlot (0),
+  m_nPlanned (0),
+  m_eventSlot (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DownlinkPlanner::~DownlinkPlanner ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DownlinkPlanner::SetBatchCallback (BatchCallback callback)
+{
+  NS_LOG_FUNCTION (this);
+  m_batchCallback = callback;
+}
+
+void
+DownlinkPlanner::Plan (Time time, const Opportunity &opportunity)
+{
+  NS_LOG_FUNCTION (this << time << opportunity.deviceAddress << opportunity.window);
+  NS_ASSERT (time >= Simulator::Now ());
+
+  // Round up to the next slot
+  int64_t slotDuration = m_slotDuration.GetTimeStep ();
+  uint64_t slot = (time.GetTimeStep () + slotDuration - 1) / slotDuration;
+
+  if (m_nPlanned == 0)
+    {
+      // The wheel is empty: move it forward to the current time
+      uint64_t nowSlot = (Simulator::Now ().GetTimeStep () + slotDuration - 1)
+        / slotDuration;
+      m_currentSlot = std::max (m_currentSlot, nowSlot);
+      m_currentTurn = m_currentSlot >> WHEEL_BITS;
+    }
+
+  // The current slot may already have been processed, if this is called
+  // by the batch callback with a null delay
+  slot = std::max (slot, m_currentSlot);
+
+  Entry entry;
+  entry.slot = slot;
+  entry.opportunity = opportunity;
+
+  uint64_t turn = slot >> WHEEL_BITS;
+  if (turn == m_currentTurn)
+    {
+      m_slots[slot & WHEEL_MASK].push_back (entry);
+    }
+  else if (turn - m_currentTurn < WHEEL_SIZE)
+    {
+      m_turns[turn & WHEEL_MASK].push_back (entry);
+    }
+  else
+    {
+      m_overflow.push_back (entry);
+    }
+  m_nPlanned++;
+
+  ScheduleSlot (slot);
+}
+
+uint32_t
+DownlinkPlanner::GetNPlanned (void) const
+{
+  return m_nPlanned;
+}
+
+void
+DownlinkPlanner::ScheduleSlot (uint64_t slot)
+{
+  if (m_event.IsRunning () && m_eventSlot <= slot)
+    {
+      return;
+    }
+
+  m_event.Cancel ();
+  m_eventSlot = slot;
+  Time slotStart = TimeStep (slot * m_slotDuration.GetTimeStep ());
+  m_event = Simulator::Schedule (slotStart - Simulator::Now (),
+                                 &DownlinkPlanner::ProcessSlot, this);
+}
+
+uint64_t
+DownlinkPlanner::FindNextSlot (void) const
+{
+  // Look in the rest of the current turn first
+  for (uint64_t slot = m_currentSlot; (slot >> WHEEL_BITS) == m_currentTurn; slot++)
+    {
+      if (!m_slots[slot & WHEEL_MASK].empty ())
+        {
+          return slot;
+        }
+    }
+
+  // Then find the first turn with opportunities, and its earliest one
+  for (uint64_t turn = m_currentTurn + 1; turn < m_currentTurn + WHEEL_SIZE; turn++)
+    {
+      const std::vector<Entry> &bucket = m_turns[turn & WHEEL_MASK];
+      if (!bucket.empty ())
+        {
+          uint64_t slot = bucket.front ().slot;
+          for (auto it = bucket.begin (); it != bucket.end (); ++it)
+            {
+              slot = std::min (slot, it->slot);
+            }
+          return slot;
+        }
+    }
+
+  // Finally, look in the overflow list
+  if (!m_overflow.empty ())
+    {
+      uint64_t slot = m_overflow.front ().slot;
+      for (auto it = m_overflow.begin (); it != m_overflow.end (); ++it)
+        {
+          slot = std::min (slot, it->slot);
+        }
+      return slot;
+    }
+
+  NS_FATAL_ERROR ("No opportunity found in a non-empty DownlinkPlanner");
+  return 0;
+}
+
+void
+DownlinkPlanner::ProcessSlot (void)
+{
+  uint64_t slot = m_eventSlot;
+  uint64_t turn = slot >> WHEEL_BITS;
+
+  NS_LOG_FUNCTION (this << slot);
+
+  if (turn != m_currentTurn)
+    {
+      // Move the opportunities of the new turn to the first level. Since this
+      // is the earliest planned slot, the previous turns are empty.
+      NS_ASSERT (turn > m_currentTurn);
+      std::vector<Entry> &bucket = m_turns[turn & WHEEL_MASK];
+      for (auto it = bucket.begin (); it != bucket.end (); ++it)
+        {
+          m_slots[it->slot & WHEEL_MASK].push_back (*it);
+        }
+      bucket.clear ();
+      m_currentTurn = turn;
+      DrainOverflow ();
+    }
+
+  std::vector<Entry> &entries = m_slots[slot & WHEEL_MASK];
+  m_batch.clear ();
+  for (auto it = entries.begin (); it != entries.end (); ++it)
+    {
+      m_batch.push_back (it->opportunity);
+    }
+  m_nPlanned -= entries.size ();
+  entries.clear ();
+  m_currentSlot = slot + 1;
+
+  NS_LOG_DEBUG ("Processing " << m_batch.size () << " opportunities");
+
+  if (!m_batch.empty () && !m_batchCallback.IsNull ())
+    {
+      m_batchCallback (m_batch);
+    }
+
+  // The callback may have planned new opportunities, but the earliest one
+  // may be an older one
+  if (m_nPlanned > 0)
+    {
+      ScheduleSlot (FindNextSlot ());
+    }
+}
+
+void
+DownlinkPlanner::DrainOverflow (void)
+{
+  uint32_t i = 0;
+  while (i < m_overflow.size ())
+    {
+      const Entry &entry = m_overflow[i];
+      uint64_t turn = entry.slot >> WHEEL_BITS;
+      if (turn - m_currentTurn >= WHEEL_SIZE)
+        {
+          i++;
+          continue;
+        }
+      if (turn == m_currentTurn)
+        {
+          m_slots[entry.slot & WHEEL_MASK].push_back (entry);
+        }
+      else
+        {
+          m_turns[turn & WHEEL_MASK].push_back (entry);
+        }
+      m_overflow[i] = m_overflow.back ();
+      m_overflow.pop_back ();
+    }
+}
+
+void
+DownlinkPlanner::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_event.Cancel ();
+  for (uint32_t i = 0; i < WHEEL_SIZE; i++)
+    {
+      m_slots[i].clear ();
+      m_turns[i].clear ();
+    }
+  m_overflow.clear ();
+  m_nPlanned = 0;
+  m_batchCallback = MakeNullCallback<void, std::vector<Opportunity> &> ();
+
+  Object::DoDispose ();
+}
+
+} // namespace lorawan
+} // namespace ns3
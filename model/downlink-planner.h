@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef DOWNLINK_PLANNER_H
+#define DOWNLINK_PLANNER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include "ns3/lora-device-address.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Collect the receive window opportunities of the Network Server, and hand
+ * them over in batches.
+ *
+ * Opportunities are rounded up to the next multiple of SlotDuration, and
+ * all those falling in the same slot are passed together to the batch
+ * callback, from a single simulator event. Rounding up ensures that a reply
+ * is never sent before the device opens its receive window.
+ *
+ * Opportunities are stored in a hierarchical timer wheel with two levels of
+ * 256 buckets: the first level holds the slots of the current turn of 256
+ * slots, the second one the following 255 turns, whose opportunities are
+ * moved to the first level when their turn begins. Planning an opportunity
+ * thus costs a push in a bucket, and a simulator event is only scheduled
+ * for the next slot that is not empty. The rare opportunities that are more
+ * than 255 turns ahead, like the ping slots of Class B devices with a long
+ * periodicity, wait in an overflow list until they fit in the wheel.
+ */
+class DownlinkPlanner : public Object
+{
+public:
+  /**
+   * The kinds of receive windows in which a downlink can be sent.
+   */
+  enum Window
+  {
+    FIRST_WINDOW = 1, //!< The first receive window after an uplink
+    SECOND_WINDOW = 2, //!< The second receive window after an uplink
+    PING_SLOT = 3, //!< A ping slot of a Class B device
+    CONTINUOUS_RX = 4 //!< The continuous reception of a Class C device
+  };
+
+  /**
+   * A receive window opportunity of a device.
+   */
+  struct Opportunity
+  {
+    LoraDeviceAddress deviceAddress; //!< The device
+    int window; //!< The receive window, a Window value
+    bool replyPrepared; //!< Whether the controller already prepared the reply
+  };
+
+  /**
+   * Callback invoked with the opportunities of a slot. The callback can plan
+   * new opportunities, in later slots.
+   */
+  typedef Callback<void, std::vector<Opportunity> &> BatchCallback;
+
+  static TypeId GetTypeId (void);
+
+  DownlinkPlanner ();
+  virtual ~DownlinkPlanner ();
+
+  /**
+   * Set the callback that handles the opportunities of each slot.
+   */
+  void SetBatchCallback (BatchCallback callback);
+
+  /**
+   * Plan an opportunity, to be handled in the slot containing the given time
+   * or, if this time is not at the start of a slot, in the next one.
+   */
+  void Plan (Time time, const Opportunity &opportunity);
+
+  /**
+   * \return The number of opportunities that are planned.
+   */
+  uint32_t GetNPlanned (void) const;
+
+private:
+  void DoDispose (void);
+
+  /**
+   * Handle the slot of the scheduled event.
+   */
+  void ProcessSlot (void);
+
+  /**
+   * Schedule the event for the first slot with opportunities, if it is
+   * earlier than the one already scheduled.
+   */
+  void ScheduleSlot (uint64_t slot);
+
+  /**
+   * \return The first slot, from m_currentSlot on, with opportunities.
+   */
+  uint64_t FindNextSlot (void) const;
+
+  /**
+   * Move the overflow entries that fit in the wheel to the second level.
+   */
+  void DrainOverflow (void);
+
+  struct Entry
+  {
+    uint64_t slot;
+    Opportunity opportunity;
+  };
+
+  static const uint32_t WHEEL_BITS = 8;
+  static const uint32_t WHEEL_SIZE = 1 << WHEEL_BITS;
+  static const uint32_t WHEEL_MASK = WHEEL_SIZE - 1;
+
+  Time m_slotDuration; //!< The granularity of the batches
+
+  std::vector<Entry> m_slots[WHEEL_SIZE]; //!< First level, one bucket per slot
+  std::vector<Entry> m_turns[WHEEL_SIZE]; //!< Second level, one bucket per turn
+  std::vector<Entry> m_overflow; //!< Entries beyond the second level
+  uint64_t m_currentTurn; //!< The turn of the slots in the first level
+  uint64_t m_currentSlot; //!< The first slot that was not processed yet
+  uint32_t m_nPlanned; //!< The number of opportunities in the wheel
+
+  EventId m_event; //!< The event of the next slot to process
+  uint64_t m_eventSlot; //!< The slot of m_event
+
+  std::vector<Opportunity> m_batch; //!< Reused for each batch
+  BatchCallback m_batchCallback; //!< The handler of the batches
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* DOWNLINK_PLANNER_H */
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/duration-histogram.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("DurationHistogram");
+
+DurationHistogram::DurationHistogram () :
+  DurationHistogram (Seconds (60), 60)
+{
+}
+
+DurationHistogram::DurationHistogram (Time binWidth, uint32_t nBins)
+{
+  SetBins (binWidth, nBins);
+}
+
+void
+DurationHistogram::SetBins (Time binWidth, uint32_t nBins)
+{
+  NS_LOG_FUNCTION (this << binWidth << nBins);
+  NS_ABORT_MSG_UNLESS (binWidth.IsStrictlyPositive (),
+                       "The bins of a DurationHistogram must have a positive width");
+  NS_ABORT_MSG_UNLESS (nBins > 0, "A DurationHistogram needs at least one bin");
+
+  m_binWidth = binWidth;
+  m_counts.assign (nBins, 0);
+  m_totalCount = 0;
+  m_total = Seconds (0);
+  m_max = Seconds (0);
+}
+
+Time
+DurationHistogram::GetBinWidth (void) const
+{
+  return m_binWidth;
+}
+
+uint32_t
+DurationHistogram::GetNBins (void) const
+{
+  return m_counts.size ();
+}
+
+void
+DurationHistogram::Add (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+
+  uint64_t bin = duration.GetTimeStep () / m_binWidth.GetTimeStep ();
+  m_counts[std::min<uint64_t> (bin, m_counts.size () - 1)]++;
+  m_totalCount++;
+  m_total += duration;
+  m_max = Max (m_max, duration);
+}
+
+bool
+DurationHistogram::HasSameBins (const DurationHistogram &other) const
+{
+  return other.m_binWidth == m_binWidth && other.m_counts.size () == m_counts.size ();
+}
+
+void
+DurationHistogram::Merge (const DurationHistogram &other)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (HasSameBins (other), "Only histograms with the same bins can be merged");
+
+  for (uint32_t i = 0; i < m_counts.size (); i++)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+  m_totalCount += other.m_totalCount;
+  m_total += other.m_total;
+  m_max = Max (m_max, other.m_max);
+}
+
+uint64_t
+DurationHistogram::GetCount (uint32_t bin) const
+{
+  return m_counts.at (bin);
+}
+
+uint64_t
+DurationHistogram::GetTotalCount (void) const
+{
+  return m_totalCount;
+}
+
+Time
+DurationHistogram::GetTotal (void) const
+{
+  return m_total;
+}
+
+Time
+DurationHistogram::GetMax (void) const
+{
+  return m_max;
+}
+
+void
+DurationHistogram::Print (std::ostream &os) const
+{
+  bool first = true;
+  for (uint32_t i = 0; i < m_counts.size (); i++)
+    {
+      if (m_counts[i] > 0)
+        {
+          os << (first ? "" : " ") << m_binWidth.GetSeconds () * i
+             << (i + 1 == m_counts.size () ? "+" : "") << ": " << m_counts[i];
+          first = false;
+        }
+    }
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef DURATION_HISTOGRAM_H
+#define DURATION_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A histogram of durations with bins of fixed width, used to keep the
+ * distribution of periods like the time a device spends off without storing
+ * each of them.
+ *
+ * The last bin also counts all the durations that exceed the histogram.
+ */
+class DurationHistogram
+{
+public:
+  DurationHistogram ();
+
+  /**
+   * \param binWidth The width of each bin.
+   * \param nBins The number of bins.
+   */
+  DurationHistogram (Time binWidth, uint32_t nBins);
+
+  /**
+   * Change the bins, discarding the durations added so far.
+   */
+  void SetBins (Time binWidth, uint32_t nBins);
+
+  Time GetBinWidth (void) const;
+
+  uint32_t GetNBins (void) const;
+
+  /**
+   * Add a duration to the histogram.
+   */
+  void Add (Time duration);
+
+  /**
+   * \return Whether another histogram has the same bins, and can be merged.
+   */
+  bool HasSameBins (const DurationHistogram &other) const;
+
+  /**
+   * Add the durations of another histogram, which must have the same bins.
+   */
+  void Merge (const DurationHistogram &other);
+
+  /**
+   * \return The number of durations in a bin.
+   */
+  uint64_t GetCount (uint32_t bin) const;
+
+  /**
+   * \return The number of durations added.
+   */
+  uint64_t GetTotalCount (void) const;
+
+  /**
+   * \return The sum of the durations added.
+   */
+  Time GetTotal (void) const;
+
+  /**
+   * \return The longest duration added.
+   */
+  Time GetMax (void) const;
+
+  /**
+   * Print the non-empty bins, as "lower bound [s]: count", on a single line.
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  Time m_binWidth; //!< The width of each bin
+  std::vector<uint64_t> m_counts; //!< The durations in each bin
+  uint64_t m_totalCount; //!< The number of durations added
+  Time m_total; //!< The sum of the durations added
+  Time m_max; //!< The longest duration added
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+#endif /* DURATION_HISTOGRAM_H */
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/end-device-energy-admission.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/lora-phy.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("EndDeviceEnergyAdmission");
+
+NS_OBJECT_ENSURE_REGISTERED (EndDeviceEnergyAdmission);
+
+std::map<EndDeviceEnergyAdmission::AirTimeKey, double> EndDeviceEnergyAdmission::m_airTimes;
+
+TypeId
+EndDeviceEnergyAdmission::GetTypeId (void)
+{
+  static TypeId tid =
+      TypeId ("ns3::EndDeviceEnergyAdmission")
+          .SetParent<Object> ()
+          .SetGroupName ("lorawan")
+          .AddConstructor<EndDeviceEnergyAdmission> ()
+          .AddTraceSource ("AdmissionDecision",
+                           "Predicted voltage, margin over the low voltage "
+                           "threshold and outcome of each admission decision",
+                           MakeTraceSourceAccessor (&EndDeviceEnergyAdmission::m_admissionDecision),
+                           "ns3::lorawan::EndDeviceEnergyAdmission::AdmissionDecisionCallback");
+  return tid;
+}
+
+EndDeviceEnergyAdmission::EndDeviceEnergyAdmission ()
+  : m_minVoltage (0),
+    m_supplyVoltage (0),
+    m_capacitance (0),
+    m_sf (MAX_DATA_RATES, 0),
+    m_bandwidthHz (MAX_DATA_RATES, 0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EndDeviceEnergyAdmission::~EndDeviceEnergyAdmission ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EndDeviceEnergyAdmission::Bind (Ptr<CapacitorEnergySource> capacitor,
+                                Ptr<LoraRadioEnergyModel> radio, Ptr<EndDeviceLorawanMac> mac)
+{
+  NS_LOG_FUNCTION (this << capacitor << radio << mac);
+  NS_ASSERT (capacitor != 0 && radio != 0 && mac != 0);
+
+  m_capacitor = capacitor;
+  m_radio = radio;
+
+  m_supplyVoltage = capacitor->GetSupplyVoltage ();
+  m_capacitance = capacitor->GetCapacitance ();
+  m_minVoltage = capacitor->GetLowVoltageThreshold () * m_supplyVoltage;
+
+  for (uint8_t dr = 0; dr < MAX_DATA_RATES; dr++)
+    {
+      m_sf[dr] = mac->GetSfFromDataRate (dr);
+      m_bandwidthHz[dr] = mac->GetBandwidthFromDataRate (dr);
+    }
+
+  // Forget values computed for a previous radio
+  m_txCurrent.clear ();
+}
+
+double
+EndDeviceEnergyAdmission::GetAirTime (uint8_t dataRate, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << unsigned (dataRate) << size);
+  NS_ASSERT (dataRate < MAX_DATA_RATES);
+
+  AirTimeKey key (m_sf[dataRate], m_bandwidthHz[dataRate], size);
+  std::map<AirTimeKey, double>::const_iterator it = m_airTimes.find (key);
+  if (it != m_airTimes.end ())
+    {
+      return it->second;
+    }
+
+  // FOR MODEL COMPARISON These are the parameters that were used by
+  // EndDeviceLorawanMac for the energy check
+  LoraTxParameters params;
+  params.sf = m_sf[dataRate];
+  params.headerDisabled = 1;
+  params.codingRate = 1;
+  params.bandwidthHz = m_bandwidthHz[dataRate];
+  params.nPreamble = 8;
+  params.crcEnabled = 1;
+  params.lowDataRateOptimizationEnabled = 0;
+
+  double airTime = LoraPhy::GetOnAirTime (Create<Packet> (size), params).GetSeconds ();
+  NS_LOG_DEBUG ("Computed time on air for DR" << unsigned (dataRate) << ", " << size
+                                              << " bytes: " << airTime << " s");
+  m_airTimes[key] = airTime;
+  return airTime;
+}
+
+double
+EndDeviceEnergyAdmission::GetTxCurrent (double txPowerDbm)
+{
+  NS_LOG_FUNCTION (this << txPowerDbm);
+
+  std::map<double, double>::const_iterator it = m_txCurrent.find (txPowerDbm);
+  if (it != m_txCurrent.end ())
+    {
+      return it->second;
+    }
+
+  Ptr<LoraTxCurrentModel> model = m_radio->GetTxCurrentModel ();
+  double current = model ? model->CalcTxCurrent (txPowerDbm) : m_radio->GetTxCurrentA ();
+  m_txCurrent[txPowerDbm] = current;
+  return current;
+}
+
+double
+EndDeviceEnergyAdmission::PredictVoltage (uint8_t dataRate, uint32_t size, double txPowerDbm)
+{
+  NS_LOG_FUNCTION (this << unsigned (dataRate) << size << txPowerDbm);
+  NS_ASSERT_MSG (m_capacitor != 0, "Bind must be called before any prediction");
+
+  double actualVoltage = m_capacitor->GetActualVoltage ();
+  return CapacitorEnergySource::ComputeRcVoltage (actualVoltage, GetTxCurrent (txPowerDbm),
+                                                  m_capacitor->GetHarvestersPower (),
+                                                  m_supplyVoltage, m_capacitance,
+                                                  GetAirTime (dataRate, size));
+}
+
+bool
+EndDeviceEnergyAdmission::Admit (uint8_t dataRate, uint32_t size, double txPowerDbm)
+{
+  NS_LOG_FUNCTION (this << unsigned (dataRate) << size << txPowerDbm);
+
+  double predictedVoltage = PredictVoltage (dataRate, size, txPowerDbm);
+  double margin = predictedVoltage - m_minVoltage;
+  bool admitted = margin >= 0;
+
+  NS_LOG_DEBUG ("predicted V, " << predictedVoltage << " min V, " << m_minVoltage
+                                << " admitted " << admitted);
+  m_admissionDecision (predictedVoltage, margin, admitted);
+  return admitted;
+}
+
+void
+EndDeviceEnergyAdmission::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_capacitor = 0;
+  m_radio = 0;
+  Object::DoDispose ();
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef END_DEVICE_ENERGY_ADMISSION_H
+#define END_DEVICE_ENERGY_ADMISSION_H
+
+#include "ns3/object.h"
+#include "ns3/traced-callback.h"
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3 {
+
+class CapacitorEnergySource;
+
+namespace lorawan {
+
+class LoraRadioEnergyModel;
+class EndDeviceLorawanMac;
+
+/**
+ * \brief Decide whether an end device has enough energy to start a new
+ * transmission.
+ *
+ * Before each new transmission, the voltage of the capacitor at the end of
+ * the transmission is predicted, and compared with the low voltage threshold
+ * of the source. If it would fall below it, the transmission is not admitted.
+ *
+ * The energy source, the radio energy model and all the parameters that do
+ * not change during the simulation (threshold, capacitance, SF and bandwidth
+ * of each data rate) are resolved once, when Bind is called by
+ * LoraRadioEnergyModelHelper. The time on air of each (SF, bandwidth, packet
+ * size) and the tx current of each tx power are computed the first time they
+ * are needed and then looked up, so that each decision only costs the
+ * evaluation of the capacitor voltage. Times on air only depend on the
+ * transmission parameters, and are shared by all devices.
+ */
+class EndDeviceEnergyAdmission : public Object
+{
+public:
+  /**
+   * TracedCallback signature for admission decisions.
+   *
+   * \param [in] predictedVoltage The voltage expected at the end of the
+   * transmission [V]
+   * \param [in] margin The difference between predictedVoltage and the low
+   * voltage threshold of the source [V]
+   * \param [in] admitted Whether the transmission was admitted
+   */
+  typedef void (*AdmissionDecisionCallback) (double predictedVoltage, double margin,
+                                             bool admitted);
+
+  static TypeId GetTypeId (void);
+
+  EndDeviceEnergyAdmission ();
+  virtual ~EndDeviceEnergyAdmission ();
+
+  /**
+   * Resolve and save the objects and parameters needed for the decisions.
+   *
+   * \param capacitor The energy source of the device
+   * \param radio The energy model of the LoRa radio
+   * \param mac The MAC layer of the device, used to map data rates to
+   * transmission parameters
+   */
+  void Bind (Ptr<CapacitorEnergySource> capacitor, Ptr<LoraRadioEnergyModel> radio,
+             Ptr<EndDeviceLorawanMac> mac);
+
+  /**
+   * Decide whether a transmission can start now.
+   *
+   * \param dataRate The data rate of the transmission
+   * \param size The size of the packet, including headers [bytes]
+   * \param txPowerDbm The transmission power [dBm]
+   * \return Whether the voltage at the end of the transmission is not below
+   * the low voltage threshold
+   */
+  bool Admit (uint8_t dataRate, uint32_t size, double txPowerDbm);
+
+  /**
+   * Predict the voltage of the capacitor at the end of a transmission starting
+   * now.
+   *
+   * \param dataRate The data rate of the transmission
+   * \param size The size of the packet, including headers [bytes]
+   * \param txPowerDbm The transmission power [dBm]
+   * \return The predicted voltage [V]
+   */
+  double PredictVoltage (uint8_t dataRate, uint32_t size, double txPowerDbm);
+
+  /**
+   * \return The time on air of a packet [s], as used for the prediction.
+   */
+  double GetAirTime (uint8_t dataRate, uint32_t size);
+
+  /**
+   * \return The current drawn while transmitting at a given power [A].
+   */
+  double GetTxCurrent (double txPowerDbm);
+
+private:
+  /// Defined in ns3::Object
+  void DoDispose (void);
+
+  static const uint8_t MAX_DATA_RATES = 6; //!< Number of data rates
+
+  /// SF, bandwidth [Hz] and packet size [bytes] of a time on air
+  typedef std::tuple<uint8_t, double, uint32_t> AirTimeKey;
+
+  Ptr<CapacitorEnergySource> m_capacitor; //!< The source of the device
+  Ptr<LoraRadioEnergyModel> m_radio; //!< The energy model of the radio
+
+  double m_minVoltage; //!< Low voltage threshold of the source [V]
+  double m_supplyVoltage; //!< Max supply voltage of the source [V]
+  double m_capacitance; //!< Capacitance of the source [F]
+
+  std::vector<uint8_t> m_sf; //!< SF of each data rate
+  std::vector<double> m_bandwidthHz; //!< Bandwidth of each data rate
+
+  /// Time on air [s] of the transmissions made so far by any device
+  static std::map<AirTimeKey, double> m_airTimes;
+  /// Tx current per tx power
+  std::map<double, double> m_txCurrent;
+
+  /// Trace source for admission decisions
+  TracedCallback<double, double, bool> m_admissionDecision;
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+
+#endif /* END_DEVICE_ENERGY_ADMISSION_H */
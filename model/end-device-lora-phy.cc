@@ -28,6 +28,7 @@
 #include "ns3/capacitor-energy-source.h"
 #include "ns3/simulator.h"
 #include "ns3/lora-tag.h"
+#include "ns3/lora-flight-recorder.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -37,6 +38,18 @@ NS_LOG_COMPONENT_DEFINE ("EndDeviceLoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (EndDeviceLoraPhy);
 
+/**
+ * Keep the state changes of a PHY in the flight recorder.
+ */
+static void
+RecordStateChange (const Ptr<NetDevice> &device, EndDeviceLoraPhy::State state)
+{
+  if (LoraFlightRecorder::IsEnabled ())
+    {
+      LoraFlightRecorder::RecordStateChange (device ? device->GetNode ()->GetId () : 0, state);
+    }
+}
+
 /**************************
  *  Listener destructor  *
  *************************/
@@ -76,7 +89,8 @@ EndDeviceLoraPhy::GetTypeId (void)
 EndDeviceLoraPhy::EndDeviceLoraPhy () :
   m_state (SLEEP),
   m_frequency (868.1),
-  m_sf (7)
+  m_sf (7),
+  m_energyGateBound (false)
 {
 }
 
@@ -142,6 +156,7 @@ EndDeviceLoraPhy::SwitchToSleep (void)
     }
 
   m_state = SLEEP;
+  RecordStateChange (m_device, SLEEP);
 
   // Notify listeners of the state change
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -161,6 +176,7 @@ EndDeviceLoraPhy::SwitchToStandby (void)
     {
       NS_LOG_DEBUG ("Actually switching to standby");
       m_state = STANDBY;
+      RecordStateChange (m_device, STANDBY);
 
       // Notify listeners of the state change
       for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -184,6 +200,7 @@ EndDeviceLoraPhy::SwitchToRx (void)
   if (IsEnergyStateOk ())
     {
       m_state = RX;
+      RecordStateChange (m_device, RX);
 
       // Notify listeners of the state change
       for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -207,6 +224,7 @@ EndDeviceLoraPhy::SwitchToTx (double txPowerDbm)
       {
         NS_LOG_DEBUG("actually switched to tx!");
         m_state = TX;
+        RecordStateChange (m_device, TX);
 
         // Notify listeners of the state change
         for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -233,6 +251,7 @@ EndDeviceLoraPhy::SwitchToIdle (void)
 
         NS_LOG_DEBUG ("Actually switching to idle");
         m_state = IDLE;
+        RecordStateChange (m_device, IDLE);
 
         // Notify listeners of the state change
         for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -258,6 +277,7 @@ EndDeviceLoraPhy::SwitchToOff (void)
     }
 
   m_state = OFF;
+  RecordStateChange (m_device, OFF);
 
   // Notify listeners of the state change
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -278,6 +298,7 @@ EndDeviceLoraPhy::SwitchToTurnOn (void)
     // We won't need to enter in KO state, but this updates the energy source
     {
       m_state = TURNON;
+      RecordStateChange (m_device, TURNON);
 
       // Notify listeners of the state change
       for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -319,71 +340,63 @@ EndDeviceLoraPhy::UnregisterListener (EndDeviceLoraPhyListener *listener)
   EndDeviceLoraPhy::IsEnergyStateOk (void)
   {
     NS_LOG_FUNCTION (this);
-    Ptr<EnergySourceContainer> nodeEnergySourceContainer =
-        m_device->GetNode ()->GetObject<EnergySourceContainer> ();
-    if (nodeEnergySourceContainer == 0)
+    if (m_energyGate == 0 && !BindDefaultEnergyGate ())
       {
         NS_LOG_DEBUG ("Energy source not found - return true");
         return true;
       }
 
-    Ptr<EnergySource> nodeEnergySource = nodeEnergySourceContainer -> Get(0);
-    nodeEnergySource->UpdateEnergySource ();
-    // If CapacitorEnergySource
-    Ptr<CapacitorEnergySource> capacitorEnergySource =
-        nodeEnergySource->GetObject<CapacitorEnergySource> ();
-    if (!(capacitorEnergySource == 0))
+    bool operational = m_energyGate->IsOperational ();
+    NS_LOG_DEBUG ("Energy state ok? " << operational);
+    return operational;
+  }
+
+  void
+  EndDeviceLoraPhy::SetEnergyGate (Ptr<EnergyGate> gate)
+  {
+    NS_LOG_FUNCTION (this << gate);
+    m_energyGate = gate;
+    m_energyGateBound = true;
+  }
+
+  Ptr<EnergyGate>
+  EndDeviceLoraPhy::GetEnergyGate (void) const
+  {
+    return m_energyGate;
+  }
+
+  bool
+  EndDeviceLoraPhy::BindDefaultEnergyGate (void)
+  {
+    NS_LOG_FUNCTION (this);
+    if (m_energyGateBound)
       {
-        NS_LOG_DEBUG ("found capacitorEnergySource pointer");
-        if (capacitorEnergySource->IsDepleted ())
-          {
-            NS_LOG_DEBUG ("Capacitor energy depleted");
-            return false;
-          }
-        else
-          {
-            NS_LOG_DEBUG ("Energy state ok!");
-            return true;
-          }
+        return m_energyGate != 0;
       }
 
-    // If BasicEnergySource
-    Ptr<BasicEnergySource> basicEnergySource =
-      nodeEnergySource->GetObject<BasicEnergySource> ();
-    if (!(basicEnergySource == 0))
+    Ptr<EnergySourceContainer> nodeEnergySourceContainer =
+        m_device->GetNode ()->GetObject<EnergySourceContainer> ();
+    if (nodeEnergySourceContainer == 0)
       {
-        NS_LOG_DEBUG ("found basicEnergySource pointer");
-        DoubleValue lowBatteryThreshold;
-        basicEnergySource->GetAttribute ("BasicEnergyLowBatteryThreshold",
-                                         lowBatteryThreshold);
-        double fraction = basicEnergySource->GetEnergyFraction ();
-        return (! (fraction <= lowBatteryThreshold.Get ()));
+        // Energy may still be installed later: look again next time
+        return false;
       }
 
-    NS_LOG_DEBUG ("Energy Source not found: returning true");
-    return true;
-
+    m_energyGate = EnergyGate::CreateFor (nodeEnergySourceContainer->Get (0));
+    m_energyGateBound = true;
+    return m_energyGate != 0;
   }
 
   void
   EndDeviceLoraPhy::SetCheckForEnergyDepletion (void)
   {
     NS_LOG_FUNCTION (this);
-    Ptr<EnergySourceContainer> nodeEnergySourceContainer =
-        m_device->GetNode ()->GetObject<EnergySourceContainer> ();
-    Ptr<EnergySource> nodeEnergySource = nodeEnergySourceContainer->Get (0);
-    // If CapacitorEnergySource
-    Ptr<CapacitorEnergySource> capacitorEnergySource =
-        nodeEnergySource->GetObject<CapacitorEnergySource> ();
-    if (!(capacitorEnergySource == 0))
-      {
-        NS_LOG_DEBUG ("found capacitorEnergySource pointer");
-        capacitorEnergySource->SetCheckForEnergyDepletion ();
-      }
-    else
+    if (m_energyGate == 0 && !BindDefaultEnergyGate ())
       {
-        NS_LOG_DEBUG ("Capacitor source not found!");
+        NS_LOG_DEBUG ("Energy source not found!");
+        return;
       }
+    m_energyGate->NotifyStateChanged ();
   }
 
 } // lorawan
@@ -32,6 +32,7 @@
 #include "ns3/lora-phy.h"
 #include "ns3/energy-source.h"
 #include "ns3/basic-energy-source.h"
+#include "ns3/energy-gate.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -279,11 +280,22 @@ public:
   static const double sensitivity[6]; //!< The sensitivity vector of this device to different SFs
 
   /**
-   * Before switching to a new state, update the energy source, which will go to
-   * sleep/off state if needed. If everything ok, switch to the state.
+   * Before switching to a new state, ask the energy gate whether the energy
+   * source allows the device to operate. If no gate was set, one fitting the
+   * first energy source of the node is created the first time it is needed.
    */
   bool IsEnergyStateOk (void);
 
+  /**
+   * Set the gate used to check the energy source before each state change.
+   */
+  void SetEnergyGate (Ptr<EnergyGate> gate);
+
+  /**
+   * \return The gate used to check the energy source, if already bound.
+   */
+  Ptr<EnergyGate> GetEnergyGate (void) const;
+
     protected :
       /**
    * Switch to the RX state
@@ -296,8 +308,8 @@ public:
   bool SwitchToTx (double txPowerDbm);
 
   /**
-   * If a CapacitorEnergySource is present, call its function to estimate when
-   * energy would be depleted
+   * Notify the energy gate of the state change, so that a
+   * CapacitorEnergySource can estimate when energy would be depleted
    */
   void SetCheckForEnergyDepletion (void);
 
@@ -332,6 +344,17 @@ public:
   typedef std::vector<EndDeviceLoraPhyListener *>::iterator ListenersI;
 
   Listeners m_listeners; //!< PHY listeners
+
+  /**
+   * Create the default gate for the first energy source of the node, if the
+   * node has one.
+   *
+   * \return Whether a gate is now bound.
+   */
+  bool BindDefaultEnergyGate (void);
+
+  Ptr<EnergyGate> m_energyGate; //!< The gate of the energy source
+  bool m_energyGateBound; //!< Whether m_energyGate was already looked for
 };
 
 } /* namespace ns3 */
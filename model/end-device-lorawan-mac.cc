@@ -25,6 +25,7 @@
 #include "ns3/assert.h"
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/energy-source.h"
 #include "ns3/capacitor-energy-source.h"
@@ -96,6 +97,12 @@ EndDeviceLorawanMac::GetTypeId (void)
                            "Trace source indicating if there is enough energy to transmit the current packet",
                            MakeTraceSourceAccessor (&EndDeviceLorawanMac::m_enoughEnergyForTx),
                            "ns3::Packet::TracedCallback")
+          .AddAttribute ("EnergyAdmission",
+                         "The object checking the energy of the device before a new transmission",
+                         PointerValue (),
+                         MakePointerAccessor (&EndDeviceLorawanMac::SetEnergyAdmission,
+                                              &EndDeviceLorawanMac::GetEnergyAdmission),
+                         MakePointerChecker<EndDeviceEnergyAdmission> ())
           .AddConstructor<EndDeviceLorawanMac> ();
   return tid;
 }
@@ -127,8 +134,8 @@ EndDeviceLorawanMac::EndDeviceLorawanMac ()
   m_uniformRV = CreateObject<UniformRandomVariable> ();
 
   // Void the transmission event
-  m_nextTx = EventId ();
-  m_nextTx.Cancel ();
+  m_txTimer = EventId ();
+  m_txTimer.Cancel ();
 
   // Initialize structure for retransmission parameters
   m_retxParams = EndDeviceLorawanMac::LoraRetxParameters ();
@@ -202,13 +209,41 @@ void
 EndDeviceLorawanMac::postponeTransmission (Time netxTxDelay, Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this);
-  // Delete previously scheduled transmissions if any.
-  Simulator::Cancel (m_postponedTx);
-  m_postponedTx = Simulator::Schedule (netxTxDelay, &EndDeviceLorawanMac::DoSend, this, packet);
+  // Replace the previously scheduled transmission, if any. The timer is only
+  // moved if it would expire too late: if it expires earlier, it is rearmed
+  // then.
+  m_pendingTx = packet;
+  m_txTime = Simulator::Now () + netxTxDelay;
+  if (!m_txTimer.IsRunning () || Simulator::GetDelayLeft (m_txTimer) > netxTxDelay)
+    {
+      m_txTimer.Cancel ();
+      m_txTimer = Simulator::Schedule (netxTxDelay, &EndDeviceLorawanMac::TxTimerExpired,
+                                       this);
+    }
   NS_LOG_WARN ("Attempting to send, but the aggregate duty cycle won't allow it. Scheduling a tx at a delay "
                << netxTxDelay.GetSeconds () << ".");
 }
 
+void
+EndDeviceLorawanMac::TxTimerExpired (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  if (now < m_txTime)
+    {
+      m_txTimer = Simulator::Schedule (m_txTime - now, &EndDeviceLorawanMac::TxTimerExpired,
+                                       this);
+      return;
+    }
+
+  Ptr<Packet> packet = m_pendingTx;
+  m_pendingTx = 0;
+  if (packet != 0)
+    {
+      DoSend (packet);
+    }
+}
 
 void
 EndDeviceLorawanMac::DoSend (Ptr<Packet> packet)
@@ -221,6 +256,9 @@ EndDeviceLorawanMac::DoSend (Ptr<Packet> packet)
       m_currentFCnt++;
       NS_LOG_DEBUG ("APP packet: " << packet << ".");
 
+      // Size of the payload, before the headers are added
+      uint32_t payloadSize = packet->GetSize ();
+
       // Add the Lora Frame Header to the packet
       LoraFrameHeader frameHdr;
       ApplyNecessaryOptions (frameHdr);
@@ -235,77 +273,25 @@ EndDeviceLorawanMac::DoSend (Ptr<Packet> packet)
       packet->AddHeader (macHdr);
 
       // Check energy conditions
-      Ptr<EnergySourceContainer> nodeEnergySourceContainer =
-          m_device->GetNode ()->GetObject<EnergySourceContainer> ();
-      if (!(nodeEnergySourceContainer == 0))
+      if (m_energyAdmission)
         {
-
-          // Predict energy consumption to decide if we can transmit
-          // Craft LoraTxParameters object
-          // LoraTxParameters params;
-          // params.sf = GetSfFromDataRate (m_dataRate);
-          // params.headerDisabled = m_headerDisabled;
-          // params.codingRate = m_codingRate;
-          // params.bandwidthHz = GetBandwidthFromDataRate (m_dataRate);
-          // params.nPreamble = m_nPreambleSymbols;
-          // params.crcEnabled = 1;
-          // params.lowDataRateOptimizationEnabled = 0;
-
-          // FOR MODEL COMPARISON Modify to compare with the model
-          LoraTxParameters params;
-          params.sf = GetSfFromDataRate (m_dataRate);
-          params.headerDisabled = 1;
-          params.codingRate = 1;
-          params.bandwidthHz = GetBandwidthFromDataRate (m_dataRate);
-          params.nPreamble = 8;
-          params.crcEnabled = 1;
-          params.lowDataRateOptimizationEnabled = 0;
-
-          Ptr<LogicalLoraChannel> txChannel = GetChannelForTx ();
-          Time duration = m_phy->GetOnAirTime (packet, params);
-
-          Ptr<LoraRadioEnergyModel> loraradioemodel =
-            nodeEnergySourceContainer->
-            Get(0)-> FindDeviceEnergyModels ("ns3::LoraRadioEnergyModel").Get (0)
-                  ->GetObject<LoraRadioEnergyModel> ();
-
-          // // Soluzione 1 - Using VOLTAGE
-
-          Ptr<CapacitorEnergySource> capacitor =
-            nodeEnergySourceContainer -> Get(0) ->GetObject<CapacitorEnergySource> ();
-          // If capacitor energy source
-          if (!(capacitor == 0))
+          // Predict the voltage at the end of the transmission to decide if
+          // we can transmit
+          if (!m_energyAdmission->Admit (m_dataRate, packet->GetSize (), m_txPower))
             {
-              double actualVoltage = capacitor->GetActualVoltage ();
-              double predictedVoltage =
-                capacitor->PredictVoltageForLorawanState (EndDeviceLoraPhy::TX, actualVoltage, duration);
-              double maxVoltage = capacitor->GetSupplyVoltage ();
-              DoubleValue lowThreshold;
-              capacitor->GetAttribute ("CapacitorLowVoltageThreshold", lowThreshold);
-              NS_LOG_DEBUG ("actual V, " << actualVoltage << " predicted V, " << predictedVoltage
-                                         << " th " << lowThreshold.Get () << ", Vmax "
-                                         << maxVoltage);
-              if (predictedVoltage < lowThreshold.Get () * maxVoltage)
-                {
-                  NS_LOG_DEBUG ("Voltage is not enough!! We can not tx!");
-                  m_enoughEnergyForTx (m_device->GetNode ()->GetId (), packet, Simulator::Now (),
-                                       false);
-                  // TODO? same check fr RXwind?
-                  return;
-                }
-              else
-                {
-                  // Remaining energy is enough. With the transmission we could fall under the battery threshold
-                  m_enoughEnergyForTx (m_device->GetNode ()->GetId (), packet, Simulator::Now (),
-                                       true);
-                }
+              NS_LOG_DEBUG ("Voltage is not enough!! We can not tx!");
+              m_enoughEnergyForTx (m_device->GetNode ()->GetId (), packet, Simulator::Now (),
+                                   false);
+              // TODO? same check fr RXwind?
+              return;
             }
-          else
-            {
-              NS_LOG_DEBUG (
-                  "Capacitor energy source not found: no check on the state of energy/voltage.");
-            }
-        } // end check on energy
+          // Remaining energy is enough. With the transmission we could fall under the battery threshold
+          m_enoughEnergyForTx (m_device->GetNode ()->GetId (), packet, Simulator::Now (), true);
+        }
+      else
+        {
+          NS_LOG_DEBUG ("No energy admission: no check on the state of energy/voltage.");
+        }
 
       // // Soluzione 2 - Using ENERGY
       // double predictedEnergyConsumption =
@@ -352,6 +338,15 @@ EndDeviceLorawanMac::DoSend (Ptr<Packet> packet)
       if (m_mType == LorawanMacHeader::CONFIRMED_DATA_UP)
         {
           m_retxParams.packet = packet->Copy ();
+
+          // Keep the header fields of the retransmissions, which carry the
+          // MAC commands that are added from now on
+          m_retxParams.payloadSize = payloadSize;
+          m_retxParams.frameHeader = LoraFrameHeader ();
+          ApplyNecessaryOptions (m_retxParams.frameHeader);
+          m_retxParams.macHeader = LorawanMacHeader ();
+          ApplyNecessaryOptions (m_retxParams.macHeader);
+
           m_retxParams.retxLeft = m_maxNumbTx;
           m_retxParams.waitingAck = true;
           m_retxParams.firstAttempt = Simulator::Now ();
@@ -383,35 +378,46 @@ EndDeviceLorawanMac::DoSend (Ptr<Packet> packet)
     {
       if (m_retxParams.waitingAck)
         {
+          DoRetransmit ();
+        }
+    }
+
+}
 
-          m_currentFCnt++;
+void
+EndDeviceLorawanMac::DoRetransmit (void)
+{
+  NS_LOG_FUNCTION (this);
 
-          // Remove the headers
-          LorawanMacHeader macHdr;
-          LoraFrameHeader frameHdr;
-          packet->RemoveHeader(macHdr);
-          packet->RemoveHeader(frameHdr);
+  m_currentFCnt++;
 
-          // Add the Lora Frame Header to the packet
-          frameHdr = LoraFrameHeader ();
-          ApplyNecessaryOptions (frameHdr);
-          packet->AddHeader (frameHdr);
+  // Update the fields that change between attempts. MAC commands that were
+  // queued since the first attempt require the complete options.
+  LoraFrameHeader &frameHdr = m_retxParams.frameHeader;
+  if (m_macCommandList.empty ())
+    {
+      frameHdr.SetFCnt (m_currentFCnt);
+      frameHdr.SetAdr (m_controlDataRate);
+    }
+  else
+    {
+      frameHdr = LoraFrameHeader ();
+      ApplyNecessaryOptions (frameHdr);
+    }
 
-          NS_LOG_INFO ("Added frame header of size " << frameHdr.GetSerializedSize () <<
-                       " bytes.");
+  // Replace the headers of the previous attempt. The packet is the one the
+  // trackers were told about at the first attempt: do not create a new one.
+  Ptr<Packet> packet = m_retxParams.packet;
+  packet->RemoveAtStart (packet->GetSize () - m_retxParams.payloadSize);
+  packet->AddHeader (frameHdr);
+  packet->AddHeader (m_retxParams.macHeader);
 
-          // Add the Lorawan Mac header to the packet
-          macHdr = LorawanMacHeader ();
-          ApplyNecessaryOptions (macHdr);
-          packet->AddHeader (macHdr);
-          m_retxParams.retxLeft = m_retxParams.retxLeft - 1;           // decreasing the number of retransmissions
-          NS_LOG_DEBUG ("Retransmitting an old packet.");
+  NS_LOG_INFO ("Replaced the headers, new size " << packet->GetSize () << " bytes.");
 
-          // static_cast<ClassAEndDeviceLorawanMac*>(this)->SendToPhy (m_retxParams.packet);
-          SendToPhy (m_retxParams.packet);
-        }
-    }
+  m_retxParams.retxLeft = m_retxParams.retxLeft - 1;           // decreasing the number of retransmissions
+  NS_LOG_DEBUG ("Retransmitting an old packet.");
 
+  SendToPhy (packet);
 }
 
 void
@@ -617,6 +623,19 @@ EndDeviceLorawanMac::GetMType (void)
   return m_mType;
 }
 
+void
+EndDeviceLorawanMac::SetEnergyAdmission (Ptr<EndDeviceEnergyAdmission> admission)
+{
+  NS_LOG_FUNCTION (this << admission);
+  m_energyAdmission = admission;
+}
+
+Ptr<EndDeviceEnergyAdmission>
+EndDeviceLorawanMac::GetEnergyAdmission (void) const
+{
+  return m_energyAdmission;
+}
+
 void
 EndDeviceLorawanMac::TxFinished (Ptr<const Packet> packet)
 { }
@@ -728,13 +747,17 @@ EndDeviceLorawanMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
 
 void EndDeviceLorawanMac::resetRetransmissionParameters ()
 {
+  // Cancel next retransmissions, if any
+  if (m_pendingTx != 0 && m_pendingTx == m_retxParams.packet)
+    {
+      m_pendingTx = 0;
+      m_txTimer.Cancel ();
+    }
+
   m_retxParams.waitingAck = false;
   m_retxParams.retxLeft = m_maxNumbTx;
   m_retxParams.packet = 0;
   m_retxParams.firstAttempt = Seconds (0);
-
-  // Cancel next retransmissions, if any
-  Simulator::Cancel (m_nextTx);
 }
 
 void
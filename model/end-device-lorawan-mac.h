@@ -31,6 +31,8 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/traced-value.h"
+#include "ns3/end-device-energy-admission.h"
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -76,6 +78,10 @@ public:
   /**
    * Postpone transmission to the specified time and delete previously scheduled transmissions if present.
    *
+   * Postponed transmissions and retransmissions share a single timer: the
+   * packet replaces the one that was waiting, if any, and the timer is only
+   * rescheduled if it would expire after the new transmission time.
+   *
    * \param nextTxDelay Delay at which the transmission will be performed.
    */
   virtual void postponeTransmission (Time nextTxDelay, Ptr<Packet>);
@@ -229,6 +235,18 @@ public:
    */
   LorawanMacHeader::MType GetMType (void);
 
+  /**
+   * Set the object deciding whether there is enough energy to send a new
+   * packet. If not set, no energy check is performed.
+   */
+  void SetEnergyAdmission (Ptr<EndDeviceEnergyAdmission> admission);
+
+  /**
+   * Get the object deciding whether there is enough energy to send a new
+   * packet.
+   */
+  Ptr<EndDeviceEnergyAdmission> GetEnergyAdmission (void) const;
+
   /**
    * Parse and take action on the commands contained on this FrameHeader.
    */
@@ -344,6 +362,9 @@ protected:
     Ptr<Packet> packet = 0;
     bool waitingAck = false;
     uint8_t retxLeft;
+    LorawanMacHeader macHeader; //!< The MAC header of the retransmissions
+    LoraFrameHeader frameHeader; //!< The frame header of the retransmissions
+    uint32_t payloadSize = 0; //!< The size of the payload of packet
   };
 
   /**
@@ -461,24 +482,31 @@ private:
   bool m_controlDataRate;
 
   /**
-   * The event of retransmitting a packet in a consecutive moment if an ACK is not received.
+   * Send the packet being retransmitted again.
    *
-   * This Event is used to cancel the retransmission if the ACK is found in ParseCommand function and
-   * if a newer packet is delivered from the application to be sent.
+   * The headers of the previous attempt are removed from the front of the
+   * packet, and replaced with the ones kept in m_retxParams. The packet
+   * stays the same object, which the trackers know from the first attempt.
    */
-  EventId m_nextTx;
+  void DoRetransmit (void);
 
   /**
-   * The event of a packet that will be re-transmitted in the future
+   * Send the packet waiting for the transmission timer, or rearm the timer
+   * if the transmission was postponed further.
    */
-  EventId m_postponedTx;
+  void TxTimerExpired (void);
 
   /**
-   * The event of transmitting a packet in a consecutive moment, when the duty cycle let us transmit.
+   * The timer of the postponed transmissions and retransmissions.
    *
-   * This Event is used to cancel the transmission of this packet if a newer packet is delivered from the application to be sent.
+   * This Event is used to cancel the retransmission if the ACK is found in
+   * ParseCommand function, and replaced when a newer packet is delivered
+   * from the application to be sent.
    */
-  EventId m_nextRetx;
+  EventId m_txTimer;
+
+  Time m_txTime; //!< When the packet waiting for m_txTimer must be sent
+  Ptr<Packet> m_pendingTx; //!< The packet waiting for m_txTimer
 
   /**
    * The last known link margin.
@@ -509,6 +537,11 @@ private:
 
   uint8_t m_currentFCnt;
 
+  /**
+   * The energy check performed before sending a new packet.
+   */
+  Ptr<EndDeviceEnergyAdmission> m_energyAdmission;
+
 };
 
 } /* namespace ns3 */
@@ -126,13 +126,7 @@ EndDeviceStatus::GetCompleteReplyPacket (void)
 
   // Add headers
   m_reply.frameHeader.SetAddress (m_endDeviceAddress);
-  Ptr<Packet> lastPacket = GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  lastPacket->RemoveHeader (mHdr);
-  lastPacket->RemoveHeader (fHdr);
-  m_reply.frameHeader.SetFCnt (fHdr.GetFCnt ());
+  m_reply.frameHeader.SetFCnt (GetLastFrameInfo ().GetFCnt ());
   m_reply.macHeader.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
   replyPacket->AddHeader (m_reply.frameHeader);
   replyPacket->AddHeader (m_reply.macHeader);
@@ -239,34 +233,32 @@ EndDeviceStatus::SetReplyPayload (Ptr<Packet> replyPayload)
 ///////////////////////
 
 void
-EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const Address &gwAddress)
+EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
+                                       const LoraFrameInfoTag &frameInfo,
+                                       const Address &gwAddress)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = receivedPacket->Copy ();
+  PacketInfoPerGw gwInfo;
+  gwInfo.receivedTime = Simulator::Now ();
+  gwInfo.rxPower = frameInfo.GetReceivePower ();
+  gwInfo.gwAddress = gwAddress;
 
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
+  GatewayList gwList;
+  gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo));
+  InsertReceivedPacket (receivedPacket, frameInfo, gwList);
+}
 
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+void
+EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
+                                       const LoraFrameInfoTag &frameInfo,
+                                       const GatewayList &gwList)
+{
+  NS_LOG_FUNCTION_NOARGS ();
 
   // Update current parameters
-  LoraTag tag;
-  myPacket->RemovePacketTag (tag);
-  SetFirstReceiveWindowSpreadingFactor (tag.GetSpreadingFactor ());
-  SetFirstReceiveWindowFrequency (tag.GetFrequency ());
-
-  // Update Information on the received packet
-  ReceivedPacketInfo info;
-  info.sf = tag.GetSpreadingFactor ();
-  info.frequency = tag.GetFrequency ();
-  info.packet = receivedPacket;
-
-  double rcvPower = tag.GetReceivePower ();
+  SetFirstReceiveWindowSpreadingFactor (frameInfo.GetSpreadingFactor ());
+  SetFirstReceiveWindowFrequency (frameInfo.GetFrequency ());
 
   // Perform insertion in list, also checking that the packet isn't already in
   // the list (it could have been received by another GW already)
@@ -277,32 +269,31 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const A
     {
       // Get the frame counter of the current packet to compare it with the
       // newly received one
-      Ptr<Packet> packetCopy = ((*it).first)->Copy ();
-      LorawanMacHeader currentMacHdr;
-      packetCopy->RemoveHeader (currentMacHdr);
-      LoraFrameHeader currentFrameHdr;
-      frameHdr.SetAsUplink ();
-      packetCopy->RemoveHeader (currentFrameHdr);
-
-      NS_LOG_DEBUG ("Received packet's frame counter: " << unsigned(frameHdr.GetFCnt ())
+      uint16_t currentFCnt = it->second.frameInfo.GetFCnt ();
+
+      NS_LOG_DEBUG ("Received packet's frame counter: " << unsigned(frameInfo.GetFCnt ())
                                                         << "\nCurrent packet's frame counter: "
-                                                        << unsigned(currentFrameHdr.GetFCnt ()));
+                                                        << unsigned(currentFCnt));
 
-      if (frameHdr.GetFCnt () == currentFrameHdr.GetFCnt ())
+      if (frameInfo.GetFCnt () == currentFCnt)
         {
           NS_LOG_INFO ("Packet was already received by another gateway");
 
-          // This packet had already been received from another gateway:
-          // add this gateway's reception information.
-          GatewayList &gwList = it->second.gwList;
+          // This packet had already been received from other gateways:
+          // add these gateways' reception information.
+          GatewayList &receivedGwList = it->second.gwList;
+          for (auto gw = gwList.begin (); gw != gwList.end (); gw++)
+            {
+              bool isNewGateway = receivedGwList.insert (*gw).second;
 
-          PacketInfoPerGw gwInfo;
-          gwInfo.receivedTime = Simulator::Now ();
-          gwInfo.rxPower = rcvPower;
-          gwInfo.gwAddress = gwAddress;
-          gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo));
+              // The ranking only concerns the last packet
+              if (isNewGateway && it == m_receivedPacketList.rbegin ())
+                {
+                  RankGateway (gw->second.rxPower, gw->first);
+                }
+            }
 
-          NS_LOG_DEBUG ("Size of gateway list: " << gwList.size ());
+          NS_LOG_DEBUG ("Size of gateway list: " << receivedGwList.size ());
 
           break; // Exit from the cycle
         }
@@ -310,13 +301,23 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const A
   if (it == m_receivedPacketList.rend ())
     {
       NS_LOG_INFO ("Packet was received for the first time");
-      PacketInfoPerGw gwInfo;
-      gwInfo.receivedTime = Simulator::Now ();
-      gwInfo.rxPower = rcvPower;
-      gwInfo.gwAddress = gwAddress;
-      info.gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo));
+
+      // Update Information on the received packet
+      ReceivedPacketInfo info;
+      info.sf = frameInfo.GetSpreadingFactor ();
+      info.frequency = frameInfo.GetFrequency ();
+      info.packet = receivedPacket;
+      info.frameInfo = frameInfo;
+      info.gwList = gwList;
       m_receivedPacketList.push_back (
           std::pair<Ptr<Packet const>, ReceivedPacketInfo> (receivedPacket, info));
+
+      // Start a new ranking, keeping the memory of the previous one
+      m_gatewayRanking.clear ();
+      for (auto gw = gwList.begin (); gw != gwList.end (); gw++)
+        {
+          RankGateway (gw->second.rxPower, gw->first);
+        }
     }
   NS_LOG_DEBUG (*this);
 }
@@ -336,6 +337,22 @@ EndDeviceStatus::GetLastReceivedPacketInfo (void)
     }
 }
 
+const LoraFrameInfoTag &
+EndDeviceStatus::GetLastFrameInfo (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  static const LoraFrameInfoTag noFrame;
+  auto it = m_receivedPacketList.rbegin ();
+  if (it != m_receivedPacketList.rend ())
+    {
+      return it->second.frameInfo;
+    }
+  else
+    {
+      return noFrame;
+    }
+}
+
 Ptr<Packet const>
 EndDeviceStatus::GetLastPacketReceivedFromDevice (void)
 {
@@ -371,21 +388,38 @@ EndDeviceStatus::GetPowerGatewayMap (void)
   // Create a map of the gateways
   // Key: received power
   // Value: address of the corresponding gateway
-  ReceivedPacketInfo info = m_receivedPacketList.back ().second;
-  GatewayList gwList = info.gwList;
-
   std::map<double, Address> gatewayPowers;
 
-  for (auto it = gwList.begin (); it != gwList.end (); it++)
+  for (auto it = m_gatewayRanking.begin (); it != m_gatewayRanking.end (); it++)
     {
-      Address currentGwAddress = (*it).first;
-      double currentRxPower = (*it).second.rxPower;
-      gatewayPowers.insert (std::pair<double, Address> (currentRxPower, currentGwAddress));
+      gatewayPowers.insert (*it);
     }
 
   return gatewayPowers;
 }
 
+const EndDeviceStatus::GatewayRanking &
+EndDeviceStatus::GetGatewayRanking (void) const
+{
+  return m_gatewayRanking;
+}
+
+void
+EndDeviceStatus::RankGateway (double rxPower, const Address &gwAddress)
+{
+  NS_LOG_FUNCTION (this << rxPower << gwAddress);
+
+  // Gateways receiving the same packet are few, so a linear scan from the
+  // end is enough. Among gateways with the same power, the first one to
+  // report the packet stays first.
+  GatewayRanking::iterator it = m_gatewayRanking.end ();
+  while (it != m_gatewayRanking.begin () && (it - 1)->first < rxPower)
+    {
+      --it;
+    }
+  m_gatewayRanking.insert (it, std::pair<double, Address> (rxPower, gwAddress));
+}
+
 std::ostream &
 operator<< (std::ostream &os, const EndDeviceStatus &status)
 {
@@ -29,7 +29,9 @@
 #include "ns3/lora-frame-header.h"
 #include "ns3/pointer.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-frame-info-tag.h"
 #include <iostream>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -171,11 +173,18 @@ public:
     GatewayList gwList;      //!< List of gateways that received this packet.
     uint8_t sf;
     double frequency;
+    LoraFrameInfoTag frameInfo;   //!< The decoded headers of the packet
   };
 
   typedef std::list<std::pair<Ptr<Packet const>, ReceivedPacketInfo> >
     ReceivedPacketList;
 
+  /**
+   * The receive power and address of the gateways that received the last
+   * packet, sorted from the highest to the lowest power.
+   */
+  typedef std::vector<std::pair<double, Address> > GatewayRanking;
+
 
   /*******************************************/
   /* Proper EndDeviceStatus class definition */
@@ -264,10 +273,27 @@ public:
 
   /**
    * Insert a received packet in the packet list.
+   *
+   * \param receivedPacket The packet.
+   * \param frameInfo The decoded headers of the packet.
+   * \param gwAddress The gateway the packet was received from.
    */
   void InsertReceivedPacket (Ptr<Packet const> receivedPacket,
+                             const LoraFrameInfoTag &frameInfo,
                              const Address& gwAddress);
 
+  /**
+   * Insert a packet received by several gateways in the packet list, or
+   * add these gateways to the packet if it is already in the list.
+   *
+   * \param receivedPacket The packet.
+   * \param frameInfo The decoded headers of the packet.
+   * \param gwList The reception information of each gateway.
+   */
+  void InsertReceivedPacket (Ptr<Packet const> receivedPacket,
+                             const LoraFrameInfoTag &frameInfo,
+                             const GatewayList &gwList);
+
   /**
    * Return the last packet that was received from this device.
    */
@@ -279,6 +305,12 @@ public:
    */
   EndDeviceStatus::ReceivedPacketInfo GetLastReceivedPacketInfo (void);
 
+  /**
+   * Return the decoded headers of the last packet that was received from the
+   * device, without copying its gateway list.
+   */
+  const LoraFrameInfoTag &GetLastFrameInfo (void) const;
+
   /**
    * Initialize reply.
    */
@@ -299,6 +331,14 @@ public:
    */
   std::map<double, Address> GetPowerGatewayMap (void);
 
+  /**
+   * Return the gateways that received the last packet, best first.
+   *
+   * Unlike GetPowerGatewayMap, this does not build a new container: the
+   * ranking is updated as receptions are inserted.
+   */
+  const GatewayRanking &GetGatewayRanking (void) const;
+
   struct Reply m_reply;   //<! Next reply intended for this device
 
   LoraDeviceAddress m_endDeviceAddress;   //<! The address of this device
@@ -312,7 +352,13 @@ private:
   uint8_t m_secondReceiveWindowOffset = 0;
   double m_secondReceiveWindowFrequency = 869.525;
 
+  /**
+   * Insert a gateway in m_gatewayRanking, according to its receive power.
+   */
+  void RankGateway (double rxPower, const Address &gwAddress);
+
   ReceivedPacketList m_receivedPacketList;   //<! List of received packets
+  GatewayRanking m_gatewayRanking;   //<! Gateways that received the last packet
 
   // NOTE Using this attribute is 'cheating', since we are assuming perfect
   // synchronization between the info at the device and at the network server
@@ -27,6 +27,7 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/lora-net-device.h"
+#include "ns3/lora-packet-pool.h"
 #include "src/lorawan/model/lora-radio-energy-model.h"
 
 namespace ns3 {
@@ -69,6 +70,7 @@ namespace ns3 {
           m_sendTime (Seconds (0)),
           m_firstSending (true),
           m_tryingToSend (false),
+          m_energySubscription (0),
           m_basePktSize (10),
           m_pktSizeRV (0)
     {
@@ -132,11 +134,11 @@ namespace ns3 {
       if (m_pktSizeRV)
         {
           int randomsize = m_pktSizeRV->GetInteger ();
-          packet = Create<Packet> (m_basePktSize + randomsize);
+          packet = LoraPacketPool::Allocate (m_basePktSize + randomsize);
         }
       else
         {
-          packet = Create<Packet> (m_basePktSize);
+          packet = LoraPacketPool::Allocate (m_basePktSize);
         }
 
       m_sendTime = Simulator::Now();
@@ -171,7 +173,16 @@ namespace ns3 {
 
         }
 
-      // Assume there's a loraRadioEnergyModel
+      // With a capacitor, let it tell us when the energy threshold is reached
+      m_capacitor = m_node->GetObject<EnergySourceContainer> ()
+        ->Get (0)->GetObject<CapacitorEnergySource> ();
+      if (m_capacitor != 0)
+        {
+          WaitForEnergy ();
+          return;
+        }
+
+      // Otherwise, assume there's a loraRadioEnergyModel
       Ptr<LoraRadioEnergyModel> radioEnergy = m_node->GetObject<EnergySourceContainer> ()
         ->Get (0)
         ->FindDeviceEnergyModels ("ns3::LoraRadioEnergyModel")
@@ -182,21 +193,54 @@ namespace ns3 {
       NS_LOG_DEBUG ("Connect the callback");
       radioEnergy-> SetEnergyChangedCallback
         (MakeCallback(&EnergyAwareSender::EnergyAwareSendPacketCallback, this));
-
-      // Schedule the next SendPacket event
-      // Simulator::Cancel (m_sendEvent);
-      // NS_LOG_DEBUG ("Starting up application with a first event with a " <<
-      //               m_initialDelay.GetSeconds () << " seconds delay");
-      // m_sendEvent = Simulator::Schedule (m_initialDelay,
-      //                                    &EnergyAwareSender::SendPacket, this);
-      // NS_LOG_DEBUG ("Event Id: " << m_sendEvent.GetUid ());
     }
 
     void
     EnergyAwareSender::StopApplication (void)
     {
       NS_LOG_FUNCTION_NOARGS ();
-      // Simulator::Cancel (m_sendEvent);
+
+      m_waitEvent.Cancel ();
+      if (m_energySubscription != 0)
+        {
+          m_capacitor->UnsubscribeThreshold (m_energySubscription);
+          m_energySubscription = 0;
+        }
+    }
+
+    void
+    EnergyAwareSender::WaitForEnergy (void)
+    {
+      NS_LOG_FUNCTION (this);
+
+      if (!m_firstSending && Simulator::Now () < m_sendTime + m_interval)
+        {
+          m_waitEvent = Simulator::Schedule (m_sendTime + m_interval - Simulator::Now (),
+                                             &EnergyAwareSender::WaitForEnergy, this);
+          return;
+        }
+
+      // No event is needed while the capacitor charges: it notifies us at
+      // the exact time the threshold is crossed
+      m_energySubscription = m_capacitor->SubscribeEnergyThreshold
+        (m_energyThreshold, true,
+         MakeCallback (&EnergyAwareSender::EnergyThresholdCrossedCallback, this));
+    }
+
+    void
+    EnergyAwareSender::EnergyThresholdCrossedCallback (double energy)
+    {
+      NS_LOG_FUNCTION (this << energy);
+
+      m_energySubscription = 0;
+      if (m_tryingToSend)
+        {
+          NS_LOG_DEBUG ("We are already trying to send a packet");
+          return;
+        }
+
+      SendPacket ();
+      m_firstSending = 0;
     }
 
     // Callback
@@ -232,6 +276,11 @@ namespace ns3 {
     {
       NS_LOG_FUNCTION (packet << id);
       m_tryingToSend = false;
+
+      if (m_capacitor != 0 && m_energySubscription == 0 && !m_waitEvent.IsRunning ())
+        {
+          WaitForEnergy ();
+        }
     }
   }
 }
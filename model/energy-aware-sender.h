@@ -26,6 +26,7 @@
 #include "ns3/nstime.h"
 #include "ns3/lorawan-mac.h"
 #include "ns3/attribute.h"
+#include "ns3/capacitor-energy-source.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -88,6 +89,17 @@ public:
 private:
   void EnergyAwareSendPacketCallback (double);
 
+  /**
+   * Wait for the minimum interval to elapse, and then for the capacitor to
+   * store the energy threshold.
+   */
+  void WaitForEnergy (void);
+
+  /**
+   * Called by the capacitor when the energy threshold is crossed.
+   */
+  void EnergyThresholdCrossedCallback (double energy);
+
 private:
   
   double m_energyThreshold;
@@ -96,6 +108,13 @@ private:
   bool m_firstSending;
     bool m_tryingToSend;
 
+  /**
+   * The capacitor notifying the energy threshold, if the node has one
+   */
+  Ptr<CapacitorEnergySource> m_capacitor;
+  uint32_t m_energySubscription; //!< The pending threshold subscription, or 0
+  EventId m_waitEvent; //!< The end of the minimum interval
+
 
   /**
    * The MAC layer of this node
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/energy-gate.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EnergyGate");
+
+NS_OBJECT_ENSURE_REGISTERED (EnergyGate);
+
+TypeId
+EnergyGate::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EnergyGate")
+    .SetParent<Object> ()
+    .SetGroupName ("Energy");
+  return tid;
+}
+
+EnergyGate::EnergyGate ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EnergyGate::~EnergyGate ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EnergyGate::NotifyStateChanged (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<EnergyGate>
+EnergyGate::CreateFor (Ptr<EnergySource> source)
+{
+  NS_LOG_FUNCTION (source);
+
+  Ptr<EnergyGate> gate;
+  if (source->GetObject<CapacitorEnergySource> ())
+    {
+      gate = CreateObject<CapacitorEnergyGate> ();
+    }
+  else if (source->GetObject<BasicEnergySource> ())
+    {
+      gate = CreateObject<BasicEnergyGate> ();
+    }
+  else
+    {
+      NS_LOG_DEBUG ("No gate for source " << source->GetInstanceTypeId ().GetName ());
+      return 0;
+    }
+  gate->SetEnergySource (source);
+  return gate;
+}
+
+// CapacitorEnergyGate
+
+NS_OBJECT_ENSURE_REGISTERED (CapacitorEnergyGate);
+
+TypeId
+CapacitorEnergyGate::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CapacitorEnergyGate")
+    .SetParent<EnergyGate> ()
+    .SetGroupName ("Energy")
+    .AddConstructor<CapacitorEnergyGate> ();
+  return tid;
+}
+
+CapacitorEnergyGate::CapacitorEnergyGate ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CapacitorEnergyGate::~CapacitorEnergyGate ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CapacitorEnergyGate::SetEnergySource (Ptr<EnergySource> source)
+{
+  NS_LOG_FUNCTION (this << source);
+  m_source = source->GetObject<CapacitorEnergySource> ();
+  NS_ASSERT_MSG (m_source != 0, "Energy source is not a CapacitorEnergySource!");
+}
+
+bool
+CapacitorEnergyGate::IsOperational (void)
+{
+  // Integrate the time since the last update with the present load, before
+  // the device changes it. This also sets the depletion and recharge flags.
+  m_source->UpdateEnergySource ();
+  bool depleted = m_source->IsDepleted ();
+  NS_LOG_DEBUG ("Capacitor depleted: " << depleted);
+  return !depleted;
+}
+
+void
+CapacitorEnergyGate::NotifyStateChanged (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_source->SetCheckForEnergyDepletion ();
+}
+
+void
+CapacitorEnergyGate::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_source = 0;
+  EnergyGate::DoDispose ();
+}
+
+// BasicEnergyGate
+
+NS_OBJECT_ENSURE_REGISTERED (BasicEnergyGate);
+
+TypeId
+BasicEnergyGate::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BasicEnergyGate")
+    .SetParent<EnergyGate> ()
+    .SetGroupName ("Energy")
+    .AddConstructor<BasicEnergyGate> ();
+  return tid;
+}
+
+BasicEnergyGate::BasicEnergyGate ()
+  : m_lowBatteryThreshold (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BasicEnergyGate::~BasicEnergyGate ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BasicEnergyGate::SetEnergySource (Ptr<EnergySource> source)
+{
+  NS_LOG_FUNCTION (this << source);
+  m_source = source->GetObject<BasicEnergySource> ();
+  NS_ASSERT_MSG (m_source != 0, "Energy source is not a BasicEnergySource!");
+
+  DoubleValue lowBatteryThreshold;
+  m_source->GetAttribute ("BasicEnergyLowBatteryThreshold", lowBatteryThreshold);
+  m_lowBatteryThreshold = lowBatteryThreshold.Get ();
+}
+
+bool
+BasicEnergyGate::IsOperational (void)
+{
+  // GetEnergyFraction runs UpdateEnergySource first
+  double fraction = m_source->GetEnergyFraction ();
+  NS_LOG_DEBUG ("Energy fraction " << fraction << ", threshold " << m_lowBatteryThreshold);
+  return fraction > m_lowBatteryThreshold;
+}
+
+void
+BasicEnergyGate::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_source = 0;
+  EnergyGate::DoDispose ();
+}
+
+} // namespace ns3
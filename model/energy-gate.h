@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef ENERGY_GATE_H
+#define ENERGY_GATE_H
+
+#include "ns3/object.h"
+#include "ns3/energy-source.h"
+
+namespace ns3 {
+
+class CapacitorEnergySource;
+class BasicEnergySource;
+
+/**
+ * \ingroup energy
+ *
+ * \brief Tell a device whether its energy source allows it to operate.
+ *
+ * The EndDeviceLoraPhy asks this object before every state transition.
+ * Implementations keep a typed pointer to their source, resolved once in
+ * SetEnergySource, and bring the source up to date in IsOperational: the time
+ * since its last update is then integrated with the load of the state the
+ * device is leaving, and the check sees the present energy.
+ *
+ * To support a new kind of source, subclass this and set its TypeId in
+ * LoraRadioEnergyModelHelper::SetEnergyGate.
+ */
+class EnergyGate : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  EnergyGate ();
+  virtual ~EnergyGate ();
+
+  /**
+   * Bind this gate to the source of the device.
+   */
+  virtual void SetEnergySource (Ptr<EnergySource> source) = 0;
+
+  /**
+   * Update the source to the present time.
+   *
+   * \return Whether the source has enough energy for the device to operate.
+   */
+  virtual bool IsOperational (void) = 0;
+
+  /**
+   * Called after the device changed state, so that the source can schedule
+   * the checks it needs with the new load. Does nothing by default.
+   */
+  virtual void NotifyStateChanged (void);
+
+  /**
+   * Create the gate that fits the given source: a CapacitorEnergyGate for a
+   * CapacitorEnergySource, a BasicEnergyGate for a BasicEnergySource.
+   *
+   * \return The bound gate, or 0 if the type of source is not known.
+   */
+  static Ptr<EnergyGate> CreateFor (Ptr<EnergySource> source);
+};
+
+/**
+ * A gate that is closed while a CapacitorEnergySource is depleted.
+ */
+class CapacitorEnergyGate : public EnergyGate
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CapacitorEnergyGate ();
+  virtual ~CapacitorEnergyGate ();
+
+  void SetEnergySource (Ptr<EnergySource> source);
+
+  bool IsOperational (void);
+
+  /**
+   * Let the capacitor estimate the time of depletion with the new load.
+   */
+  void NotifyStateChanged (void);
+
+private:
+  void DoDispose (void);
+
+  Ptr<CapacitorEnergySource> m_source;
+};
+
+/**
+ * A gate that is closed while the energy fraction of a BasicEnergySource is
+ * not above its low battery threshold.
+ */
+class BasicEnergyGate : public EnergyGate
+{
+public:
+  static TypeId GetTypeId (void);
+
+  BasicEnergyGate ();
+  virtual ~BasicEnergyGate ();
+
+  /**
+   * Bind the source, and read its BasicEnergyLowBatteryThreshold attribute.
+   */
+  void SetEnergySource (Ptr<EnergySource> source);
+
+  bool IsOperational (void);
+
+private:
+  void DoDispose (void);
+
+  Ptr<BasicEnergySource> m_source;
+  double m_lowBatteryThreshold; //!< Fraction of the initial energy
+};
+
+} // namespace ns3
+
+#endif /* ENERGY_GATE_H */
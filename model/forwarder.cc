@@ -20,6 +20,10 @@
 
 #include "ns3/forwarder.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <cmath>
 
 namespace ns3 {
 namespace lorawan {
@@ -34,7 +38,21 @@ Forwarder::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::Forwarder")
     .SetParent<Application> ()
     .AddConstructor<Forwarder> ()
-    .SetGroupName ("lorawan");
+    .SetGroupName ("lorawan")
+    .AddAttribute ("BatchInterval",
+                   "The maximum time an uplink waits for others to be sent to "
+                   "the Network Server in the same batch. Zero disables batching. "
+                   "The SNR of batched uplinks is estimated from their RSSI on a "
+                   "125 kHz bandwidth, so it is 3 dB too high for 250 kHz data rates.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Forwarder::m_batchInterval),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("MaxBatchSize",
+                   "The number of uplinks after which a batch is sent, "
+                   "without waiting for the BatchInterval to expire",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&Forwarder::m_maxBatchSize),
+                   MakeUintegerChecker<uint32_t> (1, 255));
   return tid;
 }
 
@@ -71,15 +89,63 @@ Forwarder::ReceiveFromLora (Ptr<NetDevice> loraNetDevice, Ptr<const Packet>
 {
   NS_LOG_FUNCTION (this << packet << protocol << sender);
 
-  Ptr<Packet> packetCopy = packet->Copy ();
-
-  m_pointToPointNetDevice->Send (packetCopy,
-                                 m_pointToPointNetDevice->GetBroadcast (),
-                                 0x800);
+  if (m_batchInterval.IsZero ())
+    {
+      Ptr<Packet> packetCopy = packet->Copy ();
+
+      m_pointToPointNetDevice->Send (packetCopy,
+                                     m_pointToPointNetDevice->GetBroadcast (),
+                                     0x800);
+
+      return true;
+    }
+
+  // Keep the uplink and its metadata until the batch is sent
+  // LoRa frames carry at most 255 bytes, the range of the size field
+  NS_ABORT_MSG_IF (packet->GetSize () > 255,
+                   "Uplink of " << packet->GetSize () << " bytes is too large for a batch");
+  LoraBatchHeader::FrameMetadata frame;
+  frame.size = packet->GetSize ();
+  frame.receptionTime = Simulator::Now ();
+  frame.frameInfo = LoraFrameInfoTag::Get (packet);
+  // Thermal noise on 125 kHz with a noise figure of 6 dB, ignoring
+  // interference as the AdrComponent does. Uplinks do not carry their data
+  // rate, and the SF alone does not tell 125 and 250 kHz apart.
+  frame.snr = frame.frameInfo.GetReceivePower () + 174 - 10 * std::log10 (125000.0) - 6;
+  m_batchHeader.AddFrame (frame);
+  m_batchFrames.push_back (packet);
+
+  if (m_batchFrames.size () >= m_maxBatchSize)
+    {
+      SendBatch ();
+    }
+  else if (!m_sendBatchEvent.IsRunning ())
+    {
+      m_sendBatchEvent = Simulator::Schedule (m_batchInterval, &Forwarder::SendBatch, this);
+    }
 
   return true;
 }
 
+void
+Forwarder::SendBatch (void)
+{
+  NS_LOG_FUNCTION (this << m_batchFrames.size ());
+
+  m_sendBatchEvent.Cancel ();
+
+  Ptr<Packet> batch = Create<Packet> ();
+  for (uint32_t i = 0; i < m_batchFrames.size (); i++)
+    {
+      batch->AddAtEnd (m_batchFrames[i]);
+    }
+  batch->AddHeader (m_batchHeader);
+  m_batchHeader.Clear ();
+  m_batchFrames.clear ();
+
+  m_pointToPointNetDevice->Send (batch, m_pointToPointNetDevice->GetBroadcast (), 0x800);
+}
+
 bool
 Forwarder::ReceiveFromPointToPoint (Ptr<NetDevice> pointToPointNetDevice,
                                     Ptr<const Packet> packet, uint16_t protocol,
@@ -107,6 +173,12 @@ Forwarder::StopApplication (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  // Do not lose the uplinks of the current batch
+  if (!m_batchFrames.empty ())
+    {
+      SendBatch ();
+    }
+
   // TODO Get rid of callbacks
 }
 
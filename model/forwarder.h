@@ -26,6 +26,9 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/nstime.h"
 #include "ns3/attribute.h"
+#include "ns3/event-id.h"
+#include "ns3/lora-batch-header.h"
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -33,6 +36,14 @@ namespace lorawan {
 /**
  * This application forwards packets between NetDevices:
  * LoraNetDevice -> PointToPointNetDevice and vice versa.
+ *
+ * If the BatchInterval attribute is not zero, uplinks are not forwarded one
+ * by one: like real packet forwarders, the application collects them in a
+ * batch, preceded by a LoraBatchHeader, which is sent BatchInterval after
+ * its first uplink, or as soon as it holds MaxBatchSize uplinks. Since the
+ * Network Server replies in the receive windows of the devices, the interval
+ * should be short compared with the RX1 delay. The SNR in the batch header
+ * assumes a 125 kHz bandwidth.
  */
 class Forwarder : public Application
 {
@@ -86,11 +97,22 @@ public:
   void StopApplication (void);
 
 private:
+  /**
+   * Send the uplinks of the current batch to the Network Server.
+   */
+  void SendBatch (void);
+
   Ptr<LoraNetDevice> m_loraNetDevice; //!< Pointer to the node's LoraNetDevice
 
   Ptr<PointToPointNetDevice> m_pointToPointNetDevice; //!< Pointer to the
   //!P2PNetDevice we use to
   //!communicate with the NS
+
+  Time m_batchInterval; //!< The maximum wait of an uplink, or 0 to disable batching
+  uint32_t m_maxBatchSize; //!< The maximum number of uplinks of a batch
+  LoraBatchHeader m_batchHeader; //!< The metadata of the uplinks of the current batch
+  std::vector<Ptr<const Packet> > m_batchFrames; //!< The uplinks of the current batch
+  EventId m_sendBatchEvent; //!< The sending of the current batch
 };
 
 } //namespace ns3
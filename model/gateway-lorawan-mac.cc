@@ -22,6 +22,7 @@
 #include "ns3/lorawan-mac-header.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-frame-info-tag.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -58,14 +59,13 @@ GatewayLorawanMac::Send (Ptr<Packet> packet)
 
   // Get DataRate to send this packet with
   LoraTag tag;
-  packet->RemovePacketTag (tag);
+  packet->PeekPacketTag (tag);
   uint8_t dataRate = tag.GetDataRate ();
   double frequency = tag.GetFrequency ();
   NS_LOG_DEBUG ("DR: " << unsigned (dataRate));
   NS_LOG_DEBUG ("SF: " << unsigned (GetSfFromDataRate (dataRate)));
   NS_LOG_DEBUG ("BW: " << GetBandwidthFromDataRate (dataRate));
   NS_LOG_DEBUG ("Freq: " << frequency << " MHz");
-  packet->AddPacketTag (tag);
 
   // Make sure we can transmit this packet
   if (m_channelHelper.GetWaitingTime(CreateObject<LogicalLoraChannel> (frequency)) > Seconds(0))
@@ -84,15 +84,7 @@ GatewayLorawanMac::Send (Ptr<Packet> packet)
   // params.crcEnabled = 1;
   // params.lowDataRateOptimizationEnabled = 0;
 
-  // FOR MODEL COMPARISON Modify to compare with the model
-  LoraTxParameters params;
-  params.sf = GetSfFromDataRate (dataRate);
-  params.headerDisabled = 1;
-  params.codingRate = 1;
-  params.bandwidthHz = GetBandwidthFromDataRate (dataRate);
-  params.nPreamble = 8;
-  params.crcEnabled = 1;
-  params.lowDataRateOptimizationEnabled = 0;
+  LoraTxParameters params = GetTxParameters (dataRate);
 
   // Get the duration
   Time duration = m_phy->GetOnAirTime (packet, params);
@@ -113,6 +105,29 @@ GatewayLorawanMac::Send (Ptr<Packet> packet)
   m_sentNewPacket (packet);
 }
 
+LoraTxParameters
+GatewayLorawanMac::GetTxParameters (uint8_t dataRate)
+{
+  // FOR MODEL COMPARISON Modify to compare with the model
+  LoraTxParameters params;
+  params.sf = GetSfFromDataRate (dataRate);
+  params.headerDisabled = 1;
+  params.codingRate = 1;
+  params.bandwidthHz = GetBandwidthFromDataRate (dataRate);
+  params.nPreamble = 8;
+  params.crcEnabled = 1;
+  params.lowDataRateOptimizationEnabled = 0;
+  return params;
+}
+
+Time
+GatewayLorawanMac::GetOnAirTime (Ptr<Packet> packet)
+{
+  LoraTag tag;
+  packet->PeekPacketTag (tag);
+  return m_phy->GetOnAirTime (packet, GetTxParameters (tag.GetDataRate ()));
+}
+
 bool
 GatewayLorawanMac::IsTransmitting (void)
 {
@@ -133,6 +148,10 @@ GatewayLorawanMac::Receive (Ptr<Packet const> packet)
 
   if (macHdr.IsUplink ())
     {
+      // Decode the frame once, for all the Network Server components
+      LoraFrameInfoTag frameInfo = LoraFrameInfoTag::Decode (packetCopy);
+      packetCopy->AddPacketTag (frameInfo);
+
       m_device->GetObject<LoraNetDevice> ()->Receive (packetCopy);
 
       NS_LOG_DEBUG ("Received packet: " << packet);
@@ -162,8 +181,12 @@ GatewayLorawanMac::GetWaitingTime (double frequency)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  return m_channelHelper.GetWaitingTime (CreateObject<LogicalLoraChannel>
-                                           (frequency));
+  // Look the sub-band up directly, instead of creating a LogicalLoraChannel:
+  // this is called for each candidate gateway of each reply
+  Time waitingTime = m_channelHelper.GetSubBandFromFrequency (frequency)->
+    GetNextTransmissionTime () - Simulator::Now ();
+
+  return Max (waitingTime, Seconds (0));
 }
 }
 }
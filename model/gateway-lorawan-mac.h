@@ -56,7 +56,19 @@ public:
    * \return The next transmission time.
    */
   Time GetWaitingTime (double frequency);
+
+  /**
+   * Compute the time on air of a packet, with the parameters used by Send.
+   *
+   * \param packet The packet, tagged with the LoraTag giving its data rate.
+   * \return The time on air of the packet.
+   */
+  Time GetOnAirTime (Ptr<Packet> packet);
 private:
+  /**
+   * \return The transmission parameters for a data rate.
+   */
+  LoraTxParameters GetTxParameters (uint8_t dataRate);
 protected:
 };
 
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/harvest-power-profile.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HarvestPowerProfile");
+
+HarvestPowerProfile::HarvestPowerProfile () :
+  HarvestPowerProfile (Hours (24), 24, 0.2)
+{
+}
+
+HarvestPowerProfile::HarvestPowerProfile (Time period, uint32_t nSlots, double smoothing)
+{
+  SetSmoothing (smoothing);
+  SetSlots (period, nSlots);
+}
+
+void
+HarvestPowerProfile::SetSlots (Time period, uint32_t nSlots)
+{
+  NS_LOG_FUNCTION (this << period << nSlots);
+  NS_ASSERT (period.IsStrictlyPositive () && nSlots > 0);
+
+  m_period = period.GetSeconds ();
+  m_slotWidth = m_period / nSlots;
+  m_estimate.assign (nSlots, 0);
+  m_observed.assign (nSlots, false);
+  m_prefix.assign (nSlots + 1, 0);
+  m_lastAverage = 0;
+  m_currentSlot = -1;
+  m_currentEnergy = 0;
+  m_currentTime = 0;
+}
+
+void
+HarvestPowerProfile::SetSmoothing (double smoothing)
+{
+  NS_LOG_FUNCTION (this << smoothing);
+  NS_ASSERT (smoothing > 0 && smoothing <= 1);
+
+  m_smoothing = smoothing;
+}
+
+void
+HarvestPowerProfile::Add (Time start, Time end, double power)
+{
+  NS_LOG_FUNCTION (this << start << end << power);
+
+  double s = start.GetSeconds ();
+  double e = end.GetSeconds ();
+  while (s < e)
+    {
+      int64_t slot = std::floor (s / m_slotWidth);
+      if (slot != m_currentSlot)
+        {
+          EndSlot ();
+          m_currentSlot = slot;
+        }
+      // Split the observation at the end of the slot
+      double slotEnd = std::min (e, (slot + 1) * m_slotWidth);
+      m_currentEnergy += (slotEnd - s) * power;
+      m_currentTime += slotEnd - s;
+      s = slotEnd;
+    }
+}
+
+void
+HarvestPowerProfile::EndSlot (void)
+{
+  if (m_currentSlot < 0 || m_currentTime <= 0)
+    {
+      return;
+    }
+
+  uint32_t nSlots = m_estimate.size ();
+  uint32_t slot = m_currentSlot % nSlots;
+  double average = m_currentEnergy / m_currentTime;
+  if (m_observed[slot])
+    {
+      m_estimate[slot] = m_smoothing * average + (1 - m_smoothing) * m_estimate[slot];
+    }
+  else
+    {
+      m_estimate[slot] = average;
+      m_observed[slot] = true;
+    }
+  m_lastAverage = average;
+  m_currentEnergy = 0;
+  m_currentTime = 0;
+
+  NS_LOG_DEBUG ("Slot " << slot << ": average " << average << " W, estimate "
+                        << m_estimate[slot] << " W");
+
+  // Once per slot, so that queries take constant time
+  for (uint32_t i = 0; i < nSlots; i++)
+    {
+      double estimate = m_observed[i] ? m_estimate[i] : m_lastAverage;
+      m_prefix[i + 1] = m_prefix[i] + estimate * m_slotWidth;
+    }
+}
+
+double
+HarvestPowerProfile::GetExpectedPower (Time time) const
+{
+  double position = std::fmod (time.GetSeconds (), m_period);
+  if (position < 0)
+    {
+      position += m_period;
+    }
+  uint32_t slot = std::min<double> (position / m_slotWidth, m_estimate.size () - 1);
+  return m_observed[slot] ? m_estimate[slot] : m_lastAverage;
+}
+
+double
+HarvestPowerProfile::GetCumulativeEnergy (double seconds) const
+{
+  double periods = std::floor (seconds / m_period);
+  double position = (seconds - periods * m_period) / m_slotWidth;
+  uint32_t slot = std::min<double> (position, m_estimate.size () - 1);
+  double estimate = m_observed[slot] ? m_estimate[slot] : m_lastAverage;
+  return periods * m_prefix.back () + m_prefix[slot]
+         + (position - slot) * m_slotWidth * estimate;
+}
+
+double
+HarvestPowerProfile::GetExpectedEnergy (Time start, Time end) const
+{
+  if (end <= start)
+    {
+      return 0;
+    }
+  return GetCumulativeEnergy (end.GetSeconds ()) - GetCumulativeEnergy (start.GetSeconds ());
+}
+
+double
+HarvestPowerProfile::GetExpectedMean (Time start, Time end) const
+{
+  if (end <= start)
+    {
+      return GetExpectedPower (start);
+    }
+  return GetExpectedEnergy (start, end) / (end - start).GetSeconds ();
+}
+
+} // namespace ns3
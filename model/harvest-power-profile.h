@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef HARVEST_POWER_PROFILE_H
+#define HARVEST_POWER_PROFILE_H
+
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup energy
+ * \brief An online estimate of the harvested power as a function of the time
+ * of day, for harvesters whose future power is not known in advance.
+ *
+ * The period (a day, by default) is split in slots of equal width. The power
+ * observed during each slot is averaged, and the average is folded into an
+ * exponentially weighted moving average of the slot when the slot ends, so
+ * that each slot forecasts the power expected at the same time of the
+ * following periods. Slots that were never observed use the last average.
+ *
+ * The energy expected over a window is computed in constant time from the
+ * prefix sums of the slot estimates, which are updated once per slot.
+ */
+class HarvestPowerProfile
+{
+public:
+  HarvestPowerProfile ();
+
+  /**
+   * \param period The period of the profile.
+   * \param nSlots The number of slots in a period.
+   * \param smoothing The weight of the last observation of a slot, in (0, 1].
+   */
+  HarvestPowerProfile (Time period, uint32_t nSlots, double smoothing);
+
+  /**
+   * Change the slots, discarding the observations made so far.
+   */
+  void SetSlots (Time period, uint32_t nSlots);
+
+  /**
+   * Set the weight of the last observation of a slot, in (0, 1].
+   */
+  void SetSmoothing (double smoothing);
+
+  /**
+   * Observe a constant power over [start, end). Observations must be added
+   * in time order.
+   *
+   * \param power The harvested power [W]
+   */
+  void Add (Time start, Time end, double power);
+
+  /**
+   * \return The power expected at the given time [W].
+   */
+  double GetExpectedPower (Time time) const;
+
+  /**
+   * \return The energy expected over [start, end) [J].
+   */
+  double GetExpectedEnergy (Time start, Time end) const;
+
+  /**
+   * \return The mean power expected over [start, end) [W], or the power
+   * expected at start if the window is empty.
+   */
+  double GetExpectedMean (Time start, Time end) const;
+
+private:
+  /**
+   * Fold the average of the current slot into its estimate.
+   */
+  void EndSlot (void);
+
+  /**
+   * \return The energy expected from time 0 to the given time [J].
+   */
+  double GetCumulativeEnergy (double seconds) const;
+
+  double m_period; //!< The period of the profile [s]
+  double m_slotWidth; //!< The width of each slot [s]
+  double m_smoothing; //!< The weight of the last observation of a slot
+
+  std::vector<double> m_estimate; //!< The power expected in each slot [W]
+  std::vector<bool> m_observed; //!< Whether each slot was ever observed
+  std::vector<double> m_prefix; //!< The energy of the first i slots [J]
+  double m_lastAverage; //!< The last average folded in [W]
+
+  int64_t m_currentSlot; //!< The slot being observed, counted from time 0
+  double m_currentEnergy; //!< The energy observed in the current slot [J]
+  double m_currentTime; //!< The time observed in the current slot [s]
+};
+
+} // namespace ns3
+
+#endif /* HARVEST_POWER_PROFILE_H */
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/harvest-power-statistics.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HarvestPowerStatistics");
+
+HarvestPowerStatistics::HarvestPowerStatistics ()
+  : m_interval (1)
+{
+  m_prefix.push_back (0);
+}
+
+HarvestPowerStatistics::HarvestPowerStatistics (const std::vector<double> &samples,
+                                                Time interval)
+{
+  SetTrace (samples, interval);
+}
+
+void
+HarvestPowerStatistics::SetTrace (const std::vector<double> &samples, Time interval)
+{
+  NS_LOG_FUNCTION (this << samples.size () << interval);
+  NS_ASSERT (interval.IsStrictlyPositive ());
+
+  m_samples = samples;
+  m_interval = interval.GetSeconds ();
+
+  m_prefix.resize (m_samples.size () + 1);
+  m_prefix[0] = 0;
+  for (uint32_t i = 0; i < m_samples.size (); i++)
+    {
+      m_prefix[i + 1] = m_prefix[i] + m_samples[i] * m_interval;
+    }
+
+  m_min.clear ();
+  m_max.clear ();
+}
+
+uint32_t
+HarvestPowerStatistics::GetNSamples (void) const
+{
+  return m_samples.size ();
+}
+
+double
+HarvestPowerStatistics::GetSample (uint32_t index) const
+{
+  NS_ASSERT (index < m_samples.size ());
+  return m_samples[index];
+}
+
+Time
+HarvestPowerStatistics::GetInterval (void) const
+{
+  return Seconds (m_interval);
+}
+
+Time
+HarvestPowerStatistics::GetDuration (void) const
+{
+  return Seconds (m_samples.size () * m_interval);
+}
+
+double
+HarvestPowerStatistics::GetCumulativeEnergy (double seconds) const
+{
+  double position = seconds / m_interval;
+  if (position <= 0)
+    {
+      return 0;
+    }
+  if (position >= m_samples.size ())
+    {
+      return m_prefix.back ();
+    }
+  uint32_t index = position;
+  // The part of the last sample covered by the window
+  return m_prefix[index] + (position - index) * m_interval * m_samples[index];
+}
+
+double
+HarvestPowerStatistics::GetEnergy (Time start, Time end) const
+{
+  if (end <= start)
+    {
+      return 0;
+    }
+  return GetCumulativeEnergy (end.GetSeconds ()) - GetCumulativeEnergy (start.GetSeconds ());
+}
+
+bool
+HarvestPowerStatistics::GetSampleRange (Time start, Time end, uint32_t &first,
+                                        uint32_t &last) const
+{
+  double duration = m_samples.size () * m_interval;
+  double s = std::max (0.0, start.GetSeconds ());
+  double e = std::min (duration, end.GetSeconds ());
+  if (e <= s)
+    {
+      return false;
+    }
+  first = std::floor (s / m_interval);
+  last = std::min<double> (std::ceil (e / m_interval), m_samples.size ()) - 1;
+  return true;
+}
+
+double
+HarvestPowerStatistics::GetMean (Time start, Time end) const
+{
+  if (m_samples.empty ())
+    {
+      return 0;
+    }
+
+  double duration = m_samples.size () * m_interval;
+  double s = std::max (0.0, start.GetSeconds ());
+  double e = std::min (duration, end.GetSeconds ());
+  if (e <= s)
+    {
+      // Empty window, or outside the trace: take the closest sample
+      double position = std::min (s, duration) / m_interval;
+      uint32_t index = std::min<double> (position, m_samples.size () - 1);
+      return m_samples[index];
+    }
+  return (GetCumulativeEnergy (e) - GetCumulativeEnergy (s)) / (e - s);
+}
+
+void
+HarvestPowerStatistics::BuildSparseTables (void) const
+{
+  if (!m_min.empty () || m_samples.empty ())
+    {
+      return;
+    }
+
+  NS_LOG_FUNCTION (this);
+
+  m_min.push_back (m_samples);
+  m_max.push_back (m_samples);
+  for (uint32_t half = 1; 2 * half <= m_samples.size (); half *= 2)
+    {
+      const std::vector<double> &previousMin = m_min.back ();
+      const std::vector<double> &previousMax = m_max.back ();
+      uint32_t size = m_samples.size () - 2 * half + 1;
+      std::vector<double> min (size);
+      std::vector<double> max (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          min[i] = std::min (previousMin[i], previousMin[i + half]);
+          max[i] = std::max (previousMax[i], previousMax[i + half]);
+        }
+      m_min.push_back (min);
+      m_max.push_back (max);
+    }
+}
+
+double
+HarvestPowerStatistics::GetMin (Time start, Time end) const
+{
+  uint32_t first;
+  uint32_t last;
+  if (!GetSampleRange (start, end, first, last))
+    {
+      return GetMean (start, start);
+    }
+
+  BuildSparseTables ();
+  // Two overlapping blocks of 2^k samples cover the range
+  int k = std::ilogb (double (last - first + 1));
+  return std::min (m_min[k][first], m_min[k][last + 1 - (1u << k)]);
+}
+
+double
+HarvestPowerStatistics::GetMax (Time start, Time end) const
+{
+  uint32_t first;
+  uint32_t last;
+  if (!GetSampleRange (start, end, first, last))
+    {
+      return GetMean (start, start);
+    }
+
+  BuildSparseTables ();
+  int k = std::ilogb (double (last - first + 1));
+  return std::max (m_max[k][first], m_max[k][last + 1 - (1u << k)]);
+}
+
+} // namespace ns3
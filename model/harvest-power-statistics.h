@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef HARVEST_POWER_STATISTICS_H
+#define HARVEST_POWER_STATISTICS_H
+
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup energy
+ * \brief Statistics of a harvested power trace over arbitrary time windows.
+ *
+ * The trace is a sequence of samples, each holding the power for one sample
+ * interval. The energy harvested over a window and the mean power are
+ * computed in constant time from the prefix sums of the samples, and also
+ * account for the samples only partially covered by the window.
+ *
+ * The min and max power over a window are the extremes of the samples
+ * overlapping it, and are computed in constant time from sparse tables.
+ * The tables are only built at the first min or max query, and hold about
+ * 2 * N * log2(N) doubles: roughly 850 MB for a 30-day trace sampled at
+ * 1 Hz. Each VariableEnergyHarvester that is not in a group keeps its own
+ * trace, hence its own tables, so min and max queries on long traces are
+ * better made through a VariableEnergyHarvesterGroup.
+ *
+ * Windows are clipped to the span of the trace, [0, N * interval).
+ */
+class HarvestPowerStatistics
+{
+public:
+  HarvestPowerStatistics ();
+
+  /**
+   * \param samples The power of each sample [W]
+   * \param interval The duration of each sample
+   */
+  HarvestPowerStatistics (const std::vector<double> &samples, Time interval);
+
+  /**
+   * Replace the trace.
+   *
+   * \param samples The power of each sample [W]
+   * \param interval The duration of each sample
+   */
+  void SetTrace (const std::vector<double> &samples, Time interval);
+
+  /**
+   * \return The number of samples of the trace.
+   */
+  uint32_t GetNSamples (void) const;
+
+  /**
+   * \return The power of a sample [W].
+   */
+  double GetSample (uint32_t index) const;
+
+  /**
+   * \return The duration of each sample.
+   */
+  Time GetInterval (void) const;
+
+  /**
+   * \return The time covered by the trace.
+   */
+  Time GetDuration (void) const;
+
+  /**
+   * \return The energy harvested over [start, end) [J].
+   */
+  double GetEnergy (Time start, Time end) const;
+
+  /**
+   * \return The mean power over [start, end) [W], or the power of the sample
+   * at start if the window is empty.
+   */
+  double GetMean (Time start, Time end) const;
+
+  /**
+   * \return The lowest power of the samples overlapping [start, end) [W].
+   */
+  double GetMin (Time start, Time end) const;
+
+  /**
+   * \return The highest power of the samples overlapping [start, end) [W].
+   */
+  double GetMax (Time start, Time end) const;
+
+private:
+  /**
+   * \return The energy harvested from the start of the trace to the given
+   * time, in seconds, clipped to the trace [J].
+   */
+  double GetCumulativeEnergy (double seconds) const;
+
+  /**
+   * Find the samples overlapping [start, end).
+   *
+   * \return false if no sample does.
+   */
+  bool GetSampleRange (Time start, Time end, uint32_t &first, uint32_t &last) const;
+
+  /**
+   * Build the sparse tables, if they were not built yet.
+   */
+  void BuildSparseTables (void) const;
+
+  std::vector<double> m_samples; //!< The power of each sample [W]
+  double m_interval; //!< The duration of each sample [s]
+  std::vector<double> m_prefix; //!< The energy of the first i samples [J]
+
+  // m_min[k][i] and m_max[k][i] are the extremes of samples [i, i + 2^k)
+  mutable std::vector<std::vector<double> > m_min;
+  mutable std::vector<std::vector<double> > m_max;
+};
+
+} // namespace ns3
+
+#endif /* HARVEST_POWER_STATISTICS_H */
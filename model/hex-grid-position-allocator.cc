@@ -19,6 +19,7 @@
 #include "ns3/log.h"
 #include "ns3/hex-grid-position-allocator.h"
 #include "ns3/double.h"
+#include <cstdlib>
 
 namespace ns3 {
 
@@ -26,6 +27,12 @@ namespace ns3 {
 
   NS_OBJECT_ENSURE_REGISTERED (HexGridPositionAllocator);
 
+  namespace {
+  // The steps to the six neighbors of a cell, clockwise from the north
+  const int32_t g_directions[6][2] = {{1, 0}, {0, 1}, {-1, 1}, {-1, 0}, {0, -1}, {1, -1}};
+  const double g_sqrt3 = std::sqrt (3.0);
+  }
+
   TypeId
   HexGridPositionAllocator::GetTypeId (void)
   {
@@ -35,45 +42,35 @@ namespace ns3 {
       .SetGroupName ("Lora")
       .AddAttribute ("Radius", "The radius of a single hexagon",
                      DoubleValue (6000),
-                     MakeDoubleAccessor (&HexGridPositionAllocator::m_radius),
+                     MakeDoubleAccessor (&HexGridPositionAllocator::SetRadius,
+                                         &HexGridPositionAllocator::GetRadius),
                      MakeDoubleChecker<double> ());
 
     return tid;
   }
 
   HexGridPositionAllocator::HexGridPositionAllocator () :
-    m_radius (6000)
+    m_lastRingStart (0),
+    m_next (0),
+    m_radius (6000),
+    m_constructorRadius (0)
   {
     NS_LOG_FUNCTION_NOARGS ();
 
     // Create the first position
-    m_positions.push_back (Vector (0.0,0.0,0.0));
-
-    // Add rings
-    for (int i = 0; i < 20; i++) {
-      m_positions = AddRing(m_positions);
-    }
-
-    // Set the iterator
-    m_next = m_positions.begin();
+    AddCell (Cell {0, 0});
   }
 
   HexGridPositionAllocator::HexGridPositionAllocator (double radius) :
-    m_radius (radius)
+    m_lastRingStart (0),
+    m_next (0),
+    m_radius (radius),
+    m_constructorRadius (radius)
   {
     NS_LOG_FUNCTION_NOARGS ();
 
     // Create the first position
-    m_positions.push_back (Vector (0.0,0.0,0.0));
-
-    // Add a couple rings
-    // Add rings
-    for (int i = 0; i < 20; i++) {
-      m_positions = AddRing(m_positions);
-    }
-
-    // Set the iterator
-    m_next = m_positions.begin();
+    AddCell (Cell {0, 0});
   }
 
   HexGridPositionAllocator::~HexGridPositionAllocator ()
@@ -81,10 +78,19 @@ namespace ns3 {
     NS_LOG_FUNCTION_NOARGS ();
   }
 
-  const double HexGridPositionAllocator::pi = std::acos(-1);
+  void
+  HexGridPositionAllocator::NotifyConstructionCompleted (void)
+  {
+    // Attributes were just set to their default values
+    if (m_constructorRadius > 0)
+      {
+        m_radius = m_constructorRadius;
+      }
+    PositionAllocator::NotifyConstructionCompleted ();
+  }
 
   double
-  HexGridPositionAllocator::GetRadius (void)
+  HexGridPositionAllocator::GetRadius (void) const
   {
     return m_radius;
   }
@@ -98,10 +104,11 @@ namespace ns3 {
   Vector
   HexGridPositionAllocator::GetNext (void) const
   {
-    // TODO: Check that there is a next element
-    Vector position = *m_next;
-    m_next++;
-    return position;
+    if (m_next == m_cells.size ())
+      {
+        AddRing ();
+      }
+    return GetCellCenter (m_cells[m_next++]);
   }
 
   int64_t
@@ -110,52 +117,97 @@ namespace ns3 {
     return 0;
   }
 
-  std::vector<Vector>
-  HexGridPositionAllocator::AddRing (std::vector<Vector> positions)
+  Vector
+  HexGridPositionAllocator::GetNearestCellCenter (Vector position) const
   {
-    NS_LOG_FUNCTION (this);
+    return GetCellCenter (GetCell (position));
+  }
+
+  uint32_t
+  HexGridPositionAllocator::GetNearestCellIndex (Vector position) const
+  {
+    Cell cell = GetCell (position);
 
-    // Make a copy of the vector
-    std::vector<Vector> copy = positions;
+    // Generate the rings up to the one of the cell
+    int32_t ring = (std::abs (cell.i) + std::abs (cell.j) + std::abs (cell.i + cell.j)) / 2;
+    const Cell &last = m_cells.back ();
+    int32_t lastRing = (std::abs (last.i) + std::abs (last.j) + std::abs (last.i + last.j)) / 2;
+    for (; lastRing < ring; lastRing++)
+      {
+        AddRing ();
+      }
+
+    return m_indices.find (GetKey (cell))->second;
+  }
+
+  void
+  HexGridPositionAllocator::AddRing (void) const
+  {
+    NS_LOG_FUNCTION (this);
 
-    // Iterate on the given vector
-    for (std::vector<Vector>::iterator it = positions.begin ();
-         it != positions.end (); it++)
+    // All the cells of the inner rings are already there, so that the new
+    // neighbors of the last ring are the cells of the next one
+    uint32_t start = m_lastRingStart;
+    uint32_t end = m_cells.size ();
+    m_lastRingStart = end;
+    for (uint32_t k = start; k < end; k++)
       {
-        // Get the current position
-        Vector currentPosition = *it;
-        NS_LOG_DEBUG ("Current position " << currentPosition);
-
-        // Iterate to create the 6 surrounding positions
-        // The angle is with respect to a vertical line
-        Vector newPosition;
-        for (double angle = 0; angle < 2*pi; angle+=pi/3)
+        Cell cell = m_cells[k];
+        for (int d = 0; d < 6; d++)
           {
-            newPosition = Vector (currentPosition.x+2*m_radius*std::sin(angle),
-                                  currentPosition.y+2*m_radius*std::cos(angle),
-                                  currentPosition.z);
-            NS_LOG_DEBUG ("New position: " << newPosition);
-
-            // If the newly created position is not already in the copy, add it
-            bool found = false;
-            for (std::vector<Vector>::iterator it = copy.begin ();
-                 it != copy.end (); it++)
-              {
-                // If the vector is already in the vector
-                // 1 is an EPSILON used to determine whether two floats are equal
-                if (CalculateDistance(newPosition, *it) < 10)
-                  {
-                    found = true;
-                    break;
-                  }
-              }
-            if (found == false)
-              {
-                NS_LOG_DEBUG ("Adding position " << newPosition);
-                copy.push_back (newPosition);
-              }
+            AddCell (Cell {cell.i + g_directions[d][0], cell.j + g_directions[d][1]});
           }
       }
-    return copy;
+
+    NS_LOG_DEBUG ("Added a ring of " << m_cells.size () - end << " cells");
+  }
+
+  void
+  HexGridPositionAllocator::AddCell (Cell cell) const
+  {
+    if (m_indices.insert (std::make_pair (GetKey (cell), m_cells.size ())).second)
+      {
+        m_cells.push_back (cell);
+      }
+  }
+
+  HexGridPositionAllocator::Cell
+  HexGridPositionAllocator::GetCell (Vector position) const
+  {
+    // Fractional axial coordinates, rounded in cube coordinates (i, j, k)
+    // with i + j + k = 0
+    double j = position.x / (g_sqrt3 * m_radius);
+    double i = (position.y - m_radius * j) / (2 * m_radius);
+    double k = -i - j;
+
+    double ri = std::round (i);
+    double rj = std::round (j);
+    double rk = std::round (k);
+    double di = std::abs (ri - i);
+    double dj = std::abs (rj - j);
+    double dk = std::abs (rk - k);
+    if (di > dj && di > dk)
+      {
+        ri = -rj - rk;
+      }
+    else if (dj > dk)
+      {
+        rj = -ri - rk;
+      }
+
+    return Cell {int32_t (ri), int32_t (rj)};
+  }
+
+  Vector
+  HexGridPositionAllocator::GetCellCenter (Cell cell) const
+  {
+    // The north step is (0, 2r), the north-east one (sqrt(3) r, r)
+    return Vector (g_sqrt3 * m_radius * cell.j, m_radius * (2 * cell.i + cell.j), 0.0);
+  }
+
+  uint64_t
+  HexGridPositionAllocator::GetKey (Cell cell)
+  {
+    return (uint64_t (uint32_t (cell.i)) << 32) | uint32_t (cell.j);
   }
 } // namespace ns3
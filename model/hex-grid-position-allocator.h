@@ -21,9 +21,22 @@
 
 #include "ns3/position-allocator.h"
 #include <cmath>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3 {
 
+  /**
+   * Allocate positions on the centers of a grid of hexagonal cells: first the
+   * center of the grid, then the cells of each ring around it, going
+   * outwards.
+   *
+   * Cells are identified by their axial coordinates (i, j), the numbers of
+   * steps to the north and to the north-east from the center of the grid.
+   * Rings are generated on demand, each in a time proportional to its size,
+   * so that the grid has no size limit and only the cells that were
+   * allocated, or queried, are kept in memory.
+   */
   class HexGridPositionAllocator : public PositionAllocator
   {
   public:
@@ -38,26 +51,87 @@ namespace ns3 {
 
     static TypeId GetTypeId (void);
 
-    double GetRadius (void);
+    double GetRadius (void) const;
 
     void SetRadius (double radius);
 
+    /**
+     * Get the center of the cell containing a position, in constant time.
+     *
+     * \param position The position, whose z coordinate is ignored.
+     * \return The center of the cell.
+     */
+    Vector GetNearestCellCenter (Vector position) const;
+
+    /**
+     * Get the cell containing a position, as the index of its center in the
+     * sequence of positions returned by GetNext: if a gateway was put on each
+     * position, this is the index of the gateway of the cell. This takes
+     * constant time once the ring of the cell was generated.
+     *
+     * \param position The position, whose z coordinate is ignored.
+     * \return The index of the cell.
+     */
+    uint32_t GetNearestCellIndex (Vector position) const;
+
   private:
     /**
-     * This method adds to the given list of positions an outer ring of positions
-     * \param position the list of position around which to create the other positions
+     * The axial coordinates of a cell.
+     */
+    struct Cell
+    {
+      int32_t i; //!< The steps to the north
+      int32_t j; //!< The steps to the north-east
+    };
+
+    /**
+     * Append the cells of the next ring to m_cells. The cells of ring k + 1
+     * are the new neighbors of the cells of ring k, taken in order, each
+     * going clockwise from the north.
+     */
+    void AddRing (void) const;
+
+    /**
+     * Add a cell to m_cells, if it is not there yet.
+     */
+    void AddCell (Cell cell) const;
+
+    /**
+     * \return The axial coordinates of the cell containing a position.
      */
-    std::vector<Vector> AddRing (std::vector<Vector> positions);
+    Cell GetCell (Vector position) const;
 
     /**
-     * The list of current positions
+     * \return The center of a cell.
      */
-    std::vector<Vector> m_positions;
+    Vector GetCellCenter (Cell cell) const;
 
     /**
-     * The iterator pointing to the next position to return
+     * \return A key identifying a cell in m_indices.
      */
-    mutable std::vector<Vector>::const_iterator m_next;
+    static uint64_t GetKey (Cell cell);
+
+    virtual void NotifyConstructionCompleted (void);
+
+    /**
+     * The cells generated so far, in allocation order
+     */
+    mutable std::vector<Cell> m_cells;
+
+    /**
+     * The index of each generated cell in m_cells
+     */
+    mutable std::unordered_map<uint64_t, uint32_t> m_indices;
+
+    /**
+     * The index in m_cells of the first cell of the last generated ring
+     */
+    mutable uint32_t m_lastRingStart;
+
+    /**
+     * The index in m_cells of the next cell to return
+     */
+    mutable uint32_t m_next;
 
     /**
      * The radius of a cell (defined as the half the distance between two
@@ -65,9 +139,13 @@ namespace ns3 {
      */
     double m_radius;
 
-    const static double pi; //!< Pi
+    /**
+     * The radius given to the constructor, which takes precedence over the
+     * value of the attribute, or 0
+     */
+    double m_constructorRadius;
   };
 
 } // namespace ns3
 
-#endif /* PERIODIC_SENDER_HELPER_H */
+#endif /* HEX_GRID_POSITION_ALLOCATOR_H */
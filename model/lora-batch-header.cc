@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#include "ns3/lora-batch-header.h"
+#include "ns3/log.h"
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraBatchHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (LoraBatchHeader);
+
+const uint8_t LoraBatchHeader::IDENTIFIER;
+
+TypeId
+LoraBatchHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraBatchHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraBatchHeader> ()
+  ;
+  return tid;
+}
+
+LoraBatchHeader::LoraBatchHeader ()
+{
+}
+
+LoraBatchHeader::~LoraBatchHeader ()
+{
+}
+
+TypeId
+LoraBatchHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LoraBatchHeader::GetSerializedSize (void) const
+{
+  // Identifier and number of frames, then for each frame its size (1 byte),
+  // reception time (8 bytes), SNR in tenths of dB (2 bytes) and frame info
+  return 2 + m_frames.size () * (11 + LoraFrameInfoTag ().GetSerializedSize ());
+}
+
+void
+LoraBatchHeader::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  uint32_t infoSize = LoraFrameInfoTag ().GetSerializedSize ();
+  std::vector<uint8_t> info (infoSize);
+
+  start.WriteU8 (IDENTIFIER);
+  start.WriteU8 (m_frames.size ());
+  for (uint32_t i = 0; i < m_frames.size (); i++)
+    {
+      const FrameMetadata &frame = m_frames[i];
+      start.WriteU8 (frame.size);
+      start.WriteHtonU64 (frame.receptionTime.GetNanoSeconds ());
+      start.WriteHtonU16 (int16_t (std::round (frame.snr * 10)));
+      frame.frameInfo.Serialize (TagBuffer (info.data (), info.data () + infoSize));
+      start.Write (info.data (), infoSize);
+    }
+}
+
+uint32_t
+LoraBatchHeader::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  uint32_t infoSize = LoraFrameInfoTag ().GetSerializedSize ();
+  std::vector<uint8_t> info (infoSize);
+
+  uint8_t identifier = start.ReadU8 ();
+  NS_ASSERT (identifier == IDENTIFIER);
+  uint8_t nFrames = start.ReadU8 ();
+  m_frames.resize (nFrames);
+  for (uint32_t i = 0; i < nFrames; i++)
+    {
+      FrameMetadata &frame = m_frames[i];
+      frame.size = start.ReadU8 ();
+      frame.receptionTime = NanoSeconds (int64_t (start.ReadNtohU64 ()));
+      frame.snr = int16_t (start.ReadNtohU16 ()) / 10.0;
+      start.Read (info.data (), infoSize);
+      frame.frameInfo.Deserialize (TagBuffer (info.data (), info.data () + infoSize));
+    }
+
+  return GetSerializedSize ();
+}
+
+void
+LoraBatchHeader::Print (std::ostream &os) const
+{
+  os << "Batch of " << m_frames.size () << " frames:";
+  for (uint32_t i = 0; i < m_frames.size (); i++)
+    {
+      os << " [size=" << unsigned (m_frames[i].size) << " time="
+         << m_frames[i].receptionTime.GetSeconds () << " SNR=" << m_frames[i].snr << " ";
+      m_frames[i].frameInfo.Print (os);
+      os << "]";
+    }
+}
+
+bool
+LoraBatchHeader::IsBatch (Ptr<const Packet> packet)
+{
+  uint8_t identifier = 0;
+  return packet->CopyData (&identifier, 1) == 1 && identifier == IDENTIFIER;
+}
+
+void
+LoraBatchHeader::AddFrame (const FrameMetadata &frame)
+{
+  NS_ASSERT (m_frames.size () < 255);
+  m_frames.push_back (frame);
+}
+
+uint32_t
+LoraBatchHeader::GetNFrames (void) const
+{
+  return m_frames.size ();
+}
+
+const LoraBatchHeader::FrameMetadata &
+LoraBatchHeader::GetFrame (uint32_t i) const
+{
+  return m_frames[i];
+}
+
+void
+LoraBatchHeader::Clear (void)
+{
+  m_frames.clear ();
+}
+
+} // namespace lorawan
+} // namespace ns3
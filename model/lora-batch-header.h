@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#ifndef LORA_BATCH_HEADER_H
+#define LORA_BATCH_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/lora-frame-info-tag.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The header of a batch of uplink frames, sent by a Forwarder to the
+ * Network Server.
+ *
+ * A batch is made of this header followed by the frames, one after the
+ * other. For each frame, the header gives its size, the time the gateway
+ * received it, its RSSI and SNR, and the LoraFrameInfoTag the gateway MAC
+ * attached to it, so that the Network Server can split the batch without
+ * decoding the frames again.
+ *
+ * The header starts with an identifier byte whose RFU bits would be set in
+ * a LorawanMacHeader, so that batches can be told apart from single frames.
+ */
+class LoraBatchHeader : public Header
+{
+public:
+  /**
+   * The first byte of a batch.
+   */
+  static const uint8_t IDENTIFIER = 0x1c;
+
+  /**
+   * The metadata of a frame of the batch.
+   */
+  struct FrameMetadata
+  {
+    uint8_t size; //!< The size of the frame [bytes]
+    Time receptionTime; //!< When the gateway received the frame
+    double snr; //!< The SNR of the frame [dB]
+    LoraFrameInfoTag frameInfo; //!< The headers and the RSSI of the frame
+  };
+
+  static TypeId GetTypeId (void);
+
+  LoraBatchHeader ();
+  ~LoraBatchHeader ();
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * \return Whether a packet starts with a LoraBatchHeader.
+   */
+  static bool IsBatch (Ptr<const Packet> packet);
+
+  /**
+   * Add the metadata of the frame following the ones already in the batch.
+   */
+  void AddFrame (const FrameMetadata &frame);
+
+  /**
+   * \return The number of frames of the batch.
+   */
+  uint32_t GetNFrames (void) const;
+
+  /**
+   * \return The metadata of the i-th frame of the batch.
+   */
+  const FrameMetadata &GetFrame (uint32_t i) const;
+
+  /**
+   * Remove the metadata of all frames.
+   */
+  void Clear (void);
+
+private:
+  std::vector<FrameMetadata> m_frames;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_BATCH_HEADER_H */
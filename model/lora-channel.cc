@@ -26,6 +26,7 @@
 #include "ns3/simulator.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/gateway-lora-phy.h"
+#include "ns3/lora-profiler.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -112,6 +113,7 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
 {
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << txParams <<
                    duration << frequencyMHz);
+  LORAWAN_PROFILE (CHANNEL_SEND);
 
   // Get the mobility model of the sender
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
@@ -185,6 +187,7 @@ LoraChannel::Receive (uint32_t i, Ptr<Packet> packet,
                       LoraChannelParameters parameters) const
 {
   NS_LOG_FUNCTION (this << i << packet << parameters);
+  LORAWAN_PROFILE (CHANNEL_RECEIVE);
 
   // Call the appropriate PHY instance to let it begin reception
   m_phyList[i]->StartReceive (packet, parameters.rxPowerDbm, parameters.sf,
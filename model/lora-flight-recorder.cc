@@ -0,0 +1,300 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraFlightRecorder");
+
+static_assert (sizeof (LoraFlightRecorder::Record) == 56,
+               "Dumps rely on the layout of LoraFlightRecorder::Record");
+
+/**
+ * The records of a thread. Only the owning thread writes to it: the number
+ * of records written is published with release semantics, so that Dump
+ * sees complete records.
+ */
+struct FlightRecorderRing
+{
+  std::vector<LoraFlightRecorder::Record> records;
+  std::atomic<uint64_t> written;
+};
+
+// The header of a dump, followed by its records
+static const char g_magic[8] = {'L', 'O', 'R', 'A', 'F', 'R', '0', '1'};
+
+bool LoraFlightRecorder::m_enabled = false;
+
+static uint32_t g_capacity = 0; //!< The size of new rings, a power of two
+static std::mutex g_ringsMutex; //!< Guards g_rings
+// Rings are never freed, since a dump may happen after their thread ended
+static std::vector<FlightRecorderRing *> g_rings;
+static thread_local FlightRecorderRing *t_ring = 0;
+
+static int g_triggerType = 0; //!< The RecordType dumping the rings, or 0
+static std::string g_triggerFilename;
+static std::string g_exitFilename;
+
+static void
+DumpAtExitHandler (void)
+{
+  LoraFlightRecorder::Dump (g_exitFilename);
+}
+
+void
+LoraFlightRecorder::Enable (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (capacity);
+  NS_ASSERT (capacity > 0);
+
+  std::lock_guard<std::mutex> lock (g_ringsMutex);
+  if (g_capacity == 0)
+    {
+      g_capacity = 1;
+      while (g_capacity < capacity)
+        {
+          g_capacity <<= 1;
+        }
+    }
+  m_enabled = true;
+}
+
+void
+LoraFlightRecorder::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_enabled = false;
+}
+
+void
+LoraFlightRecorder::SetTrigger (enum RecordType type, std::string filename)
+{
+  NS_LOG_FUNCTION (type << filename);
+
+  g_triggerFilename = filename;
+  g_triggerType = type;
+}
+
+void
+LoraFlightRecorder::DumpAtExit (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  if (g_exitFilename.empty ())
+    {
+      std::atexit (&DumpAtExitHandler);
+    }
+  g_exitFilename = filename;
+}
+
+void
+LoraFlightRecorder::Write (enum RecordType type, uint32_t nodeId, uint8_t sf, uint8_t code,
+                           double value, double powerDbm, const double *sinrDb)
+{
+  FlightRecorderRing *ring = t_ring;
+  if (ring == 0)
+    {
+      // First record of this thread
+      ring = new FlightRecorderRing;
+      std::lock_guard<std::mutex> lock (g_ringsMutex);
+      ring->records.resize (g_capacity);
+      ring->written.store (0, std::memory_order_relaxed);
+      g_rings.push_back (ring);
+      t_ring = ring;
+    }
+
+  uint64_t written = ring->written.load (std::memory_order_relaxed);
+  Record &record = ring->records[written & (ring->records.size () - 1)];
+  record.timeStep = Simulator::Now ().GetTimeStep ();
+  record.nodeId = nodeId;
+  record.type = type;
+  record.sf = sf;
+  record.code = code;
+  record.reserved = 0;
+  record.value = value;
+  record.powerDbm = powerDbm;
+  for (int i = 0; i < 6; i++)
+    {
+      record.sinrDb[i] = sinrDb ? float (sinrDb[i]) : 0;
+    }
+  ring->written.store (written + 1, std::memory_order_release);
+
+  if (type == g_triggerType)
+    {
+      // Only dump on the first occurrence
+      g_triggerType = 0;
+      Dump (g_triggerFilename);
+    }
+}
+
+uint32_t
+LoraFlightRecorder::Dump (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  std::vector<Record> records;
+  {
+    std::lock_guard<std::mutex> lock (g_ringsMutex);
+    for (uint32_t i = 0; i < g_rings.size (); i++)
+      {
+        const FlightRecorderRing *ring = g_rings[i];
+        uint64_t written = ring->written.load (std::memory_order_acquire);
+        uint64_t size = ring->records.size ();
+        for (uint64_t k = written > size ? written - size : 0; k < written; k++)
+          {
+            records.push_back (ring->records[k & (size - 1)]);
+          }
+      }
+  }
+
+  // Rings are in time order: merge them
+  std::stable_sort (records.begin (), records.end (),
+                    [] (const Record &a, const Record &b)
+                    {
+                      return a.timeStep < b.timeStep;
+                    });
+
+  std::ofstream file (filename.c_str (), std::ios::binary);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << filename);
+      return 0;
+    }
+  uint32_t recordSize = sizeof (Record);
+  uint32_t count = records.size ();
+  file.write (g_magic, sizeof (g_magic));
+  file.write (reinterpret_cast<const char *> (&recordSize), sizeof (recordSize));
+  file.write (reinterpret_cast<const char *> (&count), sizeof (count));
+  file.write (reinterpret_cast<const char *> (records.data ()), count * sizeof (Record));
+
+  NS_LOG_INFO ("Dumped " << count << " records to " << filename);
+
+  return count;
+}
+
+static const char *
+GetStateName (uint8_t state)
+{
+  switch (state)
+    {
+    case EndDeviceLoraPhy::SLEEP:
+      return "SLEEP";
+    case EndDeviceLoraPhy::STANDBY:
+      return "STANDBY";
+    case EndDeviceLoraPhy::TX:
+      return "TX";
+    case EndDeviceLoraPhy::RX:
+      return "RX";
+    case EndDeviceLoraPhy::OFF:
+      return "OFF";
+    case EndDeviceLoraPhy::TURNON:
+      return "TURNON";
+    case EndDeviceLoraPhy::IDLE:
+      return "IDLE";
+    }
+  return "UNKNOWN";
+}
+
+uint32_t
+LoraFlightRecorder::Decode (std::string filename, std::ostream &os)
+{
+  NS_LOG_FUNCTION (filename);
+
+  std::ifstream file (filename.c_str (), std::ios::binary);
+  NS_ABORT_MSG_UNLESS (file.is_open (), "Cannot open " << filename);
+
+  char magic[8];
+  uint32_t recordSize = 0;
+  uint32_t count = 0;
+  file.read (magic, sizeof (magic));
+  file.read (reinterpret_cast<char *> (&recordSize), sizeof (recordSize));
+  file.read (reinterpret_cast<char *> (&count), sizeof (count));
+  NS_ABORT_MSG_UNLESS (file && std::memcmp (magic, g_magic, sizeof (magic)) == 0,
+                       filename << " is not a flight recorder dump");
+  NS_ABORT_MSG_UNLESS (recordSize == sizeof (Record),
+                       filename << " was written with a different record layout");
+
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  uint32_t decoded = 0;
+  Record record;
+  while (decoded < count && file.read (reinterpret_cast<char *> (&record), sizeof (record)))
+    {
+      os << std::fixed << std::setprecision (9) << TimeStep (record.timeStep).GetSeconds ()
+         << "s node " << record.nodeId << " " << std::setprecision (3);
+      switch (record.type)
+        {
+        case TX_START:
+          os << "TX_START sf " << unsigned (record.sf) << " freq " << record.value
+             << " power " << record.powerDbm;
+          break;
+        case RX_LOCK:
+          os << "RX_LOCK sf " << unsigned (record.sf) << " freq " << record.value
+             << " power " << record.powerDbm;
+          break;
+        case INTERFERENCE_VERDICT:
+          os << "INTERFERENCE_VERDICT sf " << unsigned (record.sf) << " freq "
+             << record.value << " power " << record.powerDbm << " destroyedBy "
+             << unsigned (record.code) << " sinr";
+          for (int i = 0; i < 6; i++)
+            {
+              os << " " << i + 7 << ":" << record.sinrDb[i];
+            }
+          break;
+        case NO_MORE_DEMODULATORS:
+          os << "NO_MORE_DEMODULATORS sf " << unsigned (record.sf) << " freq "
+             << record.value << " power " << record.powerDbm;
+          break;
+        case ENERGY_DEPLETED:
+          os << "ENERGY_DEPLETED voltage " << record.value;
+          break;
+        case ENERGY_RECHARGED:
+          os << "ENERGY_RECHARGED voltage " << record.value;
+          break;
+        case STATE_CHANGE:
+          os << "STATE_CHANGE " << GetStateName (record.code);
+          break;
+        default:
+          os << "UNKNOWN type " << unsigned (record.type);
+        }
+      os << std::endl;
+      decoded++;
+    }
+  os.flags (flags);
+  os.precision (precision);
+
+  return decoded;
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORA_FLIGHT_RECORDER_H
+#define LORA_FLIGHT_RECORDER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A binary record of the last events of the hot paths of the module.
+ *
+ * Unlike NS_LOG, which formats a string for every message, the recorder
+ * copies a fixed-size Record in a ring buffer, so that it can be left
+ * enabled in long runs and inspected after a rare loss. Each thread writes
+ * to a ring of its own, without locks: the only lock is taken when a thread
+ * writes its first record, and when the rings are dumped.
+ *
+ * The rings are dumped to a binary file on demand (Dump), the first time a
+ * record of a given type is written (SetTrigger), or when the program exits
+ * (DumpAtExit). Decode, or the lora-flight-recorder-decoder example, turns
+ * a dump into text.
+ *
+ * When the recorder is disabled, which is the default, each Record* call
+ * costs a single test of a static flag.
+ */
+class LoraFlightRecorder
+{
+public:
+  /**
+   * The kinds of events the recorder keeps.
+   */
+  enum RecordType
+  {
+    TX_START = 1, //!< A PHY started sending a packet
+    RX_LOCK, //!< A PHY locked on an incoming packet
+    INTERFERENCE_VERDICT, //!< The interference check at the end of a reception
+    NO_MORE_DEMODULATORS, //!< A gateway found no free reception path
+    ENERGY_DEPLETED, //!< A capacitor went under its low threshold
+    ENERGY_RECHARGED, //!< A capacitor went over its high threshold
+    STATE_CHANGE //!< An end device PHY changed state
+  };
+
+  /**
+   * A single event, as stored in the rings and in the dumps.
+   */
+  struct Record
+  {
+    int64_t timeStep; //!< The simulation time of the event [time steps]
+    uint32_t nodeId; //!< The node, or the simulator context if unknown
+    uint8_t type; //!< The RecordType
+    uint8_t sf; //!< The spreading factor of the packet
+    uint8_t code; //!< The destroying SF of a verdict, or the new PHY state
+    uint8_t reserved;
+    double value; //!< The frequency of the packet [MHz], or the voltage [V]
+    double powerDbm; //!< The transmission or reception power [dBm]
+    float sinrDb[6]; //!< The SINR against each of SF7 to SF12, for verdicts
+  };
+
+  /**
+   * Start recording.
+   *
+   * \param capacity The number of records kept by the ring of each thread,
+   * rounded up to a power of two. It is only used by the rings created after
+   * the first call.
+   */
+  static void Enable (uint32_t capacity = 65536);
+
+  /**
+   * Stop recording. The records written so far are kept.
+   */
+  static void Disable (void);
+
+  /**
+   * \return Whether the recorder is enabled.
+   */
+  static bool
+  IsEnabled (void)
+  {
+    return m_enabled;
+  }
+
+  /**
+   * Dump the rings the first time a record of the given type is written.
+   *
+   * \param type The type of the record triggering the dump.
+   * \param filename The file to write.
+   */
+  static void SetTrigger (enum RecordType type, std::string filename);
+
+  /**
+   * Dump the rings when the program exits.
+   *
+   * \param filename The file to write.
+   */
+  static void DumpAtExit (std::string filename);
+
+  /**
+   * Write the records of all the rings to a file, oldest first.
+   *
+   * Records are only consistent if no thread writes to its ring during the
+   * dump: call this from the simulation thread.
+   *
+   * \param filename The file to write.
+   * \return The number of records written.
+   */
+  static uint32_t Dump (std::string filename);
+
+  /**
+   * Print the records of a dump, one per line.
+   *
+   * \param filename The file written by Dump.
+   * \param os The stream to print to.
+   * \return The number of records printed.
+   */
+  static uint32_t Decode (std::string filename, std::ostream &os);
+
+  static void
+  RecordTxStart (uint32_t nodeId, uint8_t sf, double frequencyMHz, double txPowerDbm)
+  {
+    if (m_enabled)
+      {
+        Write (TX_START, nodeId, sf, 0, frequencyMHz, txPowerDbm);
+      }
+  }
+
+  static void
+  RecordRxLock (uint32_t nodeId, uint8_t sf, double frequencyMHz, double rxPowerDbm)
+  {
+    if (m_enabled)
+      {
+        Write (RX_LOCK, nodeId, sf, 0, frequencyMHz, rxPowerDbm);
+      }
+  }
+
+  static void
+  RecordNoMoreDemodulators (uint32_t nodeId, uint8_t sf, double frequencyMHz,
+                            double rxPowerDbm)
+  {
+    if (m_enabled)
+      {
+        Write (NO_MORE_DEMODULATORS, nodeId, sf, 0, frequencyMHz, rxPowerDbm);
+      }
+  }
+
+  /**
+   * \param destroyedBy The SF that destroyed the packet, or 0 if it survived.
+   * \param sinrDb The SINR of the packet against the interferers of each SF.
+   */
+  static void
+  RecordInterferenceVerdict (uint32_t nodeId, uint8_t sf, double frequencyMHz,
+                             double rxPowerDbm, uint8_t destroyedBy, const double sinrDb[6])
+  {
+    if (m_enabled)
+      {
+        Write (INTERFERENCE_VERDICT, nodeId, sf, destroyedBy, frequencyMHz, rxPowerDbm,
+               sinrDb);
+      }
+  }
+
+  static void
+  RecordEnergyDepleted (uint32_t nodeId, double voltage)
+  {
+    if (m_enabled)
+      {
+        Write (ENERGY_DEPLETED, nodeId, 0, 0, voltage, 0);
+      }
+  }
+
+  static void
+  RecordEnergyRecharged (uint32_t nodeId, double voltage)
+  {
+    if (m_enabled)
+      {
+        Write (ENERGY_RECHARGED, nodeId, 0, 0, voltage, 0);
+      }
+  }
+
+  /**
+   * \param state The new EndDeviceLoraPhy::State.
+   */
+  static void
+  RecordStateChange (uint32_t nodeId, uint8_t state)
+  {
+    if (m_enabled)
+      {
+        Write (STATE_CHANGE, nodeId, 0, state, 0, 0);
+      }
+  }
+
+private:
+  /**
+   * Append a record to the ring of the calling thread, and dump the rings if
+   * it is the trigger.
+   */
+  static void Write (enum RecordType type, uint32_t nodeId, uint8_t sf, uint8_t code,
+                     double value, double powerDbm, const double *sinrDb = 0);
+
+  static bool m_enabled; //!< Whether Record* calls write anything
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+#endif /* LORA_FLIGHT_RECORDER_H */
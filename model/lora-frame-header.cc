@@ -36,7 +36,8 @@ LoraFrameHeader::LoraFrameHeader () :
   m_ack       (0),
   m_fPending  (0),
   m_fOptsLen  (0),
-  m_fCnt      (0)
+  m_fCnt      (0),
+  m_nMacCommands (0)
 {
 }
 
@@ -95,10 +96,10 @@ LoraFrameHeader::Serialize (Buffer::Iterator start) const
   start.WriteU16 (m_fCnt);
 
   // FOpts field
-  for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
       NS_LOG_DEBUG ("Serializing a MAC command");
-      (*it)->Serialize (start);
+      m_macCommands[i].Serialize (start);
     }
 
   // FPort
@@ -111,7 +112,7 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
   NS_LOG_FUNCTION_NOARGS ();
 
   // Empty the list of MAC commands
-  m_macCommands.clear ();
+  m_nMacCommands = 0;
 
   // Read from buffer and save into local variables
   m_address.Set (start.ReadU32 ());
@@ -136,173 +137,24 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
   NS_LOG_DEBUG ("Starting deserialization of MAC commands");
   for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen;)
     {
-      uint8_t cid = start.PeekU8 ();
-      NS_LOG_DEBUG ("CID: " << unsigned(cid));
-
-      // Divide Uplink and Downlink messages
-      // This needs to be done because they have the same CID, and the context
-      // about where this message will be Serialized/Deserialized (i.e., at the
-      // ED or at the NS) is umportant.
-      if (m_isUplink)
+      NS_LOG_DEBUG ("CID: " << unsigned (start.PeekU8 ()));
+
+      // Uplink and Downlink messages need to be distinguished, because they
+      // have the same CIDs, and the context about where this message will be
+      // Serialized/Deserialized (i.e., at the ED or at the NS) is important.
+      NS_ASSERT (m_nMacCommands < MAX_FOPTS_COMMANDS);
+      uint8_t size = m_macCommands[m_nMacCommands].Deserialize (start, m_isUplink);
+      if (size == 0)
         {
-          switch (cid)
-            {
-            // In the case of Uplink messages, the NS will deserialize the
-            // request for a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create <LinkCheckReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create <LinkAdrAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create <DutyCycleAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create <RxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create <DevStatusAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create <NewChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create <RxTimingSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create <TxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x0A):
-              {
-                NS_LOG_DEBUG ("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create <DlChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
-        }
-      else
-        {
-          switch (cid)
-            {
-            // In the case of Downlink messages, the ED will deserialize the
-            // answer to a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create <LinkCheckAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create <LinkAdrReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create <DutyCycleReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create <RxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create <DevStatusReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create <NewChannelReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create <RxTimingSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create <TxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
+          NS_LOG_ERROR ("CID not recognized during deserialization");
+          // Skip the rest of the FOpts field
+          start.Next (m_fOptsLen - byteNumber);
+          break;
         }
+      NS_LOG_DEBUG ("Deserialized a command of type "
+                    << m_macCommands[m_nMacCommands].GetCommandType ());
+      m_nMacCommands++;
+      byteNumber += size;
     }
 
   m_fPort = uint8_t (start.ReadU8 ());
@@ -323,9 +175,13 @@ LoraFrameHeader::Print (std::ostream &os) const
   os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
   os << "FCnt=" << unsigned(m_fCnt) << std::endl;
 
-  for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
-      (*it)->Print (os);
+      Ptr<MacCommand> command = m_macCommands[i].CreateCommand ();
+      if (command)
+        {
+          command->Print (os);
+        }
     }
 
   os << "FPort=" << unsigned(m_fPort) << std::endl;
@@ -422,10 +278,9 @@ LoraFrameHeader::GetFOptsLen (void) const
 {
   // Sum the serialized lenght of all commands in the list
   uint8_t fOptsLen = 0;
-  std::list< Ptr< MacCommand> >::const_iterator it;
-  for (it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
-      fOptsLen = fOptsLen + (*it)->GetSerializedSize ();
+      fOptsLen = fOptsLen + m_macCommands[i].GetSerializedSize ();
     }
   return fOptsLen;
 }
@@ -448,10 +303,7 @@ LoraFrameHeader::AddLinkCheckReq (void)
   NS_LOG_FUNCTION_NOARGS ();
 
   Ptr<LinkCheckReq> command = Create<LinkCheckReq> ();
-  m_macCommands.push_back (command);
-
-  NS_LOG_DEBUG ("Command SerializedSize: " << unsigned(command->GetSerializedSize ()));
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -460,9 +312,7 @@ LoraFrameHeader::AddLinkCheckAns (uint8_t margin, uint8_t gwCnt)
   NS_LOG_FUNCTION (this << unsigned(margin) << unsigned(gwCnt));
 
   Ptr<LinkCheckAns> command = Create<LinkCheckAns> (margin, gwCnt);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -483,9 +333,7 @@ LoraFrameHeader::AddLinkAdrReq (uint8_t dataRate, uint8_t txPower, std::list<int
   NS_LOG_DEBUG ("Creating LinkAdrReq with: DR = " << unsigned(dataRate) << " and txPower = " << unsigned(txPower));
 
   Ptr<LinkAdrReq> command = Create<LinkAdrReq> (dataRate, txPower, channelMask, 0, repetitions);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -494,9 +342,7 @@ LoraFrameHeader::AddLinkAdrAns (bool powerAck, bool dataRateAck, bool channelMas
   NS_LOG_FUNCTION (this << powerAck << dataRateAck << channelMaskAck);
 
   Ptr<LinkAdrAns> command = Create<LinkAdrAns> (powerAck, dataRateAck, channelMaskAck);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -506,9 +352,7 @@ LoraFrameHeader::AddDutyCycleReq (uint8_t dutyCycle)
 
   Ptr<DutyCycleReq> command = Create<DutyCycleReq> (dutyCycle);
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -518,9 +362,7 @@ LoraFrameHeader::AddDutyCycleAns (void)
 
   Ptr<DutyCycleAns> command = Create<DutyCycleAns> ();
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -536,9 +378,7 @@ LoraFrameHeader::AddRxParamSetupReq (uint8_t rx1DrOffset, uint8_t rx2DataRate, d
                                                           rx2DataRate,
                                                           frequency);
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -548,9 +388,7 @@ LoraFrameHeader::AddRxParamSetupAns (void)
 
   Ptr<RxParamSetupAns> command = Create<RxParamSetupAns> ();
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -560,9 +398,7 @@ LoraFrameHeader::AddDevStatusReq (void)
 
   Ptr<DevStatusReq> command = Create<DevStatusReq> ();
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 void
@@ -574,9 +410,7 @@ LoraFrameHeader::AddNewChannelReq (uint8_t chIndex, double frequency,
   Ptr<NewChannelReq> command = Create<NewChannelReq> (chIndex, frequency,
                                                       minDataRate, maxDataRate);
 
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (command);
 }
 
 std::list<Ptr<MacCommand> >
@@ -584,7 +418,16 @@ LoraFrameHeader::GetCommands (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  return m_macCommands;
+  std::list<Ptr<MacCommand> > commands;
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
+    {
+      Ptr<MacCommand> command = m_macCommands[i].CreateCommand ();
+      if (command)
+        {
+          commands.push_back (command);
+        }
+    }
+  return commands;
 }
 
 void
@@ -592,8 +435,43 @@ LoraFrameHeader::AddCommand (Ptr<MacCommand> macCommand)
 {
   NS_LOG_FUNCTION (this << macCommand);
 
-  m_macCommands.push_back (macCommand);
-  m_fOptsLen += macCommand->GetSerializedSize ();
+  AddCommandValue (MacCommandValue (macCommand));
+}
+
+void
+LoraFrameHeader::AddCommandValue (const MacCommandValue &value)
+{
+  NS_LOG_FUNCTION (this << value.GetCommandType ());
+
+  NS_ASSERT_MSG (m_nMacCommands < MAX_FOPTS_COMMANDS, "Too many MAC commands in FOpts");
+  m_macCommands[m_nMacCommands++] = value;
+  m_fOptsLen += value.GetSerializedSize ();
+}
+
+bool
+LoraFrameHeader::HasMacCommand (enum MacCommandType commandType) const
+{
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
+    {
+      if (m_macCommands[i].GetCommandType () == commandType)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+uint8_t
+LoraFrameHeader::GetNMacCommands (void) const
+{
+  return m_nMacCommands;
+}
+
+const MacCommandValue &
+LoraFrameHeader::GetMacCommandValue (uint8_t index) const
+{
+  NS_ASSERT (index < m_nMacCommands);
+  return m_macCommands[index];
 }
 
 }
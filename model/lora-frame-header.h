@@ -208,10 +208,34 @@ public:
   /**
    * Return a pointer to a MacCommand, or 0 if the MacCommand does not exist
    * in this header.
+   *
+   * \remark The returned object is decoded from the command stored in this
+   * header: modifying it does not modify the header.
    */
   template<typename T>
   inline Ptr<T> GetMacCommand (void);
 
+  /**
+   * Check whether a command of the given type is in this header, without
+   * creating any MacCommand object.
+   */
+  bool HasMacCommand (enum MacCommandType commandType) const;
+
+  /**
+   * \return The number of MAC commands in this header.
+   */
+  uint8_t GetNMacCommands (void) const;
+
+  /**
+   * \return The value of the MAC command at the given position.
+   */
+  const MacCommandValue &GetMacCommandValue (uint8_t index) const;
+
+  /**
+   * Add a MAC command, in its value representation, to this header.
+   */
+  void AddCommandValue (const MacCommandValue &value);
+
   /**
    * Add a LinkCheckReq command.
    */
@@ -287,6 +311,9 @@ public:
 
   /**
    * Return a list of pointers to all the MAC commands saved in this header.
+   *
+   * \remark The MacCommand objects are created from the commands stored in
+   * this header at each call.
    */
   std::list<Ptr<MacCommand> > GetCommands (void);
 
@@ -308,13 +335,18 @@ private:
 
   uint16_t m_fCnt;
 
-  Buffer m_fOpts;
+  /**
+   * Max number of MAC commands in the FOpts field, which is at most 15 bytes
+   * long, and each command takes at least one byte.
+   */
+  static const uint8_t MAX_FOPTS_COMMANDS = 15;
 
   /**
-   * List containing all the MacCommand instances that are contained in this
-   * LoraFrameHeader.
+   * The MAC commands contained in this LoraFrameHeader, stored inline so that
+   * (de)serializing the header does not allocate.
    */
-  std::list< Ptr< MacCommand> > m_macCommands;
+  MacCommandValue m_macCommands[MAX_FOPTS_COMMANDS];
+  uint8_t m_nMacCommands; //!< Number of valid entries in m_macCommands
 
   bool m_isUplink;
 };
@@ -325,12 +357,12 @@ Ptr<T>
 LoraFrameHeader::GetMacCommand ()
 {
   // Iterate on MAC commands and try casting
-  std::list< Ptr< MacCommand> >::const_iterator it;
-  for (it = m_macCommands.begin (); it != m_macCommands.end (); ++it)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
-      if ((*it)->GetObject<T> () != 0)
+      Ptr<T> command = DynamicCast<T> (m_macCommands[i].CreateCommand ());
+      if (command != 0)
         {
-          return (*it)->GetObject<T> ();
+          return command;
         }
     }
 
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/lora-frame-info-tag.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-tag.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_OBJECT_ENSURE_REGISTERED (LoraFrameInfoTag);
+
+namespace {
+const uint8_t ADR_FLAG = 0x01;
+const uint8_t ADR_ACK_REQ_FLAG = 0x02;
+const uint8_t ACK_FLAG = 0x04;
+}
+
+TypeId
+LoraFrameInfoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraFrameInfoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraFrameInfoTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+LoraFrameInfoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+LoraFrameInfoTag::LoraFrameInfoTag () :
+  m_address (0),
+  m_fCnt (0),
+  m_mType (0),
+  m_flags (0),
+  m_fOptsLen (0),
+  m_macCommands (0),
+  m_sf (0),
+  m_frequency (0),
+  m_receivePower (0)
+{
+}
+
+LoraFrameInfoTag::~LoraFrameInfoTag ()
+{
+}
+
+uint32_t
+LoraFrameInfoTag::GetSerializedSize (void) const
+{
+  // Address and command mask (4 bytes each), FCnt (2 bytes), MType, flags,
+  // FOptsLen and SF (1 byte each), frequency and receive power (doubles)
+  return 14 + 2 * sizeof (double);
+}
+
+void
+LoraFrameInfoTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_address);
+  i.WriteU16 (m_fCnt);
+  i.WriteU8 (m_mType);
+  i.WriteU8 (m_flags);
+  i.WriteU8 (m_fOptsLen);
+  i.WriteU32 (m_macCommands);
+  i.WriteU8 (m_sf);
+  i.WriteDouble (m_frequency);
+  i.WriteDouble (m_receivePower);
+}
+
+void
+LoraFrameInfoTag::Deserialize (TagBuffer i)
+{
+  m_address = i.ReadU32 ();
+  m_fCnt = i.ReadU16 ();
+  m_mType = i.ReadU8 ();
+  m_flags = i.ReadU8 ();
+  m_fOptsLen = i.ReadU8 ();
+  m_macCommands = i.ReadU32 ();
+  m_sf = i.ReadU8 ();
+  m_frequency = i.ReadDouble ();
+  m_receivePower = i.ReadDouble ();
+}
+
+void
+LoraFrameInfoTag::Print (std::ostream &os) const
+{
+  os << GetAddress () << " FCnt=" << m_fCnt << " MType=" << unsigned (m_mType)
+     << " SF=" << unsigned (m_sf) << " Freq=" << m_frequency
+     << " RxPower=" << m_receivePower;
+}
+
+LoraFrameInfoTag
+LoraFrameInfoTag::Decode (Ptr<const Packet> packet)
+{
+  LoraFrameInfoTag info;
+
+  Ptr<Packet> packetCopy = packet->Copy ();
+  LorawanMacHeader macHdr;
+  packetCopy->RemoveHeader (macHdr);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  packetCopy->RemoveHeader (frameHdr);
+
+  info.m_address = frameHdr.GetAddress ().Get ();
+  info.m_fCnt = frameHdr.GetFCnt ();
+  info.m_mType = macHdr.GetMType ();
+  info.m_flags = (frameHdr.GetAdr () ? ADR_FLAG : 0)
+    | (frameHdr.GetAdrAckReq () ? ADR_ACK_REQ_FLAG : 0)
+    | (frameHdr.GetAck () ? ACK_FLAG : 0);
+  info.m_fOptsLen = frameHdr.GetFOptsLen ();
+  for (uint8_t j = 0; j < frameHdr.GetNMacCommands (); j++)
+    {
+      info.m_macCommands |= 1u << frameHdr.GetMacCommandValue (j).GetCommandType ();
+    }
+
+  LoraTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      info.m_sf = tag.GetSpreadingFactor ();
+      info.m_frequency = tag.GetFrequency ();
+      info.m_receivePower = tag.GetReceivePower ();
+    }
+
+  return info;
+}
+
+LoraFrameInfoTag
+LoraFrameInfoTag::Get (Ptr<const Packet> packet)
+{
+  LoraFrameInfoTag info;
+  if (!packet->PeekPacketTag (info))
+    {
+      info = Decode (packet);
+    }
+  return info;
+}
+
+LoraDeviceAddress
+LoraFrameInfoTag::GetAddress (void) const
+{
+  return LoraDeviceAddress (m_address);
+}
+
+uint16_t
+LoraFrameInfoTag::GetFCnt (void) const
+{
+  return m_fCnt;
+}
+
+uint8_t
+LoraFrameInfoTag::GetMType (void) const
+{
+  return m_mType;
+}
+
+bool
+LoraFrameInfoTag::GetAdr (void) const
+{
+  return m_flags & ADR_FLAG;
+}
+
+bool
+LoraFrameInfoTag::GetAdrAckReq (void) const
+{
+  return m_flags & ADR_ACK_REQ_FLAG;
+}
+
+bool
+LoraFrameInfoTag::GetAck (void) const
+{
+  return m_flags & ACK_FLAG;
+}
+
+uint8_t
+LoraFrameInfoTag::GetFOptsLen (void) const
+{
+  return m_fOptsLen;
+}
+
+bool
+LoraFrameInfoTag::HasMacCommand (enum MacCommandType commandType) const
+{
+  return m_macCommands & (1u << commandType);
+}
+
+uint8_t
+LoraFrameInfoTag::GetSpreadingFactor (void) const
+{
+  return m_sf;
+}
+
+double
+LoraFrameInfoTag::GetFrequency (void) const
+{
+  return m_frequency;
+}
+
+double
+LoraFrameInfoTag::GetReceivePower (void) const
+{
+  return m_receivePower;
+}
+}
+}
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORA_FRAME_INFO_TAG_H
+#define LORA_FRAME_INFO_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/packet.h"
+#include "ns3/lora-device-address.h"
+#include "ns3/mac-command.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Tag carrying the decoded headers of an uplink frame.
+ *
+ * The gateway MAC parses the LorawanMacHeader and LoraFrameHeader of each
+ * uplink once, together with the reception parameters of the LoraTag, and
+ * attaches the result to the packet it forwards. The Network Server
+ * components then read the fields they need from this tag, instead of copying
+ * the packet and deserializing its headers again.
+ *
+ * Of the FOpts field, only the set of MAC command types it contains is kept.
+ */
+class LoraFrameInfoTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  LoraFrameInfoTag ();
+  virtual ~LoraFrameInfoTag ();
+
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Decode the headers of an uplink packet, and its LoraTag if present.
+   *
+   * \param packet A packet starting with a LorawanMacHeader and an uplink
+   * LoraFrameHeader.
+   * \return The decoded frame information.
+   */
+  static LoraFrameInfoTag Decode (Ptr<const Packet> packet);
+
+  /**
+   * Get the frame information of a packet: use its LoraFrameInfoTag if it
+   * has one, else decode its headers.
+   */
+  static LoraFrameInfoTag Get (Ptr<const Packet> packet);
+
+  /**
+   * \return The address of the device that sent the frame.
+   */
+  LoraDeviceAddress GetAddress (void) const;
+
+  /**
+   * \return The frame counter.
+   */
+  uint16_t GetFCnt (void) const;
+
+  /**
+   * \return The MType field of the LorawanMacHeader.
+   */
+  uint8_t GetMType (void) const;
+
+  /**
+   * \return The value of the ADR bit.
+   */
+  bool GetAdr (void) const;
+
+  /**
+   * \return The value of the ADRACKReq bit.
+   */
+  bool GetAdrAckReq (void) const;
+
+  /**
+   * \return The value of the ACK bit.
+   */
+  bool GetAck (void) const;
+
+  /**
+   * \return The length of the FOpts field, in bytes.
+   */
+  uint8_t GetFOptsLen (void) const;
+
+  /**
+   * \return Whether a command of the given type is in the FOpts field.
+   */
+  bool HasMacCommand (enum MacCommandType commandType) const;
+
+  /**
+   * \return The Spreading Factor the frame was received with.
+   */
+  uint8_t GetSpreadingFactor (void) const;
+
+  /**
+   * \return The frequency the frame was received on, in MHz.
+   */
+  double GetFrequency (void) const;
+
+  /**
+   * \return The power the frame was received with at the gateway, in dBm.
+   */
+  double GetReceivePower (void) const;
+
+private:
+  uint32_t m_address; //!< The DevAddr, in 32-bit form
+  uint16_t m_fCnt; //!< The frame counter
+  uint8_t m_mType; //!< The MType
+  uint8_t m_flags; //!< The ADR, ADRACKReq and ACK bits
+  uint8_t m_fOptsLen; //!< The length of FOpts
+  uint32_t m_macCommands; //!< Bit i is set if a command of type i is in FOpts
+  uint8_t m_sf; //!< The Spreading Factor
+  double m_frequency; //!< The frequency [MHz]
+  double m_receivePower; //!< The receive power [dBm]
+};
+} // namespace ns3
+}
+#endif
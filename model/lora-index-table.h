@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORA_INDEX_TABLE_H
+#define LORA_INDEX_TABLE_H
+
+#include "ns3/address.h"
+#include "ns3/lora-device-address.h"
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Hash table mapping keys to positions in a vector.
+ *
+ * The table uses open addressing with linear probing: slots are stored in a
+ * single array whose size is a power of two, and which is kept at most half
+ * full, so that lookups only read a few contiguous slots and never allocate.
+ * Keys cannot be removed, since the NetworkStatus never forgets a device or
+ * a gateway.
+ *
+ * \tparam Key The type of the keys, which needs operator==.
+ * \tparam Hash A functor computing a uint32_t hash of a Key.
+ */
+template <typename Key, typename Hash>
+class IndexTable
+{
+public:
+  /**
+   * The index returned for keys that are not in the table.
+   */
+  static const uint32_t NOT_FOUND = 0xffffffff;
+
+  IndexTable () :
+    m_size (0)
+  {
+  }
+
+  /**
+   * \return The index associated to key, or NOT_FOUND.
+   */
+  uint32_t Find (const Key &key) const
+  {
+    if (m_slots.empty ())
+      {
+        return NOT_FOUND;
+      }
+    uint32_t mask = m_slots.size () - 1;
+    for (uint32_t i = m_hash (key) & mask; ; i = (i + 1) & mask)
+      {
+        const Slot &slot = m_slots[i];
+        if (slot.index == NOT_FOUND)
+          {
+            return NOT_FOUND;
+          }
+        if (slot.key == key)
+          {
+            return slot.index;
+          }
+      }
+  }
+
+  /**
+   * Associate an index to a key that is not in the table yet.
+   */
+  void Insert (const Key &key, uint32_t index)
+  {
+    if (2 * (m_size + 1) > m_slots.size ())
+      {
+        Grow ();
+      }
+    Place (key, index);
+    m_size++;
+  }
+
+  /**
+   * \return The number of keys in the table.
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_size;
+  }
+
+private:
+  struct Slot
+  {
+    Key key;
+    uint32_t index;
+  };
+
+  void Place (const Key &key, uint32_t index)
+  {
+    uint32_t mask = m_slots.size () - 1;
+    uint32_t i = m_hash (key) & mask;
+    while (m_slots[i].index != NOT_FOUND)
+      {
+        i = (i + 1) & mask;
+      }
+    m_slots[i].key = key;
+    m_slots[i].index = index;
+  }
+
+  void Grow (void)
+  {
+    std::vector<Slot> oldSlots;
+    oldSlots.swap (m_slots);
+
+    Slot empty;
+    empty.key = Key ();
+    empty.index = NOT_FOUND;
+    m_slots.assign (oldSlots.empty () ? 16 : 2 * oldSlots.size (), empty);
+
+    for (typename std::vector<Slot>::const_iterator it = oldSlots.begin ();
+         it != oldSlots.end (); ++it)
+      {
+        if (it->index != NOT_FOUND)
+          {
+            Place (it->key, it->index);
+          }
+      }
+  }
+
+  std::vector<Slot> m_slots; //!< The slots, a power of two of them
+  uint32_t m_size; //!< The number of occupied slots
+  Hash m_hash; //!< The hash functor
+};
+
+template <typename Key, typename Hash>
+const uint32_t IndexTable<Key, Hash>::NOT_FOUND;
+
+/**
+ * Hash of a LoraDeviceAddress.
+ *
+ * Addresses are often assigned sequentially, so the bits are mixed before
+ * the table takes the lowest ones.
+ */
+struct LoraDeviceAddressHash
+{
+  uint32_t operator() (const LoraDeviceAddress &address) const
+  {
+    uint32_t x = address.Get ();
+    x ^= x >> 16;
+    x *= 0x45d9f3b;
+    x ^= x >> 16;
+    return x;
+  }
+};
+
+/**
+ * FNV-1a hash of the bytes of an Address.
+ */
+struct AddressHash
+{
+  uint32_t operator() (const Address &address) const
+  {
+    uint8_t buffer[Address::MAX_SIZE];
+    uint32_t length = address.CopyTo (buffer);
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; i++)
+      {
+        hash = (hash ^ buffer[i]) * 16777619u;
+      }
+    return hash;
+  }
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_INDEX_TABLE_H */
@@ -19,6 +19,8 @@
  */
 
 #include "ns3/lora-interference-helper.h"
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include <limits>
@@ -249,6 +251,7 @@ uint8_t
 LoraInterferenceHelper::IsDestroyedByInterference (Ptr<LoraInterferenceHelper::Event> event)
 {
   NS_LOG_FUNCTION (this << event);
+  LORAWAN_PROFILE (INTERFERENCE);
 
   NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_events.size ());
 
@@ -319,19 +322,42 @@ LoraInterferenceHelper::IsDestroyedByInterference (Ptr<LoraInterferenceHelper::E
       it++;
     }
 
+  double signalPowerW = pow (10, rxPowerDbm / 10) / 1000;
+  double signalEnergy = duration.GetSeconds () * signalPowerW;
+  NS_LOG_DEBUG ("Signal power in W: " << signalPowerW);
+  NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
+
+  uint8_t destroyedBy = IsDestroyedByInterference (sf, signalEnergy,
+                                                   cumulativeInterferenceEnergy);
+
+  if (LoraFlightRecorder::IsEnabled ())
+    {
+      // The helper does not know its node: receptions run in the context of
+      // the receiving node
+      double sinrDb[6];
+      for (unsigned i = 0; i < 6; i++)
+        {
+          sinrDb[i] = 10 * log10 (signalEnergy / cumulativeInterferenceEnergy[i]);
+        }
+      LoraFlightRecorder::RecordInterferenceVerdict (Simulator::GetContext (), sf, frequency,
+                                                     rxPowerDbm, destroyedBy, sinrDb);
+    }
+
+  return destroyedBy;
+}
+
+uint8_t
+LoraInterferenceHelper::IsDestroyedByInterference (uint8_t sf, double signalEnergy,
+                                                   const std::vector<double> &cumulativeInterferenceEnergy) const
+{
+  NS_LOG_FUNCTION (this << unsigned (sf) << signalEnergy);
+
   // For each SF, check if there was destructive interference
   for (uint8_t currentSf = uint8_t (7); currentSf <= uint8_t (12); currentSf++)
     {
       NS_LOG_DEBUG ("Cumulative Interference Energy: "
                     << cumulativeInterferenceEnergy.at (unsigned(currentSf) - 7));
 
-      // Use the computed cumulativeInterferenceEnergy to determine whether the
-      // interference with this SF destroys the packet
-      double signalPowerW = pow (10, rxPowerDbm / 10) / 1000;
-      double signalEnergy = duration.GetSeconds () * signalPowerW;
-      NS_LOG_DEBUG ("Signal power in W: " << signalPowerW);
-      NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
-
       // Check whether the packet survives the interference of this SF
       double snirIsolation = m_collisionSnir[unsigned(sf) - 7][unsigned(currentSf) - 7];
       NS_LOG_DEBUG ("The needed isolation to survive is " << snirIsolation << " dB");
@@ -175,6 +175,20 @@ public:
    */
   uint8_t IsDestroyedByInterference (Ptr<LoraInterferenceHelper::Event> event);
 
+  /**
+   * Apply the SNIR tables to a signal, given the energy of the interference
+   * it received from each SF.
+   *
+   * \param sf The spreading factor of the signal.
+   * \param signalEnergy The energy of the signal, in J.
+   * \param cumulativeInterferenceEnergy The energy of the interference of
+   * each SF from 7 to 12, in J.
+   * \return The sf of the packets that caused the loss, or 0 if there was no
+   * loss.
+   */
+  uint8_t IsDestroyedByInterference (uint8_t sf, double signalEnergy,
+                                     const std::vector<double> &cumulativeInterferenceEnergy) const;
+
   /**
    * Compute the time duration in which two given events are overlapping.
    *
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#include "ns3/lora-packet-pool.h"
+#include "ns3/log.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraPacketPool");
+
+static bool g_enabled = false;
+static uint32_t g_capacity = 0;
+static std::vector<Ptr<Packet> > g_packets; //!< The packets of the pool
+static uint32_t g_next = 0; //!< Where to start looking for a free packet
+
+static uint64_t g_created = 0;
+static uint64_t g_recycled = 0;
+
+void
+LoraPacketPool::Enable (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (capacity);
+  NS_ASSERT (capacity > 0);
+
+  g_capacity = capacity;
+  if (g_packets.size () > g_capacity)
+    {
+      g_packets.resize (g_capacity);
+    }
+  g_enabled = true;
+}
+
+void
+LoraPacketPool::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  g_enabled = false;
+  g_packets.clear ();
+  g_next = 0;
+}
+
+bool
+LoraPacketPool::IsEnabled (void)
+{
+  return g_enabled;
+}
+
+Ptr<Packet>
+LoraPacketPool::Allocate (uint32_t size)
+{
+  NS_LOG_FUNCTION (size);
+
+  if (g_enabled)
+    {
+      // Start after the last packet that was handed out, which is the one
+      // most likely to be still in flight
+      uint32_t nPackets = g_packets.size ();
+      for (uint32_t i = 0; i < nPackets; i++)
+        {
+          uint32_t k = (g_next + i) % nPackets;
+          const Ptr<Packet> &packet = g_packets[k];
+          // The pool holds the only reference
+          if (packet->GetReferenceCount () == 1)
+            {
+              packet->RemoveAllPacketTags ();
+              packet->RemoveAllByteTags ();
+              packet->RemoveAtStart (packet->GetSize ());
+              packet->AddPaddingAtEnd (size);
+              g_next = k + 1;
+              g_recycled++;
+              NS_LOG_DEBUG ("Recycled packet " << k << " of the pool");
+              return packet;
+            }
+        }
+    }
+
+  Ptr<Packet> packet = Create<Packet> (size);
+  g_created++;
+  if (g_enabled && g_packets.size () < g_capacity)
+    {
+      g_packets.push_back (packet);
+    }
+  return packet;
+}
+
+uint64_t
+LoraPacketPool::GetCreatedCount (void)
+{
+  return g_created;
+}
+
+uint64_t
+LoraPacketPool::GetRecycledCount (void)
+{
+  return g_recycled;
+}
+
+void
+LoraPacketPool::ResetCounters (void)
+{
+  g_created = 0;
+  g_recycled = 0;
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#ifndef LORA_PACKET_POOL_H
+#define LORA_PACKET_POOL_H
+
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include <cstdint>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A pool of the packets the applications hand to the MAC layer.
+ *
+ * When the pool is enabled, Allocate returns a packet of the pool that
+ * nobody else references anymore, after emptying it and resizing it, instead
+ * of allocating a new one. The buffer of a recycled packet already has room
+ * for the LoRaWAN headers, so that a recycled uplink usually costs no heap
+ * allocation for the packet and its frame bytes.
+ *
+ * A packet is only recycled once every reference to it was dropped: packets
+ * kept by the LoraPacketTracker, or by a MAC waiting for an acknowledgment,
+ * are never reused. As a consequence, the pool is of little use when packet
+ * tracking is enabled. Recycled packets keep their uid, so that uids no
+ * longer identify an uplink when the pool is enabled, which is why the pool
+ * is disabled by default.
+ *
+ * The pool is not protected against concurrent use, since the simulator runs
+ * on a single thread.
+ */
+class LoraPacketPool
+{
+public:
+  /**
+   * Start recycling packets.
+   *
+   * \param capacity The maximum number of packets kept by the pool.
+   */
+  static void Enable (uint32_t capacity = 64);
+
+  /**
+   * Stop recycling packets, and release the ones kept by the pool.
+   */
+  static void Disable (void);
+
+  /**
+   * \return Whether the pool is enabled.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Get an empty packet, without tags, whose payload is made of zeros.
+   *
+   * \param size The size of the payload.
+   * \return A recycled packet, or a new one if the pool is disabled or all
+   * its packets are still in use.
+   */
+  static Ptr<Packet> Allocate (uint32_t size);
+
+  /**
+   * \return The number of packets Allocate created.
+   */
+  static uint64_t GetCreatedCount (void);
+
+  /**
+   * \return The number of packets Allocate recycled.
+   */
+  static uint64_t GetRecycledCount (void);
+
+  /**
+   * Set the counters to zero.
+   */
+  static void ResetCounters (void);
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+
+#endif /* LORA_PACKET_POOL_H */
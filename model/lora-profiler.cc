@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/lora-profiler.h"
+#include <iomanip>
+
+namespace ns3 {
+namespace lorawan {
+
+static const char *g_sectionNames[LoraProfiler::N_SECTIONS] = {
+  "channel-send",
+  "channel-receive",
+  "interference",
+  "capacitor-update",
+  "harvester-update",
+  "packet-tracker",
+  "network-server"
+};
+
+uint64_t LoraProfiler::m_calls[LoraProfiler::N_SECTIONS] = {};
+uint64_t LoraProfiler::m_nanoseconds[LoraProfiler::N_SECTIONS] = {};
+
+// The start of the period covered by PrintReport
+static LoraProfiler::Clock::time_point g_start = LoraProfiler::Clock::now ();
+
+// The counters at the previous snapshot
+static uint64_t g_snapshotCalls[LoraProfiler::N_SECTIONS] = {};
+static uint64_t g_snapshotNanoseconds[LoraProfiler::N_SECTIONS] = {};
+
+bool
+LoraProfiler::IsCompiledIn (void)
+{
+#ifdef LORAWAN_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+LoraProfiler::PrintReport (std::ostream &os)
+{
+  if (!IsCompiledIn ())
+    {
+      os << "Profiling is not compiled in: configure with --enable-lorawan-profiling"
+         << std::endl;
+      return;
+    }
+
+  double wallSeconds = std::chrono::duration<double> (Clock::now () - g_start).count ();
+
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << std::left << std::setw (18) << "Section" << std::right
+     << std::setw (14) << "Calls" << std::setw (14) << "Time [s]"
+     << std::setw (12) << "ns/call" << std::setw (10) << "Share" << std::endl;
+  for (int i = 0; i < N_SECTIONS; i++)
+    {
+      double seconds = m_nanoseconds[i] * 1e-9;
+      os << std::left << std::setw (18) << g_sectionNames[i] << std::right
+         << std::setw (14) << m_calls[i]
+         << std::setw (14) << std::fixed << std::setprecision (3) << seconds
+         << std::setw (12) << std::setprecision (0)
+         << (m_calls[i] > 0 ? double (m_nanoseconds[i]) / m_calls[i] : 0)
+         << std::setw (9) << std::setprecision (1)
+         << (wallSeconds > 0 ? 100 * seconds / wallSeconds : 0) << "%" << std::endl;
+    }
+  os << "Wall time: " << std::setprecision (3) << wallSeconds << " s" << std::endl;
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+LoraProfiler::PrintSnapshot (std::ostream &os)
+{
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Profile since last snapshot:" << std::fixed << std::setprecision (3);
+  for (int i = 0; i < N_SECTIONS; i++)
+    {
+      os << " " << g_sectionNames[i] << " " << m_calls[i] - g_snapshotCalls[i]
+         << " calls " << (m_nanoseconds[i] - g_snapshotNanoseconds[i]) * 1e-9 << " s";
+      g_snapshotCalls[i] = m_calls[i];
+      g_snapshotNanoseconds[i] = m_nanoseconds[i];
+    }
+  os << std::endl;
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+LoraProfiler::Reset (void)
+{
+  for (int i = 0; i < N_SECTIONS; i++)
+    {
+      m_calls[i] = 0;
+      m_nanoseconds[i] = 0;
+      g_snapshotCalls[i] = 0;
+      g_snapshotNanoseconds[i] = 0;
+    }
+  g_start = Clock::now ();
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
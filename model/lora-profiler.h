@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORA_PROFILER_H
+#define LORA_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Call counters and wall time of the sections of the module where large
+ * simulations spend their time.
+ *
+ * A section is measured by putting LORAWAN_PROFILE (SECTION) at the start of
+ * a function: the macro counts a call and measures the wall time until the
+ * end of the enclosing scope. Times are inclusive, so that a section calling
+ * another one, like a harvester update that updates its capacitor, also
+ * counts the time of the inner section.
+ *
+ * The macro only expands to code in builds configured with
+ * --enable-lorawan-profiling, which defines LORAWAN_PROFILING, and costs
+ * nothing otherwise. The counters are not protected against concurrent
+ * updates, since the simulator runs on a single thread.
+ */
+class LoraProfiler
+{
+public:
+  /**
+   * The sections of the module that are measured.
+   */
+  enum Section
+  {
+    CHANNEL_SEND, //!< LoraChannel::Send
+    CHANNEL_RECEIVE, //!< LoraChannel::Receive
+    INTERFERENCE, //!< LoraInterferenceHelper::IsDestroyedByInterference
+    CAPACITOR_UPDATE, //!< CapacitorEnergySource::UpdateEnergySource
+    HARVESTER_UPDATE, //!< VariableEnergyHarvester::UpdateHarvestedPower
+    PACKET_TRACKER, //!< The callbacks of LoraPacketTracker
+    NETWORK_SERVER, //!< NetworkServer::Receive and ProcessUplink
+    N_SECTIONS
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Measure a section from its construction to its destruction.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope (enum Section section) :
+      m_section (section),
+      m_start (Clock::now ())
+    {
+    }
+
+    ~Scope ()
+    {
+      Add (m_section, std::chrono::duration_cast<std::chrono::nanoseconds>
+             (Clock::now () - m_start).count ());
+    }
+
+  private:
+    enum Section m_section;
+    Clock::time_point m_start;
+  };
+
+  /**
+   * \return Whether the module was built with --enable-lorawan-profiling.
+   */
+  static bool IsCompiledIn (void);
+
+  /**
+   * Account a call to a section.
+   *
+   * \param section The section that was called.
+   * \param nanoseconds The wall time spent in the call.
+   */
+  static void
+  Add (enum Section section, uint64_t nanoseconds)
+  {
+    m_calls[section]++;
+    m_nanoseconds[section] += nanoseconds;
+  }
+
+  /**
+   * Print, for each section, the calls and the time spent since the start
+   * of the program or the last Reset, and the share of the wall time that
+   * elapsed meanwhile.
+   */
+  static void PrintReport (std::ostream &os);
+
+  /**
+   * Print on a single line the calls and the time spent in each section
+   * since the previous snapshot.
+   */
+  static void PrintSnapshot (std::ostream &os);
+
+  /**
+   * Set all counters to zero.
+   */
+  static void Reset (void);
+
+private:
+  static uint64_t m_calls[N_SECTIONS]; //!< The calls to each section
+  static uint64_t m_nanoseconds[N_SECTIONS]; //!< The time spent in each section
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+
+#ifdef LORAWAN_PROFILING
+#define LORAWAN_PROFILE(section)                                        \
+  ns3::lorawan::LoraProfiler::Scope loraProfilerScope (ns3::lorawan::LoraProfiler::section)
+#else
+#define LORAWAN_PROFILE(section)
+#endif
+
+#endif /* LORA_PROFILER_H */
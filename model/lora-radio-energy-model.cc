@@ -28,6 +28,7 @@
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 #include "ns3/pointer.h"
+#include "ns3/uinteger.h"
 #include "ns3/energy-source.h"
 #include "lora-radio-energy-model.h"
 #include "src/core/model/boolean.h"
@@ -100,6 +101,19 @@ LoraRadioEnergyModel::GetTypeId (void)
               "EnterSleepIfDepleted", "Enter in sleep mode if energy is depleted - else turn off",
               BooleanValue (), MakeBooleanAccessor (&LoraRadioEnergyModel::m_enterSleepIfDepleted),
               MakeBooleanChecker ())
+          .AddAttribute ("OffTimeHistogramBinWidth",
+                         "Width of the bins of the histogram of the OFF periods",
+                         TimeValue (Seconds (60)),
+                         MakeTimeAccessor (&LoraRadioEnergyModel::SetOffTimeHistogramBinWidth,
+                                           &LoraRadioEnergyModel::GetOffTimeHistogramBinWidth),
+                         MakeTimeChecker (TimeStep (1)))
+          .AddAttribute ("OffTimeHistogramBins",
+                         "Number of bins of the histogram of the OFF periods, the last one "
+                         "counting all the longer periods",
+                         UintegerValue (60),
+                         MakeUintegerAccessor (&LoraRadioEnergyModel::SetOffTimeHistogramBins,
+                                               &LoraRadioEnergyModel::GetOffTimeHistogramBins),
+                         MakeUintegerChecker<uint32_t> (1))
           .AddTraceSource (
               "TotalEnergyConsumption", "Total energy consumption of the radio device.",
               MakeTraceSourceAccessor (&LoraRadioEnergyModel::m_totalEnergyConsumption),
@@ -115,6 +129,11 @@ LoraRadioEnergyModel::LoraRadioEnergyModel ()
   m_lastUpdateTime = Seconds (0.0);
   m_nPendingChangeState = 0;
   m_isSupersededChangeState = false;
+  for (int state = 0; state <= EndDeviceLoraPhy::IDLE; state++)
+    {
+      m_timeInState[state] = Seconds (0);
+      m_energyInState[state] = 0;
+    }
   m_energyDepletionCallback.Nullify ();
   m_source = NULL;
   // set callback for EndDeviceLoraPhy listener
@@ -343,6 +362,12 @@ LoraRadioEnergyModel::SetTxCurrentModel (Ptr<LoraTxCurrentModel> model)
   m_txCurrentModel = model;
 }
 
+Ptr<LoraTxCurrentModel>
+LoraRadioEnergyModel::GetTxCurrentModel (void) const
+{
+  return m_txCurrentModel;
+}
+
 void
 LoraRadioEnergyModel::SetTxCurrentFromModel (double txPowerDbm)
 {
@@ -367,6 +392,10 @@ LoraRadioEnergyModel::ChangeState (int newState)
   // update total energy consumption
   m_totalEnergyConsumption += energyToDecrease;
 
+  // update the statistics of the state that just ended
+  m_timeInState[m_currentState] += duration;
+  m_energyInState[m_currentState] += energyToDecrease;
+
   NS_LOG_DEBUG("Energy to decrease: " << energyToDecrease << " total energy consumption " << m_totalEnergyConsumption);
 
   // update last update time stamp
@@ -386,6 +415,16 @@ LoraRadioEnergyModel::ChangeState (int newState)
 
   if (!m_isSupersededChangeState)
     {
+      // keep the durations of the OFF periods
+      if (m_currentState != EndDeviceLoraPhy::OFF && newState == EndDeviceLoraPhy::OFF)
+        {
+          m_offStartTime = Simulator::Now ();
+        }
+      else if (m_currentState == EndDeviceLoraPhy::OFF && newState != EndDeviceLoraPhy::OFF)
+        {
+          m_offTimes.Add (Simulator::Now () - m_offStartTime);
+        }
+
       // update current state & last update time stamp
       SetLoraRadioState ((EndDeviceLoraPhy::State) newState);
       NS_LOG_DEBUG("[DEBUG] Set a new state");
@@ -578,6 +617,55 @@ LoraRadioEnergyModel::SetLoraRadioState (const EndDeviceLoraPhy::State state)
                 " at time = " << Simulator::Now ().GetSeconds () << " s");
 }
 
+Time
+LoraRadioEnergyModel::GetTimeInState (EndDeviceLoraPhy::State state) const
+{
+  Time time = m_timeInState[state];
+  if (state == m_currentState)
+    {
+      time += Simulator::Now () - m_lastUpdateTime;
+    }
+  return time;
+}
+
+double
+LoraRadioEnergyModel::GetEnergyInState (EndDeviceLoraPhy::State state) const
+{
+  return m_energyInState[state];
+}
+
+const DurationHistogram &
+LoraRadioEnergyModel::GetOffTimeHistogram (void) const
+{
+  return m_offTimes;
+}
+
+void
+LoraRadioEnergyModel::SetOffTimeHistogramBinWidth (Time binWidth)
+{
+  NS_LOG_FUNCTION (this << binWidth);
+  m_offTimes.SetBins (binWidth, m_offTimes.GetNBins ());
+}
+
+Time
+LoraRadioEnergyModel::GetOffTimeHistogramBinWidth (void) const
+{
+  return m_offTimes.GetBinWidth ();
+}
+
+void
+LoraRadioEnergyModel::SetOffTimeHistogramBins (uint32_t nBins)
+{
+  NS_LOG_FUNCTION (this << nBins);
+  m_offTimes.SetBins (m_offTimes.GetBinWidth (), nBins);
+}
+
+uint32_t
+LoraRadioEnergyModel::GetOffTimeHistogramBins (void) const
+{
+  return m_offTimes.GetNBins ();
+}
+
 double
 LoraRadioEnergyModel::ComputeLoraEnergyConsumption (EndDeviceLoraPhy::State state,
                                                     Time duration)
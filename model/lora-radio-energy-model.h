@@ -22,6 +22,7 @@
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/traced-value.h"
+#include "ns3/duration-histogram.h"
 #include "end-device-lora-phy.h"
 #include "lora-tx-current-model.h"
 
@@ -217,6 +218,30 @@ public:
    */
   EndDeviceLoraPhy::State GetCurrentState (void) const;
 
+  /**
+   * \returns The time the radio spent in a state, the present one included.
+   */
+  Time GetTimeInState (EndDeviceLoraPhy::State state) const;
+
+  /**
+   * \returns The energy the radio consumed in a state [J]. Like
+   * GetTotalEnergyConsumption, the present state is only accounted when the
+   * radio leaves it.
+   */
+  double GetEnergyInState (EndDeviceLoraPhy::State state) const;
+
+  /**
+   * \returns The histogram of the durations of the periods the radio spent
+   * in the OFF state, the present one excluded.
+   */
+  const DurationHistogram &GetOffTimeHistogram (void) const;
+
+  void SetOffTimeHistogramBinWidth (Time binWidth);
+  Time GetOffTimeHistogramBinWidth (void) const;
+
+  void SetOffTimeHistogramBins (uint32_t nBins);
+  uint32_t GetOffTimeHistogramBins (void) const;
+
   /**
    * \param callback Callback function.
    *
@@ -240,6 +265,11 @@ public:
   // NOTICE VERY WELL: Current  Model linear or constant as possible choices
   void SetTxCurrentModel (Ptr<LoraTxCurrentModel> model);
 
+  /**
+   * \returns The model used to compute the lora tx current, if any.
+   */
+  Ptr<LoraTxCurrentModel> GetTxCurrentModel (void) const;
+
   /**
    * \brief Calls the CalcTxCurrent method of the tx current model to
    *        compute the tx current based on such model
@@ -335,6 +365,12 @@ private:
   EndDeviceLoraPhy::State m_currentState;  ///< current state the radio is in
   Time m_lastUpdateTime;          ///< time stamp of previous energy update
 
+  // Online statistics, indexed by EndDeviceLoraPhy::State
+  Time m_timeInState[EndDeviceLoraPhy::IDLE + 1]; ///< time spent in each state
+  double m_energyInState[EndDeviceLoraPhy::IDLE + 1]; ///< energy consumed in each state
+  Time m_offStartTime; ///< when the radio last entered the OFF state
+  DurationHistogram m_offTimes; ///< durations of the OFF periods
+
   uint8_t m_nPendingChangeState; ///< pending state change
   bool m_isSupersededChangeState; ///< superseded change state
 
@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/lora-statistical-phy.h"
+#include "ns3/lora-interference-helper.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-phy.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraStatisticalPhy");
+
+NS_OBJECT_ENSURE_REGISTERED (LoraStatisticalPhy);
+
+TypeId
+LoraStatisticalPhy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraStatisticalPhy")
+    .SetParent<Object> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraStatisticalPhy> ()
+    .AddAttribute ("TrafficModel",
+                   "The process generating the packets of each device",
+                   EnumValue (LoraStatisticalPhy::PERIODIC),
+                   MakeEnumAccessor (&LoraStatisticalPhy::m_trafficModel),
+                   MakeEnumChecker (LoraStatisticalPhy::PERIODIC, "Periodic",
+                                    LoraStatisticalPhy::POISSON, "Poisson"))
+    .AddAttribute ("Period",
+                   "The (mean) interval between two packets of a device",
+                   TimeValue (Seconds (600)),
+                   MakeTimeAccessor (&LoraStatisticalPhy::m_period),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketSize",
+                   "The size of the application payload of the packets",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&LoraStatisticalPhy::m_packetSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BandwidthHz",
+                   "The bandwidth used by the devices",
+                   DoubleValue (125000),
+                   MakeDoubleAccessor (&LoraStatisticalPhy::m_bandwidthHz),
+                   MakeDoubleChecker<double> (0));
+  return tid;
+}
+
+LoraStatisticalPhy::LoraStatisticalPhy ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_uniform = CreateObject<UniformRandomVariable> ();
+  m_exponential = CreateObject<ExponentialRandomVariable> ();
+}
+
+LoraStatisticalPhy::~LoraStatisticalPhy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LoraStatisticalPhy::AddChannel (double frequencyMHz)
+{
+  NS_LOG_FUNCTION (this << frequencyMHz);
+
+  m_channels.push_back (frequencyMHz);
+}
+
+void
+LoraStatisticalPhy::AddReceptionPath (double frequencyMHz)
+{
+  NS_LOG_FUNCTION (this << frequencyMHz);
+
+  m_receptionPaths.push_back (frequencyMHz);
+}
+
+void
+LoraStatisticalPhy::AddTransmitter (uint8_t sf, double rxPowerDbm)
+{
+  NS_LOG_FUNCTION (this << unsigned (sf) << rxPowerDbm);
+  NS_ASSERT (sf >= 7 && sf <= 12);
+
+  Transmitter transmitter;
+  transmitter.sf = sf;
+  transmitter.rxPowerDbm = rxPowerDbm;
+  m_transmitters.push_back (transmitter);
+}
+
+void
+LoraStatisticalPhy::ClearTransmitters (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_transmitters.clear ();
+}
+
+int64_t
+LoraStatisticalPhy::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+
+  m_uniform->SetStream (stream);
+  m_exponential->SetStream (stream + 1);
+  return 2;
+}
+
+Time
+LoraStatisticalPhy::GetOnAirTime (uint8_t sf) const
+{
+  // Use the same headers and transmission parameters as
+  // ClassAEndDeviceLorawanMac
+  LorawanMacHeader macHdr;
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  Ptr<Packet> packet = Create<Packet> (m_packetSize + macHdr.GetSerializedSize ()
+                                       + frameHdr.GetSerializedSize ());
+
+  LoraTxParameters params;
+  params.sf = sf;
+  params.headerDisabled = 1;
+  params.codingRate = 1;
+  params.bandwidthHz = m_bandwidthHz;
+  params.nPreamble = 8;
+  params.crcEnabled = 1;
+  params.lowDataRateOptimizationEnabled = 0;
+
+  return LoraPhy::GetOnAirTime (packet, params);
+}
+
+Time
+LoraStatisticalPhy::GetNextInterval (void)
+{
+  if (m_trafficModel == PERIODIC)
+    {
+      return m_period;
+    }
+  return Seconds (m_exponential->GetValue (m_period.GetSeconds (), 0));
+}
+
+std::vector<int>
+LoraStatisticalPhy::Run (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+  NS_ABORT_MSG_IF (m_channels.empty (), "No channel was added");
+  NS_ABORT_MSG_IF (m_period.IsZero (), "The period must be positive");
+
+  // Same order as LoraPacketTracker::CountPhyPacketsPerGw
+  std::vector<int> packetCounts (6, 0);
+
+  std::vector<int64_t> onAirTime (6);
+  for (uint8_t sf = 7; sf <= 12; sf++)
+    {
+      onAirTime[sf - 7] = GetOnAirTime (sf).GetTimeStep ();
+    }
+  int64_t maxOnAirTime = *std::max_element (onAirTime.begin (), onAirTime.end ());
+
+  ///////////////////////
+  // Draw the arrivals //
+  ///////////////////////
+
+  std::vector<Arrival> arrivals;
+  int64_t end = duration.GetTimeStep ();
+  for (uint32_t i = 0; i < m_transmitters.size (); i++)
+    {
+      Time first = m_trafficModel == PERIODIC ?
+        Seconds (m_uniform->GetValue (0, m_period.GetSeconds ())) : GetNextInterval ();
+      for (int64_t t = first.GetTimeStep (); t < end; t += GetNextInterval ().GetTimeStep ())
+        {
+          Arrival arrival;
+          arrival.start = t;
+          arrival.end = t + onAirTime[m_transmitters[i].sf - 7];
+          arrival.transmitter = i;
+          arrival.channel = m_uniform->GetInteger (0, m_channels.size () - 1);
+          arrivals.push_back (arrival);
+        }
+    }
+
+  std::sort (arrivals.begin (), arrivals.end (),
+             [] (const Arrival &a, const Arrival &b)
+             {
+               return a.start < b.start
+               || (a.start == b.start && a.transmitter < b.transmitter);
+             });
+
+  NS_LOG_DEBUG ("Drew " << arrivals.size () << " packets");
+
+  ////////////////////////////
+  // Lock reception paths   //
+  ////////////////////////////
+
+  // Follow SimpleGatewayLoraPhy::StartReceive: every packet interferes, but
+  // only those finding a free reception path on their channel and above the
+  // sensitivity are demodulated. Keep, for each channel, its packets in
+  // order of arrival.
+  std::vector<int64_t> pathFreeAt (m_receptionPaths.size (), 0);
+  std::vector<std::vector<uint32_t> > channelArrivals (m_channels.size ());
+  std::vector<bool> locked (arrivals.size (), false);
+  for (uint32_t i = 0; i < arrivals.size (); i++)
+    {
+      const Arrival &arrival = arrivals[i];
+      const Transmitter &transmitter = m_transmitters[arrival.transmitter];
+      channelArrivals[arrival.channel].push_back (i);
+      packetCounts.at (0)++;
+
+      uint32_t path = 0;
+      while (path < m_receptionPaths.size ()
+             && (m_receptionPaths[path] != m_channels[arrival.channel]
+                 || pathFreeAt[path] > arrival.start))
+        {
+          path++;
+        }
+
+      if (path == m_receptionPaths.size ())
+        {
+          packetCounts.at (3)++;
+        }
+      else if (transmitter.rxPowerDbm < GatewayLoraPhy::sensitivity[transmitter.sf - 7])
+        {
+          packetCounts.at (4)++;
+        }
+      else
+        {
+          pathFreeAt[path] = arrival.end;
+          locked[i] = true;
+        }
+    }
+
+  ///////////////////////////
+  // Evaluate interference //
+  ///////////////////////////
+
+  // The helper picks up the collision matrix that is currently set
+  LoraInterferenceHelper interference;
+
+  std::vector<double> powerW (m_transmitters.size ());
+  for (uint32_t i = 0; i < m_transmitters.size (); i++)
+    {
+      powerW[i] = pow (10, m_transmitters[i].rxPowerDbm / 10) / 1000;
+    }
+
+  for (uint32_t c = 0; c < channelArrivals.size (); c++)
+    {
+      const std::vector<uint32_t> &channel = channelArrivals[c];
+      for (uint32_t k = 0; k < channel.size (); k++)
+        {
+          if (!locked[channel[k]])
+            {
+              continue;
+            }
+          const Arrival &arrival = arrivals[channel[k]];
+
+          // Energy for interferers of various SFs: only the packets starting
+          // less than the longest time on air before this one can overlap it
+          std::vector<double> cumulativeInterferenceEnergy (6, 0);
+          for (uint32_t j = k; j-- > 0 && arrivals[channel[j]].start + maxOnAirTime > arrival.start;)
+            {
+              const Arrival &interferer = arrivals[channel[j]];
+              int64_t overlap = std::min (arrival.end, interferer.end) - arrival.start;
+              if (overlap > 0)
+                {
+                  cumulativeInterferenceEnergy.at (m_transmitters[interferer.transmitter].sf - 7) +=
+                    TimeStep (overlap).GetSeconds () * powerW[interferer.transmitter];
+                }
+            }
+          for (uint32_t j = k + 1; j < channel.size () && arrivals[channel[j]].start < arrival.end; j++)
+            {
+              const Arrival &interferer = arrivals[channel[j]];
+              int64_t overlap = std::min (arrival.end, interferer.end) - interferer.start;
+              cumulativeInterferenceEnergy.at (m_transmitters[interferer.transmitter].sf - 7) +=
+                TimeStep (overlap).GetSeconds () * powerW[interferer.transmitter];
+            }
+
+          uint8_t sf = m_transmitters[arrival.transmitter].sf;
+          double signalEnergy = TimeStep (arrival.end - arrival.start).GetSeconds ()
+            * powerW[arrival.transmitter];
+          if (interference.IsDestroyedByInterference (sf, signalEnergy,
+                                                      cumulativeInterferenceEnergy))
+            {
+              packetCounts.at (2)++;
+            }
+          else
+            {
+              packetCounts.at (1)++;
+            }
+        }
+    }
+
+  NS_LOG_DEBUG ("Sent " << packetCounts.at (0) << ", received " << packetCounts.at (1));
+
+  return packetCounts;
+}
+
+} /* namespace lorawan */
+} /* namespace ns3 */
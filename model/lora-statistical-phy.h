@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORA_STATISTICAL_PHY_H
+#define LORA_STATISTICAL_PHY_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A fast evaluation of the uplink capacity of a single gateway.
+ *
+ * This class replaces the whole PHY stack for uplink-only, unconfirmed
+ * traffic: instead of scheduling the transmissions of each device in the
+ * simulator, it draws all the arrivals at the gateway up front (periodic,
+ * with a random offset like PeriodicSenderHelper, or Poisson), sorts them
+ * once, and sweeps them in order, applying the same rules as
+ * SimpleGatewayLoraPhy: a free reception path on the channel of the packet,
+ * the sensitivity of the gateway and the SNIR tables of
+ * LoraInterferenceHelper, whose collision matrix is the one currently set.
+ *
+ * Since the outcome of a packet only depends on the packets that overlap it
+ * on the same channel, each packet is compared with its neighbours in the
+ * sorted arrivals of its channel, and the cost of Run grows with the number
+ * of packets and not with the square of the number of devices.
+ *
+ * Duty cycle limitations, downlinks and retransmissions are not modelled:
+ * results are only comparable to those of a full simulation for traffic
+ * that never waits for the duty cycle.
+ */
+class LoraStatisticalPhy : public Object
+{
+public:
+  /**
+   * The process generating the packets of each device.
+   */
+  enum TrafficModel
+  {
+    PERIODIC, //!< A packet every Period, after a random initial offset
+    POISSON   //!< Exponential inter-arrival times, of mean Period
+  };
+
+  static TypeId GetTypeId (void);
+
+  LoraStatisticalPhy ();
+  virtual ~LoraStatisticalPhy ();
+
+  /**
+   * Add a channel the devices can use: each packet is sent on one of the
+   * channels, chosen at random.
+   *
+   * \param frequencyMHz The frequency of the channel.
+   */
+  void AddChannel (double frequencyMHz);
+
+  /**
+   * Add a reception path to the gateway.
+   *
+   * \param frequencyMHz The frequency the reception path listens on.
+   */
+  void AddReceptionPath (double frequencyMHz);
+
+  /**
+   * Add a device.
+   *
+   * \param sf The spreading factor the device uses.
+   * \param rxPowerDbm The power at which the gateway receives the device.
+   */
+  void AddTransmitter (uint8_t sf, double rxPowerDbm);
+
+  /**
+   * Remove all the devices.
+   */
+  void ClearTransmitters (void);
+
+  /**
+   * Draw the packets sent by the devices in the given time and evaluate
+   * their outcome at the gateway.
+   *
+   * \param duration The time in which the devices send their packets.
+   * \return The number of packets that were sent, received, interfered,
+   * lost because no reception path was available, lost because under
+   * sensitivity and lost because the gateway was transmitting, in the same
+   * order as LoraPacketTracker::CountPhyPacketsPerGw.
+   */
+  std::vector<int> Run (Time duration);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream The first stream index to use.
+   * \return The number of stream indices assigned by this model.
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  /**
+   * A device, as seen by the gateway.
+   */
+  struct Transmitter
+  {
+    uint8_t sf;
+    double rxPowerDbm;
+  };
+
+  /**
+   * A packet arriving at the gateway, in time steps.
+   */
+  struct Arrival
+  {
+    int64_t start;
+    int64_t end;
+    uint32_t transmitter;
+    uint32_t channel;
+  };
+
+  /**
+   * Compute the time on air of the packets sent with the given SF, headers
+   * included.
+   */
+  Time GetOnAirTime (uint8_t sf) const;
+
+  /**
+   * Draw the time before the next packet of a device.
+   */
+  Time GetNextInterval (void);
+
+  std::vector<double> m_channels; //!< The frequencies of the channels [MHz]
+  std::vector<double> m_receptionPaths; //!< The frequencies of the reception paths [MHz]
+  std::vector<Transmitter> m_transmitters; //!< The devices
+
+  enum TrafficModel m_trafficModel; //!< The process generating the packets
+  Time m_period; //!< The (mean) interval between two packets of a device
+  uint32_t m_packetSize; //!< The size of the application payload [bytes]
+  double m_bandwidthHz; //!< The bandwidth used by the devices
+
+  Ptr<UniformRandomVariable> m_uniform; //!< Initial offsets and channels
+  Ptr<ExponentialRandomVariable> m_exponential; //!< Poisson inter-arrivals
+};
+
+} /* namespace lorawan */
+} /* namespace ns3 */
+#endif /* LORA_STATISTICAL_PHY_H */
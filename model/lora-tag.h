@@ -29,6 +29,12 @@ namespace lorawan {
 /**
  * Tag used to save various data about a packet, like its Spreading Factor and
  * data about interference.
+ *
+ * Layers updating a field should read the tag with PeekPacketTag and write it
+ * back with ReplacePacketTag, which overwrites the tag in place unless it is
+ * shared with a copy of the packet, rather than removing and adding it again.
+ * ReplacePacketTag does nothing on a packet without the tag, which must then
+ * be added with AddPacketTag.
  */
 class LoraTag : public Tag
 {
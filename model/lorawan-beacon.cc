@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/lorawan-beacon.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LorawanBeacon");
+
+NS_OBJECT_ENSURE_REGISTERED (LorawanBeacon);
+
+TypeId
+LorawanBeacon::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LorawanBeacon")
+    .SetParent<Object> ()
+    .AddConstructor<LorawanBeacon> ()
+    .AddAttribute ("BeaconPeriod",
+                   "The interval between two beacons",
+                   TimeValue (Seconds (128)),
+                   MakeTimeAccessor (&LorawanBeacon::m_beaconPeriod),
+                   MakeTimeChecker (Seconds (1)))
+    .AddAttribute ("BeaconReserved",
+                   "The time reserved to the beacon at the start of a period",
+                   TimeValue (MilliSeconds (2120)),
+                   MakeTimeAccessor (&LorawanBeacon::m_beaconReserved),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("BeaconGuard",
+                   "The time at the end of a period in which no ping slot "
+                   "can start",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&LorawanBeacon::m_beaconGuard),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("PingSlotDuration",
+                   "The duration of a ping slot",
+                   TimeValue (MilliSeconds (30)),
+                   MakeTimeAccessor (&LorawanBeacon::m_pingSlotDuration),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddTraceSource ("BeaconSent",
+                     "Trace source fired at the start of each beacon period",
+                     MakeTraceSourceAccessor (&LorawanBeacon::m_beaconSent),
+                     "ns3::LorawanBeacon::BeaconSentCallback")
+    .SetGroupName ("lorawan");
+  return tid;
+}
+
+LorawanBeacon::LorawanBeacon ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LorawanBeacon::~LorawanBeacon ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LorawanBeacon::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_beaconEvent.IsRunning ())
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  uint32_t index = GetBeaconIndex (now);
+  if (GetBeaconTime (index) < now)
+    {
+      index++;
+    }
+  m_beaconEvent = Simulator::Schedule (GetBeaconTime (index) - now,
+                                       &LorawanBeacon::SendBeacon, this);
+}
+
+uint32_t
+LorawanBeacon::GetBeaconIndex (Time time) const
+{
+  return time.GetTimeStep () / m_beaconPeriod.GetTimeStep ();
+}
+
+Time
+LorawanBeacon::GetBeaconTime (uint32_t beaconIndex) const
+{
+  return TimeStep (beaconIndex * m_beaconPeriod.GetTimeStep ());
+}
+
+uint32_t
+LorawanBeacon::GetNPingSlots (void) const
+{
+  return (m_beaconPeriod - m_beaconReserved - m_beaconGuard).GetTimeStep ()
+         / m_pingSlotDuration.GetTimeStep ();
+}
+
+Time
+LorawanBeacon::GetPingSlotDuration (void) const
+{
+  return m_pingSlotDuration;
+}
+
+Time
+LorawanBeacon::GetPingSlotStart (uint32_t beaconIndex, uint32_t slot) const
+{
+  return GetBeaconTime (beaconIndex) + m_beaconReserved
+         + TimeStep (slot * m_pingSlotDuration.GetTimeStep ());
+}
+
+uint32_t
+LorawanBeacon::GetPingOffset (uint32_t beaconIndex, LoraDeviceAddress address,
+                              uint32_t pingPeriod)
+{
+  uint32_t x = beaconIndex * 0x9e3779b9u ^ address.Get ();
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  return x % pingPeriod;
+}
+
+void
+LorawanBeacon::SendBeacon (void)
+{
+  uint32_t index = GetBeaconIndex (Simulator::Now ());
+
+  NS_LOG_FUNCTION (this << index);
+
+  m_beaconSent (index);
+  m_beaconEvent = Simulator::Schedule (m_beaconPeriod, &LorawanBeacon::SendBeacon, this);
+}
+
+void
+LorawanBeacon::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_beaconEvent.Cancel ();
+  Object::DoDispose ();
+}
+
+} // namespace lorawan
+} // namespace ns3
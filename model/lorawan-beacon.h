@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef LORAWAN_BEACON_H
+#define LORAWAN_BEACON_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include "ns3/lora-device-address.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The beacon timing shared by the Class B devices of a network.
+ *
+ * The gateways of a LoRaWAN network broadcast a beacon at the start of each
+ * beacon period, and Class B devices derive the times of their ping slots
+ * from it. This class models the beacon of the whole network with a single
+ * simulator event per period, which fires the BeaconSent trace: the beacon
+ * is not transmitted over the channel, and all the devices using this
+ * object are assumed to be synchronized to it. Devices compute their ping
+ * slots from the beacon times when they need them, so that they do not
+ * need any event of their own at each beacon.
+ *
+ * Beacon periods start at multiples of BeaconPeriod. Each period starts
+ * with BeaconReserved, during which the beacon is sent, and ends with
+ * BeaconGuard, during which no ping slot can start. The time in between is
+ * divided in ping slots of PingSlotDuration.
+ */
+class LorawanBeacon : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LorawanBeacon ();
+  virtual ~LorawanBeacon ();
+
+  /**
+   * Start broadcasting the beacon, from the next beacon period on.
+   */
+  void Start (void);
+
+  /**
+   * \return The index of the beacon period containing the given time.
+   */
+  uint32_t GetBeaconIndex (Time time) const;
+
+  /**
+   * \return The time at which the beacon period with the given index starts.
+   */
+  Time GetBeaconTime (uint32_t beaconIndex) const;
+
+  /**
+   * \return The number of ping slots in a beacon period.
+   */
+  uint32_t GetNPingSlots (void) const;
+
+  /**
+   * \return The duration of a ping slot.
+   */
+  Time GetPingSlotDuration (void) const;
+
+  /**
+   * \return The time at which the ping slot with the given number of a
+   * beacon period starts.
+   */
+  Time GetPingSlotStart (uint32_t beaconIndex, uint32_t slot) const;
+
+  /**
+   * Compute the pseudo-random offset of the first ping slot of a device in
+   * a beacon period.
+   *
+   * The LoRaWAN specification derives this offset by encrypting the beacon
+   * time and the device address with AES: here, they are mixed by a hash
+   * function, which gives the same spreading of the devices over the slots.
+   *
+   * \param beaconIndex The beacon period.
+   * \param address The address of the device.
+   * \param pingPeriod The number of slots between two ping slots of the
+   * device.
+   * \return The offset, between 0 and pingPeriod - 1.
+   */
+  static uint32_t GetPingOffset (uint32_t beaconIndex, LoraDeviceAddress address,
+                                 uint32_t pingPeriod);
+
+  /**
+   * TracedCallback signature for beacon broadcasts.
+   *
+   * \param beaconIndex The index of the beacon period that starts.
+   */
+  typedef void (* BeaconSentCallback)(uint32_t beaconIndex);
+
+private:
+  void DoDispose (void);
+
+  /**
+   * Broadcast the beacon of the current period, and schedule the next one.
+   */
+  void SendBeacon (void);
+
+  Time m_beaconPeriod; //!< The interval between two beacons
+  Time m_beaconReserved; //!< The time reserved to the beacon at the start of a period
+  Time m_beaconGuard; //!< The time without ping slots at the end of a period
+  Time m_pingSlotDuration; //!< The duration of a ping slot
+
+  EventId m_beaconEvent; //!< The event of the next beacon
+
+  TracedCallback<uint32_t> m_beaconSent; //!< Fired at each beacon
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORAWAN_BEACON_H */
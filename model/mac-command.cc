@@ -1069,7 +1069,7 @@ RxTimingSetupAns::RxTimingSetupAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = RX_TIMING_SETUP_ANS;
   m_serializedSize = 1;
 }
 
@@ -1109,7 +1109,7 @@ DlChannelAns::DlChannelAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = DL_CHANNEL_ANS;
   m_serializedSize = 1;
 }
 
@@ -1149,7 +1149,7 @@ TxParamSetupReq::TxParamSetupReq ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = TX_PARAM_SETUP_REQ;
   m_serializedSize = 1;
 }
 
@@ -1189,7 +1189,7 @@ TxParamSetupAns::TxParamSetupAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = TX_PARAM_SETUP_ANS;
   m_serializedSize = 1;
 }
 
@@ -1221,5 +1221,211 @@ TxParamSetupAns::Print (std::ostream &os) const
   os << "TxParamSetupAns" << std::endl;
 }
 
+/////////////////////
+// MacCommandValue //
+/////////////////////
+
+MacCommandValue::MacCommandValue () :
+  m_commandType (INVALID)
+{
+}
+
+MacCommandValue::MacCommandValue (Ptr<const MacCommand> command)
+{
+  NS_ASSERT (command != 0);
+
+  uint8_t size = command->GetSerializedSize ();
+  NS_ASSERT (size >= 1 && size <= MAX_PAYLOAD_SIZE + 1);
+
+  // Let the command encode itself, and keep the bytes after the CID
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator it = buffer.Begin ();
+  command->Serialize (it);
+  it = buffer.Begin ();
+  it.ReadU8 ();
+  for (uint8_t i = 0; i < size - 1; i++)
+    {
+      m_payload[i] = it.ReadU8 ();
+    }
+  m_commandType = command->GetCommandType ();
+}
+
+enum MacCommandType
+MacCommandValue::GetCommandType (void) const
+{
+  return MacCommandType (m_commandType);
+}
+
+uint8_t
+MacCommandValue::GetSerializedSize (void) const
+{
+  return GetSerializedSize (MacCommandType (m_commandType));
+}
+
+const uint8_t *
+MacCommandValue::GetPayload (void) const
+{
+  return m_payload;
+}
+
+uint8_t
+MacCommandValue::GetSerializedSize (enum MacCommandType commandType)
+{
+  switch (commandType)
+    {
+    case (LINK_CHECK_REQ):
+    case (DUTY_CYCLE_ANS):
+    case (DEV_STATUS_REQ):
+    case (RX_TIMING_SETUP_ANS):
+    case (TX_PARAM_SETUP_REQ):
+    case (TX_PARAM_SETUP_ANS):
+    case (DL_CHANNEL_ANS):
+      {
+        return 1;
+      }
+    case (LINK_ADR_ANS):
+    case (DUTY_CYCLE_REQ):
+    case (RX_PARAM_SETUP_ANS):
+    case (NEW_CHANNEL_ANS):
+    case (RX_TIMING_SETUP_REQ):
+      {
+        return 2;
+      }
+    case (LINK_CHECK_ANS):
+    case (DEV_STATUS_ANS):
+      {
+        return 3;
+      }
+    case (LINK_ADR_REQ):
+    case (RX_PARAM_SETUP_REQ):
+      {
+        return 5;
+      }
+    case (NEW_CHANNEL_REQ):
+      {
+        return 6;
+      }
+    case (INVALID):
+    case (DL_CHANNEL_REQ):
+      {
+        return 0;
+      }
+    }
+  return 0;
+}
+
+void
+MacCommandValue::Serialize (Buffer::Iterator &start) const
+{
+  NS_ASSERT (m_commandType != INVALID);
+
+  start.WriteU8 (MacCommand::GetCIDFromMacCommand (MacCommandType (m_commandType)));
+  start.Write (m_payload, GetSerializedSize () - 1);
+}
+
+uint8_t
+MacCommandValue::Deserialize (Buffer::Iterator &start, bool isUplink)
+{
+  uint8_t cid = start.PeekU8 ();
+
+  // Uplink and downlink commands share the same CIDs
+  static const enum MacCommandType uplinkTypes[] = {
+    INVALID, INVALID, LINK_CHECK_REQ, LINK_ADR_ANS, DUTY_CYCLE_ANS, RX_PARAM_SETUP_ANS,
+    DEV_STATUS_ANS, NEW_CHANNEL_ANS, RX_TIMING_SETUP_ANS, TX_PARAM_SETUP_ANS, DL_CHANNEL_ANS};
+  static const enum MacCommandType downlinkTypes[] = {
+    INVALID, INVALID, LINK_CHECK_ANS, LINK_ADR_REQ, DUTY_CYCLE_REQ, RX_PARAM_SETUP_REQ,
+    DEV_STATUS_REQ, NEW_CHANNEL_REQ, RX_TIMING_SETUP_REQ, TX_PARAM_SETUP_REQ, INVALID};
+
+  enum MacCommandType commandType = INVALID;
+  if (cid <= 0x0A)
+    {
+      commandType = isUplink ? uplinkTypes[cid] : downlinkTypes[cid];
+    }
+  uint8_t size = GetSerializedSize (commandType);
+  if (size == 0)
+    {
+      return 0;
+    }
+
+  m_commandType = commandType;
+  start.ReadU8 ();
+  start.Read (m_payload, size - 1);
+  return size;
+}
+
+Ptr<MacCommand>
+MacCommandValue::CreateCommand (void) const
+{
+  Ptr<MacCommand> command;
+  switch (MacCommandType (m_commandType))
+    {
+    case (LINK_CHECK_REQ):
+      command = Create<LinkCheckReq> ();
+      break;
+    case (LINK_CHECK_ANS):
+      command = Create<LinkCheckAns> ();
+      break;
+    case (LINK_ADR_REQ):
+      command = Create<LinkAdrReq> ();
+      break;
+    case (LINK_ADR_ANS):
+      command = Create<LinkAdrAns> ();
+      break;
+    case (DUTY_CYCLE_REQ):
+      command = Create<DutyCycleReq> ();
+      break;
+    case (DUTY_CYCLE_ANS):
+      command = Create<DutyCycleAns> ();
+      break;
+    case (RX_PARAM_SETUP_REQ):
+      command = Create<RxParamSetupReq> ();
+      break;
+    case (RX_PARAM_SETUP_ANS):
+      command = Create<RxParamSetupAns> ();
+      break;
+    case (DEV_STATUS_REQ):
+      command = Create<DevStatusReq> ();
+      break;
+    case (DEV_STATUS_ANS):
+      command = Create<DevStatusAns> ();
+      break;
+    case (NEW_CHANNEL_REQ):
+      command = Create<NewChannelReq> ();
+      break;
+    case (NEW_CHANNEL_ANS):
+      command = Create<NewChannelAns> ();
+      break;
+    case (RX_TIMING_SETUP_REQ):
+      command = Create<RxTimingSetupReq> ();
+      break;
+    case (RX_TIMING_SETUP_ANS):
+      command = Create<RxTimingSetupAns> ();
+      break;
+    case (TX_PARAM_SETUP_REQ):
+      command = Create<TxParamSetupReq> ();
+      break;
+    case (TX_PARAM_SETUP_ANS):
+      command = Create<TxParamSetupAns> ();
+      break;
+    case (DL_CHANNEL_ANS):
+      command = Create<DlChannelAns> ();
+      break;
+    case (INVALID):
+    case (DL_CHANNEL_REQ):
+      return 0;
+    }
+
+  // Let the command decode its fields from the bytes
+  uint8_t size = GetSerializedSize ();
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator it = buffer.Begin ();
+  Serialize (it);
+  it = buffer.Begin ();
+  command->Deserialize (it);
+  return command;
+}
+
 }
 }
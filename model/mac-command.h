@@ -609,6 +609,78 @@ public:
 
 private:
 };
+
+/**
+ * Value representation of a LoRaWAN MAC command.
+ *
+ * This is a tagged union: the tag is the command type, and the payload is
+ * kept in the same encoding used on the air, so that a command can be copied
+ * into or out of a LoraFrameHeader without allocating any object. The
+ * MacCommand classes above can be obtained from a value, and converted to a
+ * value, when the typed fields of the command are needed.
+ */
+class MacCommandValue
+{
+public:
+  /**
+   * The size of the largest payload (i.e., NewChannelReq), CID excluded.
+   */
+  static const uint8_t MAX_PAYLOAD_SIZE = 5;
+
+  MacCommandValue ();
+
+  /**
+   * Build the value of an existing command.
+   */
+  explicit MacCommandValue (Ptr<const MacCommand> command);
+
+  /**
+   * \return The type of this command, INVALID if not set.
+   */
+  enum MacCommandType GetCommandType (void) const;
+
+  /**
+   * \return The size of this command on the air, CID included.
+   */
+  uint8_t GetSerializedSize (void) const;
+
+  /**
+   * \return The payload of this command, as it appears on the air after the
+   * CID.
+   */
+  const uint8_t *GetPayload (void) const;
+
+  /**
+   * Write the CID and the payload of this command.
+   */
+  void Serialize (Buffer::Iterator &start) const;
+
+  /**
+   * Read a command from the buffer. Since uplink and downlink commands share
+   * the same CIDs, the direction is needed to know the type of the command.
+   *
+   * \param start The position of the CID in the buffer.
+   * \param isUplink Whether the command is in an uplink frame.
+   * \return The number of bytes consumed, 0 if the CID is not recognized.
+   */
+  uint8_t Deserialize (Buffer::Iterator &start, bool isUplink);
+
+  /**
+   * Create the MacCommand object corresponding to this value.
+   *
+   * \return The command, or 0 if the type has no MacCommand implementation.
+   */
+  Ptr<MacCommand> CreateCommand (void) const;
+
+  /**
+   * \return The size on the air of a command of the given type, CID included.
+   */
+  static uint8_t GetSerializedSize (enum MacCommandType commandType);
+
+private:
+  uint8_t m_commandType; //!< The MacCommandType of this command
+  uint8_t m_payload[MAX_PAYLOAD_SIZE]; //!< The payload, CID excluded
+};
 }
 
 }
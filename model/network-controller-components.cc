@@ -72,25 +72,20 @@ ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
 
-  // Check whether the received packet requires an acknowledgment.
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-
-  NS_LOG_INFO ("Received packet Mac Header: " << mHdr);
-  NS_LOG_INFO ("Received packet Frame Header: " << fHdr);
-
-  if (mHdr.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
+  // Check whether the received packet requires an acknowledgment. The
+  // NetworkStatus already stored this packet's decoded headers.
+  const LoraFrameInfoTag &frameInfo = status->GetLastFrameInfo ();
+
+  NS_LOG_INFO ("Received packet MType: " << unsigned (frameInfo.GetMType ()));
+
+  if (frameInfo.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
     {
       NS_LOG_INFO ("Packet requires confirmation");
 
       // Set up the ACK bit on the reply
       status->m_reply.frameHeader.SetAsDownlink ();
       status->m_reply.frameHeader.SetAck (true);
-      status->m_reply.frameHeader.SetAddress (fHdr.GetAddress ());
+      status->m_reply.frameHeader.SetAddress (frameInfo.GetAddress ());
       status->m_reply.macHeader.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
       status->m_reply.needsReply = true;
 
@@ -159,17 +154,8 @@ LinkCheckComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-
-  Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq> ();
-
-  // GetMacCommand returns 0 if no command is found
-  if (command)
+  // Only the presence of the command matters, no need to create it
+  if (status->GetLastFrameInfo ().HasMacCommand (LINK_CHECK_REQ))
     {
       status->m_reply.needsReply = true;
 
@@ -60,7 +60,8 @@ NetworkController::Install (Ptr<NetworkControllerComponent> component)
 }
 
 void
-NetworkController::OnNewPacket (Ptr<Packet const> packet)
+NetworkController::OnNewPacket (Ptr<Packet const> packet,
+                                const LoraFrameInfoTag &frameInfo)
 {
   NS_LOG_FUNCTION (this << packet);
 
@@ -69,11 +70,11 @@ NetworkController::OnNewPacket (Ptr<Packet const> packet)
   // For now, we call all components.
 
   // Inform each component about the new packet
+  Ptr<EndDeviceStatus> edStatus =
+    m_status->GetEndDeviceStatus (frameInfo.GetAddress ());
   for (auto it = m_components.begin (); it != m_components.end (); ++it)
     {
-      (*it)->OnReceivedPacket (packet,
-                               m_status->GetEndDeviceStatus (packet),
-                               m_status);
+      (*it)->OnReceivedPacket (packet, edStatus, m_status);
     }
 }
 
@@ -55,8 +55,10 @@ public:
    * Method that is called by the NetworkServer when a new packet is received.
    *
    * \param packet The newly received packet.
+   * \param frameInfo The decoded headers of the packet.
    */
-  void OnNewPacket (Ptr<Packet const> packet);
+  void OnNewPacket (Ptr<Packet const> packet,
+                    const LoraFrameInfoTag &frameInfo);
 
   /**
    * Method that is called by the NetworkScheduler just before sending a reply
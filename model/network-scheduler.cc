@@ -1,4 +1,7 @@
 #include "network-scheduler.h"
+#include "ns3/class-b-end-device-lorawan-mac.h"
+#include "ns3/class-c-end-device-lorawan-mac.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
@@ -21,48 +24,52 @@ NetworkScheduler::GetTypeId (void)
   return tid;
 }
 
-NetworkScheduler::NetworkScheduler ()
+NetworkScheduler::NetworkScheduler () :
+  m_planner (CreateObject<DownlinkPlanner> ())
 {
+  m_planner->SetBatchCallback (MakeCallback
+                                 (&NetworkScheduler::OnReceiveWindowOpportunities, this));
 }
 
 NetworkScheduler::NetworkScheduler (Ptr<NetworkStatus> status,
                                     Ptr<NetworkController> controller) :
   m_status (status),
-  m_controller (controller)
+  m_controller (controller),
+  m_planner (CreateObject<DownlinkPlanner> ())
 {
+  m_planner->SetBatchCallback (MakeCallback
+                                 (&NetworkScheduler::OnReceiveWindowOpportunities, this));
 }
 
 NetworkScheduler::~NetworkScheduler ()
 {
 }
 
+Ptr<DownlinkPlanner>
+NetworkScheduler::GetDownlinkPlanner (void)
+{
+  return m_planner;
+}
+
 void
-NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
+NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet,
+                                    const LoraFrameInfoTag &frameInfo,
+                                    Time receptionTime)
 {
   NS_LOG_FUNCTION (packet);
 
   // Get the current packet's frame counter
-  Ptr<Packet> packetCopy = packet->Copy ();
-  LorawanMacHeader receivedMacHdr;
-  packetCopy->RemoveHeader (receivedMacHdr);
-  LoraFrameHeader receivedFrameHdr;
-  receivedFrameHdr.SetAsUplink ();
-  packetCopy->RemoveHeader (receivedFrameHdr);
-  uint8_t currentFrameCounter = receivedFrameHdr.GetFCnt ();
+  uint8_t currentFrameCounter = frameInfo.GetFCnt ();
+  LoraDeviceAddress deviceAddress = frameInfo.GetAddress ();
 
   // Get the saved packet's frame counter
-  Ptr<const Packet> savedPacket = m_status->GetEndDeviceStatus
-      (packet)->GetLastReceivedPacketInfo ().packet;
-  if (savedPacket)
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+  if (edStatus->GetLastPacketReceivedFromDevice ())
     {
-      Ptr<Packet> savedPacketCopy = savedPacket->Copy ();
-      LorawanMacHeader savedMacHdr;
-      savedPacketCopy->RemoveHeader (savedMacHdr);
-      LoraFrameHeader savedFrameHdr;
-      savedFrameHdr.SetAsUplink ();
-      savedPacketCopy->RemoveHeader (savedFrameHdr);
-      uint8_t savedFrameCounter = savedFrameHdr.GetFCnt ();
+      uint8_t savedFrameCounter = edStatus->GetLastFrameInfo ().GetFCnt ();
 
+      // It's possible that we already received the same packet from another
+      // gateway.
       if (currentFrameCounter == savedFrameCounter)
         {
           NS_LOG_DEBUG ("Packet was already received by another gateway.");
@@ -70,78 +77,222 @@ NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
         }
     }
 
-  // It's possible that we already received the same packet from another
-  // gateway.
-  // - Extract the address
-  LoraDeviceAddress deviceAddress = receivedFrameHdr.GetAddress ();
-
-  // Schedule OnReceiveWindowOpportunity event
-  Simulator::Schedule (Seconds (1),
-                       &NetworkScheduler::OnReceiveWindowOpportunity,
-                       this,
-                       deviceAddress,
-                       1);     // This will be the first receive window
+  // Plan the first receive window opportunity
+  DownlinkPlanner::Opportunity opportunity;
+  opportunity.deviceAddress = deviceAddress;
+  opportunity.window = DownlinkPlanner::FIRST_WINDOW;
+  opportunity.replyPrepared = false;
+  m_planner->Plan (receptionTime + Seconds (1), opportunity);
 }
 
 void
-NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window)
+NetworkScheduler::OnDownlinkQueued (LoraDeviceAddress deviceAddress)
 {
-  NS_LOG_FUNCTION (deviceAddress);
+  NS_LOG_FUNCTION (this << deviceAddress);
 
-  NS_LOG_DEBUG ("Opening receive window nubmer " << window << " for device "
-                                                 << deviceAddress);
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+  Ptr<ClassAEndDeviceLorawanMac> mac = edStatus->GetMac ();
 
-  // Check whether we can send a reply to the device, again by using
-  // NetworkStatus
-  Address gwAddress = m_status->GetBestGatewayForDevice (deviceAddress, window);
+  if (edStatus->GetGatewayRanking ().empty ())
+    {
+      // No gateway ever received the device: the reply stays queued, and is
+      // sent in the receive windows of its first uplink
+      NS_LOG_INFO ("No gateway can reach device " << deviceAddress <<
+                   " yet: the downlink waits for its next uplink");
+      return;
+    }
 
-  NS_LOG_DEBUG ("Found available gateway with address: " << gwAddress);
+  // The controller components only add commands to the replies of uplinks
+  DownlinkPlanner::Opportunity opportunity;
+  opportunity.deviceAddress = deviceAddress;
+  opportunity.replyPrepared = true;
 
-  if (gwAddress == Address () && window == 1)
+  if (DynamicCast<ClassBEndDeviceLorawanMac> (mac) != 0)
     {
-      NS_LOG_DEBUG ("No suitable gateway found.");
-
-      // No suitable GW was found
-      // Schedule OnReceiveWindowOpportunity event
-      Simulator::Schedule (Seconds (1),
-                           &NetworkScheduler::OnReceiveWindowOpportunity,
-                           this,
-                           deviceAddress,
-                           2);     // This will be the second receive window
+      opportunity.window = DownlinkPlanner::PING_SLOT;
+      PlanPingSlot (opportunity, Simulator::Now ());
     }
-  else if (gwAddress == Address () && window == 2)
+  else if (DynamicCast<ClassCEndDeviceLorawanMac> (mac) != 0)
     {
-      // No suitable GW was found
-      // Simply give up.
-      NS_LOG_INFO ("Giving up on reply: no suitable gateway was found " <<
-                   "on the second receive window");
-
-      // Reset the reply
-      // XXX Should we reset it here or keep it for the next opportunity?
-      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+      opportunity.window = DownlinkPlanner::CONTINUOUS_RX;
+      m_planner->Plan (Simulator::Now (), opportunity);
     }
   else
     {
+      NS_LOG_DEBUG ("Class A device: the downlink waits for its next uplink");
+    }
+}
+
+void
+NetworkScheduler::PlanPingSlot (const DownlinkPlanner::Opportunity &opportunity, Time time)
+{
+  NS_LOG_FUNCTION (this << opportunity.deviceAddress << time);
+
+  Ptr<ClassBEndDeviceLorawanMac> mac = DynamicCast<ClassBEndDeviceLorawanMac>
+    (m_status->GetEndDeviceStatus (opportunity.deviceAddress)->GetMac ());
+  NS_ASSERT (mac != 0);
+
+  // Only the ping slots in which a downlink is sent are opened
+  Time slotStart = mac->GetNextPingSlot (time);
+  mac->SchedulePingSlot (slotStart);
+  m_planner->Plan (slotStart, opportunity);
+}
+
+void
+NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window)
+{
+  NS_LOG_FUNCTION (deviceAddress);
+
+  std::vector<DownlinkPlanner::Opportunity> opportunities (1);
+  opportunities[0].deviceAddress = deviceAddress;
+  opportunities[0].window = window;
+  opportunities[0].replyPrepared = false;
+  OnReceiveWindowOpportunities (opportunities);
+}
+
+void
+NetworkScheduler::OnReceiveWindowOpportunities
+  (std::vector<DownlinkPlanner::Opportunity> &opportunities)
+{
+  NS_LOG_FUNCTION (this << opportunities.size ());
+
+  m_requests.clear ();
+  m_candidates.clear ();
+  m_bookedGateways.clear ();
+
+  // First, find the gateways that could serve each device, and whether the
+  // device needs a reply
+  for (auto it = opportunities.begin (); it != opportunities.end (); ++it)
+    {
+      NS_LOG_DEBUG ("Opening receive window number " << it->window <<
+                    " for device " << it->deviceAddress);
+
+      uint32_t firstGateway = m_candidates.size ();
+      m_status->GetAvailableGateways (it->deviceAddress, it->window, m_candidates);
+      uint32_t nGateways = m_candidates.size () - firstGateway;
+
+      if (nGateways == 0)
+        {
+          NS_LOG_DEBUG ("No suitable gateway found.");
+          OnNoGatewayAvailable (*it);
+          continue;
+        }
+
       // A gateway was found
-      m_controller->BeforeSendingReply (m_status->GetEndDeviceStatus
-                                          (deviceAddress));
+      if (!it->replyPrepared)
+        {
+          m_controller->BeforeSendingReply (m_status->GetEndDeviceStatus
+                                              (it->deviceAddress));
+        }
 
       // Check whether this device needs a response by querying m_status
-      bool needsReply = m_status->NeedsReply (deviceAddress);
+      if (m_status->NeedsReply (it->deviceAddress))
+        {
+          ReplyRequest request;
+          request.opportunity = *it;
+          request.opportunity.replyPrepared = true;
+          request.firstGateway = firstGateway;
+          request.nGateways = nGateways;
+          m_requests.push_back (request);
+        }
+    }
 
-      if (needsReply)
+  // Then, assign the gateways starting from the devices with fewer options.
+  // The sort is stable, so that devices with as many options are served in
+  // order of arrival.
+  std::stable_sort (m_requests.begin (), m_requests.end (),
+                    [] (const ReplyRequest &a, const ReplyRequest &b)
+                    {
+                      return a.nGateways < b.nGateways;
+                    });
+
+  for (auto it = m_requests.begin (); it != m_requests.end (); ++it)
+    {
+      LoraDeviceAddress deviceAddress = it->opportunity.deviceAddress;
+
+      // The candidates are sorted from the best gateway to the worst
+      Address gwAddress;
+      for (uint32_t i = it->firstGateway; i < it->firstGateway + it->nGateways; i++)
         {
-          NS_LOG_INFO ("A reply is needed");
+          const Address &candidate = m_candidates[i];
+          if (std::find (m_bookedGateways.begin (), m_bookedGateways.end (),
+                         candidate) == m_bookedGateways.end ())
+            {
+              gwAddress = candidate;
+              break;
+            }
+        }
 
-          // Send the reply through that gateway
-          m_status->SendThroughGateway (m_status->GetReplyForDevice
-                                          (deviceAddress, window),
-                                        gwAddress);
+      if (gwAddress == Address ())
+        {
+          NS_LOG_DEBUG ("All gateways of device " << deviceAddress <<
+                        " are taken by other replies in this slot");
+          OnNoGatewayAvailable (it->opportunity);
+          continue;
+        }
+
+      NS_LOG_INFO ("A reply is needed");
+      NS_LOG_DEBUG ("Found available gateway with address: " << gwAddress);
+
+      Ptr<Packet> reply = m_status->GetReplyForDevice (deviceAddress,
+                                                       it->opportunity.window);
+
+      // Book the gateway until the end of the reply, so that the
+      // opportunities of the next slots, processed before the reply reaches
+      // the gateway and starts, do not pick it
+      m_bookedGateways.push_back (gwAddress);
+      Ptr<GatewayStatus> gwStatus = m_status->GetGatewayStatus (gwAddress);
+      gwStatus->SetNextTransmissionTime
+        (Simulator::Now () + gwStatus->GetGatewayMac ()->GetOnAirTime (reply));
+
+      // Send the reply through that gateway
+      m_status->SendThroughGateway (reply, gwAddress);
+
+      // Reset the reply
+      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+    }
+}
 
-          // Reset the reply
-          m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+void
+NetworkScheduler::OnNoGatewayAvailable (const DownlinkPlanner::Opportunity &opportunity)
+{
+  NS_LOG_FUNCTION (this << opportunity.deviceAddress << opportunity.window);
+
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (opportunity.deviceAddress);
+
+  if (opportunity.window == DownlinkPlanner::FIRST_WINDOW)
+    {
+      // Plan the opportunity of the second receive window
+      DownlinkPlanner::Opportunity secondWindow = opportunity;
+      secondWindow.window = DownlinkPlanner::SECOND_WINDOW;
+      m_planner->Plan (Simulator::Now () + Seconds (1), secondWindow);
+    }
+  else if (opportunity.window != DownlinkPlanner::SECOND_WINDOW
+           && edStatus->NeedsReply ()
+           && !edStatus->GetGatewayRanking ().empty ())
+    {
+      // Class B and C devices keep listening: try again later, while there
+      // are gateways that can reach the device
+      if (opportunity.window == DownlinkPlanner::PING_SLOT)
+        {
+          PlanPingSlot (opportunity, Simulator::Now () + TimeStep (1));
+        }
+      else
+        {
+          m_planner->Plan (Simulator::Now () + Seconds (1), opportunity);
         }
     }
+  else
+    {
+      // No suitable GW was found
+      // Simply give up.
+      NS_LOG_INFO ("Giving up on reply: no suitable gateway was found " <<
+                   "on the second receive window");
+
+      // Reset the reply
+      // XXX Should we reset it here or keep it for the next opportunity?
+      edStatus->InitializeReply ();
+    }
 }
 }
 }
@@ -27,8 +27,11 @@
 #include "ns3/lora-device-address.h"
 #include "ns3/lorawan-mac-header.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-frame-info-tag.h"
 #include "ns3/network-controller.h"
 #include "ns3/network-status.h"
+#include "ns3/downlink-planner.h"
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -36,6 +39,23 @@ namespace lorawan {
 class NetworkStatus;     // Forward declaration
 class NetworkController;     // Forward declaration
 
+/**
+ * Plan the replies of the Network Server in the receive windows of the
+ * devices.
+ *
+ * Receive window opportunities are collected by a DownlinkPlanner, which
+ * hands over together all the opportunities falling in the same slot. The
+ * gateways are then assigned jointly to the devices of a slot that need a
+ * reply: devices that can be reached by fewer gateways choose first, so
+ * that a device with many options does not take the only gateway of
+ * another one. Each gateway sends at most one reply per slot.
+ *
+ * Downlinks that the Network Server queues outside of an uplink exchange
+ * are planned in the next ping slot of Class B devices, which is then the
+ * only one the device opens, and right away for Class C devices. Class A
+ * devices, and devices that no gateway received yet, receive them after
+ * their next uplink.
+ */
 class NetworkScheduler : public Object
 {
 public:
@@ -49,9 +69,16 @@ public:
   /**
    * Method called by NetworkServer to inform the Scheduler of a newly arrived
    * uplink packet. This function schedules the OnReceiveWindowOpportunity
-   * events 1 and 2 seconds later.
+   * events 1 and 2 seconds after the packet's reception.
+   *
+   * \param packet The received packet.
+   * \param frameInfo The decoded headers of the packet.
+   * \param receptionTime When the packet was first received: the
+   * NetworkServer calls this at the end of its deduplication window.
    */
-  void OnReceivedPacket (Ptr<const Packet> packet);
+  void OnReceivedPacket (Ptr<const Packet> packet,
+                         const LoraFrameInfoTag &frameInfo,
+                         Time receptionTime);
 
   /**
    * Method that is scheduled after packet arrivals in order to act on
@@ -59,10 +86,57 @@ public:
    */
   void OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window);
 
+  /**
+   * Act on all the receive window opportunities of a slot of the
+   * DownlinkPlanner, assigning the gateways jointly.
+   */
+  void OnReceiveWindowOpportunities (std::vector<DownlinkPlanner::Opportunity> &opportunities);
+
+  /**
+   * Method called by NetworkServer when a downlink was queued for a device,
+   * to plan it in the next receive window of the device class.
+   */
+  void OnDownlinkQueued (LoraDeviceAddress deviceAddress);
+
+  /**
+   * Get the DownlinkPlanner collecting the receive window opportunities.
+   */
+  Ptr<DownlinkPlanner> GetDownlinkPlanner (void);
+
 private:
+  /**
+   * A device of the current slot that needs a reply, and the gateways that
+   * can send it.
+   */
+  struct ReplyRequest
+  {
+    DownlinkPlanner::Opportunity opportunity;
+    uint32_t firstGateway; //!< Position of its first gateway in m_candidates
+    uint32_t nGateways; //!< The number of gateways that can send the reply
+  };
+
+  /**
+   * Handle an opportunity for which no gateway could be found: try again in
+   * the second window, in a later ping slot or continuous reception
+   * opportunity, or give up.
+   */
+  void OnNoGatewayAvailable (const DownlinkPlanner::Opportunity &opportunity);
+
+  /**
+   * Plan an opportunity in the first ping slot of a Class B device that
+   * starts at the given time or later, and make the device open that slot.
+   */
+  void PlanPingSlot (const DownlinkPlanner::Opportunity &opportunity, Time time);
+
   TracedCallback<Ptr<const Packet> > m_receiveWindowOpened;
   Ptr<NetworkStatus> m_status;
   Ptr<NetworkController> m_controller;
+  Ptr<DownlinkPlanner> m_planner;
+
+  // Reused at each slot
+  std::vector<ReplyRequest> m_requests;
+  std::vector<Address> m_candidates;
+  std::vector<Address> m_bookedGateways;
 };
 
 } /* namespace ns3 */
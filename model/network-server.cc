@@ -26,7 +26,10 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/packet.h"
 #include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-frame-info-tag.h"
+#include "ns3/lora-batch-header.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/network-status.h"
 #include "ns3/lora-frame-header.h"
@@ -34,6 +37,9 @@
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/mac-command.h"
 #include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
@@ -53,6 +59,14 @@ NetworkServer::GetTypeId (void)
                   IntegerValue (),
                   MakeIntegerAccessor(&NetworkServer::SetReplyPayloadSize),
                   MakeIntegerChecker<int> ())
+    .AddAttribute ("DeduplicationWindow",
+                   "How long to wait, after the first copy of an uplink "
+                   "arrives, for the copies forwarded by other gateways. "
+                   "With 0, only the copies arriving at the same time "
+                   "are merged.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&NetworkServer::m_deduplicationWindow),
+                   MakeTimeChecker (Seconds (0), Seconds (1)))
     .AddTraceSource ("ReceivedPacket",
                      "Trace source that is fired when a packet arrives at the Network Server",
                      MakeTraceSourceAccessor (&NetworkServer::m_receivedPacket),
@@ -150,7 +164,7 @@ NetworkServer::AddNode (Ptr<Node> node)
         }
     }
 
-  // Get the MAC
+  // Get the MAC. Class B and C MACs extend the Class A one.
   Ptr<ClassAEndDeviceLorawanMac> edLorawanMac =
     loraNetDevice->GetMac ()->GetObject<ClassAEndDeviceLorawanMac> ();
 
@@ -159,28 +173,138 @@ NetworkServer::AddNode (Ptr<Node> node)
   
 }
 
+void
+NetworkServer::SendDownlink (LoraDeviceAddress deviceAddress, Ptr<Packet> payload)
+{
+  NS_LOG_FUNCTION (this << deviceAddress << payload);
+
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+  NS_ABORT_MSG_IF (edStatus == 0, "Unknown device " << deviceAddress);
+
+  edStatus->SetReplyPayload (payload);
+  edStatus->m_reply.needsReply = true;
+  m_scheduler->OnDownlinkQueued (deviceAddress);
+}
+
 bool
 NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
                         uint16_t protocol, const Address& address)
 {
   NS_LOG_FUNCTION (this << packet << protocol << address);
+  LORAWAN_PROFILE (NETWORK_SERVER);
+
+  if (LoraBatchHeader::IsBatch (packet))
+    {
+      // Split the batch: the fragments share the bytes of the batch
+      Ptr<Packet> frames = packet->Copy ();
+      LoraBatchHeader batchHeader;
+      frames->RemoveHeader (batchHeader);
+      NS_LOG_DEBUG ("Received a batch of " << batchHeader.GetNFrames () << " uplinks");
+
+      uint32_t offset = 0;
+      for (uint32_t i = 0; i < batchHeader.GetNFrames (); i++)
+        {
+          const LoraBatchHeader::FrameMetadata &frame = batchHeader.GetFrame (i);
+          Ptr<Packet> uplink = frames->CreateFragment (offset, frame.size);
+          uplink->AddPacketTag (frame.frameInfo);
+          offset += frame.size;
+          ReceiveUplink (uplink, frame.frameInfo, frame.receptionTime, address);
+        }
+      return true;
+    }
+
+  // Get the headers decoded by the gateway. Packets that were not forwarded
+  // by a GatewayLorawanMac have no tag, and are decoded here.
+  ReceiveUplink (packet, LoraFrameInfoTag::Get (packet), Simulator::Now (), address);
+
+  return true;
+}
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
+void
+NetworkServer::ReceiveUplink (Ptr<const Packet> packet, const LoraFrameInfoTag &frameInfo,
+                              Time receivedTime, const Address &address)
+{
+  NS_LOG_FUNCTION (this << packet << receivedTime << address);
 
   // Fire the trace source
   m_receivedPacket (packet);
 
+  // Find the uplink this packet is a copy of
+  UplinkKey key (frameInfo.GetAddress ().Get (), frameInfo.GetFCnt ());
+  auto it = m_pendingUplinks.find (key);
+  if (it == m_pendingUplinks.end ())
+    {
+      NS_LOG_DEBUG ("New uplink from " << frameInfo.GetAddress ());
+
+      PendingUplink uplink;
+      uplink.packet = packet;
+      uplink.frameInfo = frameInfo;
+      uplink.firstReceptionTime = receivedTime;
+      it = m_pendingUplinks.insert (std::make_pair (key, uplink)).first;
+
+      // Events already scheduled at the end of the window, like the
+      // reception of the other copies in case of a null window, come first
+      Simulator::Schedule (m_deduplicationWindow, &NetworkServer::ProcessUplink,
+                           this, key);
+    }
+  else
+    {
+      NS_LOG_DEBUG ("Merging copy of the uplink from " << frameInfo.GetAddress ());
+
+      // Copies from batching gateways may arrive after later receptions
+      it->second.firstReceptionTime = std::min (it->second.firstReceptionTime,
+                                                receivedTime);
+    }
+
+  // Add this gateway's reception information
+  EndDeviceStatus::PacketInfoPerGw gwInfo;
+  gwInfo.receivedTime = receivedTime;
+  gwInfo.rxPower = frameInfo.GetReceivePower ();
+  gwInfo.gwAddress = address;
+  it->second.gwList.insert (std::make_pair (address, gwInfo));
+}
+
+void
+NetworkServer::ProcessUplink (UplinkKey key)
+{
+  NS_LOG_FUNCTION (this << key.first << key.second);
+  LORAWAN_PROFILE (NETWORK_SERVER);
+
+  auto it = m_pendingUplinks.find (key);
+  NS_ASSERT (it != m_pendingUplinks.end ());
+  PendingUplink uplink = it->second;
+  m_pendingUplinks.erase (it);
+
+  NS_LOG_DEBUG ("Processing uplink received by " << uplink.gwList.size () <<
+                " gateways");
+
+  // A copy arriving after the window closed only adds its gateway to the
+  // packet that was already processed
+  Ptr<EndDeviceStatus> edStatus =
+    m_status->GetEndDeviceStatus (uplink.frameInfo.GetAddress ());
+  bool isLateCopy = edStatus != 0
+    && edStatus->GetLastPacketReceivedFromDevice () != 0
+    && edStatus->GetLastFrameInfo ().GetFCnt () == uplink.frameInfo.GetFCnt ();
+
   // Inform the scheduler of the newly arrived packet
-  m_scheduler->OnReceivedPacket (packet);
+  if (!isLateCopy)
+    {
+      m_scheduler->OnReceivedPacket (uplink.packet, uplink.frameInfo,
+                                     uplink.firstReceptionTime);
+    }
 
   // Inform the status of the newly arrived packet
-  m_status->OnReceivedPacket (packet, address);
+  m_status->OnReceivedPacket (uplink.packet, uplink.frameInfo, uplink.gwList);
 
   // Inform the controller of the newly arrived packet
-  m_controller->OnNewPacket (packet);
-
-  return true;
+  if (!isLateCopy)
+    {
+      m_controller->OnNewPacket (uplink.packet, uplink.frameInfo);
+    }
+  else
+    {
+      NS_LOG_DEBUG ("Late copy of an uplink that was already processed");
+    }
 }
 
 void
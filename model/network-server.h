@@ -36,6 +36,8 @@
 #include "ns3/log.h"
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include <map>
 
 namespace ns3 {
 namespace lorawan {
@@ -46,6 +48,12 @@ namespace lorawan {
  *
  * This version of the NetworkServer attempts to closely mimic an actual
  * Network Server, by providing as much functionality as possible.
+ *
+ * Like a real Network Server, this application deduplicates uplinks: the
+ * copies of an uplink that different gateways forward within the
+ * DeduplicationWindow of the first one are merged, and the scheduler,
+ * the NetworkStatus and the NetworkController components are informed once
+ * per uplink, with the reception data of all the gateways.
  */
 class NetworkServer : public Application
 {
@@ -80,6 +88,19 @@ public:
    */
   void AddNode (Ptr<Node> node);
 
+  /**
+   * Queue a downlink with the given payload for a device.
+   *
+   * The downlink is sent in the next ping slot of a Class B device, as soon
+   * as possible to a Class C device, and in the receive windows that follow
+   * the next uplink of a Class A device. It replaces the payload of the
+   * reply that is pending for the device, if any.
+   *
+   * \param deviceAddress the address of the device.
+   * \param payload the application payload of the downlink.
+   */
+  void SendDownlink (LoraDeviceAddress deviceAddress, Ptr<Packet> payload);
+
   /**
    * Add this gateway to the list of gateways connected to this NS.
    * Each GW is identified by its Address in the NS-GWs network.
@@ -93,6 +114,14 @@ public:
 
   /**
    * Receive a packet from a gateway.
+   *
+   * The packet is added to the pending uplink with the same DevAddr and
+   * FCnt, which is created if needed and processed at the end of the
+   * deduplication window.
+   *
+   * Batches sent by a Forwarder are split in their uplinks, whose reception
+   * time is the one reported by the gateway.
+   *
    * \param packet the received packet
    */
   bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
@@ -105,10 +134,44 @@ public:
   int m_replyPayloadSize;
 
 protected:
+  /**
+   * The copies of an uplink received so far.
+   */
+  struct PendingUplink
+  {
+    Ptr<const Packet> packet;   //!< The first copy of the packet
+    LoraFrameInfoTag frameInfo;   //!< The decoded headers of the first copy
+    EndDeviceStatus::GatewayList gwList;   //!< The gateways that received it
+    Time firstReceptionTime;   //!< The earliest gateway reception of a copy
+  };
+
+  /// An uplink is identified by the DevAddr and the FCnt of its device
+  typedef std::pair<uint32_t, uint16_t> UplinkKey;
+
+  /**
+   * Add a copy of an uplink to its pending uplink.
+   *
+   * \param packet the copy of the uplink.
+   * \param frameInfo the decoded headers of the uplink.
+   * \param receivedTime when the gateway received the copy.
+   * \param address the address of the gateway.
+   */
+  void ReceiveUplink (Ptr<const Packet> packet, const LoraFrameInfoTag &frameInfo,
+                      Time receivedTime, const Address &address);
+
+  /**
+   * Inform the scheduler, the status and the controller of an uplink, once
+   * its deduplication window is over.
+   */
+  void ProcessUplink (UplinkKey key);
+
   Ptr<NetworkStatus> m_status;
   Ptr<NetworkController> m_controller;
   Ptr<NetworkScheduler> m_scheduler;
 
+  Time m_deduplicationWindow;   //!< How long to wait for other copies
+  std::map<UplinkKey, PendingUplink> m_pendingUplinks;   //!< Uplinks in their window
+
   TracedCallback<Ptr<const Packet>> m_receivedPacket;
 };
 
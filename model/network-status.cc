@@ -22,6 +22,8 @@
 #include "ns3/network-status.h"
 #include "ns3/end-device-status.h"
 #include "ns3/gateway-status.h"
+#include "ns3/class-b-end-device-lorawan-mac.h"
+#include "ns3/downlink-planner.h"
 
 #include "ns3/net-device.h"
 #include "ns3/packet.h"
@@ -64,7 +66,7 @@ NetworkStatus::AddNode (Ptr<ClassAEndDeviceLorawanMac> edMac,
 
   // Check whether this device already exists in our list
   LoraDeviceAddress edAddress = edMac->GetDeviceAddress ();
-  if (m_endDeviceStatuses.find (edAddress) == m_endDeviceStatuses.end ())
+  if (m_endDeviceIndices.Find (edAddress) == m_endDeviceIndices.NOT_FOUND)
     {
       // The device doesn't exist. Create new EndDeviceStatus
       Ptr<EndDeviceStatus> edStatus = CreateObject<EndDeviceStatus>
@@ -72,9 +74,9 @@ NetworkStatus::AddNode (Ptr<ClassAEndDeviceLorawanMac> edMac,
       Ptr<Packet> replyPayload = Create<Packet> (replyPayloadSize);
       edStatus->SetReplyPayload(replyPayload);
 
-      // Add it to the map
-      m_endDeviceStatuses.insert (std::pair<LoraDeviceAddress, Ptr<EndDeviceStatus> >
-                                  (edAddress, edStatus));
+      // Add it to the list
+      m_endDeviceIndices.Insert (edAddress, m_endDeviceStatuses.size ());
+      m_endDeviceStatuses.push_back (edStatus);
       NS_LOG_DEBUG ("Added to the list a device with address " <<
                     edAddress.Print ());
     }
@@ -86,86 +88,96 @@ NetworkStatus::AddGateway (Address& address, Ptr<GatewayStatus> gwStatus)
   NS_LOG_FUNCTION (this);
 
   // Check whether this device already exists in the list
-  if (m_gatewayStatuses.find (address) == m_gatewayStatuses.end ())
+  if (m_gatewayIndices.Find (address) == m_gatewayIndices.NOT_FOUND)
     {
       // The device doesn't exist.
 
-      // Add it to the map
-      m_gatewayStatuses.insert (std::pair<Address, Ptr<GatewayStatus> >
-                                (address, gwStatus));
+      // Add it to the list
+      m_gatewayIndices.Insert (address, m_gatewayStatuses.size ());
+      m_gatewayStatuses.push_back (gwStatus);
       NS_LOG_DEBUG ("Added to the list a gateway with address " << address);
     }
 }
 
 void
 NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
-                                  const Address& gwAddress)
+                                 const LoraFrameInfoTag &frameInfo,
+                                 const Address& gwAddress)
 {
   NS_LOG_FUNCTION (this << packet << gwAddress);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
+  // Update the correct EndDeviceStatus object
+  LoraDeviceAddress edAddr = frameInfo.GetAddress ();
+  NS_LOG_DEBUG ("Node address: " << edAddr);
+  Ptr<EndDeviceStatus> edStatus = GetEndDeviceStatus (edAddr);
+  NS_ABORT_MSG_IF (edStatus == 0, "Packet from unknown device " << edAddr);
+  edStatus->InsertReceivedPacket (packet, frameInfo, gwAddress);
+}
 
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+void
+NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
+                                 const LoraFrameInfoTag &frameInfo,
+                                 const EndDeviceStatus::GatewayList &gwList)
+{
+  NS_LOG_FUNCTION (this << packet << gwList.size ());
 
   // Update the correct EndDeviceStatus object
-  LoraDeviceAddress edAddr = frameHdr.GetAddress ();
+  LoraDeviceAddress edAddr = frameInfo.GetAddress ();
   NS_LOG_DEBUG ("Node address: " << edAddr);
-  m_endDeviceStatuses.at (edAddr)->InsertReceivedPacket (packet, gwAddress);
+  Ptr<EndDeviceStatus> edStatus = GetEndDeviceStatus (edAddr);
+  NS_ABORT_MSG_IF (edStatus == 0, "Packet from unknown device " << edAddr);
+  edStatus->InsertReceivedPacket (packet, frameInfo, gwList);
 }
 
 bool
 NetworkStatus::NeedsReply (LoraDeviceAddress deviceAddress)
 {
-  // Throws out of range if no device is found
-  return m_endDeviceStatuses.at (deviceAddress)->NeedsReply ();
+  Ptr<EndDeviceStatus> edStatus = GetEndDeviceStatus (deviceAddress);
+  NS_ABORT_MSG_IF (edStatus == 0, "Unknown device " << deviceAddress);
+  return edStatus->NeedsReply ();
 }
 
 Address
 NetworkStatus::GetBestGatewayForDevice (LoraDeviceAddress deviceAddress, int window)
 {
-  // Get the endDeviceStatus we are interested in
-  Ptr<EndDeviceStatus> edStatus = m_endDeviceStatuses.at (deviceAddress);
-  double replyFrequency;
-  if (window == 1)
+  std::vector<Address> gateways;
+  GetAvailableGateways (deviceAddress, window, gateways);
+  if (gateways.empty ())
     {
-      replyFrequency = edStatus->GetFirstReceiveWindowFrequency();
-    }
-  else if (window == 2)
-    {
-      replyFrequency = edStatus->GetSecondReceiveWindowFrequency();
-    }
-  else
-    {
-      NS_ABORT_MSG ("Invalid window value");
+      return Address ();
     }
+  return gateways.front ();
+}
+
+void
+NetworkStatus::GetAvailableGateways (LoraDeviceAddress deviceAddress, int window,
+                                     std::vector<Address> &gateways)
+{
+  NS_LOG_FUNCTION (this << deviceAddress << window);
+
+  Ptr<EndDeviceStatus> edStatus = GetEndDeviceStatus (deviceAddress);
+  NS_ABORT_MSG_IF (edStatus == 0, "Unknown device " << deviceAddress);
+  double replyFrequency;
+  uint8_t replyDataRate;
+  GetReplyParameters (edStatus, window, replyFrequency, replyDataRate);
 
   // Get the list of gateways that this device can reach
   // NOTE: At this point, we could also take into account the whole network to
   // identify the best gateway according to various metrics. For now, we just
-  // ask the EndDeviceStatus to pick the best gateway for us via its method.
-  std::map<double, Address> gwAddresses = edStatus->GetPowerGatewayMap ();
-
-  // By iterating on the map in reverse, we go from the 'best'
-  // gateway, i.e. the one with the highest received power, to the
-  // worst.
-  Address bestGwAddress;
-  for (auto it = gwAddresses.rbegin(); it != gwAddresses.rend(); it++)
+  // use the ranking the EndDeviceStatus keeps of the gateways that received
+  // the last packet.
+  // The ranking goes from the 'best' gateway, i.e. the one with the highest
+  // received power, to the worst.
+  const EndDeviceStatus::GatewayRanking &ranking = edStatus->GetGatewayRanking ();
+  for (auto it = ranking.begin (); it != ranking.end (); it++)
     {
-      bool isAvailable = m_gatewayStatuses.find(it->second)->second->IsAvailableForTransmission (replyFrequency);
-      if (isAvailable)
+      Ptr<GatewayStatus> gwStatus = GetGatewayStatus (it->second);
+      NS_ASSERT (gwStatus != 0);
+      if (gwStatus->IsAvailableForTransmission (replyFrequency))
         {
-          bestGwAddress = it->second;
-          break;
+          gateways.push_back (it->second);
         }
     }
-
-  return bestGwAddress;
 }
 
 void
@@ -173,34 +185,56 @@ NetworkStatus::SendThroughGateway (Ptr<Packet> packet, Address gwAddress)
 {
   NS_LOG_FUNCTION (packet << gwAddress);
 
-  m_gatewayStatuses.find (gwAddress)->second->GetNetDevice ()->Send (packet,
-                                                                      gwAddress,
-                                                                      0x0800);
+  GetGatewayStatus (gwAddress)->GetNetDevice ()->Send (packet, gwAddress, 0x0800);
 }
 
 Ptr<Packet>
 NetworkStatus::GetReplyForDevice (LoraDeviceAddress edAddress, int windowNumber)
 {
   // Get the reply packet
-  Ptr<EndDeviceStatus> edStatus = m_endDeviceStatuses.find (edAddress)->second;
+  Ptr<EndDeviceStatus> edStatus = GetEndDeviceStatus (edAddress);
   Ptr<Packet> packet = edStatus->GetCompleteReplyPacket ();
 
   // Apply the appropriate tag
+  double frequency;
+  uint8_t dataRate;
+  GetReplyParameters (edStatus, windowNumber, frequency, dataRate);
   LoraTag tag;
-  switch (windowNumber)
+  tag.SetDataRate (dataRate);
+  tag.SetFrequency (frequency);
+
+  packet->AddPacketTag (tag);
+  return packet;
+}
+
+void
+NetworkStatus::GetReplyParameters (Ptr<EndDeviceStatus> edStatus, int window,
+                                   double &frequency, uint8_t &dataRate)
+{
+  switch (window)
     {
-    case 1:
-      tag.SetDataRate (edStatus->GetMac ()->GetFirstReceiveWindowDataRate ());
-      tag.SetFrequency (edStatus->GetFirstReceiveWindowFrequency ());
+    case DownlinkPlanner::FIRST_WINDOW:
+      frequency = edStatus->GetFirstReceiveWindowFrequency ();
+      dataRate = edStatus->GetMac ()->GetFirstReceiveWindowDataRate ();
       break;
-    case 2:
-      tag.SetDataRate (edStatus->GetMac ()->GetSecondReceiveWindowDataRate ());
-      tag.SetFrequency (edStatus->GetSecondReceiveWindowFrequency ());
+    case DownlinkPlanner::SECOND_WINDOW:
+    case DownlinkPlanner::CONTINUOUS_RX:
+      // Class C devices listen on the parameters of the second window
+      frequency = edStatus->GetSecondReceiveWindowFrequency ();
+      dataRate = edStatus->GetMac ()->GetSecondReceiveWindowDataRate ();
       break;
+    case DownlinkPlanner::PING_SLOT:
+      {
+        Ptr<ClassBEndDeviceLorawanMac> mac =
+          DynamicCast<ClassBEndDeviceLorawanMac> (edStatus->GetMac ());
+        NS_ABORT_MSG_IF (mac == 0, "Ping slot for a device that is not in Class B");
+        frequency = mac->GetPingSlotFrequency ();
+        dataRate = mac->GetPingSlotDataRate ();
+        break;
+      }
+    default:
+      NS_ABORT_MSG ("Invalid window value");
     }
-
-  packet->AddPacketTag (tag);
-  return packet;
 }
 
 Ptr<EndDeviceStatus>
@@ -208,16 +242,19 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
 
-  // Get the address
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-  auto it = m_endDeviceStatuses.find (fHdr.GetAddress ());
-  if (it != m_endDeviceStatuses.end ())
+  // Get the address, from the tag of the gateway if possible
+  return GetEndDeviceStatus (LoraFrameInfoTag::Get (packet).GetAddress ());
+}
+
+Ptr<EndDeviceStatus>
+NetworkStatus::GetEndDeviceStatus (LoraDeviceAddress address)
+{
+  NS_LOG_FUNCTION (this << address);
+
+  uint32_t index = m_endDeviceIndices.Find (address);
+  if (index != m_endDeviceIndices.NOT_FOUND)
     {
-      return (*it).second;
+      return m_endDeviceStatuses[index];
     }
   else
     {
@@ -226,29 +263,37 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
     }
 }
 
-Ptr<EndDeviceStatus>
-NetworkStatus::GetEndDeviceStatus (LoraDeviceAddress address)
+int
+NetworkStatus::CountEndDevices (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_endDeviceStatuses.size ();
+}
+
+Ptr<GatewayStatus>
+NetworkStatus::GetGatewayStatus (const Address &address)
 {
   NS_LOG_FUNCTION (this << address);
 
-  auto it = m_endDeviceStatuses.find (address);
-  if (it != m_endDeviceStatuses.end ())
+  uint32_t index = m_gatewayIndices.Find (address);
+  if (index != m_gatewayIndices.NOT_FOUND)
     {
-      return (*it).second;
+      return m_gatewayStatuses[index];
     }
   else
     {
-      NS_LOG_ERROR ("EndDeviceStatus not found");
+      NS_LOG_ERROR ("GatewayStatus not found");
       return 0;
     }
 }
 
 int
-NetworkStatus::CountEndDevices (void)
+NetworkStatus::CountGateways (void)
 {
   NS_LOG_FUNCTION (this);
 
-  return m_endDeviceStatuses.size ();
+  return m_gatewayStatuses.size ();
 }
 }
 }
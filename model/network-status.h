@@ -27,6 +27,7 @@
 #include "ns3/gateway-status.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/network-scheduler.h"
+#include "ns3/lora-index-table.h"
 #include "ns3/packet.h"
 
 #include <iterator>
@@ -42,6 +43,12 @@ namespace lorawan {
  *
  * This class is meant to be queried by NetworkController components, which
  * can decide to take action based on the current status of the network.
+ *
+ * Devices and gateways are stored in vectors, in order of addition, and
+ * found through open addressing hash tables keyed by LoraDeviceAddress and
+ * by the Address of the gateway. Together with the gateway ranking kept by
+ * each EndDeviceStatus, this makes gateway selection for a reply free of
+ * allocations.
  */
 class NetworkStatus : public Object
 {
@@ -68,9 +75,23 @@ public:
    * Update network status on the received packet.
    *
    * \param packet the received packet.
+   * \param frameInfo the decoded headers of the packet.
    * \param address the gateway this packet was received from.
    */
-  void OnReceivedPacket (Ptr<const Packet> packet, const Address &gwaddress);
+  void OnReceivedPacket (Ptr<const Packet> packet,
+                         const LoraFrameInfoTag &frameInfo,
+                         const Address &gwaddress);
+
+  /**
+   * Update network status on a packet received by several gateways.
+   *
+   * \param packet the received packet.
+   * \param frameInfo the decoded headers of the packet.
+   * \param gwList the gateways this packet was received from.
+   */
+  void OnReceivedPacket (Ptr<const Packet> packet,
+                         const LoraFrameInfoTag &frameInfo,
+                         const EndDeviceStatus::GatewayList &gwList);
 
   /**
    * Return whether the specified device needs a reply.
@@ -87,6 +108,17 @@ public:
    */
   Address GetBestGatewayForDevice (LoraDeviceAddress deviceAddress, int window);
 
+  /**
+   * Append to a vector all the gateways that are available to send a reply
+   * to the specified device, from the best to the worst.
+   *
+   * \param deviceAddress the address of the device we are interested in.
+   * \param window the receive window of the reply, a DownlinkPlanner::Window.
+   * \param gateways the vector the gateways are appended to.
+   */
+  void GetAvailableGateways (LoraDeviceAddress deviceAddress, int window,
+                             std::vector<Address> &gateways);
+
   /**
    * Send a packet through a Gateway.
    *
@@ -116,9 +148,39 @@ public:
    */
   int CountEndDevices (void);
 
-public:
-  std::map<LoraDeviceAddress, Ptr<EndDeviceStatus>> m_endDeviceStatuses;
-  std::map<Address, Ptr<GatewayStatus>> m_gatewayStatuses;
+  /**
+   * Get the GatewayStatus corresponding to the Address of a gateway.
+   *
+   * \return The GatewayStatus, or 0 if the gateway is not known.
+   */
+  Ptr<GatewayStatus> GetGatewayStatus (const Address &address);
+
+  /**
+   * Return the number of gateways currently connected to the server.
+   */
+  int CountGateways (void);
+
+private:
+  /**
+   * Get the frequency and the Data Rate a device listens on in a receive
+   * window.
+   *
+   * \param edStatus the status of the device.
+   * \param window the receive window, a DownlinkPlanner::Window.
+   * \param frequency the frequency, in MHz.
+   * \param dataRate the Data Rate.
+   */
+  void GetReplyParameters (Ptr<EndDeviceStatus> edStatus, int window,
+                           double &frequency, uint8_t &dataRate);
+
+  /// The known devices, in order of addition
+  std::vector<Ptr<EndDeviceStatus> > m_endDeviceStatuses;
+  /// The position of each device in m_endDeviceStatuses
+  IndexTable<LoraDeviceAddress, LoraDeviceAddressHash> m_endDeviceIndices;
+  /// The known gateways, in order of addition
+  std::vector<Ptr<GatewayStatus> > m_gatewayStatuses;
+  /// The position of each gateway in m_gatewayStatuses
+  IndexTable<Address, AddressHash> m_gatewayIndices;
 };
 
 } // namespace lorawan
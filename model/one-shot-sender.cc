@@ -26,6 +26,7 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/lora-net-device.h"
+#include "ns3/lora-packet-pool.h"
 #include "ns3/trace-source-accessor.h"
 
 namespace ns3 {
@@ -82,7 +83,7 @@ OneShotSender::SendPacket (void)
   NS_LOG_FUNCTION (this);
 
   // Create and send a new packet
-  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  Ptr<Packet> packet = LoraPacketPool::Allocate (m_packetSize);
   m_mac->Send (packet);
   // Fire the callback
   m_generatedPacket();
@@ -24,6 +24,7 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/lora-net-device.h"
+#include "ns3/lora-packet-pool.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -116,11 +117,11 @@ PeriodicSender::SendPacket (void)
   if (m_pktSizeRV)
     {
       int randomsize = m_pktSizeRV->GetInteger ();
-      packet = Create<Packet> (m_basePktSize + randomsize);
+      packet = LoraPacketPool::Allocate (m_basePktSize + randomsize);
     }
   else
     {
-      packet = Create<Packet> (m_basePktSize);
+      packet = LoraPacketPool::Allocate (m_basePktSize);
     }
   m_mac->Send (packet);
   // Fire the callback
@@ -22,6 +22,7 @@
 #include "ns3/simple-end-device-lora-phy.h"
 #include "ns3/simulator.h"
 #include "ns3/lora-tag.h"
+#include "ns3/lora-flight-recorder.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -77,14 +78,23 @@ SimpleEndDeviceLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams,
 
   // Tag the packet with information about its Spreading Factor
   LoraTag tag;
-  packet->RemovePacketTag (tag);
+  packet->PeekPacketTag (tag);
   tag.SetSpreadingFactor (txParams.sf);
-  packet->AddPacketTag (tag);
+  if (!packet->ReplacePacketTag (tag))
+    {
+      packet->AddPacketTag (tag);
+    }
 
   // Send the packet over the channel
   NS_LOG_INFO ("Sending the packet in the channel");
   m_channel->Send (this, packet, txPowerDbm, txParams, duration, frequencyMHz);
 
+  if (LoraFlightRecorder::IsEnabled ())
+    {
+      LoraFlightRecorder::RecordTxStart (m_device ? m_device->GetNode ()->GetId () : 0,
+                                         txParams.sf, frequencyMHz, txPowerDbm);
+    }
+
   // Schedule the switch back to STANDBY mode.
   // For reference see SX1272 datasheet, section 4.1.6
   Simulator::Schedule (duration, &EndDeviceLoraPhy::SwitchToStandby, this);
@@ -256,6 +266,12 @@ SimpleEndDeviceLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
 
                 Simulator::Schedule (duration, &LoraPhy::EndReceive, this, packet, event);
 
+                if (LoraFlightRecorder::IsEnabled ())
+                  {
+                    LoraFlightRecorder::RecordRxLock (m_device ? m_device->GetNode ()->GetId () : 0,
+                                                      sf, frequencyMHz, rxPowerDbm);
+                  }
+
                 // Fire the beginning of reception trace source
                 m_phyRxBeginTrace (packet);
               }
@@ -20,6 +20,7 @@
 
 #include "ns3/simple-gateway-lora-phy.h"
 #include "ns3/lora-tag.h"
+#include "ns3/lora-flight-recorder.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -101,6 +102,12 @@ SimpleGatewayLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams,
   // Send the packet in the channel
   m_channel->Send (this, packet, txPowerDbm, txParams, duration, frequencyMHz);
 
+  if (LoraFlightRecorder::IsEnabled ())
+    {
+      LoraFlightRecorder::RecordTxStart (m_device ? m_device->GetNode ()->GetId () : 0,
+                                         txParams.sf, frequencyMHz, txPowerDbm);
+    }
+
   Simulator::Schedule (duration, &SimpleGatewayLoraPhy::TxFinished, this, packet);
 
   m_isTransmitting = true;
@@ -207,6 +214,12 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
 
               currentPath->SetEndReceive (endReceiveEventId);
 
+              if (LoraFlightRecorder::IsEnabled ())
+                {
+                  LoraFlightRecorder::RecordRxLock (m_device ? m_device->GetNode ()->GetId () : 0,
+                                                    sf, frequencyMHz, rxPowerDbm);
+                }
+
               // Make sure we don't go on searching for other ReceivePaths
               return;
             }
@@ -217,6 +230,12 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
                << unsigned(sf) <<
                " because no suitable demodulator was found");
 
+  if (LoraFlightRecorder::IsEnabled ())
+    {
+      LoraFlightRecorder::RecordNoMoreDemodulators (m_device ? m_device->GetNode ()->GetId () : 0,
+                                                    sf, frequencyMHz, rxPowerDbm);
+    }
+
   // Fire the trace source
   if (m_device)
     {
@@ -248,11 +267,14 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet,
     {
       NS_LOG_DEBUG ("packetDestroyed by " << unsigned(packetDestroyed));
 
-      // Update the packet's LoraTag
+      // Update the packet's LoraTag in place
       LoraTag tag;
-      packet->RemovePacketTag (tag);
+      packet->PeekPacketTag (tag);
       tag.SetDestroyedBy (packetDestroyed);
-      packet->AddPacketTag (tag);
+      if (!packet->ReplacePacketTag (tag))
+        {
+          packet->AddPacketTag (tag);
+        }
 
       // Fire the trace source
       if (m_device)
@@ -290,10 +312,13 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet,
           // information can be useful for upper layers trying to control link
           // quality.
           LoraTag tag;
-          packet->RemovePacketTag (tag);
+          packet->PeekPacketTag (tag);
           tag.SetReceivePower (event->GetRxPowerdBm ());
           tag.SetFrequency (event->GetFrequency ());
-          packet->AddPacketTag (tag);
+          if (!packet->ReplacePacketTag (tag))
+            {
+              packet->AddPacketTag (tag);
+            }
 
           m_rxOkCallback (packet);
         }
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "ns3/variable-energy-harvester-group.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VariableEnergyHarvesterGroup");
+
+NS_OBJECT_ENSURE_REGISTERED (VariableEnergyHarvesterGroup);
+
+TypeId
+VariableEnergyHarvesterGroup::GetTypeId (void)
+{
+  static TypeId tid =
+      TypeId ("ns3::VariableEnergyHarvesterGroup")
+          .SetParent<Object> ()
+          .SetGroupName ("Energy")
+          .AddConstructor<VariableEnergyHarvesterGroup> ()
+          .AddAttribute ("UpdateInterval",
+                         "Time between two consecutive evaluations of the shared trace.",
+                         TimeValue (Seconds (1.0)),
+                         MakeTimeAccessor (&VariableEnergyHarvesterGroup::SetUpdateInterval,
+                                           &VariableEnergyHarvesterGroup::GetUpdateInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("Filename", "Input power trace shared by the harvesters of the group",
+                         StringValue ("outputixys.csv"),
+                         MakeStringAccessor (&VariableEnergyHarvesterGroup::SetInputFile,
+                                             &VariableEnergyHarvesterGroup::GetInputFile),
+                         MakeStringChecker ());
+  return tid;
+}
+
+VariableEnergyHarvesterGroup::VariableEnergyHarvesterGroup ()
+  : m_traceLoaded (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+VariableEnergyHarvesterGroup::~VariableEnergyHarvesterGroup ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+VariableEnergyHarvesterGroup::SetInputFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_filename = filename;
+  m_traceLoaded = false;
+}
+
+std::string
+VariableEnergyHarvesterGroup::GetInputFile (void) const
+{
+  return m_filename;
+}
+
+void
+VariableEnergyHarvesterGroup::SetUpdateInterval (Time interval)
+{
+  NS_LOG_FUNCTION (this << interval);
+  m_updateInterval = interval;
+}
+
+Time
+VariableEnergyHarvesterGroup::GetUpdateInterval (void) const
+{
+  return m_updateInterval;
+}
+
+void
+VariableEnergyHarvesterGroup::AddHarvester (Ptr<VariableEnergyHarvester> harvester,
+                                            double scale, Time shift)
+{
+  NS_LOG_FUNCTION (this << harvester << scale << shift);
+  NS_ASSERT (harvester != 0);
+  NS_ABORT_MSG_UNLESS (harvester->GetHarvestedPowerUpdateInterval () == m_updateInterval,
+                       "The update interval of the harvester ("
+                       << harvester->GetHarvestedPowerUpdateInterval ()
+                       << ") differs from the one of its group (" << m_updateInterval << ")");
+
+  if (!m_traceLoaded)
+    {
+      m_statistics.SetTrace (VariableEnergyHarvester::ReadPowerTrace (m_filename),
+                             Seconds (1));
+      m_traceLoaded = true;
+    }
+
+  harvester->SetGroup (this, scale, shift);
+
+  Member member;
+  member.harvester = harvester;
+  member.scale = scale;
+
+  // Look for members with the same shift
+  uint32_t i = 0;
+  while (i < m_shifts.size () && m_shifts[i] != shift)
+    {
+      i++;
+    }
+  if (i == m_shifts.size ())
+    {
+      m_shifts.push_back (shift);
+      // Force the notification of the members at the first update
+      m_lastSample.push_back (std::numeric_limits<double>::quiet_NaN ());
+      m_members.push_back (std::vector<Member> ());
+    }
+  else if (!std::isnan (m_lastSample[i]))
+    {
+      // The group is already running: align the new member with the others
+      harvester->SetGroupPower (m_lastSample[i] * scale);
+    }
+  m_members[i].push_back (member);
+
+  // Start the updates at the first registration
+  if (m_updateEvent.IsExpired ())
+    {
+      m_updateEvent = Simulator::ScheduleNow (&VariableEnergyHarvesterGroup::Update, this);
+    }
+}
+
+uint32_t
+VariableEnergyHarvesterGroup::GetNHarvesters (void) const
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_members.size (); i++)
+    {
+      n += m_members[i].size ();
+    }
+  return n;
+}
+
+double
+VariableEnergyHarvesterGroup::GetTracePower (Time time) const
+{
+  NS_ASSERT_MSG (m_statistics.GetNSamples () > 0, "Input power trace is empty!");
+  // One sample per second
+  double t = std::max (0.0, std::floor (time.GetSeconds ()));
+  uint32_t index = t;
+  NS_ASSERT_MSG (index < m_statistics.GetNSamples (),
+                 "Simulated time larger than input power trace!");
+  return m_statistics.GetSample (index);
+}
+
+const HarvestPowerStatistics &
+VariableEnergyHarvesterGroup::GetTraceStatistics (void) const
+{
+  return m_statistics;
+}
+
+void
+VariableEnergyHarvesterGroup::Update (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // do not update if simulation has finished
+  if (Simulator::IsFinished ())
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  for (uint32_t i = 0; i < m_shifts.size (); i++)
+    {
+      double sample = GetTracePower (now + m_shifts[i]);
+      if (sample == m_lastSample[i])
+        {
+          // Nothing changed for the members with this shift
+          continue;
+        }
+      m_lastSample[i] = sample;
+
+      std::vector<Member>::const_iterator it;
+      for (it = m_members[i].begin (); it != m_members[i].end (); ++it)
+        {
+          double power = sample * it->scale;
+          if (power != it->harvester->GetPower ())
+            {
+              it->harvester->SetGroupPower (power);
+            }
+        }
+    }
+
+  m_updateEvent = Simulator::Schedule (m_updateInterval,
+                                       &VariableEnergyHarvesterGroup::Update, this);
+}
+
+void
+VariableEnergyHarvesterGroup::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_updateEvent.Cancel ();
+  m_members.clear ();
+  Object::DoDispose ();
+}
+
+} // namespace ns3
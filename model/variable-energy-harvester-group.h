@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef VARIABLE_ENERGY_HARVESTER_GROUP_H
+#define VARIABLE_ENERGY_HARVESTER_GROUP_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/variable-energy-harvester.h"
+#include "ns3/harvest-power-statistics.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup energy
+ * \brief A set of VariableEnergyHarvester objects sharing the same input trace.
+ *
+ * The trace is read once, and sampled once per update for each distinct time
+ * shift of the members. Each member harvester provides the sampled power
+ * multiplied by its own scaling factor (e.g., to model different panel
+ * areas), and is only notified when the power it provides changes. A single
+ * event per update interval is scheduled for the whole group, instead of one
+ * per harvester.
+ */
+class VariableEnergyHarvesterGroup : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  VariableEnergyHarvesterGroup ();
+  virtual ~VariableEnergyHarvesterGroup ();
+
+  /**
+   * Set the input trace shared by the members of this group.
+   */
+  void SetInputFile (std::string filename);
+
+  /**
+   * \returns The filename of the input trace
+   */
+  std::string GetInputFile (void) const;
+
+  /**
+   * Set the interval between two consecutive evaluations of the trace.
+   */
+  void SetUpdateInterval (Time interval);
+
+  /**
+   * \returns The interval between two consecutive evaluations of the trace.
+   */
+  Time GetUpdateInterval (void) const;
+
+  /**
+   * Add a harvester to this group.
+   *
+   * \param harvester The harvester to drive
+   * \param scale The factor multiplying the power of the trace for this
+   * harvester
+   * \param shift The time shift applied to the trace for this harvester: the
+   * harvester provides at time t the power of the trace at time t + shift
+   *
+   * The PeriodicHarvestedPowerUpdateInterval of the harvester must match the
+   * UpdateInterval of the group, since the group updates all its members.
+   */
+  void AddHarvester (Ptr<VariableEnergyHarvester> harvester, double scale, Time shift);
+
+  /**
+   * \returns The number of harvesters in this group
+   */
+  uint32_t GetNHarvesters (void) const;
+
+  /**
+   * \returns The power of the trace at the given time [W]
+   */
+  double GetTracePower (Time time) const;
+
+  /**
+   * \returns The statistics of the trace, before the scaling and the time
+   * shift of each member
+   */
+  const HarvestPowerStatistics &GetTraceStatistics (void) const;
+
+private:
+  /// Defined in ns3::Object
+  void DoDispose (void);
+
+  /**
+   * Sample the trace and notify the members whose power changed.
+   */
+  void Update (void);
+
+  /**
+   * A harvester in this group
+   */
+  struct Member
+  {
+    Ptr<VariableEnergyHarvester> harvester;
+    double scale;
+  };
+
+  std::string m_filename; // input trace
+  HarvestPowerStatistics m_statistics; // samples of the trace, one per second
+  bool m_traceLoaded; // whether the trace was already read
+
+  // Members are grouped by time shift, so that the trace is only sampled
+  // once per distinct shift
+  std::vector<Time> m_shifts; // distinct time shifts
+  std::vector<double> m_lastSample; // last sample of the trace, per shift
+  std::vector<std::vector<Member> > m_members; // members, per shift
+
+  Time m_updateInterval; // interval between updates
+  EventId m_updateEvent; // next update
+};
+
+} // namespace ns3
+
+#endif /* VARIABLE_ENERGY_HARVESTER_GROUP_H */
@@ -21,11 +21,16 @@
  */
 
 #include "variable-energy-harvester.h"
+#include "ns3/variable-energy-harvester-group.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/log-macros-enabled.h"
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "ns3/pointer.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/simulator.h"
 #include <bits/stdint-uintn.h>
@@ -33,6 +38,9 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -55,8 +63,31 @@ VariableEnergyHarvester::GetTypeId (void)
                  MakeTimeChecker ())
     .AddAttribute ("Filename", "Add description",
                    StringValue ("outputixys.csv"),
-                   MakeStringAccessor(&VariableEnergyHarvester::SetInputFile),
+                   MakeStringAccessor(&VariableEnergyHarvester::SetInputFile,
+                                      &VariableEnergyHarvester::GetInputFile),
                    MakeStringChecker())
+  .AddAttribute ("ForecastFromTrace",
+                 "Whether GetAveragePower forecasts the power from the input trace, "
+                 "or from a time of day profile learnt from the power harvested so far",
+                 BooleanValue (true),
+                 MakeBooleanAccessor (&VariableEnergyHarvester::m_forecastFromTrace),
+                 MakeBooleanChecker ())
+  .AddAttribute ("ProfilePeriod",
+                 "The period of the time of day profile",
+                 TimeValue (Hours (24)),
+                 MakeTimeAccessor (&VariableEnergyHarvester::m_profilePeriod),
+                 MakeTimeChecker (TimeStep (1)))
+  .AddAttribute ("ProfileSlots",
+                 "The number of slots in a period of the time of day profile",
+                 UintegerValue (24),
+                 MakeUintegerAccessor (&VariableEnergyHarvester::m_profileSlots),
+                 MakeUintegerChecker<uint32_t> (1))
+  .AddAttribute ("ProfileSmoothing",
+                 "The weight of the last observation of a slot in its estimate, "
+                 "in (0, 1]",
+                 DoubleValue (0.2),
+                 MakeDoubleAccessor (&VariableEnergyHarvester::m_profileSmoothing),
+                 MakeDoubleChecker<double> (std::numeric_limits<double>::min (), 1))
   .AddTraceSource ("HarvestedPower",
                    "Harvested power by the VariableEnergyHarvester.",
                    MakeTraceSourceAccessor (&VariableEnergyHarvester::m_harvestedPower),
@@ -70,11 +101,15 @@ VariableEnergyHarvester::GetTypeId (void)
 }
 
 VariableEnergyHarvester::VariableEnergyHarvester ()
+  : m_groupScale (1),
+    m_forecastFromTrace (true)
 {
   NS_LOG_FUNCTION (this);
 }
 
 VariableEnergyHarvester::VariableEnergyHarvester (Time updateInterval)
+  : m_groupScale (1),
+    m_forecastFromTrace (true)
 {
   NS_LOG_FUNCTION (this << updateInterval);
   m_harvestedPowerUpdateInterval = updateInterval;
@@ -91,6 +126,46 @@ VariableEnergyHarvester::~VariableEnergyHarvester ()
     m_filename = filename;
   }
 
+std::string
+VariableEnergyHarvester::GetInputFile (void) const
+{
+  return m_filename;
+}
+
+void
+VariableEnergyHarvester::SetGroup (Ptr<VariableEnergyHarvesterGroup> group, double scale,
+                                   Time shift)
+{
+  NS_LOG_FUNCTION (this << group << scale << shift);
+  m_group = group;
+  m_groupScale = scale;
+  m_groupShift = shift;
+  m_energyHarvestingUpdateEvent.Cancel ();
+}
+
+void
+VariableEnergyHarvester::SetGroupPower (double power)
+{
+  NS_LOG_FUNCTION (this << power);
+
+  Time duration = Simulator::Now () - m_lastHarvestingUpdateTime;
+  NS_ASSERT (duration.GetNanoSeconds () >= 0); // check if duration is valid
+
+  // The previous power was constant since the last update
+  m_totalEnergyHarvestedJ += duration.GetSeconds () * m_harvestedPower;
+  if (!m_forecastFromTrace)
+    {
+      m_profile.Add (m_lastHarvestingUpdateTime, Simulator::Now (), m_harvestedPower);
+    }
+
+  m_harvestedPower = power;
+
+  // notify energy source
+  GetEnergySource ()->UpdateEnergySource ();
+
+  m_lastHarvestingUpdateTime = Simulator::Now ();
+}
+
 void
 VariableEnergyHarvester::SetHarvestedPowerUpdateInterval (Time updateInterval)
 {
@@ -113,6 +188,7 @@ void
 VariableEnergyHarvester::UpdateHarvestedPower (void)
 {
   NS_LOG_FUNCTION (this);
+  LORAWAN_PROFILE (HARVESTER_UPDATE);
   NS_LOG_DEBUG (Simulator::Now ().GetSeconds ()
                 << "s VariableEnergyHarvester(" << GetNode ()->GetId () << "): Updating harvesting power.");
 
@@ -131,6 +207,11 @@ VariableEnergyHarvester::UpdateHarvestedPower (void)
 
   m_energyHarvestingUpdateEvent.Cancel ();
 
+  if (!m_forecastFromTrace)
+    {
+      m_profile.Add (m_lastHarvestingUpdateTime, Simulator::Now (), m_harvestedPower);
+    }
+
   CalculateHarvestedPower ();
 
   energyHarvested = duration.GetSeconds () * m_harvestedPower;
@@ -153,10 +234,20 @@ void
 VariableEnergyHarvester::DoInitialize (void)
 {
   NS_LOG_FUNCTION (this);
-  ReadPowerFromFile ();
 
   m_lastHarvestingUpdateTime = Simulator::Now ();
 
+  m_profile.SetSmoothing (m_profileSmoothing);
+  m_profile.SetSlots (m_profilePeriod, m_profileSlots);
+
+  // The group takes care of reading the trace and of the updates
+  if (m_group != 0)
+    {
+      return;
+    }
+
+  ReadPowerFromFile ();
+
   UpdateHarvestedPower ();  // start periodic harvesting update
 }
 
@@ -164,6 +255,10 @@ void
 VariableEnergyHarvester::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_energyHarvestingUpdateEvent.Cancel ();
+  // Break the reference cycle with the group
+  m_group = 0;
+  EnergyHarvester::DoDispose ();
 }
 
 void
@@ -189,11 +284,19 @@ VariableEnergyHarvester::ReadPowerFromFile ()
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("Input file: " << m_filename);
+
+  m_statistics.SetTrace (ReadPowerTrace (m_filename), Seconds (1));
+}
+
+std::vector<double>
+VariableEnergyHarvester::ReadPowerTrace (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
   // Assumption: one sample every second
 
   std::vector<double> power;
   std::string delimiter1 = ",";
-  std::ifstream inputfile (m_filename);
+  std::ifstream inputfile (filename);
   std::string in;
 
   if (inputfile)
@@ -222,21 +325,65 @@ VariableEnergyHarvester::ReadPowerFromFile ()
       NS_LOG_DEBUG ("Input file not found!");
     }
 
-  // NS_LOG_DEBUG("power... " << power[0] << " " << power[1]);
-  m_power = power;
+  return power;
+}
 
-  }
+double
+VariableEnergyHarvester::GetPowerFromFile (Time time)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_statistics.GetNSamples () > 0, "Input power trace is empty!");
+  // One sample per second
+  double t = std::max (0.0, std::floor (time.GetSeconds ()));
+  uint32_t index = t;
+  NS_ASSERT_MSG (index < m_statistics.GetNSamples (),
+                 "Simulated time larger than input power trace!");
+  double power = m_statistics.GetSample (index);
+  NS_LOG_DEBUG ("t: " << t << " s, Power from file is: " << power << " W");
+  return power;
+}
 
-  double
-  VariableEnergyHarvester::GetPowerFromFile (Time time)
-  {
-    NS_LOG_FUNCTION (this);
-    uint8_t t = time.GetSeconds();
-    NS_ASSERT_MSG (m_power.size() > 0, "Input power trace is empty!");
-    NS_ASSERT_MSG (m_power.size() >= t, "Simulated time largest than input power trace!");
-    NS_LOG_DEBUG("t: " << double(t) <<" s, Power from file is: " << m_power[t] << " W");
-    return m_power[t];
-  }
+double
+VariableEnergyHarvester::GetAveragePower (Time time, double samples) const
+{
+  NS_LOG_FUNCTION (this << time << samples);
+
+  Time now = Simulator::Now ();
+  if (!m_forecastFromTrace)
+    {
+      return m_profile.GetExpectedMean (now, now + time);
+    }
+  if (m_group != 0)
+    {
+      Time start = now + m_groupShift;
+      return m_groupScale * m_group->GetTraceStatistics ().GetMean (start, start + time);
+    }
+  return m_statistics.GetMean (now, now + time);
+}
+
+double
+VariableEnergyHarvester::GetExpectedEnergy (Time time) const
+{
+  NS_LOG_FUNCTION (this << time);
+
+  Time now = Simulator::Now ();
+  if (!m_forecastFromTrace)
+    {
+      return m_profile.GetExpectedEnergy (now, now + time);
+    }
+  if (m_group != 0)
+    {
+      Time start = now + m_groupShift;
+      return m_groupScale * m_group->GetTraceStatistics ().GetEnergy (start, start + time);
+    }
+  return m_statistics.GetEnergy (now, now + time);
+}
+
+const HarvestPowerStatistics &
+VariableEnergyHarvester::GetTraceStatistics (void) const
+{
+  return m_statistics;
+}
 
 
 } // namespace ns3
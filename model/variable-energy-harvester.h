@@ -32,9 +32,13 @@
 #include "ns3/energy-harvester.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/device-energy-model.h"
+#include "ns3/harvest-power-statistics.h"
+#include "ns3/harvest-power-profile.h"
 
 namespace ns3 {
 
+class VariableEnergyHarvesterGroup;
+
 /**
  * \ingroup energy
  * TODO Add description
@@ -82,6 +86,71 @@ public:
    */
   void SetInputFile (std::string filename);
 
+  /**
+   * \returns The filename of the input trace
+   */
+  std::string GetInputFile (void) const;
+
+  /**
+   * Let a VariableEnergyHarvesterGroup drive this harvester. The harvester
+   * will neither read its input file nor schedule its own periodic updates,
+   * and will only be updated through SetGroupPower.
+   *
+   * \param group The group this harvester belongs to
+   * \param scale The factor multiplying the power of the group trace
+   * \param shift The time shift applied to the group trace
+   */
+  void SetGroup (Ptr<VariableEnergyHarvesterGroup> group, double scale, Time shift);
+
+  /**
+   * Set the power currently provided by this harvester, and notify the energy
+   * source. Called by the group this harvester belongs to, only when the
+   * power changes.
+   *
+   * \param power The new harvested power [W]
+   */
+  void SetGroupPower (double power);
+
+  /**
+   * Read a power trace file.
+   *
+   * The file has a header line, and the power [W] is in the sixth column of
+   * each following line. One sample per second is assumed.
+   *
+   * \param filename The file to read
+   * \returns The power samples
+   */
+  static std::vector<double> ReadPowerTrace (std::string filename);
+
+  /**
+   * Compute the mean power this harvester is expected to provide from now
+   * until now + time.
+   *
+   * If ForecastFromTrace is set, the forecast is the power of the input
+   * trace, or of the group trace scaled and shifted for this harvester.
+   * Otherwise, it is taken from a time of day profile learnt from the power
+   * harvested so far. Either way, it takes constant time.
+   *
+   * \param time The length of the window
+   * \param samples Unused, since the mean is computed exactly over the window
+   * \returns The expected mean power [W]
+   */
+  double GetAveragePower (Time time, double samples) const;
+
+  /**
+   * \param time The length of the window
+   * \returns The energy this harvester is expected to provide from now until
+   * now + time [J], forecast as in GetAveragePower
+   */
+  double GetExpectedEnergy (Time time) const;
+
+  /**
+   * \returns The statistics of the input trace of this harvester. For a
+   * harvester driven by a group, see
+   * VariableEnergyHarvesterGroup::GetTraceStatistics.
+   */
+  const HarvestPowerStatistics &GetTraceStatistics (void) const;
+
 
 private:
   /// Defined in ns3::Object
@@ -129,7 +198,17 @@ private:
   Time m_harvestedPowerUpdateInterval;          // harvestable energy update interval
 
   std::string m_filename;
-  std::vector<double> m_power;
+  HarvestPowerStatistics m_statistics; // input trace, one sample per second
+
+  Ptr<VariableEnergyHarvesterGroup> m_group; // group driving this harvester, if any
+  double m_groupScale; // scale of the group trace for this harvester
+  Time m_groupShift; // shift of the group trace for this harvester
+
+  bool m_forecastFromTrace; // whether forecasts use the trace or the profile
+  HarvestPowerProfile m_profile; // power harvested so far, by time of day
+  Time m_profilePeriod; // period of the profile
+  uint32_t m_profileSlots; // slots in a period of the profile
+  double m_profileSmoothing; // weight of the last observation of a slot
 
 };
 
@@ -8,6 +8,33 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/lora-statistical-phy.h"
+#include "ns3/capacitor-energy-source.h"
+#include "ns3/capacitor-energy-source-helper.h"
+#include "ns3/capacitor-fleet-energy-manager.h"
+#include "ns3/basic-energy-harvester-helper.h"
+#include "ns3/lora-flight-recorder.h"
+#include "ns3/duration-histogram.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/lora-scenario-helper.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/lora-batch-header.h"
+#include "ns3/lora-frame-info-tag.h"
+#include "ns3/harvest-power-statistics.h"
+#include "ns3/harvest-power-profile.h"
+#include "ns3/energy-gate.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/simple-device-energy-model.h"
+#include "ns3/variable-energy-harvester-helper.h"
+#include "ns3/basic-energy-source-helper.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/lora-packet-pool.h"
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include "utilities.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -239,6 +266,20 @@ public:
 
 private:
   virtual void DoRun (void);
+
+  /**
+   * Send a MAC command alone in a frame header, and check that the received
+   * header holds the same command.
+   *
+   * 
+eturn The command decoded from the received header
+   */
+  Ptr<MacCommand> CheckRoundTrip (Ptr<MacCommand> command, bool isUplink);
+
+  /**
+   * Check that an unknown CID skips the rest of the FOpts field.
+   */
+  void CheckUnknownCid (void);
 };
 
 // Add some help text to this case to describe what it is intended to test
@@ -252,6 +293,103 @@ HeaderTest::~HeaderTest ()
 {
 }
 
+Ptr<MacCommand>
+HeaderTest::CheckRoundTrip (Ptr<MacCommand> command, bool isUplink)
+{
+  LoraFrameHeader frameHdr;
+  if (isUplink)
+    {
+      frameHdr.SetAsUplink ();
+    }
+  else
+    {
+      frameHdr.SetAsDownlink ();
+    }
+  frameHdr.SetFCnt (7);
+  frameHdr.SetAddress (LoraDeviceAddress (12, 3456));
+  frameHdr.AddCommand (command);
+
+  Ptr<Packet> pkt = Create<Packet> (5);
+  pkt->AddHeader (frameHdr);
+  NS_TEST_EXPECT_MSG_EQ (pkt->GetSize (), 5 + 8 + command->GetSerializedSize (),
+                         "Wrong size of a frame with command " << command->GetCommandType ());
+
+  LoraFrameHeader received;
+  if (isUplink)
+    {
+      received.SetAsUplink ();
+    }
+  else
+    {
+      received.SetAsDownlink ();
+    }
+  pkt->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (pkt->GetSize (), 5, "The payload should follow the FOpts field");
+  NS_TEST_EXPECT_MSG_EQ (received.GetFCnt (), 7, "FCnt changes in the serialization/deserialization process");
+  NS_TEST_ASSERT_MSG_EQ (unsigned (received.GetNMacCommands ()), 1, "Wrong number of MAC commands");
+
+  // The stored value has the same type and on-air bytes
+  MacCommandValue expected (command);
+  const MacCommandValue &value = received.GetMacCommandValue (0);
+  NS_TEST_EXPECT_MSG_EQ (value.GetCommandType (), command->GetCommandType (),
+                         "Wrong type of the received command");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (value.GetSerializedSize ()),
+                         unsigned (command->GetSerializedSize ()),
+                         "Wrong size of the received command " << command->GetCommandType ());
+  for (uint8_t i = 0; i + 1 < value.GetSerializedSize (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (value.GetPayload ()[i]),
+                             unsigned (expected.GetPayload ()[i]),
+                             "Wrong byte " << unsigned (i) << " of command "
+                             << command->GetCommandType ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (received.HasMacCommand (command->GetCommandType ()), true,
+                         "The received header should have command " << command->GetCommandType ());
+
+  // The Ptr adapter decodes the same command
+  std::list<Ptr<MacCommand> > commands = received.GetCommands ();
+  NS_TEST_ASSERT_MSG_EQ (commands.size (), 1, "Wrong number of decoded MAC commands");
+  Ptr<MacCommand> decoded = commands.front ();
+  NS_TEST_EXPECT_MSG_EQ (decoded->GetCommandType (), command->GetCommandType (),
+                         "Wrong type of the decoded command");
+  MacCommandValue reencoded (decoded);
+  for (uint8_t i = 0; i + 1 < value.GetSerializedSize (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (reencoded.GetPayload ()[i]),
+                             unsigned (expected.GetPayload ()[i]),
+                             "Wrong byte " << unsigned (i) << " of decoded command "
+                             << command->GetCommandType ());
+    }
+  return decoded;
+}
+
+void
+HeaderTest::CheckUnknownCid (void)
+{
+  // DevAddr, FCtrl with FOptsLen = 4, FCnt, then a LinkCheckReq, the unknown
+  // CID 0x80 with two bytes, FPort and a payload of 3 bytes
+  uint8_t bytes[] = {0x00, 0x00, 0x30, 0x39, 0x04, 0x00, 0x07,
+                     0x02, 0x80, 0xab, 0xcd,
+                     0x05, 0x11, 0x22, 0x33};
+  Ptr<Packet> pkt = Create<Packet> (bytes, sizeof (bytes));
+
+  LoraFrameHeader received;
+  received.SetAsUplink ();
+  pkt->RemoveHeader (received);
+
+  NS_TEST_EXPECT_MSG_EQ (unsigned (received.GetNMacCommands ()), 1,
+                         "Only the command before the unknown CID should be kept");
+  NS_TEST_EXPECT_MSG_EQ (received.HasMacCommand (LINK_CHECK_REQ), true,
+                         "The command before the unknown CID was lost");
+  NS_TEST_EXPECT_MSG_EQ (received.GetCommands ().size (), 1, "Wrong number of decoded MAC commands");
+  NS_TEST_EXPECT_MSG_EQ (received.GetFCnt (), 7, "Wrong FCnt");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (received.GetFPort ()), 5, "The FPort was read from FOpts");
+  NS_TEST_EXPECT_MSG_EQ (pkt->GetSize (), 3, "The whole FOpts field should be consumed");
+  uint8_t payload[3];
+  pkt->CopyData (payload, 3);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (payload[0]), 0x11, "The payload was shifted");
+}
+
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
@@ -343,6 +481,54 @@ HeaderTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((frameHdr1.GetAddress () == frameHdr.GetAddress ()),true, "Removed header contents don't match");
   NS_TEST_EXPECT_MSG_EQ (linkCheckAns->GetMargin (), 10, "Removed header's MAC command contents don't match");
   NS_TEST_EXPECT_MSG_EQ (linkCheckAns->GetGwCnt (), 1, "Removed header's MAC command contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (frameHdr1.GetNMacCommands ()), 1, "Wrong number of MAC commands");
+  NS_TEST_EXPECT_MSG_EQ (frameHdr1.HasMacCommand (LINK_CHECK_ANS), true, "LinkCheckAns not found in removed header");
+  NS_TEST_EXPECT_MSG_EQ (frameHdr1.HasMacCommand (LINK_CHECK_REQ), false, "Unexpected LinkCheckReq in removed header");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (frameHdr1.GetMacCommandValue (0).GetPayload ()[0]), 10, "Removed header's MAC command value doesn't match");
+
+  ////////////////////////////////////////////
+  // Round trip of each type of MAC command //
+  ////////////////////////////////////////////
+  // Uplink commands
+  CheckRoundTrip (Create<LinkCheckReq> (), true);
+  CheckRoundTrip (Create<LinkAdrAns> (true, false, true), true);
+  CheckRoundTrip (Create<DutyCycleAns> (), true);
+  CheckRoundTrip (Create<RxParamSetupAns> (true, true, false), true);
+  Ptr<DevStatusAns> devStatusAns =
+    DynamicCast<DevStatusAns> (CheckRoundTrip (Create<DevStatusAns> (200, 17), true));
+  NS_TEST_EXPECT_MSG_EQ (unsigned (devStatusAns->GetBattery ()), 200, "Wrong battery level");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (devStatusAns->GetMargin ()), 17, "Wrong margin");
+  CheckRoundTrip (Create<NewChannelAns> (false, true), true);
+  CheckRoundTrip (Create<RxTimingSetupAns> (), true);
+  CheckRoundTrip (Create<TxParamSetupAns> (), true);
+  CheckRoundTrip (Create<DlChannelAns> (), true);
+
+  // Downlink commands
+  Ptr<LinkCheckAns> checkAns =
+    DynamicCast<LinkCheckAns> (CheckRoundTrip (Create<LinkCheckAns> (12, 3), false));
+  NS_TEST_EXPECT_MSG_EQ (unsigned (checkAns->GetMargin ()), 12, "Wrong margin");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (checkAns->GetGwCnt ()), 3, "Wrong number of gateways");
+  Ptr<LinkAdrReq> adrReq =
+    DynamicCast<LinkAdrReq> (CheckRoundTrip (Create<LinkAdrReq> (3, 2, 0x0007, 0, 1), false));
+  NS_TEST_EXPECT_MSG_EQ (unsigned (adrReq->GetDataRate ()), 3, "Wrong data rate");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (adrReq->GetTxPower ()), 2, "Wrong tx power");
+  CheckRoundTrip (Create<DutyCycleReq> (4), false);
+  Ptr<RxParamSetupReq> rxParamReq = DynamicCast<RxParamSetupReq>
+    (CheckRoundTrip (Create<RxParamSetupReq> (2, 5, 869525000), false));
+  NS_TEST_EXPECT_MSG_EQ (unsigned (rxParamReq->GetRx1DrOffset ()), 2, "Wrong RX1 offset");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (rxParamReq->GetRx2DataRate ()), 5, "Wrong RX2 data rate");
+  NS_TEST_EXPECT_MSG_EQ (rxParamReq->GetFrequency (), 869525000, "Wrong RX2 frequency");
+  CheckRoundTrip (Create<DevStatusReq> (), false);
+  Ptr<NewChannelReq> newChannelReq = DynamicCast<NewChannelReq>
+    (CheckRoundTrip (Create<NewChannelReq> (3, 867100000, 0, 5), false));
+  NS_TEST_EXPECT_MSG_EQ (unsigned (newChannelReq->GetChannelIndex ()), 3, "Wrong channel index");
+  NS_TEST_EXPECT_MSG_EQ (newChannelReq->GetFrequency (), 867100000, "Wrong frequency");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (newChannelReq->GetMinDataRate ()), 0, "Wrong min data rate");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (newChannelReq->GetMaxDataRate ()), 5, "Wrong max data rate");
+  CheckRoundTrip (Create<RxTimingSetupReq> (3), false);
+  CheckRoundTrip (Create<TxParamSetupReq> (), false);
+
+  CheckUnknownCid ();
 }
 
 /*******************
@@ -1301,8 +1487,18 @@ public:
   LorawanMacTest ();
   virtual ~LorawanMacTest ();
 
+  void ReceivedPacketAtGateway (Ptr<const Packet> packet);
+
 private:
   virtual void DoRun (void);
+
+  /**
+   * Retransmit a confirmed uplink whose ACK is lost with packet tracking
+   * enabled, and check that the trackers see a single packet.
+   */
+  void CheckTracking (void);
+
+  std::vector<Ptr<Packet> > m_receivedPackets;
 };
 
 // Add some help text to this case to describe what it is intended to test
@@ -1316,6 +1512,12 @@ LorawanMacTest::~LorawanMacTest ()
 {
 }
 
+void
+LorawanMacTest::ReceivedPacketAtGateway (Ptr<const Packet> packet)
+{
+  m_receivedPackets.push_back (packet->Copy ());
+}
+
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
@@ -1323,6 +1525,2455 @@ LorawanMacTest::DoRun (void)
 {
   NS_LOG_DEBUG ("LorawanMacTest");
 
+  // A device and a gateway without a Network Server, so that confirmed
+  // uplinks are never acknowledged and are retransmitted
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (1, mobility, channel);
+  NodeContainer gateways = CreateGateways (1, mobility, channel);
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+  LorawanMacHelper::SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  uint8_t maxTransmissions = 3;
+  Ptr<EndDeviceLorawanMac> edMac = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0));
+  edMac->SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  edMac->SetAttribute ("MaxTransmissions", IntegerValue (maxTransmissions));
+
+  GetMacLayerFromNode<GatewayLorawanMac> (gateways.Get (0))->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&LorawanMacTest::ReceivedPacketAtGateway, this));
+
+  uint8_t payload[20];
+  for (uint8_t i = 0; i < sizeof (payload); i++)
+    {
+      payload[i] = i;
+    }
+  Simulator::Schedule (Seconds (1), &NetDevice::Send, endDevices.Get (0)->GetDevice (0),
+                       Create<Packet> (payload, sizeof (payload)), Address (), 0);
+
+  Simulator::Stop (Seconds (600));
+  Simulator::Run ();
+  LoraDeviceAddress address = edMac->GetDeviceAddress ();
+  Simulator::Destroy ();
+
+  // Each attempt carries the headers serialized for it, and the payload of
+  // the first attempt
+  NS_TEST_ASSERT_MSG_EQ (m_receivedPackets.size (), maxTransmissions,
+                         "The gateway should receive every attempt");
+  for (uint32_t i = 0; i < m_receivedPackets.size (); i++)
+    {
+      Ptr<Packet> packet = m_receivedPackets[i];
+      LorawanMacHeader macHdr;
+      packet->RemoveHeader (macHdr);
+      LoraFrameHeader frameHdr;
+      frameHdr.SetAsUplink ();
+      packet->RemoveHeader (frameHdr);
+
+      NS_TEST_EXPECT_MSG_EQ (unsigned (macHdr.GetMType ()),
+                             unsigned (LorawanMacHeader::CONFIRMED_DATA_UP),
+                             "Attempt " << i << " has the wrong message type");
+      NS_TEST_EXPECT_MSG_EQ (frameHdr.GetAddress (), address,
+                             "Attempt " << i << " has the wrong address");
+      NS_TEST_EXPECT_MSG_EQ (frameHdr.GetFCnt (), i + 1,
+                             "Attempt " << i << " has the wrong frame counter");
+
+      uint8_t received[sizeof (payload)];
+      NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), sizeof (payload),
+                             "Attempt " << i << " has the wrong payload size");
+      packet->CopyData (received, sizeof (received));
+      NS_TEST_EXPECT_MSG_EQ (std::equal (payload, payload + sizeof (payload), received), true,
+                             "Attempt " << i << " has the wrong payload");
+    }
+
+  CheckTracking ();
+}
+
+void
+LorawanMacTest::CheckTracking (void)
+{
+  // The same deployment, with packet tracking. The ACK is lost, since there
+  // is no Network Server to send it.
+  Ptr<LoraChannel> channel = CreateChannel ();
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper;
+  LoraHelper helper;
+  helper.EnablePacketTracking ();
+
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  NodeContainer gateways;
+  gateways.Create (1);
+  mobility.Install (gateways);
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+  LorawanMacHelper::SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  Ptr<EndDeviceLorawanMac> edMac = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0));
+  edMac->SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  edMac->SetAttribute ("MaxTransmissions", IntegerValue (3));
+
+  Simulator::Schedule (Seconds (1), &NetDevice::Send, endDevices.Get (0)->GetDevice (0),
+                       Create<Packet> (20), Address (), 0);
+
+  // The tracker aborts if the gateway receives a packet it was not told about
+  Simulator::Stop (Seconds (600));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  LoraPacketTracker &tracker = helper.GetPacketTracker ();
+  NS_TEST_EXPECT_MSG_EQ (tracker.CountMacPacketsGlobally (Seconds (0), Seconds (600)),
+                         "1.000000 1.000000",
+                         "The retransmissions should be tracked as the first attempt");
+  std::vector<int> phyCounts = tracker.CountPhyPacketsPerGw (Seconds (0), Seconds (600),
+                                                             gateways.Get (0)->GetId ());
+  NS_TEST_EXPECT_MSG_EQ (phyCounts[0], 1, "The PHY tracker should count a single packet");
+  NS_TEST_EXPECT_MSG_EQ (phyCounts[1], 1, "The packet should be received by the gateway");
+}
+
+/**************************
+ * StatisticalPhyTest *
+ **************************/
+
+class StatisticalPhyTest : public TestCase
+{
+public:
+  StatisticalPhyTest ();
+  virtual ~StatisticalPhyTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+StatisticalPhyTest::StatisticalPhyTest ()
+  : TestCase ("Verify that LoraStatisticalPhy and a full simulation of the same"
+              " deployment deliver the same fraction of packets")
+{
+}
+
+// Reminder that the test case should clean up after itself
+StatisticalPhyTest::~StatisticalPhyTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+StatisticalPhyTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("StatisticalPhyTest");
+
+  // The deployment of aloha-throughput: SF7 devices on a single channel,
+  // around a gateway with a single reception path, with an offered load
+  // high enough for collisions to matter
+  int nDevices = 100;
+  Time period = Seconds (100);
+  Time duration = Seconds (1000);
+  uint8_t packetSize = 150;
+
+  LoraInterferenceHelper::CollisionMatrix collisionMatrix =
+    LoraInterferenceHelper::collisionMatrix;
+  LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel>
+      (loss, CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper;
+  macHelper.SetRegion (LorawanMacHelper::ALOHA);
+  LoraHelper helper;
+  helper.EnablePacketTracking ();
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator", "rho", DoubleValue (1000),
+                                 "X", DoubleValue (0.0), "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  NodeContainer gateways;
+  gateways.Create (1);
+  mobility.Install (gateways);
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 15));
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  // The statistical PHY sees the devices as the gateway does
+  Ptr<LoraStatisticalPhy> statPhy = CreateObjectWithAttributes<LoraStatisticalPhy>
+      ("Period", TimeValue (period), "PacketSize", UintegerValue (packetSize));
+  statPhy->AddChannel (868.1);
+  statPhy->AddReceptionPath (868.1);
+  Ptr<MobilityModel> gwMobility = gateways.Get (0)->GetObject<MobilityModel> ();
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      GetMacLayerFromNode<EndDeviceLorawanMac> (*j)->SetDataRate (5);
+      double rxPower = loss->CalcRxPower (14, (*j)->GetObject<MobilityModel> (), gwMobility);
+      statPhy->AddTransmitter (7, rxPower);
+    }
+  std::vector<int> statCounts = statPhy->Run (duration);
+
+  PeriodicSenderHelper appHelper;
+  appHelper.SetPeriod (period);
+  appHelper.SetPacketSize (packetSize);
+  ApplicationContainer apps = appHelper.Install (endDevices);
+  apps.Start (Seconds (0));
+  apps.Stop (duration);
+
+  Simulator::Stop (duration + Hours (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<int> simCounts = helper.GetPacketTracker ().CountPhyPacketsPerGw
+      (Seconds (0), duration + Hours (1), gateways.Get (0)->GetId ());
+
+  LoraInterferenceHelper::collisionMatrix = collisionMatrix;
+
+  NS_TEST_ASSERT_MSG_GT (simCounts[0], 0, "The devices of the full simulation sent nothing");
+  NS_TEST_ASSERT_MSG_GT (statCounts[0], 0, "The devices of the statistical PHY sent nothing");
+  double simPdr = double (simCounts[1]) / simCounts[0];
+  double statPdr = double (statCounts[1]) / statCounts[0];
+  NS_LOG_DEBUG ("PDR: " << simPdr << " simulated, " << statPdr << " statistical");
+
+  // About 1000 packets each: the two estimates differ by a few percent
+  NS_TEST_EXPECT_MSG_EQ_TOL (statPdr, simPdr, 0.05,
+                             "The statistical PHY and the full simulation disagree");
+}
+
+/******************************
+ * CapacitorThresholdTest *
+ ******************************/
+
+class CapacitorThresholdTest : public TestCase
+{
+public:
+  CapacitorThresholdTest ();
+  virtual ~CapacitorThresholdTest ();
+
+  void Subscribe (Ptr<CapacitorEnergySource> source);
+  void VoltageCrossed (double voltage);
+  void EnergyCrossed (double energy);
+  void UnreachableCrossed (double voltage);
+  void SubscribeFirstFalling (Ptr<CapacitorEnergySource> source);
+  void SubscribeSecondFalling (Ptr<CapacitorEnergySource> source);
+  void FirstFallingCrossed (double voltage);
+  void SecondFallingCrossed (double voltage);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Discharge a capacitor through the PHY of a device, with a load change
+   * between two subscriptions to falling thresholds.
+   */
+  void CheckDischarge (void);
+
+  /**
+   * Record the crossing of a threshold.
+   */
+  void Crossed (uint32_t index, double value);
+
+  /**
+   * Integrate the voltage of the capacitor in small steps from the time of
+   * the subscriptions, and return the time it reaches the given voltage.
+   */
+  Time Integrate (double threshold) const;
+
+  /**
+   * Integrate the voltage of the discharge case in small steps from time 0,
+   * and return the time it falls to the given voltage.
+   */
+  Time IntegrateDischarge (double threshold) const;
+
+  double m_capacitance;
+  double m_supplyVoltage;
+  double m_power;
+
+  double m_dischargeCapacitance;
+  double m_initialVoltage;
+  double m_sleepCurrent;
+  double m_standbyCurrent;
+  Time m_loadChangeTime;
+
+  Time m_subscriptionTime;
+  double m_subscriptionVoltage;
+  std::vector<Time> m_crossingTimes;
+  std::vector<double> m_crossingValues;
+};
+
+// Add some help text to this case to describe what it is intended to test
+CapacitorThresholdTest::CapacitorThresholdTest ()
+  : TestCase ("Verify that CapacitorEnergySource notifies threshold crossings"
+              " when a stepped integration of the voltage crosses them"),
+    m_capacitance (0.01),
+    m_supplyVoltage (3.3),
+    m_power (0.001),
+    m_dischargeCapacitance (0.1),
+    m_initialVoltage (3),
+    m_sleepCurrent (1e-6),
+    m_standbyCurrent (0.01),
+    m_loadChangeTime (Seconds (2))
+{
+}
+
+// Reminder that the test case should clean up after itself
+CapacitorThresholdTest::~CapacitorThresholdTest ()
+{
+}
+
+void
+CapacitorThresholdTest::Subscribe (Ptr<CapacitorEnergySource> source)
+{
+  m_subscriptionTime = Simulator::Now ();
+  m_subscriptionVoltage = source->GetActualVoltage ();
+
+  source->SubscribeVoltageThreshold
+    (2.0, true, MakeCallback (&CapacitorThresholdTest::VoltageCrossed, this));
+  source->SubscribeEnergyThreshold
+    (m_capacitance * 2.5 * 2.5 / 2, true,
+    MakeCallback (&CapacitorThresholdTest::EnergyCrossed, this));
+  // Beyond the asymptotic voltage: never crossed
+  source->SubscribeVoltageThreshold
+    (3.4, true, MakeCallback (&CapacitorThresholdTest::UnreachableCrossed, this));
+}
+
+void
+CapacitorThresholdTest::VoltageCrossed (double voltage)
+{
+  Crossed (0, voltage);
+}
+
+void
+CapacitorThresholdTest::EnergyCrossed (double energy)
+{
+  Crossed (1, energy);
+}
+
+void
+CapacitorThresholdTest::UnreachableCrossed (double voltage)
+{
+  Crossed (2, voltage);
+}
+
+void
+CapacitorThresholdTest::SubscribeFirstFalling (Ptr<CapacitorEnergySource> source)
+{
+  source->SubscribeVoltageThreshold
+    (2.5, false, MakeCallback (&CapacitorThresholdTest::FirstFallingCrossed, this));
+}
+
+void
+CapacitorThresholdTest::SubscribeSecondFalling (Ptr<CapacitorEnergySource> source)
+{
+  source->SubscribeVoltageThreshold
+    (2.0, false, MakeCallback (&CapacitorThresholdTest::SecondFallingCrossed, this));
+}
+
+void
+CapacitorThresholdTest::FirstFallingCrossed (double voltage)
+{
+  Crossed (3, voltage);
+}
+
+void
+CapacitorThresholdTest::SecondFallingCrossed (double voltage)
+{
+  Crossed (4, voltage);
+}
+
+void
+CapacitorThresholdTest::Crossed (uint32_t index, double value)
+{
+  NS_LOG_DEBUG ("Threshold " << index << " crossed with " << value);
+  m_crossingTimes[index] = Simulator::Now ();
+  m_crossingValues[index] = value;
+}
+
+Time
+CapacitorThresholdTest::Integrate (double threshold) const
+{
+  // C dv/dt = hp / V - v hp / V^2, for a harvester and no load
+  double dt = 1e-4;
+  double v = m_subscriptionVoltage;
+  double t = 0;
+  while (v < threshold)
+    {
+      v += dt * (m_power / m_supplyVoltage
+                 - v * m_power / (m_supplyVoltage * m_supplyVoltage)) / m_capacitance;
+      t += dt;
+    }
+  return m_subscriptionTime + Seconds (t);
+}
+
+Time
+CapacitorThresholdTest::IntegrateDischarge (double threshold) const
+{
+  // C dv/dt = hp / V - v hp / V^2 - v I / V, with the sleep current before
+  // the load change and the standby current after it
+  double dt = 1e-4;
+  double v = m_initialVoltage;
+  double t = 0;
+  while (v > threshold)
+    {
+      double current = t < m_loadChangeTime.GetSeconds () ? m_sleepCurrent : m_standbyCurrent;
+      v += dt * (m_power / m_supplyVoltage
+                 - v * m_power / (m_supplyVoltage * m_supplyVoltage)
+                 - v * current / m_supplyVoltage) / m_dischargeCapacitance;
+      t += dt;
+    }
+  return Seconds (t);
+}
+
+void
+CapacitorThresholdTest::CheckDischarge (void)
+{
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (1, mobility, channel);
+  Ptr<LoraNetDevice> device = endDevices.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ();
+  Ptr<EndDeviceLoraPhy> phy = device->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
+
+  // The initial voltage is drawn when the source is constructed
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::ConstantRandomVariable[Constant=" +
+                                   std::to_string (m_initialVoltage) + "]"));
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (m_dischargeCapacitance));
+  capacitorHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (m_supplyVoltage));
+  capacitorHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (0.3));
+  capacitorHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (Seconds (7)));
+  EnergySourceContainer sources = capacitorHelper.Install (endDevices);
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=0.0]"));
+  Ptr<CapacitorEnergySource> source = sources.Get (0)->GetObject<CapacitorEnergySource> ();
+
+  BasicEnergyHarvesterHelper harvesterHelper;
+  harvesterHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (10)));
+  harvesterHelper.Set ("HarvestablePower",
+                       StringValue ("ns3::ConstantRandomVariable[Constant=" +
+                                    std::to_string (m_power) + "]"));
+  EnergyHarvesterContainer harvesters = harvesterHelper.Install (sources);
+  harvesters.Get (0)->Initialize ();
+
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Set ("SleepCurrentA", DoubleValue (m_sleepCurrent));
+  radioEnergy.Set ("StandbyCurrentA", DoubleValue (m_standbyCurrent));
+  radioEnergy.Install (NetDeviceContainer (device), sources);
+
+  // The first threshold is out of reach while sleeping, and is re-solved at
+  // the load change. The second one is subscribed after it.
+  Simulator::Schedule (Seconds (1), &CapacitorThresholdTest::SubscribeFirstFalling, this,
+                       source);
+  Simulator::Schedule (m_loadChangeTime, &EndDeviceLoraPhy::SwitchToStandby, phy);
+  Simulator::Schedule (Seconds (4.5), &CapacitorThresholdTest::SubscribeSecondFalling, this,
+                       source);
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Time expected = IntegrateDischarge (2.5);
+  NS_LOG_DEBUG ("First falling threshold: expected at " << expected.GetSeconds () <<
+                " s, notified at " << m_crossingTimes[3].GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingTimes[3].GetSeconds (), expected.GetSeconds (), 0.01,
+                             "The threshold subscribed before the load change was notified"
+                             " at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingValues[3], 2.5, 1e-3,
+                             "The callback should receive the voltage at the crossing");
+
+  expected = IntegrateDischarge (2.0);
+  NS_LOG_DEBUG ("Second falling threshold: expected at " << expected.GetSeconds () <<
+                " s, notified at " << m_crossingTimes[4].GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingTimes[4].GetSeconds (), expected.GetSeconds (), 0.01,
+                             "The threshold subscribed after the load change was notified"
+                             " at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingValues[4], 2.0, 1e-3,
+                             "The callback should receive the voltage at the crossing");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CapacitorThresholdTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CapacitorThresholdTest");
+
+  m_crossingTimes.assign (5, Seconds (-1));
+  m_crossingValues.assign (5, 0);
+
+  NodeContainer nodes;
+  nodes.Create (1);
+
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (m_capacitance));
+  capacitorHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (m_supplyVoltage));
+  capacitorHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (Seconds (7)));
+  EnergySourceContainer sources = capacitorHelper.Install (nodes);
+  Ptr<CapacitorEnergySource> source = sources.Get (0)->GetObject<CapacitorEnergySource> ();
+
+  BasicEnergyHarvesterHelper harvesterHelper;
+  harvesterHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (10)));
+  harvesterHelper.Set ("HarvestablePower",
+                       StringValue ("ns3::ConstantRandomVariable[Constant=" +
+                                    std::to_string (m_power) + "]"));
+  EnergyHarvesterContainer harvesters = harvesterHelper.Install (sources);
+  harvesters.Get (0)->Initialize ();
+
+  // The periodic updates of the source and of the harvester re-solve the
+  // crossing times in between
+  Simulator::Schedule (Seconds (1), &CapacitorThresholdTest::Subscribe, this, source);
+
+  Simulator::Stop (Seconds (1000));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Time expected = Integrate (2.0);
+  NS_LOG_DEBUG ("Voltage threshold: expected at " << expected.GetSeconds () <<
+                " s, notified at " << m_crossingTimes[0].GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingTimes[0].GetSeconds (), expected.GetSeconds (), 0.01,
+                             "The voltage threshold was notified at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingValues[0], 2.0, 1e-3,
+                             "The callback should receive the voltage at the crossing");
+
+  expected = Integrate (2.5);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingTimes[1].GetSeconds (), expected.GetSeconds (), 0.01,
+                             "The energy threshold was notified at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_crossingValues[1], m_capacitance * 2.5 * 2.5 / 2, 1e-5,
+                             "The callback should receive the energy at the crossing");
+
+  NS_TEST_EXPECT_MSG_EQ (m_crossingTimes[2].IsNegative (), true,
+                         "A threshold above the asymptotic voltage should never be crossed");
+
+  CheckDischarge ();
+}
+
+/***************************
+ * FlightRecorderTest *
+ ***************************/
+
+class FlightRecorderTest : public TestCase
+{
+public:
+  FlightRecorderTest ();
+  virtual ~FlightRecorderTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+FlightRecorderTest::FlightRecorderTest ()
+  : TestCase ("Verify that LoraFlightRecorder keeps the last records of its ring,"
+              " and that Decode prints what Dump wrote")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FlightRecorderTest::~FlightRecorderTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FlightRecorderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FlightRecorderTest");
+
+  // Six records in a ring of four: the first two are overwritten
+  LoraFlightRecorder::Enable (4);
+  double sinrDb[6] = {1, 2, 3, 4, 5, 6};
+  Simulator::Schedule (Seconds (1), &LoraFlightRecorder::RecordTxStart, 1, 7, 868.1, 14);
+  Simulator::Schedule (Seconds (2), &LoraFlightRecorder::RecordRxLock, 2, 7, 868.1, -100.5);
+  Simulator::Schedule (Seconds (3), &LoraFlightRecorder::RecordStateChange, 1,
+                       uint8_t (EndDeviceLoraPhy::STANDBY));
+  Simulator::Schedule (Seconds (4), &LoraFlightRecorder::RecordInterferenceVerdict, 2, 9,
+                       868.3, -110.25, 7, sinrDb);
+  Simulator::Schedule (Seconds (5), &LoraFlightRecorder::RecordEnergyDepleted, 3, 1.8);
+  Simulator::Schedule (Seconds (6), &LoraFlightRecorder::RecordNoMoreDemodulators, 2, 12,
+                       868.5, -120);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  LoraFlightRecorder::Disable ();
+
+  std::string filename = CreateTempDirFilename ("flight-recorder.bin");
+  uint32_t dumped = LoraFlightRecorder::Dump (filename);
+  NS_TEST_ASSERT_MSG_EQ (dumped, 4, "The dump should hold the last four records");
+
+  std::ostringstream os;
+  os.precision (2);
+  uint32_t decoded = LoraFlightRecorder::Decode (filename, os);
+  NS_TEST_EXPECT_MSG_EQ (decoded, dumped, "Decode should print every record of the dump");
+  NS_TEST_EXPECT_MSG_EQ (os.precision (), 2, "Decode should restore the precision of the stream");
+  NS_TEST_EXPECT_MSG_EQ (os.str (),
+                         "3.000000000s node 1 STATE_CHANGE STANDBY\n"
+                         "4.000000000s node 2 INTERFERENCE_VERDICT sf 9 freq 868.300"
+                         " power -110.250 destroyedBy 7 sinr 7:1.000 8:2.000 9:3.000"
+                         " 10:4.000 11:5.000 12:6.000\n"
+                         "5.000000000s node 3 ENERGY_DEPLETED voltage 1.800\n"
+                         "6.000000000s node 2 NO_MORE_DEMODULATORS sf 12 freq 868.500"
+                         " power -120.000\n",
+                         "The decoded records differ from the recorded ones");
+}
+
+/*****************************
+ * EnergyStatisticsTest *
+ *****************************/
+
+class EnergyStatisticsTest : public TestCase
+{
+public:
+  EnergyStatisticsTest ();
+  virtual ~EnergyStatisticsTest ();
+
+  void CheckRadio (Ptr<LoraRadioEnergyModel> radio);
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+EnergyStatisticsTest::EnergyStatisticsTest ()
+  : TestCase ("Verify DurationHistogram and the time and energy LoraRadioEnergyModel"
+              " keeps for each state")
+{
+}
+
+// Reminder that the test case should clean up after itself
+EnergyStatisticsTest::~EnergyStatisticsTest ()
+{
+}
+
+void
+EnergyStatisticsTest::CheckRadio (Ptr<LoraRadioEnergyModel> radio)
+{
+  // SLEEP [0, 1), STANDBY [1, 1.5), TX [1.5, 2.5), SLEEP [2.5, 3), OFF [3, 10),
+  // then SLEEP from now on
+  double voltage = 3;
+  NS_TEST_EXPECT_MSG_EQ (radio->GetTimeInState (EndDeviceLoraPhy::SLEEP), Seconds (1.5),
+                         "Wrong time in SLEEP");
+  NS_TEST_EXPECT_MSG_EQ (radio->GetTimeInState (EndDeviceLoraPhy::STANDBY), Seconds (0.5),
+                         "Wrong time in STANDBY");
+  NS_TEST_EXPECT_MSG_EQ (radio->GetTimeInState (EndDeviceLoraPhy::TX), Seconds (1),
+                         "Wrong time in TX");
+  NS_TEST_EXPECT_MSG_EQ (radio->GetTimeInState (EndDeviceLoraPhy::OFF), Seconds (7),
+                         "Wrong time in OFF");
+  NS_TEST_EXPECT_MSG_EQ (radio->GetTimeInState (EndDeviceLoraPhy::RX), Seconds (0),
+                         "Wrong time in RX");
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (radio->GetEnergyInState (EndDeviceLoraPhy::SLEEP),
+                             1.5 * 0.001 * voltage, 1e-12, "Wrong energy in SLEEP");
+  NS_TEST_EXPECT_MSG_EQ_TOL (radio->GetEnergyInState (EndDeviceLoraPhy::STANDBY),
+                             0.5 * 0.01 * voltage, 1e-12, "Wrong energy in STANDBY");
+  NS_TEST_EXPECT_MSG_EQ_TOL (radio->GetEnergyInState (EndDeviceLoraPhy::TX),
+                             1 * 0.03 * voltage, 1e-12, "Wrong energy in TX");
+  NS_TEST_EXPECT_MSG_EQ_TOL (radio->GetEnergyInState (EndDeviceLoraPhy::OFF),
+                             7 * 0.0001 * voltage, 1e-12, "Wrong energy in OFF");
+
+  const DurationHistogram &offTimes = radio->GetOffTimeHistogram ();
+  NS_TEST_EXPECT_MSG_EQ (offTimes.GetTotalCount (), 1, "There was one OFF period");
+  NS_TEST_EXPECT_MSG_EQ (offTimes.GetMax (), Seconds (7), "The OFF period lasted 7 s");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EnergyStatisticsTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("EnergyStatisticsTest");
+
+  // Bins of 10 s, the last one counting the longer durations
+  DurationHistogram histogram (Seconds (10), 3);
+  histogram.Add (Seconds (0));
+  histogram.Add (Seconds (5));
+  histogram.Add (Seconds (15));
+  histogram.Add (Seconds (100));
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (0), 2, "Wrong count in the first bin");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (1), 1, "Wrong count in the second bin");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (2), 1,
+                         "The last bin should count the longer durations");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetTotalCount (), 4, "Wrong number of durations");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetTotal (), Seconds (120), "Wrong sum of the durations");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMax (), Seconds (100), "Wrong longest duration");
+
+  std::ostringstream os;
+  histogram.Print (os);
+  NS_TEST_EXPECT_MSG_EQ (os.str (), "0: 2 10: 1 20+: 1", "Wrong printed histogram");
+
+  DurationHistogram other (Seconds (10), 3);
+  other.Add (Seconds (25));
+  NS_TEST_ASSERT_MSG_EQ (histogram.HasSameBins (other), true, "The bins are the same");
+  histogram.Merge (other);
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (2), 2, "Merge should add the counts");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetTotalCount (), 5, "Merge should add the durations");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetTotal (), Seconds (145), "Merge should add the sums");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMax (), Seconds (100), "Merge should keep the maximum");
+
+  NS_TEST_EXPECT_MSG_EQ (histogram.HasSameBins (DurationHistogram (Seconds (5), 3)), false,
+                         "The bins have a different width");
+  NS_TEST_EXPECT_MSG_EQ (histogram.HasSameBins (DurationHistogram (Seconds (10), 4)), false,
+                         "The bins are a different number");
+
+  // Drive a radio through its states, as its PHY listener would
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  source->SetSupplyVoltage (3);
+  Ptr<LoraRadioEnergyModel> radio = CreateObject<LoraRadioEnergyModel> ();
+  radio->SetEnergySource (source);
+  radio->SetSleepCurrentA (0.001);
+  radio->SetStandbyCurrentA (0.01);
+  radio->SetTxCurrentA (0.03);
+  radio->SetOffCurrentA (0.0001);
+
+  Simulator::Schedule (Seconds (1), &LoraRadioEnergyModel::ChangeState, radio,
+                       int (EndDeviceLoraPhy::STANDBY));
+  Simulator::Schedule (Seconds (1.5), &LoraRadioEnergyModel::ChangeState, radio,
+                       int (EndDeviceLoraPhy::TX));
+  Simulator::Schedule (Seconds (2.5), &LoraRadioEnergyModel::ChangeState, radio,
+                       int (EndDeviceLoraPhy::SLEEP));
+  Simulator::Schedule (Seconds (3), &LoraRadioEnergyModel::ChangeState, radio,
+                       int (EndDeviceLoraPhy::OFF));
+  Simulator::Schedule (Seconds (10), &LoraRadioEnergyModel::ChangeState, radio,
+                       int (EndDeviceLoraPhy::SLEEP));
+  Simulator::Schedule (Seconds (10), &EnergyStatisticsTest::CheckRadio, this, radio);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/***************************
+ * ScenarioLoaderTest *
+ ***************************/
+
+class ScenarioLoaderTest : public TestCase
+{
+public:
+  ScenarioLoaderTest ();
+  virtual ~ScenarioLoaderTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Write a scenario file in the temporary directory of the test.
+   */
+  std::string WriteScenario (std::string name, std::string contents);
+
+  /**
+   * Check that loading a scenario fails with the given line and message.
+   */
+  void CheckError (std::string contents, std::string expected);
+};
+
+// Add some help text to this case to describe what it is intended to test
+ScenarioLoaderTest::ScenarioLoaderTest ()
+  : TestCase ("Verify that LoraScenarioHelper parses valid scenario files and reports"
+              " the line of invalid records")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ScenarioLoaderTest::~ScenarioLoaderTest ()
+{
+}
+
+std::string
+ScenarioLoaderTest::WriteScenario (std::string name, std::string contents)
+{
+  std::string filename = CreateTempDirFilename (name);
+  std::ofstream file (filename.c_str (), std::ios::binary);
+  file << contents;
+  return filename;
+}
+
+void
+ScenarioLoaderTest::CheckError (std::string contents, std::string expected)
+{
+  std::string filename = WriteScenario ("invalid.csv", contents);
+  LoraScenarioHelper scenario;
+  NS_TEST_EXPECT_MSG_EQ (scenario.TryLoad (filename), filename + ":" + expected,
+                         "Wrong error for '" << contents << "'");
+  NS_TEST_EXPECT_MSG_EQ (scenario.GetNEndDevices (), 0, "No record should be kept");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ScenarioLoaderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ScenarioLoaderTest");
+
+  // Comments, empty lines, spaces around the fields, CRLF line ends, empty
+  // optional fields and a trace defined after its use
+  std::string filename = WriteScenario ("valid.csv",
+                                        "# A scenario\n"
+                                        "gw,0,0,15\n"
+                                        "\n"
+                                        "ed, 100.5, -20, 1.2, 9, 600, 20, 0.01, 3\r\n"
+                                        "  ed,10,20,0,,,,,\n"
+                                        "trace,3,solar.csv\n");
+  LoraScenarioHelper scenario;
+  NS_TEST_ASSERT_MSG_EQ (scenario.TryLoad (filename), "", "The scenario is valid");
+  NS_TEST_ASSERT_MSG_EQ (scenario.GetNGateways (), 1, "Wrong number of gateways");
+  NS_TEST_ASSERT_MSG_EQ (scenario.GetNEndDevices (), 2, "Wrong number of end devices");
+  NS_TEST_EXPECT_MSG_EQ (scenario.GetGateway (0).position.z, 15, "Wrong gateway position");
+
+  const LoraScenarioHelper::EndDeviceRecord &full = scenario.GetEndDevice (0);
+  NS_TEST_EXPECT_MSG_EQ (full.position.x, 100.5, "Wrong end device position");
+  NS_TEST_EXPECT_MSG_EQ (full.position.y, -20, "Wrong end device position");
+  NS_TEST_EXPECT_MSG_EQ (full.position.z, 1.2, "Wrong end device position");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (full.sf), 9, "Wrong SF");
+  NS_TEST_EXPECT_MSG_EQ (full.period, 600, "Wrong period");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (full.packetSize), 20, "Wrong packet size");
+  NS_TEST_EXPECT_MSG_EQ (full.capacitance, 0.01, "Wrong capacitance");
+  NS_TEST_EXPECT_MSG_EQ (full.traceId, 3, "Wrong trace id");
+  NS_TEST_EXPECT_MSG_EQ (scenario.GetTraceFilename (3), "solar.csv", "Wrong trace file");
+
+  const LoraScenarioHelper::EndDeviceRecord &empty = scenario.GetEndDevice (1);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (empty.sf), 0, "An empty SF should be 0");
+  NS_TEST_EXPECT_MSG_EQ (empty.period, 0, "An empty period should be 0");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (empty.packetSize), 0, "An empty packet size should be 0");
+  NS_TEST_EXPECT_MSG_EQ (empty.capacitance, 0, "An empty capacitance should be 0");
+  NS_TEST_EXPECT_MSG_EQ (empty.traceId, -1, "An empty trace id should be -1");
+
+  // Invalid records
+  CheckError ("gw,0,0\n", "1: invalid position");
+  CheckError ("gw,0,0,0,1\n", "1: a gw record has 4 fields");
+  CheckError ("# comment\ned,0,0,0,6,,,,\n", "2: invalid SF '6'");
+  CheckError ("ed,0,0,0,,-1,,,\n", "1: invalid period '-1'");
+  CheckError ("ed,0,0,0,,,256,,\n", "1: invalid packet size '256'");
+  CheckError ("ed,0,0,0,,,,x,\n", "1: invalid capacitance 'x'");
+  CheckError ("ed,0,0,0,,,,\n", "1: an ed record has 9 fields");
+  CheckError ("gw,0,0,0\nap,0,0,0\n", "2: unknown record type 'ap'");
+  CheckError ("trace,1,a.csv\ntrace,1,b.csv\n", "2: duplicate trace id 1");
+  CheckError ("gw,0,0,0\ned,0,0,0,,,,0.01,7\n", "2: undefined trace id 7");
+  CheckError ("trace,1,a.csv\ned,0,0,0,,,,,1\n", "2: a harvester needs a capacitance");
+
+  // Large enough to be split among several threads: the records keep the
+  // order of the file, and errors the line in the whole file
+  uint32_t nLines = 10000;
+  std::ostringstream large;
+  for (uint32_t i = 0; i < nLines; i++)
+    {
+      large << "ed," << i << ",2,3,7,600,20,,\n";
+    }
+  filename = WriteScenario ("large.csv", large.str ());
+  scenario.SetParsingThreads (4);
+  NS_TEST_ASSERT_MSG_EQ (scenario.TryLoad (filename), "", "The scenario is valid");
+  NS_TEST_ASSERT_MSG_EQ (scenario.GetNEndDevices (), nLines, "Wrong number of end devices");
+  bool ordered = true;
+  for (uint32_t i = 0; i < nLines; i++)
+    {
+      ordered = ordered && scenario.GetEndDevice (i).position.x == i;
+    }
+  NS_TEST_EXPECT_MSG_EQ (ordered, true, "The records should keep the order of the file");
+
+  std::string text = large.str ();
+  std::string::size_type lineStart = 0;
+  for (uint32_t i = 0; i < 8999; i++)
+    {
+      lineStart = text.find ('\n', lineStart) + 1;
+    }
+  text.insert (lineStart, "ed,0,0,0,13,,,,\n");
+  filename = WriteScenario ("large-invalid.csv", text);
+  NS_TEST_EXPECT_MSG_EQ (scenario.TryLoad (filename), filename + ":9000: invalid SF '13'",
+                         "The error should report its line in the whole file");
+}
+
+/***************************
+ * HexGridTest *
+ ***************************/
+
+class HexGridTest : public TestCase
+{
+public:
+  HexGridTest ();
+  virtual ~HexGridTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * The positions of the first rings, built like the allocator used to:
+   * the six neighbors of every position, clockwise from the north, are
+   * appended if no position is there yet.
+   */
+  std::vector<Vector> GetReferencePositions (double radius, int nRings);
+};
+
+// Add some help text to this case to describe what it is intended to test
+HexGridTest::HexGridTest ()
+  : TestCase ("Verify the allocation order and the cell lookup of"
+              " HexGridPositionAllocator")
+{
+}
+
+// Reminder that the test case should clean up after itself
+HexGridTest::~HexGridTest ()
+{
+}
+
+std::vector<Vector>
+HexGridTest::GetReferencePositions (double radius, int nRings)
+{
+  std::vector<Vector> positions;
+  positions.push_back (Vector (0.0, 0.0, 0.0));
+  for (int ring = 0; ring < nRings; ring++)
+    {
+      std::vector<Vector> copy = positions;
+      for (uint32_t i = 0; i < positions.size (); i++)
+        {
+          for (int d = 0; d < 6; d++)
+            {
+              double angle = d * M_PI / 3;
+              Vector position (positions[i].x + 2 * radius * std::sin (angle),
+                               positions[i].y + 2 * radius * std::cos (angle),
+                               0.0);
+              bool found = false;
+              for (uint32_t j = 0; j < copy.size () && !found; j++)
+                {
+                  found = CalculateDistance (position, copy[j]) < radius / 10;
+                }
+              if (!found)
+                {
+                  copy.push_back (position);
+                }
+            }
+        }
+      positions = copy;
+    }
+  return positions;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+HexGridTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("HexGridTest");
+
+  double radius = 1000;
+  std::vector<Vector> reference = GetReferencePositions (radius, 5);
+  NS_TEST_ASSERT_MSG_EQ (reference.size (), 91, "5 rings should have 91 cells");
+
+  // The allocation order did not change
+  Ptr<HexGridPositionAllocator> allocator = CreateObject<HexGridPositionAllocator> (radius);
+  for (uint32_t i = 0; i < reference.size (); i++)
+    {
+      Vector position = allocator->GetNext ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (position.x, reference[i].x, 1e-6,
+                                 "Wrong x of position " << i);
+      NS_TEST_EXPECT_MSG_EQ_TOL (position.y, reference[i].y, 1e-6,
+                                 "Wrong y of position " << i);
+    }
+
+  // Each point is in the cell of the nearest center. The nearest center of a
+  // point within 8 radii of the origin is in the first 5 rings.
+  uint32_t nPoints = 0;
+  for (double x = -8 * radius + 11; x < 8 * radius; x += 370)
+    {
+      for (double y = -8 * radius + 7; y < 8 * radius; y += 370)
+        {
+          Vector point (x, y, 25.0);
+          if (CalculateDistance (point, Vector (0.0, 0.0, 25.0)) >= 8 * radius)
+            {
+              continue;
+            }
+          uint32_t nearest = 0;
+          for (uint32_t i = 1; i < reference.size (); i++)
+            {
+              Vector flat (x, y, 0.0);
+              if (CalculateDistance (flat, reference[i])
+                  < CalculateDistance (flat, reference[nearest]))
+                {
+                  nearest = i;
+                }
+            }
+          nPoints++;
+          NS_TEST_EXPECT_MSG_EQ (allocator->GetNearestCellIndex (point), nearest,
+                                 "Wrong cell of " << point);
+          Vector center = allocator->GetNearestCellCenter (point);
+          NS_TEST_EXPECT_MSG_EQ_TOL (center.x, reference[nearest].x, 1e-6,
+                                     "Wrong cell center of " << point);
+          NS_TEST_EXPECT_MSG_EQ_TOL (center.y, reference[nearest].y, 1e-6,
+                                     "Wrong cell center of " << point);
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (nPoints, 1000, "Too few points were checked");
+
+  // A lookup beyond the generated rings generates them, and the positions
+  // returned afterwards are the same
+  std::vector<Vector> larger = GetReferencePositions (radius, 8);
+  Ptr<HexGridPositionAllocator> fresh = CreateObject<HexGridPositionAllocator> (radius);
+  NS_TEST_EXPECT_MSG_EQ (fresh->GetNearestCellIndex (larger.back ()), larger.size () - 1,
+                         "Wrong index of a cell of the 8th ring");
+  for (uint32_t i = 0; i < larger.size (); i++)
+    {
+      Vector position = fresh->GetNext ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (CalculateDistance (position, larger[i]), 0, 1e-6,
+                                 "Wrong position " << i << " after a lookup");
+    }
+}
+
+/***************************
+ * BatchHeaderTest *
+ ***************************/
+
+class BatchHeaderTest : public TestCase
+{
+public:
+  BatchHeaderTest ();
+  virtual ~BatchHeaderTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Build an uplink with the given headers, as received by a gateway.
+   */
+  Ptr<Packet> CreateUplink (uint32_t address, uint16_t fCnt, uint8_t sf,
+                            double receivePower);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BatchHeaderTest::BatchHeaderTest ()
+  : TestCase ("Verify that LoraBatchHeader keeps the metadata of its frames"
+              " through serialization")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatchHeaderTest::~BatchHeaderTest ()
+{
+}
+
+Ptr<Packet>
+BatchHeaderTest::CreateUplink (uint32_t address, uint16_t fCnt, uint8_t sf,
+                               double receivePower)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (address));
+  frameHdr.SetFCnt (fCnt);
+  frameHdr.SetAdr (true);
+  packet->AddHeader (frameHdr);
+
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  macHdr.SetMajor (1);
+  packet->AddHeader (macHdr);
+
+  LoraTag tag;
+  tag.SetSpreadingFactor (sf);
+  tag.SetFrequency (868.3);
+  tag.SetReceivePower (receivePower);
+  packet->AddPacketTag (tag);
+
+  return packet;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatchHeaderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatchHeaderTest");
+
+  std::vector<Ptr<Packet> > uplinks;
+  uplinks.push_back (CreateUplink (0x01000002, 5, 9, -110.5));
+  uplinks.push_back (CreateUplink (0x0100abcd, 65535, 12, -130.25));
+
+  NS_TEST_EXPECT_MSG_EQ (LoraBatchHeader::IsBatch (uplinks[0]), false,
+                         "An uplink is not a batch");
+
+  LoraBatchHeader header;
+  Ptr<Packet> batch = Create<Packet> ();
+  for (uint32_t i = 0; i < uplinks.size (); i++)
+    {
+      LoraBatchHeader::FrameMetadata frame;
+      frame.size = uplinks[i]->GetSize ();
+      frame.receptionTime = Seconds (3600) + NanoSeconds (i + 1);
+      frame.snr = -7.3 - i;
+      frame.frameInfo = LoraFrameInfoTag::Decode (uplinks[i]);
+      header.AddFrame (frame);
+      batch->AddAtEnd (uplinks[i]);
+    }
+  batch->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (LoraBatchHeader::IsBatch (batch), true, "The batch is not recognized");
+
+  LoraBatchHeader received;
+  uint32_t size = batch->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (size, header.GetSerializedSize (), "Wrong header size");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNFrames (), uplinks.size (), "Wrong number of frames");
+  NS_TEST_EXPECT_MSG_EQ (batch->GetSize (), uplinks[0]->GetSize () + uplinks[1]->GetSize (),
+                         "The frames should follow the header");
+
+  for (uint32_t i = 0; i < uplinks.size (); i++)
+    {
+      const LoraBatchHeader::FrameMetadata &sent = header.GetFrame (i);
+      const LoraBatchHeader::FrameMetadata &frame = received.GetFrame (i);
+      NS_TEST_EXPECT_MSG_EQ (unsigned (frame.size), unsigned (sent.size), "Wrong size");
+      NS_TEST_EXPECT_MSG_EQ (frame.receptionTime, sent.receptionTime, "Wrong reception time");
+      NS_TEST_EXPECT_MSG_EQ_TOL (frame.snr, sent.snr, 0.05, "Wrong SNR");
+      NS_TEST_EXPECT_MSG_EQ (frame.frameInfo.GetAddress (), sent.frameInfo.GetAddress (),
+                             "Wrong address");
+      NS_TEST_EXPECT_MSG_EQ (frame.frameInfo.GetFCnt (), sent.frameInfo.GetFCnt (),
+                             "Wrong FCnt");
+      NS_TEST_EXPECT_MSG_EQ (unsigned (frame.frameInfo.GetMType ()),
+                             unsigned (LorawanMacHeader::CONFIRMED_DATA_UP), "Wrong MType");
+      NS_TEST_EXPECT_MSG_EQ (frame.frameInfo.GetAdr (), true, "Wrong ADR bit");
+      NS_TEST_EXPECT_MSG_EQ (unsigned (frame.frameInfo.GetSpreadingFactor ()),
+                             unsigned (sent.frameInfo.GetSpreadingFactor ()), "Wrong SF");
+      NS_TEST_EXPECT_MSG_EQ (frame.frameInfo.GetFrequency (), 868.3, "Wrong frequency");
+      NS_TEST_EXPECT_MSG_EQ (frame.frameInfo.GetReceivePower (),
+                             sent.frameInfo.GetReceivePower (), "Wrong receive power");
+    }
+}
+
+/***************************
+ * HarvestStatisticsTest *
+ ***************************/
+
+class HarvestStatisticsTest : public TestCase
+{
+public:
+  HarvestStatisticsTest ();
+  virtual ~HarvestStatisticsTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Check the statistics of a trace over many windows against sums over
+   * its samples.
+   */
+  void CheckStatistics (void);
+
+  /**
+   * Check the profile learned from a power signal against a slot by slot
+   * replay of its moving averages.
+   */
+  void CheckProfile (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+HarvestStatisticsTest::HarvestStatisticsTest ()
+  : TestCase ("Verify HarvestPowerStatistics and HarvestPowerProfile against"
+              " brute-force computations")
+{
+}
+
+// Reminder that the test case should clean up after itself
+HarvestStatisticsTest::~HarvestStatisticsTest ()
+{
+}
+
+void
+HarvestStatisticsTest::CheckStatistics (void)
+{
+  // 37 samples of half a second, not a power of 2
+  double interval = 0.5;
+  std::vector<double> samples;
+  for (uint32_t i = 0; i < 37; i++)
+    {
+      samples.push_back (0.01 * (1.5 + std::sin (1.7 * i)));
+    }
+  double duration = samples.size () * interval;
+  HarvestPowerStatistics statistics (samples, MilliSeconds (500));
+
+  NS_TEST_EXPECT_MSG_EQ (statistics.GetNSamples (), samples.size (), "Wrong number of samples");
+  NS_TEST_EXPECT_MSG_EQ (statistics.GetDuration (), MilliSeconds (500 * samples.size ()),
+                         "Wrong duration");
+
+  // Windows starting before, inside and after the trace, shorter than a
+  // sample or longer than the trace
+  std::vector<double> lengths;
+  lengths.push_back (0.1);
+  lengths.push_back (0.5);
+  lengths.push_back (1.3);
+  lengths.push_back (7.9);
+  lengths.push_back (30);
+  for (int64_t startMs = -1000; startMs < duration * 1000 + 1000; startMs += 370)
+    {
+      for (uint32_t l = 0; l < lengths.size (); l++)
+        {
+          Time start = Seconds (startMs / 1000.0);
+          Time end = start + Seconds (lengths[l]);
+          double s = std::max (0.0, start.GetSeconds ());
+          double e = std::min (duration, end.GetSeconds ());
+
+          double energy = 0;
+          double min = std::numeric_limits<double>::max ();
+          double max = -std::numeric_limits<double>::max ();
+          for (uint32_t i = 0; i < samples.size (); i++)
+            {
+              double overlap = std::min (e, (i + 1) * interval) - std::max (s, i * interval);
+              if (overlap > 0)
+                {
+                  energy += overlap * samples[i];
+                  min = std::min (min, samples[i]);
+                  max = std::max (max, samples[i]);
+                }
+            }
+
+          NS_TEST_EXPECT_MSG_EQ_TOL (statistics.GetEnergy (start, end), energy, 1e-12,
+                                     "Wrong energy over [" << start << ", " << end << ")");
+          if (e <= s)
+            {
+              // Nothing to average: the closest sample
+              double closest = start.IsStrictlyNegative () ? samples.front () : samples.back ();
+              NS_TEST_EXPECT_MSG_EQ (statistics.GetMean (start, end), closest,
+                                     "Wrong mean over [" << start << ", " << end << ")");
+              continue;
+            }
+          NS_TEST_EXPECT_MSG_EQ_TOL (statistics.GetMean (start, end), energy / (e - s), 1e-12,
+                                     "Wrong mean over [" << start << ", " << end << ")");
+          NS_TEST_EXPECT_MSG_EQ (statistics.GetMin (start, end), min,
+                                 "Wrong min over [" << start << ", " << end << ")");
+          NS_TEST_EXPECT_MSG_EQ (statistics.GetMax (start, end), max,
+                                 "Wrong max over [" << start << ", " << end << ")");
+        }
+    }
+
+  // An empty window inside the trace takes the sample at its start
+  NS_TEST_EXPECT_MSG_EQ (statistics.GetMean (Seconds (3.2), Seconds (3.2)), samples[6],
+                         "Wrong mean over an empty window");
+}
+
+void
+HarvestStatisticsTest::CheckProfile (void)
+{
+  // Slots of 2 s, observed in pieces of 0.7 s that straddle them
+  double period = 10;
+  uint32_t nSlots = 5;
+  double slotWidth = period / nSlots;
+  double smoothing = 0.4;
+  HarvestPowerProfile profile (Seconds (period), nSlots, smoothing);
+
+  NS_TEST_EXPECT_MSG_EQ (profile.GetExpectedPower (Seconds (3)), 0,
+                         "A profile without observations expects no power");
+
+  // The observations of each slot, counted from time 0
+  std::vector<double> slotEnergy;
+  std::vector<double> slotTime;
+  for (uint32_t k = 0; k < 42; k++)
+    {
+      Time start = MilliSeconds (700 * k);
+      Time end = MilliSeconds (700 * (k + 1));
+      double power = 0.01 * (1 + std::cos (0.9 * k));
+      profile.Add (start, end, power);
+
+      double s = start.GetSeconds ();
+      double e = end.GetSeconds ();
+      while (s < e)
+        {
+          uint32_t slot = std::floor (s / slotWidth);
+          double slotEnd = std::min (e, (slot + 1) * slotWidth);
+          slotEnergy.resize (std::max<size_t> (slotEnergy.size (), slot + 1), 0);
+          slotTime.resize (std::max<size_t> (slotTime.size (), slot + 1), 0);
+          slotEnergy[slot] += (slotEnd - s) * power;
+          slotTime[slot] += slotEnd - s;
+          s = slotEnd;
+        }
+    }
+
+  // Replay the moving averages. The last slot is still being observed.
+  std::vector<double> estimate (nSlots, 0);
+  std::vector<bool> observed (nSlots, false);
+  double lastAverage = 0;
+  for (uint32_t slot = 0; slot + 1 < slotEnergy.size (); slot++)
+    {
+      double average = slotEnergy[slot] / slotTime[slot];
+      uint32_t i = slot % nSlots;
+      estimate[i] = observed[i] ? smoothing * average + (1 - smoothing) * estimate[i] : average;
+      observed[i] = true;
+      lastAverage = average;
+    }
+  for (uint32_t i = 0; i < nSlots; i++)
+    {
+      if (!observed[i])
+        {
+          estimate[i] = lastAverage;
+        }
+    }
+
+  for (int64_t timeMs = -15000; timeMs < 25000; timeMs += 130)
+    {
+      Time time = Seconds (timeMs / 1000.0);
+      double position = std::fmod (time.GetSeconds (), period);
+      if (position < 0)
+        {
+          position += period;
+        }
+      uint32_t slot = std::min<uint32_t> (position / slotWidth, nSlots - 1);
+      NS_TEST_EXPECT_MSG_EQ_TOL (profile.GetExpectedPower (time), estimate[slot], 1e-15,
+                                 "Wrong expected power at " << time);
+    }
+
+  // Windows within a slot, across slots and across periods
+  std::vector<double> lengths;
+  lengths.push_back (0);
+  lengths.push_back (0.3);
+  lengths.push_back (2.9);
+  lengths.push_back (13.7);
+  lengths.push_back (41);
+  for (int64_t startMs = 0; startMs < 30000; startMs += 610)
+    {
+      for (uint32_t l = 0; l < lengths.size (); l++)
+        {
+          Time start = Seconds (startMs / 1000.0);
+          Time end = start + Seconds (lengths[l]);
+
+          // Integrate the periodic estimate slot by slot
+          double energy = 0;
+          double t = start.GetSeconds ();
+          while (t < end.GetSeconds ())
+            {
+              double slotEnd = std::min (end.GetSeconds (),
+                                         (std::floor (t / slotWidth) + 1) * slotWidth);
+              uint32_t slot = uint32_t (std::floor (t / slotWidth)) % nSlots;
+              energy += (slotEnd - t) * estimate[slot];
+              t = slotEnd;
+            }
+
+          NS_TEST_EXPECT_MSG_EQ_TOL (profile.GetExpectedEnergy (start, end), energy, 1e-12,
+                                     "Wrong expected energy over [" << start << ", "
+                                     << end << ")");
+          double mean = lengths[l] > 0 ? energy / lengths[l]
+            : profile.GetExpectedPower (start);
+          NS_TEST_EXPECT_MSG_EQ_TOL (profile.GetExpectedMean (start, end), mean, 1e-12,
+                                     "Wrong expected mean over [" << start << ", "
+                                     << end << ")");
+        }
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+HarvestStatisticsTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("HarvestStatisticsTest");
+
+  CheckStatistics ();
+  CheckProfile ();
+}
+
+/***************************
+ * EnergyGateTest *
+ ***************************/
+
+/**
+ * A gate that never lets the device operate.
+ */
+class ClosedEnergyGate : public EnergyGate
+{
+public:
+  void
+  SetEnergySource (Ptr<EnergySource> source)
+  {
+  }
+
+  bool
+  IsOperational (void)
+  {
+    return false;
+  }
+};
+
+class EnergyGateTest : public TestCase
+{
+public:
+  EnergyGateTest ();
+  virtual ~EnergyGateTest ();
+
+  void Depleted (void);
+  void CheckGate (Ptr<EnergyGate> gate, bool operational);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Drive the PHY of a device powered by a capacitor through its states, and
+   * compare the time of depletion with the one obtained integrating each
+   * state with its own current.
+   */
+  void CheckCapacitorGate (void);
+
+  /**
+   * Check that the BasicEnergyGate sees the energy drawn since the last
+   * update of its source.
+   */
+  void CheckBasicGate (void);
+
+  /**
+   * Check that the PHY asks the gate set with SetEnergyGate.
+   */
+  void CheckSetEnergyGate (void);
+
+  Ptr<CapacitorEnergySource> m_capacitor;
+  Time m_depletionTime;
+  double m_depletionVoltage;
+};
+
+// Add some help text to this case to describe what it is intended to test
+EnergyGateTest::EnergyGateTest ()
+  : TestCase ("Verify that the energy gates bring their source up to date before"
+              " each state change of the PHY"),
+    m_depletionVoltage (0)
+{
+}
+
+// Reminder that the test case should clean up after itself
+EnergyGateTest::~EnergyGateTest ()
+{
+}
+
+void
+EnergyGateTest::Depleted (void)
+{
+  m_depletionTime = Simulator::Now ();
+  m_depletionVoltage = m_capacitor->GetActualVoltage ();
+}
+
+void
+EnergyGateTest::CheckGate (Ptr<EnergyGate> gate, bool operational)
+{
+  NS_TEST_EXPECT_MSG_EQ (gate->IsOperational (), operational,
+                         "Wrong gate state at " << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+EnergyGateTest::CheckCapacitorGate (void)
+{
+  double capacitance = 0.1;
+  double supplyVoltage = 3.3;
+  double initialVoltage = 3;
+  double power = 0.001;
+  double lowThreshold = 0.5;
+  double sleepCurrent = 1e-6;
+  double standbyCurrent = 0.01;
+  double idleCurrent = 1e-5;
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (1, mobility, channel);
+  Ptr<LoraNetDevice> device = endDevices.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ();
+  Ptr<EndDeviceLoraPhy> phy = device->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
+
+  // The initial voltage is drawn when the source is constructed
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::ConstantRandomVariable[Constant=" +
+                                   std::to_string (initialVoltage) + "]"));
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (capacitance));
+  capacitorHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (supplyVoltage));
+  capacitorHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (lowThreshold));
+  capacitorHelper.Set ("CapacitorHighVoltageThreshold", DoubleValue (0.95));
+  // Only the transitions update the source
+  capacitorHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (Seconds (1000)));
+  EnergySourceContainer sources = capacitorHelper.Install (endDevices);
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=0.0]"));
+  m_capacitor = sources.Get (0)->GetObject<CapacitorEnergySource> ();
+
+  BasicEnergyHarvesterHelper harvesterHelper;
+  harvesterHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (1000)));
+  harvesterHelper.Set ("HarvestablePower",
+                       StringValue ("ns3::ConstantRandomVariable[Constant=" +
+                                    std::to_string (power) + "]"));
+  EnergyHarvesterContainer harvesters = harvesterHelper.Install (sources);
+  harvesters.Get (0)->Initialize ();
+
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Set ("SleepCurrentA", DoubleValue (sleepCurrent));
+  radioEnergy.Set ("StandbyCurrentA", DoubleValue (standbyCurrent));
+  radioEnergy.Set ("IdleCurrentA", DoubleValue (idleCurrent));
+  radioEnergy.SetEnergyGate ("ns3::CapacitorEnergyGate");
+  radioEnergy.SetEnergyDepletionCallback (MakeCallback (&EnergyGateTest::Depleted, this));
+  radioEnergy.Install (NetDeviceContainer (device), sources);
+
+  NS_TEST_ASSERT_MSG_EQ (phy->GetEnergyGate () != 0, true,
+                         "The helper should bind a gate to the PHY");
+  NS_TEST_EXPECT_MSG_EQ (phy->GetEnergyGate ()->GetObject<CapacitorEnergyGate> () != 0, true,
+                         "The PHY should use the gate set in the helper");
+
+  // SLEEP [0, 1), STANDBY [1, 3), IDLE [3, 6), then STANDBY until depleted
+  m_depletionTime = Seconds (-1);
+  Simulator::Schedule (Seconds (1), &EndDeviceLoraPhy::SwitchToStandby, phy);
+  Simulator::Schedule (Seconds (3), &EndDeviceLoraPhy::SwitchToIdle, phy);
+  Simulator::Schedule (Seconds (6), &EndDeviceLoraPhy::SwitchToStandby, phy);
+  Simulator::Stop (Seconds (60));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // Integrate each state with its own current, then solve for the time the
+  // low threshold is reached in the last one
+  double voltage = initialVoltage;
+  voltage = CapacitorEnergySource::ComputeRcVoltage (voltage, sleepCurrent, power,
+                                                     supplyVoltage, capacitance, 1);
+  voltage = CapacitorEnergySource::ComputeRcVoltage (voltage, standbyCurrent, power,
+                                                     supplyVoltage, capacitance, 2);
+  voltage = CapacitorEnergySource::ComputeRcVoltage (voltage, idleCurrent, power,
+                                                     supplyVoltage, capacitance, 3);
+  double g = standbyCurrent / supplyVoltage + power / (supplyVoltage * supplyVoltage);
+  double vInf = power / (supplyVoltage * g);
+  double vMin = lowThreshold * supplyVoltage;
+  double expected = 6 - std::log ((vMin - vInf) / (voltage - vInf)) * capacitance / g;
+
+  NS_LOG_DEBUG ("Depletion: expected at " << expected << " s, notified at "
+                << m_depletionTime.GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_depletionTime.GetSeconds (), expected, 1e-6,
+                             "The capacitor was depleted at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_depletionVoltage, vMin, 1e-6,
+                             "The capacitor should be depleted at the low threshold");
+  m_capacitor = 0;
+}
+
+void
+EnergyGateTest::CheckBasicGate (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<BasicEnergySource> source = CreateObjectWithAttributes<BasicEnergySource>
+      ("BasicEnergySourceInitialEnergyJ", DoubleValue (10),
+      "BasicEnergySupplyVoltageV", DoubleValue (3),
+      "BasicEnergyLowBatteryThreshold", DoubleValue (0.5),
+      "PeriodicEnergyUpdateInterval", TimeValue (Seconds (1000)));
+  source->SetNode (node);
+  Ptr<SimpleDeviceEnergyModel> model = CreateObject<SimpleDeviceEnergyModel> ();
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+  // 3 W, 30 % of the initial energy per second
+  model->SetCurrentA (1);
+
+  Ptr<EnergyGate> gate = EnergyGate::CreateFor (source);
+  NS_TEST_ASSERT_MSG_EQ (gate != 0 && gate->GetObject<BasicEnergyGate> () != 0, true,
+                         "A BasicEnergySource should get a BasicEnergyGate");
+
+  // Nothing else updates the source in between
+  Simulator::Schedule (Seconds (1), &EnergyGateTest::CheckGate, this, gate, true);
+  Simulator::Schedule (Seconds (2), &EnergyGateTest::CheckGate, this, gate, false);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+EnergyGateTest::CheckSetEnergyGate (void)
+{
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (1, mobility, channel);
+  Ptr<EndDeviceLoraPhy> phy = endDevices.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ()
+    ->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
+
+  NS_TEST_EXPECT_MSG_EQ (phy->SwitchToStandby (), true,
+                         "Without an energy source the device should always operate");
+  NS_TEST_EXPECT_MSG_EQ (phy->GetEnergyGate () == 0, true,
+                         "Without an energy source there should be no gate");
+
+  Ptr<EnergyGate> gate = CreateObject<ClosedEnergyGate> ();
+  phy->SetEnergyGate (gate);
+  NS_TEST_EXPECT_MSG_EQ (phy->GetEnergyGate () == gate, true, "The gate was not set");
+  NS_TEST_EXPECT_MSG_EQ (phy->SwitchToIdle (), false,
+                         "A closed gate should keep the device from switching state");
+  NS_TEST_EXPECT_MSG_EQ (phy->GetState (), EndDeviceLoraPhy::STANDBY,
+                         "The device should stay in its state");
+
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EnergyGateTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("EnergyGateTest");
+
+  CheckCapacitorGate ();
+  CheckBasicGate ();
+  CheckSetEnergyGate ();
+}
+
+/***************************
+ * CapacitorFleetTest *
+ ***************************/
+
+class CapacitorFleetTest : public TestCase
+{
+public:
+  CapacitorFleetTest ();
+  virtual ~CapacitorFleetTest ();
+
+  void SwitchState (EndDeviceLoraPhy::State state);
+  void CheckVoltages (void);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<Ptr<EndDeviceLoraPhy> > m_phys;
+  Ptr<CapacitorEnergySource> m_fleetSource;
+  Ptr<CapacitorEnergySource> m_ownSource;
+};
+
+// Add some help text to this case to describe what it is intended to test
+CapacitorFleetTest::CapacitorFleetTest ()
+  : TestCase ("Verify that a capacitor advanced by a CapacitorFleetEnergyManager"
+              " follows one doing its own periodic updates, across state changes")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CapacitorFleetTest::~CapacitorFleetTest ()
+{
+}
+
+void
+CapacitorFleetTest::SwitchState (EndDeviceLoraPhy::State state)
+{
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      switch (state)
+        {
+        case EndDeviceLoraPhy::STANDBY:
+          m_phys[i]->SwitchToStandby ();
+          break;
+        case EndDeviceLoraPhy::IDLE:
+          m_phys[i]->SwitchToIdle ();
+          break;
+        case EndDeviceLoraPhy::SLEEP:
+          m_phys[i]->SwitchToSleep ();
+          break;
+        default:
+          NS_FATAL_ERROR ("State not used by this test");
+        }
+    }
+}
+
+void
+CapacitorFleetTest::CheckVoltages (void)
+{
+  double fleetVoltage = m_fleetSource->GetActualVoltage ();
+  double ownVoltage = m_ownSource->GetActualVoltage ();
+  NS_LOG_DEBUG ("At " << Simulator::Now ().GetSeconds () << " s: fleet " << fleetVoltage
+                << " V, own updates " << ownVoltage << " V");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fleetVoltage, ownVoltage, 1e-9,
+                             "The fleet source differs at " << Simulator::Now ().GetSeconds ()
+                             << " s");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CapacitorFleetTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CapacitorFleetTest");
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (2, mobility, channel);
+
+  // Both capacitors start charged, and are updated on the same grid
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::ConstantRandomVariable[Constant=3]"));
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (0.05));
+  capacitorHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (0.3));
+  capacitorHelper.Set ("PeriodicVoltageUpdateInterval", TimeValue (Seconds (0.5)));
+  EnergySourceContainer ownSources = capacitorHelper.Install (endDevices.Get (1));
+  Ptr<CapacitorFleetEnergyManager> manager = CreateObjectWithAttributes
+      <CapacitorFleetEnergyManager> ("UpdateInterval", TimeValue (Seconds (0.5)));
+  capacitorHelper.SetFleetManager (manager);
+  EnergySourceContainer fleetSources = capacitorHelper.Install (endDevices.Get (0));
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=0.0]"));
+  m_fleetSource = fleetSources.Get (0)->GetObject<CapacitorEnergySource> ();
+  m_ownSource = ownSources.Get (0)->GetObject<CapacitorEnergySource> ();
+  NS_TEST_ASSERT_MSG_EQ (manager->GetNSources (), 1, "Only one source should be managed");
+
+  BasicEnergyHarvesterHelper harvesterHelper;
+  harvesterHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (1000)));
+  harvesterHelper.Set ("HarvestablePower",
+                       StringValue ("ns3::ConstantRandomVariable[Constant=0.001]"));
+  EnergySourceContainer sources;
+  sources.Add (fleetSources);
+  sources.Add (ownSources);
+  EnergyHarvesterContainer harvesters = harvesterHelper.Install (sources);
+  harvesters.Get (0)->Initialize ();
+  harvesters.Get (1)->Initialize ();
+
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Set ("SleepCurrentA", DoubleValue (1e-6));
+  radioEnergy.Set ("StandbyCurrentA", DoubleValue (0.01));
+  radioEnergy.Set ("IdleCurrentA", DoubleValue (1e-5));
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<LoraNetDevice> device = endDevices.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      radioEnergy.Install (NetDeviceContainer (device), i == 0 ? fleetSources : ownSources);
+      m_phys.push_back (device->GetPhy ()->GetObject<EndDeviceLoraPhy> ());
+    }
+
+  // Transitions between the updates. SwitchToSleep does not ask the gate,
+  // so the source is brought up to date by SetCheckForEnergyDepletion.
+  Simulator::Schedule (Seconds (1.3), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (2.7), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::SLEEP);
+  Simulator::Schedule (Seconds (3.05), &CapacitorFleetTest::CheckVoltages, this);
+  Simulator::Schedule (Seconds (4.1), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (4.6), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::IDLE);
+  Simulator::Schedule (Seconds (5.2), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (6.2), &CapacitorFleetTest::CheckVoltages, this);
+  Simulator::Schedule (Seconds (7.4), &CapacitorFleetTest::SwitchState, this,
+                       EndDeviceLoraPhy::SLEEP);
+  Simulator::Schedule (Seconds (9.9), &CapacitorFleetTest::CheckVoltages, this);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  // Something was drawn from the capacitors
+  NS_TEST_EXPECT_MSG_LT (m_ownSource->GetActualVoltage (), 2.9,
+                         "The standby periods should have discharged the capacitor");
+  Simulator::Destroy ();
+
+  m_phys.clear ();
+  m_fleetSource = 0;
+  m_ownSource = 0;
+}
+
+/***************************
+ * EnergyAdmissionTest *
+ ***************************/
+
+class EnergyAdmissionTest : public TestCase
+{
+public:
+  EnergyAdmissionTest ();
+  virtual ~EnergyAdmissionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+EnergyAdmissionTest::EnergyAdmissionTest ()
+  : TestCase ("Verify that the cached times on air of EndDeviceEnergyAdmission, shared"
+              " between devices, give the same predictions as computing them anew")
+{
+}
+
+// Reminder that the test case should clean up after itself
+EnergyAdmissionTest::~EnergyAdmissionTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EnergyAdmissionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("EnergyAdmissionTest");
+
+  double capacitance = 0.005;
+  double supplyVoltage = 3.3;
+  double lowThreshold = 0.8;
+  double txCurrent = 0.028;
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (2, mobility, channel);
+
+  // Charged capacitors, small enough for long packets not to be admitted
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::ConstantRandomVariable[Constant=3]"));
+  CapacitorEnergySourceHelper capacitorHelper;
+  capacitorHelper.Set ("Capacitance", DoubleValue (capacitance));
+  capacitorHelper.Set ("CapacitorMaxSupplyVoltageV", DoubleValue (supplyVoltage));
+  capacitorHelper.Set ("CapacitorLowVoltageThreshold", DoubleValue (lowThreshold));
+  EnergySourceContainer sources = capacitorHelper.Install (endDevices);
+  Config::SetDefault ("ns3::CapacitorEnergySource::RandomInitialVoltage",
+                      StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=0.0]"));
+
+  LoraRadioEnergyModelHelper radioEnergy;
+  radioEnergy.Set ("TxCurrentA", DoubleValue (txCurrent));
+
+  std::vector<uint32_t> sizes;
+  sizes.push_back (1);
+  sizes.push_back (23);
+  sizes.push_back (51);
+  sizes.push_back (222);
+  std::vector<double> powers;
+  powers.push_back (14);
+  powers.push_back (2);
+
+  // Each size is first computed by device 0, then found in the cache by
+  // device 1
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<LoraNetDevice> device =
+          endDevices.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      Ptr<EndDeviceLorawanMac> mac = device->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+      Ptr<CapacitorEnergySource> capacitor = sources.Get (i)->GetObject<CapacitorEnergySource> ();
+      Ptr<LoraRadioEnergyModel> radio = radioEnergy.Install (device, sources.Get (i))
+                                            .Get (0)->GetObject<LoraRadioEnergyModel> ();
+      Ptr<EndDeviceEnergyAdmission> admission = mac->GetEnergyAdmission ();
+      NS_TEST_ASSERT_MSG_EQ (admission != 0, true,
+                             "The helper should bind an admission to the MAC");
+
+      double voltage = capacitor->GetActualVoltage ();
+      for (uint8_t dr = 0; dr < 6; dr++)
+        {
+          for (uint32_t s = 0; s < sizes.size (); s++)
+            {
+              LoraTxParameters params;
+              params.sf = mac->GetSfFromDataRate (dr);
+              params.headerDisabled = 1;
+              params.codingRate = 1;
+              params.bandwidthHz = mac->GetBandwidthFromDataRate (dr);
+              params.nPreamble = 8;
+              params.crcEnabled = 1;
+              params.lowDataRateOptimizationEnabled = 0;
+              double airTime =
+                  LoraPhy::GetOnAirTime (Create<Packet> (sizes[s]), params).GetSeconds ();
+
+              // Twice, to read the value back from the cache
+              for (uint32_t k = 0; k < 2; k++)
+                {
+                  NS_TEST_EXPECT_MSG_EQ (admission->GetAirTime (dr, sizes[s]), airTime,
+                                         "Wrong time on air for device " << i << ", DR"
+                                         << unsigned (dr) << ", " << sizes[s] << " bytes");
+                }
+
+              for (uint32_t p = 0; p < powers.size (); p++)
+                {
+                  double expected = CapacitorEnergySource::ComputeRcVoltage
+                      (voltage, radio->GetTxCurrentA (), 0, supplyVoltage, capacitance, airTime);
+                  NS_TEST_EXPECT_MSG_EQ (admission->PredictVoltage (dr, sizes[s], powers[p]),
+                                         expected,
+                                         "Wrong prediction for device " << i << ", DR"
+                                         << unsigned (dr) << ", " << sizes[s] << " bytes");
+                  NS_TEST_EXPECT_MSG_EQ (admission->Admit (dr, sizes[s], powers[p]),
+                                         expected >= lowThreshold * supplyVoltage,
+                                         "Wrong decision for device " << i << ", DR"
+                                         << unsigned (dr) << ", " << sizes[s] << " bytes");
+                }
+            }
+        }
+    }
+
+  Simulator::Destroy ();
+}
+
+/***************************
+ * HarvesterGroupTest *
+ ***************************/
+
+class HarvesterGroupTest : public TestCase
+{
+public:
+  HarvesterGroupTest ();
+  virtual ~HarvesterGroupTest ();
+
+  /**
+   * Write a power trace in the format read by VariableEnergyHarvester.
+   */
+  std::string WriteTrace (std::string name, std::vector<double> power);
+
+  /**
+   * Add the power of each harvester over the next second, and compare the
+   * grouped harvesters with the standalone ones.
+   */
+  void Sample (void);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<Ptr<VariableEnergyHarvester> > m_grouped;
+  std::vector<Ptr<VariableEnergyHarvester> > m_standalone;
+  std::vector<double> m_groupedEnergy;
+  std::vector<double> m_standaloneEnergy;
+};
+
+// Add some help text to this case to describe what it is intended to test
+HarvesterGroupTest::HarvesterGroupTest ()
+  : TestCase ("Verify that harvesters driven by a VariableEnergyHarvesterGroup, with"
+              " a scale and a time shift, harvest as much as standalone harvesters")
+{
+}
+
+// Reminder that the test case should clean up after itself
+HarvesterGroupTest::~HarvesterGroupTest ()
+{
+}
+
+std::string
+HarvesterGroupTest::WriteTrace (std::string name, std::vector<double> power)
+{
+  std::string filename = CreateTempDirFilename (name);
+  std::ofstream file (filename.c_str ());
+  // Enough digits for the samples to be read back exactly
+  file.precision (17);
+  file << "Time,A,B,C,D,Power" << std::endl;
+  for (uint32_t i = 0; i < power.size (); i++)
+    {
+      file << i << ",0,0,0,0," << power[i] << std::endl;
+    }
+  return filename;
+}
+
+void
+HarvesterGroupTest::Sample (void)
+{
+  for (uint32_t i = 0; i < m_grouped.size (); i++)
+    {
+      double grouped = m_grouped[i]->GetPower ();
+      double standalone = m_standalone[i]->GetPower ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (grouped, standalone, 1e-15,
+                                 "Wrong power of grouped harvester " << i << " at "
+                                 << Simulator::Now ().GetSeconds () << " s");
+      m_groupedEnergy[i] += grouped;
+      m_standaloneEnergy[i] += standalone;
+
+      // The forecasts read the same trace
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_grouped[i]->GetExpectedEnergy (Seconds (7.3)),
+                                 m_standalone[i]->GetExpectedEnergy (Seconds (7.3)), 1e-12,
+                                 "Wrong forecast of grouped harvester " << i << " at "
+                                 << Simulator::Now ().GetSeconds () << " s");
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+HarvesterGroupTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("HarvesterGroupTest");
+
+  // Some power changes, and some repeated samples that do not notify the
+  // members of the group
+  uint32_t nSamples = 60;
+  std::vector<double> power;
+  for (uint32_t i = 0; i < nSamples; i++)
+    {
+      power.push_back (i % 7 < 3 ? 0.002 : 0.001 * (1 + std::sin (0.8 * i)));
+    }
+  std::string filename = WriteTrace ("group.csv", power);
+
+  // The traces that standalone harvesters need to match each member
+  std::vector<double> scales;
+  std::vector<uint32_t> shifts;
+  scales.push_back (1);
+  shifts.push_back (0);
+  scales.push_back (2.5);
+  shifts.push_back (0);
+  scales.push_back (2.5);
+  shifts.push_back (4);
+  scales.push_back (0.3);
+  shifts.push_back (11);
+
+  NodeContainer nodes;
+  nodes.Create (2 * scales.size ());
+  BasicEnergySourceHelper sourceHelper;
+  sourceHelper.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (1000));
+  EnergySourceContainer sources = sourceHelper.Install (nodes);
+
+  VariableEnergyHarvesterHelper groupHelper;
+  groupHelper.Set ("Filename", StringValue (filename));
+  groupHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (1)));
+  groupHelper.EnableGroups (true);
+
+  for (uint32_t k = 0; k < scales.size (); k++)
+    {
+      groupHelper.SetPowerScale (scales[k]);
+      groupHelper.SetTimeShift (Seconds (shifts[k]));
+      EnergyHarvesterContainer grouped = groupHelper.Install (sources.Get (k));
+      m_grouped.push_back (grouped.Get (0)->GetObject<VariableEnergyHarvester> ());
+
+      std::vector<double> reference;
+      for (uint32_t i = shifts[k]; i < nSamples; i++)
+        {
+          reference.push_back (scales[k] * power[i]);
+        }
+      std::ostringstream name;
+      name << "standalone-" << k << ".csv";
+      VariableEnergyHarvesterHelper standaloneHelper;
+      standaloneHelper.Set ("Filename", StringValue (WriteTrace (name.str (), reference)));
+      standaloneHelper.Set ("PeriodicHarvestedPowerUpdateInterval", TimeValue (Seconds (1)));
+      EnergyHarvesterContainer standalone =
+          standaloneHelper.Install (sources.Get (scales.size () + k));
+      m_standalone.push_back (standalone.Get (0)->GetObject<VariableEnergyHarvester> ());
+
+      m_grouped.back ()->Initialize ();
+      m_standalone.back ()->Initialize ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (groupHelper.GetGroup (filename)->GetNHarvesters (), scales.size (),
+                         "All the grouped harvesters should share one group");
+
+  // Between the updates, which happen every second
+  m_groupedEnergy.assign (scales.size (), 0);
+  m_standaloneEnergy.assign (scales.size (), 0);
+  uint32_t duration = 40;
+  for (uint32_t t = 0; t < duration; t++)
+    {
+      Simulator::Schedule (Seconds (t + 0.5), &HarvesterGroupTest::Sample, this);
+    }
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+
+  for (uint32_t k = 0; k < scales.size (); k++)
+    {
+      double expected = 0;
+      for (uint32_t t = 0; t < duration; t++)
+        {
+          expected += scales[k] * power[t + shifts[k]];
+        }
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_groupedEnergy[k], m_standaloneEnergy[k], 1e-12,
+                                 "Grouped harvester " << k << " harvested a different energy");
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_groupedEnergy[k], expected, 1e-12,
+                                 "Grouped harvester " << k << " did not follow the trace");
+    }
+  Simulator::Destroy ();
+
+  m_grouped.clear ();
+  m_standalone.clear ();
+}
+
+/***************************
+ * CorrelatedShadowingTest *
+ ***************************/
+
+class CorrelatedShadowingTest : public TestCase
+{
+public:
+  CorrelatedShadowingTest ();
+  virtual ~CorrelatedShadowingTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Create a model whose raster covers [min, max], with the raster values
+   * drawn from stream and the values of the shadowing maps from stream + 1.
+   */
+  Ptr<CorrelatedShadowingPropagationLossModel> CreateModel (bool useRaster, Vector min,
+                                                            Vector max, int64_t stream);
+
+  /**
+   * \return The shadowing loss between two positions [dB]
+   */
+  double GetLoss (Ptr<PropagationLossModel> model, Vector txPosition, Vector rxPosition);
+
+  /**
+   * Compare the raster with the shadowing maps inside a square.
+   */
+  void CheckInsideSquare (void);
+
+  /**
+   * Check that the raster gives the values drawn for the vertices at the
+   * grid points.
+   */
+  void CheckGridPoints (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+CorrelatedShadowingTest::CorrelatedShadowingTest ()
+  : TestCase ("Verify that the raster mode of CorrelatedShadowingPropagationLossModel"
+              " interpolates its vertices as the shadowing maps")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CorrelatedShadowingTest::~CorrelatedShadowingTest ()
+{
+}
+
+Ptr<CorrelatedShadowingPropagationLossModel>
+CorrelatedShadowingTest::CreateModel (bool useRaster, Vector min, Vector max, int64_t stream)
+{
+  Ptr<CorrelatedShadowingPropagationLossModel> model =
+      CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  model->SetAttribute ("UseRaster", BooleanValue (useRaster));
+  model->SetAttribute ("RasterMin", VectorValue (min));
+  model->SetAttribute ("RasterMax", VectorValue (max));
+  model->SetAttribute ("RasterResolution", DoubleValue (1));
+  NS_TEST_EXPECT_MSG_EQ (model->AssignStreams (stream), 2,
+                         "The model should use one stream for the raster and one for the maps");
+  return model;
+}
+
+double
+CorrelatedShadowingTest::GetLoss (Ptr<PropagationLossModel> model, Vector txPosition,
+                                  Vector rxPosition)
+{
+  Ptr<ConstantPositionMobilityModel> tx = CreateObject<ConstantPositionMobilityModel> ();
+  tx->SetPosition (txPosition);
+  Ptr<ConstantPositionMobilityModel> rx = CreateObject<ConstantPositionMobilityModel> ();
+  rx->SetPosition (rxPosition);
+  return -model->CalcRxPower (0, tx, rx);
+}
+
+void
+CorrelatedShadowingTest::CheckInsideSquare (void)
+{
+  int64_t stream = 10;
+
+  // A raster of a single square, whose vertices are drawn in row order: lower
+  // left, lower right, upper left, upper right. A shadowing map draws them as
+  // lower left, upper left, lower right, upper right. On the diagonal of the
+  // square the lower right and upper left vertices have the same weight, so
+  // the same draws give the same loss.
+  Ptr<CorrelatedShadowingPropagationLossModel> raster =
+      CreateModel (true, Vector (-10, -10, 0), Vector (10, 10, 0), stream);
+  Vector txPosition (3, -7, 0);
+  for (double t = -54.5; t < 55; t += 4.7)
+    {
+      Vector rxPosition (t, t, 0);
+      // The maps draw new vertices for each receiver position: start from the
+      // beginning of the stream every time
+      Ptr<CorrelatedShadowingPropagationLossModel> maps =
+          CreateModel (false, Vector (-10, -10, 0), Vector (10, 10, 0), stream - 1);
+      NS_TEST_EXPECT_MSG_EQ_TOL (GetLoss (raster, txPosition, rxPosition),
+                                 GetLoss (maps, txPosition, rxPosition), 1e-3,
+                                 "The raster differs from the maps at " << rxPosition);
+    }
+}
+
+void
+CorrelatedShadowingTest::CheckGridPoints (void)
+{
+  int64_t stream = 20;
+  double d = 110;
+
+  // Squares -1 to 1, i.e., 4x4 vertices, drawn in row order when the first
+  // transmitter is found
+  Ptr<CorrelatedShadowingPropagationLossModel> raster =
+      CreateModel (true, Vector (-150, -150, 0), Vector (150, 150, 0), stream);
+  Ptr<NormalRandomVariable> value = CreateObject<NormalRandomVariable> ();
+  value->SetAttribute ("Mean", DoubleValue (0.0));
+  value->SetAttribute ("Variance", DoubleValue (16.0));
+  value->SetStream (stream);
+  std::vector<double> vertices;
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      vertices.push_back (value->GetValue ());
+    }
+
+  // The outer vertices are on the border of squares outside the raster
+  Vector txPosition (10, -20, 0);
+  for (int iy = 1; iy <= 2; iy++)
+    {
+      for (int ix = 1; ix <= 2; ix++)
+        {
+          Vector rxPosition ((ix - 1) * d - d / 2, (iy - 1) * d - d / 2, 0);
+          double loss = GetLoss (raster, txPosition, rxPosition);
+          NS_TEST_EXPECT_MSG_EQ_TOL (loss, vertices[iy * 4 + ix], 1e-9,
+                                     "Wrong loss at the grid point " << rxPosition);
+          NS_TEST_EXPECT_MSG_EQ (GetLoss (raster, txPosition, rxPosition), loss,
+                                 "The raster should always give the same loss");
+        }
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CorrelatedShadowingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CorrelatedShadowingTest");
+
+  CheckInsideSquare ();
+  CheckGridPoints ();
+}
+
+/***************************
+ * PacketPoolTest *
+ ***************************/
+
+class PacketPoolTest : public TestCase
+{
+public:
+  PacketPoolTest ();
+  virtual ~PacketPoolTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+PacketPoolTest::PacketPoolTest ()
+  : TestCase ("Verify that LoraPacketPool only recycles packets nobody references,"
+              " without their tags and at the requested size")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PacketPoolTest::~PacketPoolTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PacketPoolTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PacketPoolTest");
+
+  LoraPacketPool::Enable (2);
+  LoraPacketPool::ResetCounters ();
+
+  // A packet used as an uplink, with headers and tags
+  Ptr<Packet> packet = LoraPacketPool::Allocate (10);
+  Packet *first = PeekPointer (packet);
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+  LoraTag tag (7);
+  packet->AddPacketTag (tag);
+  packet->AddByteTag (tag);
+  Ptr<Packet> copy = packet->Copy ();
+
+  // Once released, it is recycled empty
+  packet = 0;
+  Ptr<Packet> recycled = LoraPacketPool::Allocate (20);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (recycled) == first, true,
+                         "A released packet should be recycled");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetRecycledCount (), 1, "Wrong number of recycled packets");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetCreatedCount (), 1, "Wrong number of created packets");
+  NS_TEST_EXPECT_MSG_EQ (recycled->GetSize (), 20, "Wrong size of the recycled packet");
+  LoraTag leftover;
+  NS_TEST_EXPECT_MSG_EQ (recycled->PeekPacketTag (leftover), false,
+                         "The recycled packet kept a packet tag");
+  NS_TEST_EXPECT_MSG_EQ (recycled->GetByteTagIterator ().HasNext (), false,
+                         "The recycled packet kept a byte tag");
+  uint8_t bytes[20];
+  recycled->CopyData (bytes, 20);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (bytes[i]), 0, "Byte " << i << " of the payload is not zero");
+    }
+
+  // A copy made before the release is not affected
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 11, "The copy of a recycled packet changed");
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (leftover), true,
+                         "The copy of a recycled packet lost its tag");
+  LorawanMacHeader copyHdr;
+  copy->PeekHeader (copyHdr);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (copyHdr.GetMType ()),
+                         unsigned (LorawanMacHeader::CONFIRMED_DATA_UP),
+                         "The copy of a recycled packet lost its header");
+
+  // A packet that is still referenced elsewhere is never reused, and the
+  // pool never grows beyond its capacity
+  Ptr<Packet> held = recycled;
+  held->AddPacketTag (tag);
+  recycled = 0;
+  Ptr<Packet> second = LoraPacketPool::Allocate (5);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (second) == PeekPointer (held), false,
+                         "A packet still referenced was recycled");
+  Ptr<Packet> third = LoraPacketPool::Allocate (5);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (third) == PeekPointer (held)
+                         || PeekPointer (third) == PeekPointer (second), false,
+                         "A packet still referenced was recycled");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetCreatedCount (), 3, "Wrong number of created packets");
+  NS_TEST_EXPECT_MSG_EQ (held->GetSize (), 20, "A packet still referenced was resized");
+  NS_TEST_EXPECT_MSG_EQ (held->PeekPacketTag (leftover), true,
+                         "A packet still referenced lost its tag");
+
+  // The packet beyond the capacity is not kept by the pool, so the next
+  // allocation reuses the second one
+  Packet *pooled = PeekPointer (second);
+  third = 0;
+  second = 0;
+  Ptr<Packet> fourth = LoraPacketPool::Allocate (5);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (fourth) == pooled, true,
+                         "The pool did not reuse its released packet");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetRecycledCount (), 2, "Wrong number of recycled packets");
+
+  LoraPacketPool::Disable ();
+  LoraPacketPool::ResetCounters ();
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::IsEnabled (), false, "The pool should be disabled");
+}
+
+/***************************
+ * LoraTagTest *
+ ***************************/
+
+class LoraTagTest : public TestCase
+{
+public:
+  LoraTagTest ();
+  virtual ~LoraTagTest ();
+
+  void ReceivedPacket (Ptr<const Packet> packet);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Count the LoraTags attached to a packet.
+   */
+  uint32_t CountLoraTags (Ptr<const Packet> packet) const;
+
+  std::vector<Ptr<Packet> > m_receivedPackets;
+};
+
+// Add some help text to this case to describe what it is intended to test
+LoraTagTest::LoraTagTest ()
+  : TestCase ("Verify that the PHYs and the gateway MAC keep a single LoraTag"
+              " with the right fields")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LoraTagTest::~LoraTagTest ()
+{
+}
+
+void
+LoraTagTest::ReceivedPacket (Ptr<const Packet> packet)
+{
+  m_receivedPackets.push_back (packet->Copy ());
+}
+
+uint32_t
+LoraTagTest::CountLoraTags (Ptr<const Packet> packet) const
+{
+  uint32_t count = 0;
+  PacketTagIterator it = packet->GetPacketTagIterator ();
+  while (it.HasNext ())
+    {
+      if (it.Next ().GetTypeId () == LoraTag::GetTypeId ())
+        {
+          count++;
+        }
+    }
+  return count;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LoraTagTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraTagTest");
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices = CreateEndDevices (1, mobility, channel);
+  NodeContainer gateways = CreateGateways (1, mobility, channel);
+  Ptr<MobilityModel> edMobility = endDevices.Get (0)->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> gwMobility = gateways.Get (0)->GetObject<MobilityModel> ();
+  edMobility->SetPosition (Vector (0, 0, 0));
+  gwMobility->SetPosition (Vector (100, 0, 0));
+
+  Ptr<EndDeviceLoraPhy> edPhy = endDevices.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ()
+    ->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
+  Ptr<GatewayLorawanMac> gwMac = GetMacLayerFromNode<GatewayLorawanMac> (gateways.Get (0));
+  gwMac->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&LoraTagTest::ReceivedPacket, this));
+
+  // An uplink without a LoraTag, and one that already carries a data rate
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+
+  Ptr<Packet> untagged = Create<Packet> (10);
+  untagged->AddHeader (frameHdr);
+  untagged->AddHeader (macHdr);
+  LoraTxParameters untaggedParams;
+  untaggedParams.sf = 9;
+  Simulator::Schedule (Seconds (2), &EndDeviceLoraPhy::Send, edPhy, untagged,
+                       untaggedParams, 868.3, 14);
+
+  Ptr<Packet> tagged = Create<Packet> (10);
+  tagged->AddHeader (frameHdr);
+  tagged->AddHeader (macHdr);
+  LoraTag tag;
+  tag.SetDataRate (2);
+  tagged->AddPacketTag (tag);
+  LoraTxParameters taggedParams;
+  taggedParams.sf = 10;
+  Simulator::Schedule (Seconds (10), &EndDeviceLoraPhy::Send, edPhy, tagged,
+                       taggedParams, 868.5, 14);
+
+  // A downlink handed to the gateway MAC, which only reads its tag
+  Ptr<Packet> downlink = Create<Packet> (10);
+  LoraTag downlinkTag;
+  downlinkTag.SetDataRate (5);
+  downlinkTag.SetFrequency (868.1);
+  downlink->AddPacketTag (downlinkTag);
+  Simulator::Schedule (Seconds (20), &GatewayLorawanMac::Send, gwMac, downlink);
+
+  double rxPower = channel->GetRxPower (14, edMobility, gwMobility);
+
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_receivedPackets.size (), 2, "The gateway should receive both uplinks");
+  uint8_t sfs[2] = {9, 10};
+  double frequencies[2] = {868.3, 868.5};
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Packet> packet = m_receivedPackets[i];
+      NS_TEST_EXPECT_MSG_EQ (CountLoraTags (packet), 1,
+                             "Uplink " << i << " should carry exactly one LoraTag");
+      LoraTag received;
+      packet->PeekPacketTag (received);
+      NS_TEST_EXPECT_MSG_EQ (unsigned (received.GetSpreadingFactor ()), unsigned (sfs[i]),
+                             "Uplink " << i << " has the wrong SF");
+      NS_TEST_EXPECT_MSG_EQ_TOL (received.GetReceivePower (), rxPower, 1e-9,
+                                 "Uplink " << i << " has the wrong receive power");
+      NS_TEST_EXPECT_MSG_EQ_TOL (received.GetFrequency (), frequencies[i], 1e-9,
+                                 "Uplink " << i << " has the wrong frequency");
+    }
+  LoraTag received;
+  m_receivedPackets[1]->PeekPacketTag (received);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (received.GetDataRate ()), 2,
+                         "The data rate set before the transmission was lost");
+
+  // The senders' packets carry the tag too
+  NS_TEST_EXPECT_MSG_EQ (CountLoraTags (untagged), 1,
+                         "The untagged uplink should carry exactly one LoraTag");
+  NS_TEST_EXPECT_MSG_EQ (CountLoraTags (tagged), 1,
+                         "The tagged uplink should carry exactly one LoraTag");
+
+  NS_TEST_EXPECT_MSG_EQ (CountLoraTags (downlink), 1,
+                         "The downlink should carry exactly one LoraTag");
+  LoraTag sent;
+  downlink->PeekPacketTag (sent);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (sent.GetDataRate ()), 5,
+                         "The gateway MAC changed the data rate of the downlink");
+  NS_TEST_EXPECT_MSG_EQ_TOL (sent.GetFrequency (), 868.1, 1e-9,
+                             "The gateway MAC changed the frequency of the downlink");
 }
 
 /**************
@@ -1351,6 +4002,22 @@ LorawanTestSuite::LorawanTestSuite ()
   AddTestCase (new LogicalLoraChannelTest, TestCase::QUICK);
   AddTestCase (new TimeOnAirTest, TestCase::QUICK);
   AddTestCase (new PhyConnectivityTest, TestCase::QUICK);
+  AddTestCase (new LorawanMacTest, TestCase::QUICK);
+  AddTestCase (new StatisticalPhyTest, TestCase::QUICK);
+  AddTestCase (new CapacitorThresholdTest, TestCase::QUICK);
+  AddTestCase (new FlightRecorderTest, TestCase::QUICK);
+  AddTestCase (new EnergyStatisticsTest, TestCase::QUICK);
+  AddTestCase (new ScenarioLoaderTest, TestCase::QUICK);
+  AddTestCase (new HexGridTest, TestCase::QUICK);
+  AddTestCase (new BatchHeaderTest, TestCase::QUICK);
+  AddTestCase (new HarvestStatisticsTest, TestCase::QUICK);
+  AddTestCase (new EnergyGateTest, TestCase::QUICK);
+  AddTestCase (new CapacitorFleetTest, TestCase::QUICK);
+  AddTestCase (new EnergyAdmissionTest, TestCase::QUICK);
+  AddTestCase (new HarvesterGroupTest, TestCase::QUICK);
+  AddTestCase (new CorrelatedShadowingTest, TestCase::QUICK);
+  AddTestCase (new PacketPoolTest, TestCase::QUICK);
+  AddTestCase (new LoraTagTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
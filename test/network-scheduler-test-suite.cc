@@ -6,6 +6,9 @@
 // Include headers of classes to test
 #include "ns3/log.h"
 #include "ns3/network-scheduler.h"
+#include "ns3/downlink-planner.h"
+#include "ns3/simulator.h"
+#include <vector>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -52,6 +55,139 @@ NetworkSchedulerTest::DoRun (void)
   // scheduled to happen 1 second after the reception.
 }
 
+////////////////////////////
+// DownlinkPlanner testing //
+////////////////////////////
+
+class DownlinkPlannerTest : public TestCase
+{
+public:
+  DownlinkPlannerTest ();
+  virtual ~DownlinkPlannerTest ();
+
+  void OnBatch (std::vector<DownlinkPlanner::Opportunity> &opportunities);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Plan an opportunity of the given kind for the device with the given
+   * address.
+   */
+  void Plan (Time time, uint32_t device,
+             DownlinkPlanner::Window window = DownlinkPlanner::FIRST_WINDOW);
+
+  /**
+   * Check that a batch was handled at the given time, with the given devices
+   * in this order.
+   */
+  void CheckBatch (uint32_t batch, Time time, std::vector<uint32_t> devices);
+
+  Ptr<DownlinkPlanner> m_planner;
+  std::vector<Time> m_batchTimes; //!< When each batch was handled
+  std::vector<std::vector<uint32_t> > m_batches; //!< The devices of each batch
+};
+
+// Add some help text to this case to describe what it is intended to test
+DownlinkPlannerTest::DownlinkPlannerTest ()
+  : TestCase ("Verify that the DownlinkPlanner hands over the opportunities"
+              " in batches, in the order of their slots")
+{
+}
+
+// Reminder that the test case should clean up after itself
+DownlinkPlannerTest::~DownlinkPlannerTest ()
+{
+}
+
+void
+DownlinkPlannerTest::Plan (Time time, uint32_t device, DownlinkPlanner::Window window)
+{
+  DownlinkPlanner::Opportunity opportunity;
+  opportunity.deviceAddress = LoraDeviceAddress (device);
+  opportunity.window = window;
+  opportunity.replyPrepared = false;
+  m_planner->Plan (time, opportunity);
+}
+
+void
+DownlinkPlannerTest::OnBatch (std::vector<DownlinkPlanner::Opportunity> &opportunities)
+{
+  std::vector<uint32_t> devices;
+  for (auto it = opportunities.begin (); it != opportunities.end (); ++it)
+    {
+      devices.push_back (it->deviceAddress.Get ());
+
+      // Plan again from the callback: in the current slot, which was already
+      // processed, and far beyond the second level of the wheel
+      if (it->deviceAddress.Get () == 2)
+        {
+          Plan (Simulator::Now (), 8);
+          Plan (Simulator::Now () + Seconds (80), 9, DownlinkPlanner::PING_SLOT);
+        }
+    }
+  m_batchTimes.push_back (Simulator::Now ());
+  m_batches.push_back (devices);
+}
+
+void
+DownlinkPlannerTest::CheckBatch (uint32_t batch, Time time, std::vector<uint32_t> devices)
+{
+  NS_TEST_ASSERT_MSG_LT (batch, m_batches.size (), "Missing batch " << batch);
+  NS_TEST_EXPECT_MSG_EQ (m_batchTimes[batch], time, "Batch " << batch << " at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_batches[batch].size (), devices.size (),
+                         "Wrong size of batch " << batch);
+  for (uint32_t i = 0; i < std::min (devices.size (), m_batches[batch].size ()); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_batches[batch][i], devices[i],
+                             "Wrong device in batch " << batch);
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+DownlinkPlannerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("DownlinkPlannerTest");
+
+  m_planner = CreateObject<DownlinkPlanner> ();
+  m_planner->SetAttribute ("SlotDuration", TimeValue (MilliSeconds (1)));
+  m_planner->SetBatchCallback (MakeCallback (&DownlinkPlannerTest::OnBatch, this));
+
+  // Slots of the first level, out of order and shared
+  Plan (MilliSeconds (5), 1);
+  Plan (MilliSeconds (2), 2);
+  Plan (MicroSeconds (2500), 3); // Rounded up to the next slot
+  Plan (MilliSeconds (2), 4);
+  // Second level
+  Plan (Seconds (1), 5);
+  Plan (MilliSeconds (300), 7);
+  // Near the end of the second level: slot 65000 is in turn 253 of 256
+  Plan (Seconds (65), 6);
+  // Beyond the second level: slot 70000 is more than 255 turns ahead
+  Plan (Seconds (70), 10, DownlinkPlanner::PING_SLOT);
+
+  NS_TEST_EXPECT_MSG_EQ (m_planner->GetNPlanned (), 8, "Wrong number of planned opportunities");
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_batches.size (), 8, "Wrong number of batches");
+  CheckBatch (0, MilliSeconds (2), {2, 4});
+  CheckBatch (1, MilliSeconds (3), {3, 8});
+  CheckBatch (2, MilliSeconds (5), {1});
+  CheckBatch (3, MilliSeconds (300), {7});
+  CheckBatch (4, Seconds (1), {5});
+  CheckBatch (5, Seconds (65), {6});
+  CheckBatch (6, Seconds (70), {10});
+  CheckBatch (7, MilliSeconds (80002), {9});
+  NS_TEST_EXPECT_MSG_EQ (m_planner->GetNPlanned (), 0, "Opportunities left in the planner");
+
+  m_planner->Dispose ();
+  m_planner = 0;
+  Simulator::Destroy ();
+}
+
 /**************
  * Test Suite *
  **************/
@@ -72,6 +208,7 @@ NetworkSchedulerTestSuite::NetworkSchedulerTestSuite ()
   LogComponentEnable ("NetworkSchedulerTestSuite", LOG_LEVEL_DEBUG);
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new NetworkSchedulerTest, TestCase::QUICK);
+  AddTestCase (new DownlinkPlannerTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -15,6 +15,12 @@
 #include "ns3/callback.h"
 #include "ns3/network-server.h"
 #include "ns3/network-server-helper.h"
+#include "ns3/network-controller-components.h"
+#include "ns3/mobility-model.h"
+#include "ns3/class-b-end-device-lorawan-mac.h"
+#include "ns3/forwarder.h"
+#include "ns3/lora-frame-info-tag.h"
+#include "ns3/lora-tag.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -267,6 +273,630 @@ LinkCheckTest::DoRun (void)
   NS_ASSERT (m_receivedPacketAtEd);
 }
 
+//////////////////////
+// DeduplicationTest //
+//////////////////////
+
+/**
+ * A controller component counting the uplinks it is informed of.
+ */
+class CountingComponent : public NetworkControllerComponent
+{
+public:
+  void
+  OnReceivedPacket (Ptr<const Packet> packet, Ptr<EndDeviceStatus> status,
+                    Ptr<NetworkStatus> networkStatus)
+  {
+    m_receivedPackets++;
+  }
+
+  void
+  BeforeSendingReply (Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus)
+  {
+  }
+
+  void
+  OnFailedReply (Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus)
+  {
+  }
+
+  int m_receivedPackets = 0;
+};
+
+class DeduplicationTest : public TestCase
+{
+public:
+  DeduplicationTest ();
+  virtual ~DeduplicationTest ();
+
+  void ReceivedPacket (Ptr<Packet const> packet);
+  void SendPacket (Ptr<Node> endDevice);
+
+private:
+  virtual void DoRun (void);
+  int m_receivedCopies = 0;
+};
+
+// Add some help text to this case to describe what it is intended to test
+DeduplicationTest::DeduplicationTest ()
+  : TestCase ("Verify that the NetworkServer merges the copies of an uplink"
+              " forwarded by different gateways before processing it")
+{
+}
+
+// Reminder that the test case should clean up after itself
+DeduplicationTest::~DeduplicationTest ()
+{
+}
+
+void
+DeduplicationTest::ReceivedPacket (Ptr<Packet const> packet)
+{
+  NS_LOG_DEBUG ("Received a copy at the NS");
+  m_receivedCopies++;
+}
+
+void
+DeduplicationTest::SendPacket (Ptr<Node> endDevice)
+{
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+DeduplicationTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("DeduplicationTest");
+
+  // One device, close to two gateways
+  NetworkComponents components = InitializeNetwork (1, 2);
+
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+  Ptr<Node> nsNode = components.nsNode;
+
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+  gateways.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 100, 0));
+
+  Ptr<NetworkServer> ns = nsNode->GetApplication (0)->GetObject<NetworkServer> ();
+  Ptr<CountingComponent> component = CreateObject<CountingComponent> ();
+  ns->AddComponent (component);
+
+  ns->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&DeduplicationTest::ReceivedPacket, this));
+
+  Simulator::Schedule (Seconds (1), &DeduplicationTest::SendPacket, this,
+                       endDevices.Get (0));
+
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  LoraDeviceAddress address =
+    GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0))->GetDeviceAddress ();
+  Ptr<EndDeviceStatus> status = ns->GetNetworkStatus ()->GetEndDeviceStatus (address);
+  uint32_t nGateways = status->GetLastReceivedPacketInfo ().gwList.size ();
+
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedCopies, 2, "Both gateways should forward the uplink");
+  NS_TEST_EXPECT_MSG_EQ (component->m_receivedPackets, 1,
+                         "Controller components should run once per uplink, not per copy");
+  NS_TEST_EXPECT_MSG_EQ (nGateways, 2, "The uplink should list both gateways");
+}
+
+//////////////////////////
+// ClassBCDownlinkTest //
+//////////////////////////
+
+class ClassBCDownlinkTest : public TestCase
+{
+public:
+  ClassBCDownlinkTest (LorawanMacHelper::DeviceType deviceType, bool uplinkFirst);
+  virtual ~ClassBCDownlinkTest ();
+
+  void ReceivedPacketAtEndDevice (Ptr<Packet const> packet);
+  void SendPacket (Ptr<Node> endDevice);
+  void SendDownlink (Ptr<NetworkServer> ns, LoraDeviceAddress address);
+
+private:
+  virtual void DoRun (void);
+  LorawanMacHelper::DeviceType m_deviceType;
+  bool m_uplinkFirst;
+  std::vector<Time> m_receptionTimes;
+};
+
+// Add some help text to this case to describe what it is intended to test
+ClassBCDownlinkTest::ClassBCDownlinkTest (LorawanMacHelper::DeviceType deviceType,
+                                          bool uplinkFirst)
+  : TestCase (std::string ("Verify that a downlink queued by the NetworkServer reaches a Class ")
+              + (deviceType == LorawanMacHelper::ED_B ? "B device in its next ping slot"
+                 : "C device right away")
+              + (uplinkFirst ? "" : ", once its first uplink reveals a gateway")),
+    m_deviceType (deviceType),
+    m_uplinkFirst (uplinkFirst)
+{
+}
+
+// Reminder that the test case should clean up after itself
+ClassBCDownlinkTest::~ClassBCDownlinkTest ()
+{
+}
+
+void
+ClassBCDownlinkTest::ReceivedPacketAtEndDevice (Ptr<Packet const> packet)
+{
+  NS_LOG_DEBUG ("Received a downlink at the ED");
+  m_receptionTimes.push_back (Simulator::Now ());
+}
+
+void
+ClassBCDownlinkTest::SendPacket (Ptr<Node> endDevice)
+{
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+void
+ClassBCDownlinkTest::SendDownlink (Ptr<NetworkServer> ns, LoraDeviceAddress address)
+{
+  ns->SendDownlink (address, Create<Packet> (10));
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ClassBCDownlinkTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ClassBCDownlinkTest");
+
+  NetworkComponents components = InitializeNetwork (1, 1, m_deviceType);
+
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+  Ptr<Node> nsNode = components.nsNode;
+
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+
+  Ptr<ClassAEndDeviceLorawanMac> mac =
+    GetMacLayerFromNode<ClassAEndDeviceLorawanMac> (endDevices.Get (0));
+  mac->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&ClassBCDownlinkTest::ReceivedPacketAtEndDevice, this));
+
+  Ptr<NetworkServer> ns = nsNode->GetApplication (0)->GetObject<NetworkServer> ();
+
+  // The uplink needs no reply, so that the only downlink is the queued one
+  Time uplinkTime = m_uplinkFirst ? Seconds (1) : Seconds (10);
+  Time downlinkTime = m_uplinkFirst ? Seconds (10) : Seconds (1);
+  Simulator::Schedule (uplinkTime, &ClassBCDownlinkTest::SendPacket, this,
+                       endDevices.Get (0));
+  Simulator::Schedule (downlinkTime, &ClassBCDownlinkTest::SendDownlink, this, ns,
+                       mac->GetDeviceAddress ());
+
+  // Where the downlink is expected
+  Time earliest;
+  Time latest;
+  if (!m_uplinkFirst)
+    {
+      // In the receive windows of the uplink
+      earliest = uplinkTime + Seconds (1);
+      latest = uplinkTime + Seconds (4);
+    }
+  else if (m_deviceType == LorawanMacHelper::ED_B)
+    {
+      Ptr<ClassBEndDeviceLorawanMac> macB = mac->GetObject<ClassBEndDeviceLorawanMac> ();
+      earliest = macB->GetNextPingSlot (downlinkTime);
+      latest = earliest + Seconds (1);
+    }
+  else
+    {
+      earliest = downlinkTime;
+      latest = downlinkTime + Seconds (1);
+    }
+
+  Simulator::Stop (latest + Seconds (200));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_receptionTimes.size (), 1,
+                         "The device should receive the queued downlink exactly once");
+  NS_TEST_EXPECT_MSG_EQ (m_receptionTimes[0] >= earliest, true,
+                         "The downlink arrived before its receive opportunity");
+  NS_TEST_EXPECT_MSG_LT (m_receptionTimes[0], latest,
+                         "The downlink did not arrive in the expected opportunity");
+}
+
+/////////////////////
+// BatchedAckTest //
+/////////////////////
+
+class BatchedAckTest : public TestCase
+{
+public:
+  BatchedAckTest ();
+  virtual ~BatchedAckTest ();
+
+  void ReceivedPacketAtEndDevice (Ptr<Packet const> packet);
+  void ReceivedPacketAtNetworkServer (Ptr<Packet const> packet);
+  void SendPacket (Ptr<Node> endDevice);
+
+private:
+  virtual void DoRun (void);
+  std::vector<Time> m_edReceptionTimes;
+  std::vector<Time> m_nsReceptionTimes;
+};
+
+// Add some help text to this case to describe what it is intended to test
+BatchedAckTest::BatchedAckTest ()
+  : TestCase ("Verify that a confirmed uplink forwarded in a batch is"
+              " acknowledged in the first receive window")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatchedAckTest::~BatchedAckTest ()
+{
+}
+
+void
+BatchedAckTest::ReceivedPacketAtEndDevice (Ptr<Packet const> packet)
+{
+  NS_LOG_DEBUG ("Received a downlink at the ED");
+  m_edReceptionTimes.push_back (Simulator::Now ());
+}
+
+void
+BatchedAckTest::ReceivedPacketAtNetworkServer (Ptr<Packet const> packet)
+{
+  NS_LOG_DEBUG ("Received an uplink at the NS");
+  m_nsReceptionTimes.push_back (Simulator::Now ());
+}
+
+void
+BatchedAckTest::SendPacket (Ptr<Node> endDevice)
+{
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatchedAckTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatchedAckTest");
+
+  NetworkComponents components = InitializeNetwork (1, 1);
+
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+  Ptr<Node> nsNode = components.nsNode;
+
+  // Close to the gateway, so that the uplink uses SF7 and lasts less than 0.1 s
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+  LorawanMacHelper ().SetSpreadingFactorsUp (endDevices, gateways, components.channel);
+
+  Time batchInterval = MilliSeconds (200);
+  gateways.Get (0)->GetApplication (0)->GetObject<Forwarder> ()
+    ->SetAttribute ("BatchInterval", TimeValue (batchInterval));
+
+  Ptr<ClassAEndDeviceLorawanMac> mac =
+    GetMacLayerFromNode<ClassAEndDeviceLorawanMac> (endDevices.Get (0));
+  mac->SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  mac->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&BatchedAckTest::ReceivedPacketAtEndDevice, this));
+  nsNode->GetApplication (0)->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&BatchedAckTest::ReceivedPacketAtNetworkServer, this));
+
+  Time uplinkTime = Seconds (1);
+  Simulator::Schedule (uplinkTime, &BatchedAckTest::SendPacket, this, endDevices.Get (0));
+
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_nsReceptionTimes.empty (), false, "The uplink was not forwarded");
+  NS_TEST_EXPECT_MSG_EQ (m_nsReceptionTimes[0] >= uplinkTime + batchInterval, true,
+                         "The uplink should wait for the end of the batch");
+  NS_TEST_ASSERT_MSG_EQ (m_edReceptionTimes.empty (), false, "The ACK was not received");
+  // RX2 opens 2 s after the end of the uplink
+  NS_TEST_EXPECT_MSG_EQ (m_edReceptionTimes[0] >= uplinkTime + Seconds (1), true,
+                         "The ACK arrived before RX1");
+  NS_TEST_EXPECT_MSG_LT (m_edReceptionTimes[0], uplinkTime + Seconds (2),
+                         "The ACK should arrive in RX1");
+}
+
+/////////////////////
+// BatchSplitTest //
+/////////////////////
+
+class BatchSplitTest : public TestCase
+{
+public:
+  BatchSplitTest ();
+  virtual ~BatchSplitTest ();
+
+  void ReceivedPacket (Ptr<Packet const> packet);
+  void SendPacket (Ptr<Node> endDevice);
+
+private:
+  virtual void DoRun (void);
+  std::vector<Ptr<Packet const> > m_packets;
+  std::vector<Time> m_receptionTimes;
+};
+
+// Add some help text to this case to describe what it is intended to test
+BatchSplitTest::BatchSplitTest ()
+  : TestCase ("Verify that the NetworkServer splits a batch in its uplinks,"
+              " each with the time its gateway received it")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatchSplitTest::~BatchSplitTest ()
+{
+}
+
+void
+BatchSplitTest::ReceivedPacket (Ptr<Packet const> packet)
+{
+  NS_LOG_DEBUG ("Received an uplink at the NS");
+  m_packets.push_back (packet);
+  m_receptionTimes.push_back (Simulator::Now ());
+}
+
+void
+BatchSplitTest::SendPacket (Ptr<Node> endDevice)
+{
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatchSplitTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatchSplitTest");
+
+  NetworkComponents components = InitializeNetwork (2, 1);
+
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+  Ptr<Node> nsNode = components.nsNode;
+
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  endDevices.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 100, 0));
+  gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (100, 0, 0));
+  LorawanMacHelper ().SetSpreadingFactorsUp (endDevices, gateways, components.channel);
+
+  // Both uplinks end up in the same batch
+  gateways.Get (0)->GetApplication (0)->GetObject<Forwarder> ()
+    ->SetAttribute ("BatchInterval", TimeValue (Seconds (1)));
+
+  Ptr<NetworkServer> ns = nsNode->GetApplication (0)->GetObject<NetworkServer> ();
+  ns->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&BatchSplitTest::ReceivedPacket, this));
+
+  std::vector<Time> sendTimes;
+  sendTimes.push_back (Seconds (1));
+  sendTimes.push_back (Seconds (1.5));
+  for (uint32_t i = 0; i < sendTimes.size (); i++)
+    {
+      Simulator::Schedule (sendTimes[i], &BatchSplitTest::SendPacket, this,
+                           endDevices.Get (i));
+    }
+
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  std::vector<Time> gwReceptionTimes;
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      LoraDeviceAddress address =
+        GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (i))->GetDeviceAddress ();
+      Ptr<EndDeviceStatus> status = ns->GetNetworkStatus ()->GetEndDeviceStatus (address);
+      EndDeviceStatus::GatewayList gwList = status->GetLastReceivedPacketInfo ().gwList;
+      NS_TEST_ASSERT_MSG_EQ (gwList.size (), 1, "The uplink of device " << i << " was lost");
+      gwReceptionTimes.push_back (gwList.begin ()->second.receivedTime);
+    }
+
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_packets.size (), 2, "Both uplinks should reach the NS");
+  NS_TEST_EXPECT_MSG_EQ (m_receptionTimes[0], m_receptionTimes[1],
+                         "The uplinks should arrive in the same batch");
+  for (uint32_t i = 0; i < m_packets.size (); i++)
+    {
+      // Decoding the bytes of each fragment gives the headers of its tag
+      LoraFrameInfoTag info = LoraFrameInfoTag::Get (m_packets[i]);
+      Ptr<Packet> bytes = m_packets[i]->Copy ();
+      bytes->RemoveAllPacketTags ();
+      LoraFrameInfoTag decoded = LoraFrameInfoTag::Decode (bytes);
+      NS_TEST_EXPECT_MSG_EQ (decoded.GetAddress (), info.GetAddress (),
+                             "Uplink " << i << " was not split at its boundaries");
+      NS_TEST_EXPECT_MSG_EQ (decoded.GetFCnt (), info.GetFCnt (),
+                             "Uplink " << i << " was not split at its boundaries");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_packets[0]->GetSize (), m_packets[1]->GetSize (),
+                         "Both uplinks have the same size");
+
+  for (uint32_t i = 0; i < gwReceptionTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (gwReceptionTimes[i] > sendTimes[i], true,
+                             "Wrong gateway reception time of device " << i);
+      NS_TEST_EXPECT_MSG_LT (gwReceptionTimes[i], sendTimes[i] + MilliSeconds (200),
+                             "The gateway reception time of device " << i
+                             << " should not be the arrival of the batch");
+    }
+}
+
+/////////////////////////
+// FrameInfoTagTest //
+/////////////////////////
+
+class FrameInfoTagTest : public TestCase
+{
+public:
+  FrameInfoTagTest ();
+  virtual ~FrameInfoTagTest ();
+
+  /**
+   * Build an uplink with a LinkCheckReq, received with a LoraTag.
+   */
+  Ptr<Packet> CreateUplink (LorawanMacHeader::MType mType, uint16_t fCnt);
+
+  bool ReceivedAtDevice (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                         uint16_t protocol, const Address &sender);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<Ptr<const Packet> > m_forwardedPackets;
+};
+
+// Add some help text to this case to describe what it is intended to test
+FrameInfoTagTest::FrameInfoTagTest ()
+  : TestCase ("Verify that LoraFrameInfoTag decodes the headers of an uplink, and"
+              " that the ConfirmedMessagesComponent reads them from the device status")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FrameInfoTagTest::~FrameInfoTagTest ()
+{
+}
+
+Ptr<Packet>
+FrameInfoTagTest::CreateUplink (LorawanMacHeader::MType mType, uint16_t fCnt)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (5, 1234));
+  frameHdr.SetFCnt (fCnt);
+  frameHdr.SetAdr (true);
+  frameHdr.SetAck (false);
+  frameHdr.AddLinkCheckReq ();
+  packet->AddHeader (frameHdr);
+
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (mType);
+  packet->AddHeader (macHdr);
+
+  LoraTag tag;
+  tag.SetSpreadingFactor (9);
+  tag.SetFrequency (868.3);
+  tag.SetReceivePower (-110);
+  packet->AddPacketTag (tag);
+  return packet;
+}
+
+bool
+FrameInfoTagTest::ReceivedAtDevice (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                    uint16_t protocol, const Address &sender)
+{
+  m_forwardedPackets.push_back (packet);
+  return true;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FrameInfoTagTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FrameInfoTagTest");
+
+  // Decode the headers and the LoraTag
+  Ptr<Packet> confirmed = CreateUplink (LorawanMacHeader::CONFIRMED_DATA_UP, 42);
+  LoraFrameInfoTag decoded = LoraFrameInfoTag::Decode (confirmed);
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetAddress (), LoraDeviceAddress (5, 1234), "Wrong address");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetFCnt (), 42, "Wrong FCnt");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (decoded.GetMType ()),
+                         unsigned (LorawanMacHeader::CONFIRMED_DATA_UP), "Wrong MType");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetAdr (), true, "Wrong ADR bit");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetAdrAckReq (), false, "Wrong ADRACKReq bit");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetAck (), false, "Wrong ACK bit");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (decoded.GetFOptsLen ()), 1, "Wrong FOpts length");
+  NS_TEST_EXPECT_MSG_EQ (decoded.HasMacCommand (LINK_CHECK_REQ), true,
+                         "The LinkCheckReq was not found");
+  NS_TEST_EXPECT_MSG_EQ (decoded.HasMacCommand (LINK_ADR_ANS), false,
+                         "Unexpected LinkAdrAns");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (decoded.GetSpreadingFactor ()), 9, "Wrong SF");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetFrequency (), 868.3, "Wrong frequency");
+  NS_TEST_EXPECT_MSG_EQ (decoded.GetReceivePower (), -110, "Wrong receive power");
+  NS_TEST_EXPECT_MSG_EQ (confirmed->GetSize (), 10 + 1 + 9,
+                         "Decoding should not remove the headers");
+
+  // Without a LoraFrameInfoTag, Get decodes the headers
+  LoraFrameInfoTag untagged = LoraFrameInfoTag::Get (confirmed);
+  NS_TEST_EXPECT_MSG_EQ (untagged.GetFCnt (), 42, "Get should decode an untagged packet");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (untagged.GetMType ()), unsigned (decoded.GetMType ()),
+                         "Get should decode an untagged packet");
+
+  // With a tag, Get returns its contents, which survive the serialization
+  // of the tag
+  Ptr<Packet> unconfirmed = CreateUplink (LorawanMacHeader::UNCONFIRMED_DATA_UP, 7);
+  unconfirmed->AddPacketTag (decoded);
+  LoraFrameInfoTag tagged = LoraFrameInfoTag::Get (unconfirmed);
+  NS_TEST_EXPECT_MSG_EQ (tagged.GetFCnt (), 42, "Get should use the tag of a tagged packet");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (tagged.GetMType ()),
+                         unsigned (LorawanMacHeader::CONFIRMED_DATA_UP),
+                         "Get should use the tag of a tagged packet");
+  NS_TEST_EXPECT_MSG_EQ (tagged.GetAddress (), decoded.GetAddress (), "Wrong address in the tag");
+  NS_TEST_EXPECT_MSG_EQ (tagged.GetAdr (), true, "Wrong ADR bit in the tag");
+  NS_TEST_EXPECT_MSG_EQ (tagged.HasMacCommand (LINK_CHECK_REQ), true,
+                         "Wrong MAC commands in the tag");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (tagged.GetSpreadingFactor ()), 9, "Wrong SF in the tag");
+  NS_TEST_EXPECT_MSG_EQ (tagged.GetFrequency (), 868.3, "Wrong frequency in the tag");
+  NS_TEST_EXPECT_MSG_EQ (tagged.GetReceivePower (), -110, "Wrong receive power in the tag");
+
+  // The component reads the MType and FCnt of the last frame from the status
+  Ptr<ConfirmedMessagesComponent> component = CreateObject<ConfirmedMessagesComponent> ();
+  Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> ();
+  Address gwAddress;
+
+  Ptr<Packet> first = CreateUplink (LorawanMacHeader::UNCONFIRMED_DATA_UP, 3);
+  status->InsertReceivedPacket (first, LoraFrameInfoTag::Decode (first), gwAddress);
+  NS_TEST_EXPECT_MSG_EQ (status->GetLastFrameInfo ().GetFCnt (), 3, "Wrong FCnt of the last frame");
+  component->OnReceivedPacket (first, status, 0);
+  NS_TEST_EXPECT_MSG_EQ (status->m_reply.needsReply, false,
+                         "An unconfirmed uplink should not be acknowledged");
+
+  Ptr<Packet> second = CreateUplink (LorawanMacHeader::CONFIRMED_DATA_UP, 4);
+  status->InsertReceivedPacket (second, LoraFrameInfoTag::Decode (second), gwAddress);
+  NS_TEST_EXPECT_MSG_EQ (status->GetLastFrameInfo ().GetFCnt (), 4, "Wrong FCnt of the last frame");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (status->GetLastFrameInfo ().GetMType ()),
+                         unsigned (LorawanMacHeader::CONFIRMED_DATA_UP),
+                         "Wrong MType of the last frame");
+  component->OnReceivedPacket (second, status, 0);
+  NS_TEST_EXPECT_MSG_EQ (status->m_reply.needsReply, true,
+                         "A confirmed uplink should be acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (status->m_reply.frameHeader.GetAck (), true, "The ACK bit is not set");
+  NS_TEST_EXPECT_MSG_EQ (status->m_reply.frameHeader.GetAddress (), LoraDeviceAddress (5, 1234),
+                         "The reply is not addressed to the device");
+
+  // The gateway MAC attaches the tag to the uplinks it forwards
+  Ptr<LoraChannel> channel = CreateChannel ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer gateways = CreateGateways (1, mobility, channel);
+  gateways.Get (0)->GetDevice (0)->SetReceiveCallback
+    (MakeCallback (&FrameInfoTagTest::ReceivedAtDevice, this));
+  Ptr<GatewayLorawanMac> gwMac = GetMacLayerFromNode<GatewayLorawanMac> (gateways.Get (0));
+  gwMac->Receive (CreateUplink (LorawanMacHeader::CONFIRMED_DATA_UP, 8));
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_forwardedPackets.size (), 1, "The gateway should forward the uplink");
+  LoraFrameInfoTag forwarded;
+  NS_TEST_EXPECT_MSG_EQ (m_forwardedPackets[0]->PeekPacketTag (forwarded), true,
+                         "The forwarded uplink does not carry a LoraFrameInfoTag");
+  NS_TEST_EXPECT_MSG_EQ (forwarded.GetFCnt (), 8, "Wrong FCnt in the forwarded tag");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (forwarded.GetSpreadingFactor ()), 9,
+                         "Wrong SF in the forwarded tag");
+}
+
 /**************
  * Test Suite *
  **************/
@@ -305,6 +935,13 @@ NetworkServerTestSuite::NetworkServerTestSuite ()
   AddTestCase (new UplinkPacketTest, TestCase::QUICK);
   AddTestCase (new DownlinkPacketTest, TestCase::QUICK);
   AddTestCase (new LinkCheckTest, TestCase::QUICK);
+  AddTestCase (new DeduplicationTest, TestCase::QUICK);
+  AddTestCase (new ClassBCDownlinkTest (LorawanMacHelper::ED_B, true), TestCase::QUICK);
+  AddTestCase (new ClassBCDownlinkTest (LorawanMacHelper::ED_C, true), TestCase::QUICK);
+  AddTestCase (new ClassBCDownlinkTest (LorawanMacHelper::ED_C, false), TestCase::QUICK);
+  AddTestCase (new BatchedAckTest, TestCase::QUICK);
+  AddTestCase (new BatchSplitTest, TestCase::QUICK);
+  AddTestCase (new FrameInfoTagTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
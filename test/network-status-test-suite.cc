@@ -12,6 +12,9 @@
 #include "ns3/log.h"
 #include "ns3/end-device-status.h"
 #include "ns3/network-status.h"
+#include "ns3/lora-index-table.h"
+#include "ns3/lora-frame-info-tag.h"
+#include "ns3/mac48-address.h"
 #include "utilities.h"
 
 // An essential include is test.h
@@ -104,6 +107,237 @@ NetworkStatusTest::DoRun (void)
   ns.AddNode (GetMacLayerFromNode<ClassAEndDeviceLorawanMac> (endDevices.Get (0)), 0);
 }
 
+/////////////////////////
+// IndexTable testing //
+/////////////////////////
+
+/**
+ * A hash putting all the keys in the same slot, to test collisions.
+ */
+struct ConstantHash
+{
+  uint32_t operator() (const LoraDeviceAddress &) const
+  {
+    return 7;
+  }
+};
+
+class IndexTableTest : public TestCase
+{
+public:
+  IndexTableTest ();
+  virtual ~IndexTableTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Check that the first n sequential addresses are found at their index,
+   * and that the following ones are not.
+   */
+  template <typename Hash>
+  void CheckAddresses (const IndexTable<LoraDeviceAddress, Hash> &table, uint32_t n);
+};
+
+// Add some help text to this case to describe what it is intended to test
+IndexTableTest::IndexTableTest ()
+  : TestCase ("Verify that IndexTable finds its keys across growths and collisions")
+{
+}
+
+// Reminder that the test case should clean up after itself
+IndexTableTest::~IndexTableTest ()
+{
+}
+
+template <typename Hash>
+void
+IndexTableTest::CheckAddresses (const IndexTable<LoraDeviceAddress, Hash> &table, uint32_t n)
+{
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), n, "Wrong number of keys");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (table.Find (LoraDeviceAddress (i + 1)), i,
+                             "Wrong index of key " << i + 1 << " with " << n << " keys");
+    }
+  for (uint32_t i = n; i < n + 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (table.Find (LoraDeviceAddress (i + 1)),
+                             (IndexTable<LoraDeviceAddress, Hash>::NOT_FOUND),
+                             "Key " << i + 1 << " should not be found with " << n << " keys");
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+IndexTableTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("IndexTableTest");
+
+  // Growth: check every key on both sides of each rehash
+  IndexTable<LoraDeviceAddress, LoraDeviceAddressHash> devices;
+  CheckAddresses (devices, 0);
+  for (uint32_t n = 1; n <= 1100; n++)
+    {
+      devices.Insert (LoraDeviceAddress (n), n - 1);
+      // The slots double when the table would become more than half full
+      if ((n & (n - 1)) == 0 || ((n - 1) & (n - 2)) == 0)
+        {
+          CheckAddresses (devices, n);
+        }
+    }
+  CheckAddresses (devices, 1100);
+
+  // Collisions: all the keys are probed from the same slot, across rehashes
+  IndexTable<LoraDeviceAddress, ConstantHash> colliding;
+  for (uint32_t n = 1; n <= 40; n++)
+    {
+      colliding.Insert (LoraDeviceAddress (n), n - 1);
+      CheckAddresses (colliding, n);
+    }
+
+  // Gateway addresses, hashed on their bytes
+  IndexTable<Address, AddressHash> gateways;
+  std::vector<Address> addresses;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      addresses.push_back (Mac48Address::Allocate ());
+      gateways.Insert (addresses.back (), i);
+    }
+  for (uint32_t i = 0; i < addresses.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (gateways.Find (addresses[i]), i, "Wrong index of gateway " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (gateways.Find (Mac48Address::Allocate ()),
+                         (IndexTable<Address, AddressHash>::NOT_FOUND),
+                         "An unknown gateway should not be found");
+}
+
+////////////////////////////////
+// Gateway ranking testing //
+////////////////////////////////
+
+class GatewayRankingTest : public TestCase
+{
+public:
+  GatewayRankingTest ();
+  virtual ~GatewayRankingTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Insert the reception of a packet by a gateway.
+   */
+  void Receive (Ptr<EndDeviceStatus> status, uint16_t fCnt, Address gateway, double rxPower);
+
+  /**
+   * Check that the ranking lists the given gateways, in order.
+   */
+  void CheckRanking (Ptr<EndDeviceStatus> status, std::vector<Address> expected);
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewayRankingTest::GatewayRankingTest ()
+  : TestCase ("Verify that EndDeviceStatus ranks the gateways of the last packet"
+              " by receive power")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewayRankingTest::~GatewayRankingTest ()
+{
+}
+
+void
+GatewayRankingTest::Receive (Ptr<EndDeviceStatus> status, uint16_t fCnt, Address gateway,
+                             double rxPower)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (1, 1));
+  frameHdr.SetFCnt (fCnt);
+  packet->AddHeader (frameHdr);
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+
+  EndDeviceStatus::PacketInfoPerGw info;
+  info.gwAddress = gateway;
+  info.rxPower = rxPower;
+  EndDeviceStatus::GatewayList gwList;
+  gwList[gateway] = info;
+  status->InsertReceivedPacket (packet, LoraFrameInfoTag::Decode (packet), gwList);
+}
+
+void
+GatewayRankingTest::CheckRanking (Ptr<EndDeviceStatus> status, std::vector<Address> expected)
+{
+  const EndDeviceStatus::GatewayRanking &ranking = status->GetGatewayRanking ();
+  NS_TEST_ASSERT_MSG_EQ (ranking.size (), expected.size (), "Wrong number of ranked gateways");
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (ranking[i].second, expected[i], "Wrong gateway at rank " << i);
+      if (i > 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (ranking[i - 1].first >= ranking[i].first, true,
+                                 "The ranking is not sorted at rank " << i);
+        }
+    }
+
+  // The map keeps the best gateway last
+  std::map<double, Address> powers = status->GetPowerGatewayMap ();
+  NS_TEST_EXPECT_MSG_EQ (powers.rbegin ()->second, expected.front (),
+                         "The power map and the ranking disagree on the best gateway");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+GatewayRankingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("GatewayRankingTest");
+
+  Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> ();
+  std::vector<Address> gw;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      gw.push_back (Mac48Address::Allocate ());
+    }
+
+  // The same packet reported by several gateways, with a tie between gw[1]
+  // and gw[3]: the first to report stays first
+  Receive (status, 1, gw[0], -110);
+  Receive (status, 1, gw[1], -100);
+  Receive (status, 1, gw[2], -120);
+  Receive (status, 1, gw[3], -100);
+  std::vector<Address> expected;
+  expected.push_back (gw[1]);
+  expected.push_back (gw[3]);
+  expected.push_back (gw[0]);
+  expected.push_back (gw[2]);
+  CheckRanking (status, expected);
+
+  // A second report from the same gateway is not ranked twice
+  Receive (status, 1, gw[2], -90);
+  CheckRanking (status, expected);
+
+  // A new packet drops the gateways of the previous one
+  Receive (status, 2, gw[2], -115);
+  expected.clear ();
+  expected.push_back (gw[2]);
+  CheckRanking (status, expected);
+  Receive (status, 2, gw[0], -105);
+  expected.insert (expected.begin (), gw[0]);
+  CheckRanking (status, expected);
+
+  // A late report of the previous packet does not change the ranking
+  Receive (status, 1, gw[3], -80);
+  CheckRanking (status, expected);
+}
+
 /**************
  * Test Suite *
  **************/
@@ -125,6 +359,8 @@ NetworkStatusTestSuite::NetworkStatusTestSuite ()
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new EndDeviceStatusTest, TestCase::QUICK);
   AddTestCase (new NetworkStatusTest, TestCase::QUICK);
+  AddTestCase (new IndexTableTest, TestCase::QUICK);
+  AddTestCase (new GatewayRankingTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -17,7 +17,8 @@ CreateChannel (void)
 }
 
 NodeContainer
-CreateEndDevices (int nDevices, MobilityHelper mobility, Ptr<LoraChannel> channel)
+CreateEndDevices (int nDevices, MobilityHelper mobility, Ptr<LoraChannel> channel,
+                  LorawanMacHelper::DeviceType deviceType)
 {
   // Create the LoraPhyHelper
   LoraPhyHelper phyHelper = LoraPhyHelper ();
@@ -38,7 +39,7 @@ CreateEndDevices (int nDevices, MobilityHelper mobility, Ptr<LoraChannel> channe
 
   // Create the LoraNetDevices of the end devices
   phyHelper.SetDeviceType (LoraPhyHelper::ED);
-  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  macHelper.SetDeviceType (deviceType);
   helper.Install (phyHelper, macHelper, endDevices);
 
   return endDevices;
@@ -89,7 +90,7 @@ CreateNetworkServer (NodeContainer endDevices, NodeContainer gateways)
 }
 
 NetworkComponents
-InitializeNetwork (int nDevices, int nGateways)
+InitializeNetwork (int nDevices, int nGateways, LorawanMacHelper::DeviceType deviceType)
 {
   // This function sets up a network with some devices and some gateways, and
   // returns the created nodes through a NetworkComponents struct.
@@ -103,7 +104,7 @@ InitializeNetwork (int nDevices, int nGateways)
                                  "Y", DoubleValue (0.0));
   mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
 
-  NodeContainer endDevices = CreateEndDevices (nDevices, mobility, channel);
+  NodeContainer endDevices = CreateEndDevices (nDevices, mobility, channel, deviceType);
 
   NodeContainer gateways = CreateGateways (nGateways, mobility, channel);
 
@@ -40,7 +40,8 @@ struct NetworkComponents
 Ptr<LoraChannel> CreateChannel (void);
 
 NodeContainer CreateEndDevices (int nDevices, MobilityHelper mobility,
-                                Ptr<LoraChannel> channel);
+                                Ptr<LoraChannel> channel,
+                                LorawanMacHelper::DeviceType deviceType = LorawanMacHelper::ED_A);
 
 NodeContainer CreateGateways (int nGateways, MobilityHelper mobility,
                               Ptr<LoraChannel> channel);
@@ -55,7 +56,8 @@ GetMacLayerFromNode (Ptr<Node> n)
   return n->GetDevice (0)->GetObject<LoraNetDevice> ()->GetMac ()->GetObject<T> ();
 }
 
-NetworkComponents InitializeNetwork (int nDevices, int nGateways);
+NetworkComponents InitializeNetwork (int nDevices, int nGateways,
+                                     LorawanMacHelper::DeviceType deviceType = LorawanMacHelper::ED_A);
 }
 
 }